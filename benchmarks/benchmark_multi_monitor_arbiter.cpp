@@ -0,0 +1,148 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/multi_monitor_arbiter.h"
+#include "src/server/compositor/queueing_schedule.h"
+#include "src/server/compositor/dropping_schedule.h"
+#include "mir/graphics/buffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+class BenchmarkBuffer : public mg::Buffer
+{
+public:
+    explicit BenchmarkBuffer(uint32_t id) : id_{id} {}
+
+    std::shared_ptr<mg::NativeBuffer> native_buffer_handle() const override { return nullptr; }
+    mg::BufferID id() const override { return id_; }
+    geom::Size size() const override { return {}; }
+    MirPixelFormat pixel_format() const override { return mir_pixel_format_argb_8888; }
+    mg::NativeBufferBase* native_buffer_base() override { return nullptr; }
+
+private:
+    mg::BufferID const id_;
+};
+}
+
+/*
+ * Has one thread submitting buffers to a stream's schedule while several
+ * compositor threads do what a compositor does on each frame: check whether
+ * the stream has a buffer ready, and acquire it if so.
+ *
+ * Contention only shows with the threads on separate cores: on a single
+ * core they are time-sliced, and this measures the cost per operation.
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 3 || argc > 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of compositors> <frames per thread> [queueing|dropping]"<<std::endl;
+        exit(1);
+    }
+
+    int const compositor_count = std::atoi(argv[1]);
+    uint64_t const frame_count = std::atoll(argv[2]);
+    bool const dropping = argc > 3 && strcmp(argv[3], "dropping") == 0;
+
+    if (compositor_count < 1)
+    {
+        std::cout<<"Compositor count must be positive"<<std::endl;
+        exit(1);
+    }
+
+    std::shared_ptr<mc::Schedule> const schedule = dropping ?
+        std::shared_ptr<mc::Schedule>{std::make_shared<mc::DroppingSchedule>()} :
+        std::shared_ptr<mc::Schedule>{std::make_shared<mc::QueueingSchedule>()};
+    mc::MultiMonitorArbiter arbiter{schedule};
+
+    std::vector<std::shared_ptr<mg::Buffer>> buffers;
+    for (uint32_t i = 0; i != 3; ++i)
+        buffers.push_back(std::make_shared<BenchmarkBuffer>(i + 1));
+
+    // Give the compositors something to start with
+    schedule->schedule(buffers[0]);
+
+    std::atomic<bool> go{false};
+    std::vector<uint64_t> acquisitions(compositor_count);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < compositor_count; ++i)
+    {
+        threads.emplace_back([&, i]
+        {
+            auto const id = &acquisitions[i];
+            uint64_t acquired{0};
+
+            while (!go)
+                std::this_thread::yield();
+
+            for (uint64_t frame = 0; frame != frame_count; ++frame)
+            {
+                if (arbiter.buffer_ready_for(id))
+                {
+                    arbiter.compositor_acquire(id);
+                    ++acquired;
+                }
+            }
+
+            acquisitions[i] = acquired;
+        });
+    }
+
+    threads.emplace_back([&]
+    {
+        while (!go)
+            std::this_thread::yield();
+
+        for (uint64_t frame = 0; frame != frame_count; ++frame)
+            schedule->schedule(buffers[frame % buffers.size()]);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto duration = std::chrono::steady_clock::now() - start;
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+    uint64_t total_acquisitions{0};
+    for (auto const acquired : acquisitions)
+        total_acquisitions += acquired;
+
+    auto const operations = frame_count * (compositor_count + 1);
+    std::cout<<"Submitting and checking "<<frame_count<<" frames with "<<compositor_count<<" compositors"
+             <<" ("<<(dropping ? "dropping" : "queueing")<<") took "<<ns<<"ns"
+             <<" ("<<static_cast<uint64_t>(operations * 1e9 / ns)<<" operations/s, "
+             <<total_acquisitions<<" buffers acquired)"<<std::endl;
+    exit(0);
+}
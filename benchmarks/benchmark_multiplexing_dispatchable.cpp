@@ -18,10 +18,14 @@
 
 #include "mir/dispatch/multiplexing_dispatchable.h"
 
+#include <atomic>
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <string>
 #include <chrono>
+#include <cstdlib>
+#include <system_error>
 #include <thread>
 #include <poll.h>
 #include <unistd.h>
@@ -56,8 +60,7 @@ public:
     }
     bool dispatch(md::FdEvents) override
     {
-        ++dispatch_count;
-        return (dispatch_count < dispatch_limit);
+        return (++dispatch_count < dispatch_limit);
     }
     md::FdEvents relevant_events() const override
     {
@@ -65,13 +68,11 @@ public:
     }
 
 private:
-    static thread_local uint64_t dispatch_count;
+    std::atomic<uint64_t> dispatch_count{0};
     uint64_t const dispatch_limit;
     mir::Fd read_fd, write_fd;
 };
 
-thread_local uint64_t TestDispatchable::dispatch_count = 0;
-
 bool fd_is_readable(int fd)
 {
     struct pollfd poller {
@@ -84,17 +85,32 @@ bool fd_is_readable(int fd)
 
 int main(int argc, char** argv)
 {
-    if (argc != 3)
+    if (argc < 3 || argc > 6)
     {
-        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count>"<<std::endl;
+        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count> [<number of fds> [<batch size> [sequential]]]"<<std::endl;
         exit(1);
     }
 
     int const thread_count = std::atoi(argv[1]);
     uint64_t const dispatch_count = std::atoll(argv[2]);
+    int const fd_count = argc > 3 ? std::atoi(argv[3]) : 1;
+    int const batch_size = argc > 4 ? std::atoi(argv[4]) : 1;
+    // Sequential dispatchees are what the client RPC channel and the X11 readers use
+    bool const sequential = argc > 5 && std::string{argv[5]} == "sequential";
 
-    auto dispatcher = std::make_shared<md::MultiplexingDispatchable>();
-    dispatcher->add_watch(std::make_shared<TestDispatchable>(dispatch_count / thread_count), md::DispatchReentrancy::reentrant);
+    if (thread_count < 1 || fd_count < 1 || batch_size < 1)
+    {
+        std::cout<<"Thread, fd and batch counts must be positive"<<std::endl;
+        exit(1);
+    }
+
+    auto dispatcher = std::make_shared<md::MultiplexingDispatchable>(batch_size);
+    for (int i = 0; i < fd_count; ++i)
+    {
+        dispatcher->add_watch(
+            std::make_shared<TestDispatchable>(dispatch_count / fd_count),
+            sequential ? md::DispatchReentrancy::sequential : md::DispatchReentrancy::reentrant);
+    }
 
     auto start = std::chrono::steady_clock::now();
 
@@ -116,6 +132,9 @@ int main(int argc, char** argv)
     }
 
     auto duration = std::chrono::steady_clock::now() - start;
-    std::cout<<"Dispatching "<<dispatch_count<<" times took "<<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()<<"ns"<<std::endl;
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    std::cout<<"Dispatching "<<dispatch_count<<" times over "<<fd_count<<" fds on "<<thread_count<<" threads"
+             <<" (batch size "<<batch_size<<(sequential ? ", sequential" : "")<<") took "<<ns<<"ns"
+             <<" ("<<static_cast<uint64_t>(dispatch_count * 1e9 / ns)<<" events/s)"<<std::endl;
     exit(0);
 }
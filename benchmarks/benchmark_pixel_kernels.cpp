@@ -0,0 +1,101 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_kernels.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace mgp = mir::graphics::pixel;
+
+namespace
+{
+/// Runs op over an image repeatedly and reports the rate pixels are read (or written, for fills)
+void measure(char const* what, mgp::Kernels const& kernels, size_t pixel_count, int repeats, std::function<void()> const& op)
+{
+    op(); // Fault everything in first
+
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i != repeats; ++i)
+        op();
+    auto const duration = std::chrono::steady_clock::now() - start;
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+    auto const bytes = double(pixel_count) * sizeof(uint32_t) * repeats;
+    std::cout<<std::setw(16)<<std::left<<what<<std::setw(8)<<kernels.name
+             <<std::fixed<<std::setprecision(2)<<bytes / ns<<" GB/s"<<std::endl;
+}
+}
+
+/*
+ * Times each of the pixel kernels the CPU supports on a width x height image
+ * (by default the size of a 1080p screen).
+ */
+int main(int argc, char** argv)
+{
+    if (argc > 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" [<width> <height> [<repeats>]]"<<std::endl;
+        exit(1);
+    }
+
+    size_t const width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    size_t const height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    int const repeats = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    if (width < 1 || height < 1 || repeats < 1)
+    {
+        std::cout<<"Width, height and repeats must be positive"<<std::endl;
+        exit(1);
+    }
+
+    auto const pixel_count = width * height;
+    std::vector<uint32_t> src(pixel_count);
+    std::vector<uint32_t> dst(pixel_count);
+    for (size_t i = 0; i != pixel_count; ++i)
+        src[i] = uint32_t(i * 2654435761u);
+
+    std::cout<<"Pixel kernels on a "<<width<<"x"<<height<<" image, best are \""
+             <<mgp::best_kernels().name<<"\""<<std::endl;
+
+    for (auto const kernels : mgp::supported_kernels())
+    {
+        measure("swap_red_blue", *kernels, pixel_count, repeats,
+            [&] { kernels->swap_red_blue(src.data(), dst.data(), pixel_count); });
+
+        measure("reverse", *kernels, pixel_count, repeats,
+            [&]
+            {
+                for (size_t row = 0; row != height; ++row)
+                    kernels->reverse(src.data() + row * width, dst.data() + row * width, width);
+            });
+
+        measure("fill", *kernels, pixel_count, repeats,
+            [&] { kernels->fill(dst.data(), pixel_count, 0xff336699); });
+
+        measure("rotate_cw", *kernels, pixel_count, repeats,
+            [&] { kernels->rotate_clockwise(src.data(), width, width, height, dst.data(), height); });
+
+        measure("rotate_acw", *kernels, pixel_count, repeats,
+            [&] { kernels->rotate_anticlockwise(src.data(), width, width, height, dst.data(), height); });
+    }
+
+    exit(0);
+}
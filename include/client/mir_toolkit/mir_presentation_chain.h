@@ -68,6 +68,25 @@ void mir_presentation_chain_submit_buffer(
     MirPresentationChain* presentation_chain, MirBuffer* buffer,
     MirBufferCallback available_callback, void* available_context);
 
+/** Submit a buffer to the server to be displayed at a given time.
+ *
+ *  The server holds the buffer back until it is due, then presents it in
+ *  place of any buffers due before it. As with
+ *  mir_presentation_chain_submit_buffer(), the server will notify the client
+ *  when the buffer is available again.
+ *
+ *   \param [in] presentation_chain     The presentation chain
+ *   \param [in] buffer                 The buffer to be submitted
+ *   \param [in] target_time            The CLOCK_MONOTONIC time (in
+ *                                      nanoseconds) to present the buffer at
+ *   \param [in] available_callback     The callback called when the buffer
+ *                                      is available
+ *   \param [in] available_context      The context for the available_callback
+ **/
+void mir_presentation_chain_submit_buffer_at(
+    MirPresentationChain* presentation_chain, MirBuffer* buffer, int64_t target_time,
+    MirBufferCallback available_callback, void* available_context);
+
 #ifdef __cplusplus
 }
 /**@}*/
@@ -200,6 +200,31 @@ void mir_screencast_capture_to_buffer(
  **/
 MirScreencastResult mir_screencast_capture_to_buffer_sync(MirScreencast* screencast, MirBuffer* buffer);
 
+/**
+ * Get the number of rectangles making up the area that changed in the most
+ * recent capture.
+ *
+ * For a screencast captured with mir_screencast_capture_to_buffer(), this is
+ * the last capture to complete; otherwise it is the capture into the current
+ * buffer of the screencast's buffer stream. No rectangles means nothing had
+ * changed since the capture before.
+ *
+ *   \param [in] screencast  The screencast
+ *   eturn                 The number of damage rectangles
+ */
+unsigned int mir_screencast_get_num_damage_rectangles(MirScreencast* screencast);
+
+/**
+ * Get a rectangle of the area that changed in the most recent capture, in
+ * buffer coordinates.
+ *
+ *   \pre                    index < mir_screencast_get_num_damage_rectangles(screencast)
+ *   \param [in] screencast  The screencast
+ *   \param [in] index       The index of the rectangle
+ *   eturn                 The damage rectangle
+ */
+MirRectangle mir_screencast_get_damage_rectangle(MirScreencast* screencast, unsigned int index);
+
 #ifdef __cplusplus
 }
 /**@}*/
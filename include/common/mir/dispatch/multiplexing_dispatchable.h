@@ -22,9 +22,11 @@
 #include "mir/dispatch/dispatchable.h"
 #include "mir/posix_rw_mutex.h"
 
+#include <cstddef>
 #include <functional>
 #include <initializer_list>
 #include <list>
+#include <memory>
 #include <mutex>
 
 #include <pthread.h>
@@ -53,7 +55,18 @@ enum class DispatchReentrancy
 class MultiplexingDispatchable final : public Dispatchable
 {
 public:
+    /// The most ready dispatchees a single dispatch() can handle
+    static std::size_t const max_batch_size = 32;
+
     MultiplexingDispatchable();
+    /**
+     * \param [in] batch_size  How many ready dispatchees each dispatch() collects
+     *                         and dispatches in turn (up to max_batch_size).
+     *                         Batching saves a wakeup and an epoll_wait() per
+     *                         dispatchee, at the expense of parallelism when several
+     *                         threads call dispatch().
+     */
+    explicit MultiplexingDispatchable(std::size_t batch_size);
     MultiplexingDispatchable(std::initializer_list<std::shared_ptr<Dispatchable>> dispatchees);
     virtual ~MultiplexingDispatchable() noexcept;
 
@@ -95,8 +108,11 @@ public:
      */
     void remove_watch(Fd const& fd);
 private:
+    struct Watch;
+
+    std::size_t const batch_size;
     PosixRWMutex lifetime_mutex;
-    std::list<std::pair<std::shared_ptr<Dispatchable>, bool>> dispatchee_holder;
+    std::list<std::shared_ptr<Watch>> dispatchee_holder;
 
     Fd epoll_fd;
 };
@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GEOMETRY_REGION_H_
+#define MIR_GEOMETRY_REGION_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/displacement.h"
+
+#include <vector>
+#include <initializer_list>
+#include <iosfwd>
+
+namespace mir
+{
+namespace geometry
+{
+
+/**
+ * An area made up of non-overlapping rectangles.
+ *
+ * The rectangles are kept in "y-x banded" form (as in pixman and X11):
+ * sorted by top edge and then by left edge, with the rectangles in each
+ * horizontal band sharing the same top and bottom. Vertically adjacent
+ * bands with identical horizontal extents are merged, so equal areas have
+ * equal representations.
+ */
+class Region
+{
+public:
+    Region();
+    Region(Rectangle const& rect);
+    Region(std::initializer_list<Rectangle> const& rects);
+    explicit Region(std::vector<Rectangle> const& rects);
+    /* We want to keep implicit copy and move methods */
+
+    /// Adds the area of other to this region
+    void unite(Region const& other);
+    /// Removes the area of other from this region
+    void subtract(Region const& other);
+    /// Restricts this region to the area it shares with other
+    void intersect(Region const& other);
+    void translate(Displacement const& d);
+    void clear();
+
+    bool empty() const;
+    bool contains(Rectangle const& rect) const;
+    bool overlaps(Rectangle const& rect) const;
+    Rectangle bounding_rectangle() const;
+
+    typedef std::vector<Rectangle>::const_iterator const_iterator;
+    typedef std::vector<Rectangle>::size_type size_type;
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_type size() const;
+
+    bool operator==(Region const& other) const;
+    bool operator!=(Region const& other) const;
+
+private:
+    std::vector<Rectangle> rectangles;
+};
+
+std::ostream& operator<<(std::ostream& out, Region const& value);
+}
+}
+
+#endif /* MIR_GEOMETRY_REGION_H_ */
@@ -24,6 +24,7 @@
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
+#include <cstdint>
 
 namespace mir
 {
@@ -73,6 +74,21 @@ public:
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
 
     virtual unsigned int swap_interval() const = 0;
+
+    /**
+     * The parts of a shaped renderable (in screen coordinates) that the
+     * client has declared fully opaque in spite of the pixel format.
+     * Empty if nothing is known to be opaque.
+     */
+    virtual std::vector<geometry::Rectangle> opaque_region() const = 0;
+
+    /**
+     * Changes whenever the content of buffer() may have changed, even if
+     * its BufferID has not (as when a client refills and resubmits a buffer).
+     * Zero if this isn't tracked, in which case the content must be assumed
+     * to change whenever the buffer is released.
+     */
+    virtual uint64_t content_serial() const = 0;
 protected:
     Renderable() = default;
     Renderable(Renderable const&) = delete;
@@ -20,8 +20,11 @@
 #ifndef MIR_PLATFORM_GRAPHICS_WAYLAND_ALLOCATOR_H_
 #define MIR_PLATFORM_GRAPHICS_WAYLAND_ALLOCATOR_H_
 
+#include "mir/geometry/rectangle.h"
+
 #include <memory>
 #include <functional>
+#include <vector>
 
 #include <wayland-server-core.h>
 
@@ -33,6 +36,24 @@ namespace graphics
 {
 class Buffer;
 
+/**
+ * Per-surface state shared by the successive SHM buffers committed to one surface
+ *
+ * This is opaque to the frontend, which just keeps one for each surface and
+ * passes it with every SHM buffer of that surface it imports. A WaylandAllocator
+ * may use it to keep GPU storage alive between buffers, so that only the damaged
+ * region of each new buffer needs uploading.
+ */
+class ShmSurfaceState
+{
+public:
+    ShmSurfaceState() = default;
+    virtual ~ShmSurfaceState();
+
+    ShmSurfaceState(ShmSurfaceState const&) = delete;
+    ShmSurfaceState& operator=(ShmSurfaceState const&) = delete;
+};
+
 class WaylandAllocator
 {
 public:
@@ -47,10 +68,23 @@ public:
         wl_resource* buffer,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) = 0;
+    /**
+     * Import a wl_shm buffer committed to a surface
+     *
+     * \param [in]     buffer           The wl_shm buffer
+     * \param [in]     wayland_executor An Executor that defers work to the Wayland event loop
+     * \param [in]     on_consumed      Called when the compositor has consumed the buffer
+     * \param [in,out] surface_state    State shared by all SHM buffers of this surface.
+     *                                  The allocator may (re)create it as it sees fit.
+     * \param [in]     damage           The region of the buffer, in buffer coordinates,
+     *                                  that differs from the previous buffer of the surface
+     */
     virtual auto buffer_from_shm(
         wl_resource* buffer,
         std::shared_ptr<mir::Executor> wayland_executor,
-        std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer> = 0;
+        std::function<void()>&& on_consumed,
+        std::shared_ptr<ShmSurfaceState>& surface_state,
+        std::vector<geometry::Rectangle> const& damage) -> std::shared_ptr<Buffer> = 0;
 };
 }
 }
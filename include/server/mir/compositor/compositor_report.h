@@ -21,6 +21,8 @@
 
 #include "mir/graphics/renderable.h"
 
+#include <cstddef>
+
 namespace mir
 {
 namespace compositor
@@ -38,6 +40,11 @@ public:
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
+    /// Textures kept by a renderer's cache, and those it has freed so far
+    virtual void texture_cache_usage(
+        SubCompositorId id,
+        size_t textures, size_t bytes,
+        size_t evicted_textures, size_t evicted_bytes) = 0;
 protected:
     CompositorReport() = default;
     virtual ~CompositorReport() = default;
@@ -22,6 +22,7 @@
 #include <mir_toolkit/common.h>
 #include "mir/graphics/buffer_id.h"
 #include "mir/geometry/size.h"
+#include "mir/time/types.h"
 #include <functional>
 #include <memory>
 
@@ -42,6 +43,8 @@ public:
     virtual ~BufferStream() = default;
 
     virtual void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) = 0;
+    /// Submits a buffer to be presented at (or as soon as possible after) target
+    virtual void submit_buffer_at(std::shared_ptr<graphics::Buffer> const& buffer, time::Timestamp target) = 0;
 
     virtual void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) = 0;
@@ -41,6 +41,8 @@ struct StreamInfo
     std::shared_ptr<compositor::BufferStream> stream;
     geometry::Displacement displacement;
     optional_value<geometry::Size> size;
+    /// Parts of the stream (relative to its top left) declared fully opaque
+    std::vector<geometry::Rectangle> opaque_region = {};
 };
 
 class SurfaceObserver;
@@ -87,6 +89,8 @@ public:
      * set_input_region({Rectangle{}}).
      */
     virtual void set_input_region(std::vector<geometry::Rectangle> const& region) = 0;
+    /// The custom input region (empty if none has been set)
+    virtual auto input_region() const -> std::vector<geometry::Rectangle> = 0;
     /// Given value is the frame size of the window
     virtual void resize(geometry::Size const& window_size) = 0;
     virtual void set_transformation(glm::mat4 const& t) = 0;
@@ -74,6 +74,7 @@ public:
     virtual void start_drag_and_drop(Surface const* surf, std::vector<uint8_t> const& handle) = 0;
     virtual void depth_layer_set_to(Surface const* surf, MirDepthLayer depth_layer) = 0;
     virtual void application_id_set_to(Surface const* surf, std::string const& application_id) = 0;
+    virtual void input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region) = 0;
 
 protected:
     SurfaceObserver() = default;
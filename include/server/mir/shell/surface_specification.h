@@ -50,6 +50,8 @@ struct StreamSpecification
     std::weak_ptr<frontend::BufferStream> stream;
     geometry::Displacement displacement;
     optional_value<geometry::Size> size;
+    /// Parts of the stream (relative to its top left) declared fully opaque
+    std::vector<geometry::Rectangle> opaque_region = {};
 };
 auto operator==(StreamSpecification const& lhs, StreamSpecification const& rhs) -> bool;
 
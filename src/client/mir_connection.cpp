@@ -1002,7 +1002,7 @@ void MirConnection::stream_error(std::string const& error_msg, std::shared_ptr<S
     request->wh->result_received();
 }
 
-std::shared_ptr<MirBufferStream> MirConnection::make_consumer_stream(
+std::shared_ptr<mcl::ScreencastStream> MirConnection::make_consumer_stream(
    mp::BufferStream const& protobuf_bs)
 {
     return std::make_shared<mcl::ScreencastStream>(
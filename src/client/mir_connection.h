@@ -69,6 +69,7 @@ class AsyncBufferFactory;
 class MirBuffer;
 class BufferStream;
 class PresentationChain;
+class ScreencastStream;
 
 namespace rpc
 {
@@ -140,7 +141,7 @@ public:
     void available_surface_formats(MirPixelFormat* formats,
                                    unsigned int formats_size, unsigned int& valid_formats);
 
-    std::shared_ptr<MirBufferStream> make_consumer_stream(
+    std::shared_ptr<mir::client::ScreencastStream> make_consumer_stream(
        mir::protobuf::BufferStream const& protobuf_bs);
 
 #pragma GCC diagnostic push
@@ -28,6 +28,7 @@ class MirPresentationChain
 public:
     virtual ~MirPresentationChain() = default;
     virtual void submit_buffer(mir::client::MirBuffer* buffer) = 0;
+    virtual void submit_buffer_at(mir::client::MirBuffer* buffer, int64_t target_time) = 0;
     virtual MirConnection* connection() const = 0;
     virtual int rpc_id() const = 0;
     virtual char const* error_msg() const = 0;
@@ -46,6 +46,23 @@ catch (std::exception const& ex)
     MIR_LOG_UNCAUGHT_EXCEPTION(ex);
 }
 
+void mir_presentation_chain_submit_buffer_at(
+    MirPresentationChain* chain,
+    MirBuffer* b,
+    int64_t target_time,
+    MirBufferCallback available_callback, void* available_context)
+try
+{
+    auto buffer = reinterpret_cast<mcl::MirBuffer*>(b);
+    mir::require(chain && buffer && mir_presentation_chain_is_valid(chain));
+    buffer->set_callback(available_callback, available_context);
+    chain->submit_buffer_at(buffer, target_time);
+}
+catch (std::exception const& ex)
+{
+    MIR_LOG_UNCAUGHT_EXCEPTION(ex);
+}
+
 bool mir_presentation_chain_is_valid(MirPresentationChain* chain)
 try
 {
@@ -18,6 +18,7 @@
 
 #include "mir_screencast.h"
 #include "mir_connection.h"
+#include "screencast_stream.h"
 #include "mir_protobuf.pb.h"
 #include "make_protobuf_object.h"
 #include "mir/mir_buffer_stream.h"
@@ -237,6 +238,16 @@ MirBufferStream* MirScreencast::get_buffer_stream()
     return buffer_stream.get();
 }
 
+std::vector<MirRectangle> MirScreencast::capture_damage()
+{
+    std::lock_guard<decltype(mutex)> lock(mutex);
+    if (buffer_capture_damage.is_set())
+        return buffer_capture_damage.value();
+    if (buffer_stream)
+        return buffer_stream->capture_damage();
+    return {};
+}
+
 void MirScreencast::screencast_done(ScreencastRequest* request)
 {
     auto const status = request->response.has_error() ? mir_screencast_error_failure : mir_screencast_success;
@@ -255,6 +266,14 @@ void MirScreencast::screencast_done(ScreencastRequest* request)
     std::unique_ptr<ScreencastRequest> request_holder;
     {
         std::unique_lock<decltype(mutex)> lk(mutex);
+        if (status == mir_screencast_success)
+        {
+            std::vector<MirRectangle> damage;
+            for (auto const& rect : request->response.damage())
+                damage.push_back({rect.left(), rect.top(), rect.width(), rect.height()});
+            buffer_capture_damage = damage;
+        }
+
         auto it = std::find_if(requests.begin(), requests.end(),
                                [&request](auto const& it)
                                { return it.get() == request; });
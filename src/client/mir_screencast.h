@@ -29,6 +29,7 @@
 #include <EGL/eglplatform.h>
 
 #include <memory>
+#include <vector>
 
 namespace mir
 {
@@ -40,6 +41,7 @@ class Void;
 namespace client
 {
 class MirBuffer;
+class ScreencastStream;
 namespace rpc
 {
 class DisplayServer;
@@ -87,6 +89,8 @@ public:
 
     MirBufferStream* get_buffer_stream();
 
+    std::vector<MirRectangle> capture_damage();
+
     void screencast_to_buffer(
         mir::client::MirBuffer* buffer,
         MirScreencastBufferCallback available_callback,
@@ -101,7 +105,7 @@ private:
     std::mutex mutable mutex;
     mir::client::rpc::DisplayServer* const server{nullptr};
     MirConnection* const connection{nullptr};
-    std::shared_ptr<MirBufferStream> buffer_stream;
+    std::shared_ptr<mir::client::ScreencastStream> buffer_stream;
 
     std::unique_ptr<mir::protobuf::Screencast> const protobuf_screencast;
     std::unique_ptr<mir::protobuf::Void> const protobuf_void;
@@ -123,10 +127,13 @@ private:
         mir::client::MirBuffer* buffer;
         MirScreencastBufferCallback available_callback;
         void* available_context;
-        mir::protobuf::Void response;
+        mir::protobuf::ScreencastCapture response;
     };
     std::vector<std::unique_ptr<ScreencastRequest>> requests;
     void screencast_done(ScreencastRequest* request);
+
+    /// Set once a capture to a buffer completes
+    mir::optional_value<std::vector<MirRectangle>> buffer_capture_damage;
 };
 
 #endif /* MIR_CLIENT_MIR_SCREENCAST_H_ */
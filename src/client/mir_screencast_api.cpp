@@ -168,3 +168,29 @@ catch (std::exception const& ex)
     MIR_LOG_UNCAUGHT_EXCEPTION(ex);
     return mir_screencast_error_failure;
 }
+
+unsigned int mir_screencast_get_num_damage_rectangles(MirScreencast* screencast)
+try
+{
+    mir::require(screencast);
+    return screencast->capture_damage().size();
+}
+catch (std::exception const& ex)
+{
+    MIR_LOG_UNCAUGHT_EXCEPTION(ex);
+    return 0;
+}
+
+MirRectangle mir_screencast_get_damage_rectangle(MirScreencast* screencast, unsigned int index)
+try
+{
+    mir::require(screencast);
+    auto const damage = screencast->capture_damage();
+    mir::require(index < damage.size());
+    return damage[index];
+}
+catch (std::exception const& ex)
+{
+    MIR_LOG_UNCAUGHT_EXCEPTION(ex);
+    return MirRectangle{0, 0, 0, 0};
+}
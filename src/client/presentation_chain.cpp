@@ -60,6 +60,18 @@ static void ignore_response(mp::Void* response)
 void mcl::PresentationChain::submit_buffer(MirBuffer* buffer)
 {
     mp::BufferRequest request;
+    submit(buffer, request);
+}
+
+void mcl::PresentationChain::submit_buffer_at(MirBuffer* buffer, int64_t target_time)
+{
+    mp::BufferRequest request;
+    request.set_target_time(target_time);
+    submit(buffer, request);
+}
+
+void mcl::PresentationChain::submit(MirBuffer* buffer, mp::BufferRequest& request)
+{
     {
         request.mutable_id()->set_value(stream_id);
         request.mutable_buffer()->set_buffer_id(buffer->rpc_id());
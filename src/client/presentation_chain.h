@@ -50,6 +50,7 @@ public:
         std::shared_ptr<ClientBufferFactory> const& native_buffer_factory,
         std::shared_ptr<AsyncBufferFactory> const& mir_buffer_factory);
     void submit_buffer(MirBuffer* buffer) override;
+    void submit_buffer_at(MirBuffer* buffer, int64_t target_time) override;
     MirConnection* connection() const override;
     int rpc_id() const override;
     char const* error_msg() const override;
@@ -57,6 +58,7 @@ public:
     void set_queueing_mode() override;
 
 private:
+    void submit(MirBuffer* buffer, mir::protobuf::BufferRequest& request);
 
     MirConnection* const connection_;
     int const stream_id;
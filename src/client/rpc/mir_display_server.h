@@ -97,7 +97,7 @@ public:
         google::protobuf::Closure* done) override;
     void screencast_to_buffer(
         mir::protobuf::ScreencastRequest const* request,
-        mir::protobuf::Void* response,
+        mir::protobuf::ScreencastCapture* response,
         google::protobuf::Closure* done) override;
     void release_screencast(
         mir::protobuf::ScreencastId const* request,
@@ -81,8 +81,12 @@ mclr::MirProtobufRpcChannel::MirProtobufRpcChannel(
     disconnected(false),
     transport{std::move(transport)},
     delayed_processor{std::make_shared<md::ActionQueue>()},
-    multiplexer{this->transport, delayed_processor}
+    // Only the RPC thread dispatches this, so batching costs no parallelism
+    multiplexer{md::MultiplexingDispatchable::max_batch_size}
 {
+    multiplexer.add_watch(this->transport);
+    multiplexer.add_watch(delayed_processor);
+
     class NullDeleter
     {
     public:
@@ -189,6 +189,15 @@ void mcl::ScreencastStream::swap_buffers_sync()
     swap_buffers([](){})->wait_for_all();
 }
 
+std::vector<MirRectangle> mcl::ScreencastStream::capture_damage() const
+{
+    std::lock_guard<decltype(mutex)> lock(mutex);
+    std::vector<MirRectangle> damage;
+    for (auto const& rect : protobuf_bs->buffer().damage())
+        damage.push_back({rect.left(), rect.top(), rect.width(), rect.height()});
+    return damage;
+}
+
 uint32_t mcl::ScreencastStream::get_current_buffer_id()
 {
     std::lock_guard<decltype(mutex)> lock(mutex);
@@ -32,6 +32,7 @@
 #include <queue>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace google
 {
@@ -108,6 +109,9 @@ public:
     MirRenderSurface* render_surface() const override;
 #pragma GCC diagnostic pop
 
+    /// The area the capture into the current buffer changed, in buffer coordinates
+    std::vector<MirRectangle> capture_damage() const;
+
 private:
     void process_buffer(protobuf::Buffer const& buffer);
     void process_buffer(protobuf::Buffer const& buffer, std::unique_lock<std::mutex>&);
@@ -31,6 +31,7 @@
 #include <string.h>
 #include <system_error>
 #include <algorithm>
+#include <atomic>
 
 namespace md = mir::dispatch;
 
@@ -71,8 +72,29 @@ private:
 
 }
 
+size_t const md::MultiplexingDispatchable::max_batch_size;
+
+struct md::MultiplexingDispatchable::Watch
+{
+    Watch(std::shared_ptr<Dispatchable> const& dispatchee, bool rearm)
+        : dispatchee{dispatchee},
+          rearm{rearm}
+    {
+    }
+
+    std::shared_ptr<Dispatchable> const dispatchee;
+    bool const rearm;   // Sequential: watched with EPOLLONESHOT and rearmed after dispatch
+    std::atomic<bool> removed{false};
+};
+
 md::MultiplexingDispatchable::MultiplexingDispatchable()
-    : lifetime_mutex{PosixRWMutex::Type::PreferWriterNonRecursive},
+    : MultiplexingDispatchable(1)
+{
+}
+
+md::MultiplexingDispatchable::MultiplexingDispatchable(size_t batch_size)
+    : batch_size{std::min(std::max(batch_size, size_t{1}), max_batch_size)},
+      lifetime_mutex{PosixRWMutex::Type::PreferWriterNonRecursive},
       epoll_fd{mir::Fd{::epoll_create1(EPOLL_CLOEXEC)}}
 {
     if (epoll_fd == mir::Fd::invalid)
@@ -108,43 +130,71 @@ bool md::MultiplexingDispatchable::dispatch(md::FdEvents events)
         return false;
     }
 
-    std::shared_ptr<md::Dispatchable> source;
-    bool rearm_source{false};
-    epoll_event event;
+    epoll_event ready[max_batch_size];
+    std::shared_ptr<Watch> watches[max_batch_size];
+    int ready_count;
 
     {
         std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
 
-        auto result = epoll_wait(epoll_fd, &event, 1, 0);
+        ready_count = epoll_wait(epoll_fd, ready, static_cast<int>(batch_size), 0);
 
-        if (result < 0)
+        if (ready_count < 0)
         {
             BOOST_THROW_EXCEPTION((std::system_error{errno,
                                                      std::system_category(),
                                                      "Failed to wait on fds"}));
         }
 
-        if (result == 0)
+        if (ready_count == 0)
         {
             // Some other thread must have stolen the event we were woken for;
             // that's ok, just return.
             return true;
         }
 
-        auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(event.data.ptr);
-
-        source = event_source->first;
-        rearm_source = event_source->second;
+        for (int i = 0; i != ready_count; ++i)
+            watches[i] = *static_cast<decltype(dispatchee_holder)::pointer>(ready[i].data.ptr);
     }
 
-    if (!source->dispatch(epoll_to_fd_event(event)))
+    auto const rearm = [this](Watch const& watch, epoll_event& event)
+        {
+            event.events = fd_event_to_epoll(watch.dispatchee->relevant_events()) | EPOLLONESHOT;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, watch.dispatchee->watch_fd(), &event);
+        };
+
+    int next{0};
+    try
     {
-        remove_watch(source);
+        for (; next != ready_count; ++next)
+        {
+            auto const& watch = *watches[next];
+
+            // An earlier dispatchee in the batch may have removed this one
+            if (watch.removed)
+                continue;
+
+            if (!watch.dispatchee->dispatch(epoll_to_fd_event(ready[next])))
+            {
+                remove_watch(watch.dispatchee);
+            }
+            else if (watch.rearm)
+            {
+                rearm(watch, ready[next]);
+            }
+        }
     }
-    else if (rearm_source)
+    catch (...)
     {
-        event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
-        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        // The sequential dispatchees we didn't get to would otherwise never
+        // be dispatched again
+        for (++next; next < ready_count; ++next)
+        {
+            auto const& watch = *watches[next];
+            if (watch.rearm && !watch.removed)
+                rearm(watch, ready[next]);
+        }
+        throw;
     }
 
     return true;
@@ -167,8 +217,9 @@ void md::MultiplexingDispatchable::add_watch(std::shared_ptr<md::Dispatchable> c
     {
         std::unique_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
         new_holder = dispatchee_holder.emplace(dispatchee_holder.begin(),
-                                               dispatchee,
-                                               reentrancy == DispatchReentrancy::sequential);
+                                               std::make_shared<Watch>(
+                                                   dispatchee,
+                                                   reentrancy == DispatchReentrancy::sequential));
     }
 
     epoll_event e;
@@ -223,8 +274,12 @@ void md::MultiplexingDispatchable::remove_watch(Fd const& fd)
     }
 
     std::unique_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
-    dispatchee_holder.remove_if([&fd](std::pair<std::shared_ptr<Dispatchable>,bool> const& candidate)
+    dispatchee_holder.remove_if([&fd](std::shared_ptr<Watch> const& candidate)
     {
-        return candidate.first->watch_fd() == fd;
+        if (candidate->dispatchee->watch_fd() != fd)
+            return false;
+
+        candidate->removed = true;
+        return true;
     });
 }
@@ -36,9 +36,224 @@
 
 #include <capnp/serialize.h>
 
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
 
 namespace ml = mir::logging;
 
+namespace
+{
+/**
+ * Fixed-size blocks, cached by the thread that allocated them
+ *
+ * Events are mostly built on one thread (input) and released on another
+ * (wherever they are delivered), so a released block goes back to the cache
+ * of the thread it came from. Other threads push it onto that cache's
+ * lock-free list of returns, and the owning thread takes the whole list over
+ * in one exchange when its own list runs out. (Only ever taking the whole
+ * list means there is no ABA problem with concurrent pops.)
+ *
+ * A cache outlives its thread: when the thread exits the cached blocks are
+ * freed and the cache is kept for the next new thread, so a block released
+ * late always has somewhere to go. A cache holds no more blocks than its
+ * threads have had allocated at once.
+ *
+ * Newly allocated blocks are zeroed.
+ */
+template<std::size_t block_size>
+class BlockPool
+{
+public:
+    static void* allocate();
+    static void release(void* payload);
+
+private:
+    struct Cache;
+
+    struct Block
+    {
+        Cache* home;
+        Block* next;
+        alignas(std::max_align_t) unsigned char payload[block_size];
+    };
+
+    struct Cache
+    {
+        Block* local{nullptr};                  // Only used by the owning thread
+        std::atomic<Block*> returned{nullptr};  // Released here by other threads
+        Cache* next_spare{nullptr};
+    };
+
+    struct ThisThread
+    {
+        ThisThread();
+        ~ThisThread();
+
+        Cache* const cache;
+    };
+
+    static auto block_of(void* payload) -> Block*
+    {
+        return reinterpret_cast<Block*>(static_cast<unsigned char*>(payload) - offsetof(Block, payload));
+    }
+
+    static void delete_blocks(Block* list)
+    {
+        while (auto const block = list)
+        {
+            list = block->next;
+            delete block;
+        }
+    }
+
+    struct Spares
+    {
+        std::mutex mutex;
+        Cache* caches{nullptr};
+    };
+
+    // Never destroyed: threads may exit after static destructors have run
+    static auto spares() -> Spares&
+    {
+        static auto* const instance = new Spares;
+        return *instance;
+    }
+
+    static thread_local ThisThread this_thread;
+    // These outlive this_thread, so can be checked during thread exit
+    static thread_local Cache* current_cache;
+    static thread_local bool finished;
+};
+
+template<std::size_t block_size>
+thread_local typename BlockPool<block_size>::ThisThread BlockPool<block_size>::this_thread;
+
+template<std::size_t block_size>
+thread_local typename BlockPool<block_size>::Cache* BlockPool<block_size>::current_cache{nullptr};
+
+template<std::size_t block_size>
+thread_local bool BlockPool<block_size>::finished{false};
+
+template<std::size_t block_size>
+BlockPool<block_size>::ThisThread::ThisThread()
+    : cache{[]
+        {
+            auto& spare = spares();
+            {
+                std::lock_guard<std::mutex> lock{spare.mutex};
+                if (auto const cache = spare.caches)
+                {
+                    spare.caches = cache->next_spare;
+                    return cache;
+                }
+            }
+            return new Cache;
+        }()}
+{
+    current_cache = cache;
+}
+
+template<std::size_t block_size>
+BlockPool<block_size>::ThisThread::~ThisThread()
+{
+    finished = true;
+    current_cache = nullptr;
+
+    delete_blocks(cache->local);
+    cache->local = nullptr;
+    delete_blocks(cache->returned.exchange(nullptr, std::memory_order_acquire));
+
+    auto& spare = spares();
+    std::lock_guard<std::mutex> lock{spare.mutex};
+    cache->next_spare = spare.caches;
+    spare.caches = cache;
+}
+
+template<std::size_t block_size>
+void* BlockPool<block_size>::allocate()
+{
+    if (finished)
+        return (new Block{nullptr, nullptr, {}})->payload;
+
+    auto const cache = this_thread.cache;
+
+    if (!cache->local)
+        cache->local = cache->returned.exchange(nullptr, std::memory_order_acquire);
+
+    if (auto const block = cache->local)
+    {
+        cache->local = block->next;
+        return block->payload;
+    }
+
+    return (new Block{cache, nullptr, {}})->payload;
+}
+
+template<std::size_t block_size>
+void BlockPool<block_size>::release(void* payload)
+{
+    auto const block = block_of(payload);
+    auto const home = block->home;
+
+    if (!home)
+    {
+        delete block;
+    }
+    else if (home == current_cache)
+    {
+        block->next = home->local;
+        home->local = block;
+    }
+    else
+    {
+        block->next = home->returned.load(std::memory_order_relaxed);
+        while (!home->returned.compare_exchange_weak(
+            block->next, block, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+using EventBlocks = BlockPool<sizeof(MirEvent)>;
+std::size_t const segment_size = 1024;
+using SegmentBlocks = BlockPool<segment_size>;
+}
+
+void* MirEvent::operator new(std::size_t size)
+{
+    // All the event types share MirEvent's layout, but be defensive
+    if (size == sizeof(MirEvent))
+        return EventBlocks::allocate();
+
+    return ::operator new(size);
+}
+
+void MirEvent::operator delete(void* block, std::size_t size)
+{
+    if (size == sizeof(MirEvent))
+        EventBlocks::release(block);
+    else
+        ::operator delete(block);
+}
+
+MirEvent::FirstSegment::FirstSegment()
+    : segment{static_cast<::capnp::word*>(SegmentBlocks::allocate())}
+{
+    static_assert(sizeof(::capnp::word) * first_segment_words == segment_size, "segment_size mismatch");
+}
+
+MirEvent::FirstSegment::~FirstSegment()
+{
+    SegmentBlocks::release(segment);
+}
+
+kj::ArrayPtr<::capnp::word> MirEvent::FirstSegment::words() const
+{
+    return {segment, first_segment_words};
+}
+
 MirEvent::MirEvent(MirEvent const& e)
 {
     auto reader = e.event.asReader();
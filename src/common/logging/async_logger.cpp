@@ -0,0 +1,289 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+namespace ml = mir::logging;
+
+/// Lines logged by one thread, waiting to be written. Only that thread
+/// adds lines, and only the writer (holding output_mutex) removes them.
+struct ml::AsyncLogger::Ring
+{
+    struct Line
+    {
+        timespec time;
+        Severity severity;
+        std::string component;
+        std::string message;
+    };
+
+    explicit Ring(size_t size) : lines(size) {}
+
+    bool push(Severity severity, std::string const& message, std::string const& component)
+    {
+        auto const h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == lines.size())
+            return false;
+
+        // Reassigning the strings reuses their storage once it's big enough
+        auto& line = lines[h % lines.size()];
+        clock_gettime(CLOCK_REALTIME, &line.time);
+        line.severity = severity;
+        line.component.assign(component);
+        line.message.assign(message);
+
+        // (Sequentially consistent, to pair with AsyncLogger::writer_waiting)
+        head.store(h + 1);
+        return true;
+    }
+
+    template<typename Write>
+    bool drain(Write const& write)
+    {
+        auto const t = tail.load(std::memory_order_relaxed);
+        auto const h = head.load(std::memory_order_acquire);
+
+        for (auto i = t; i != h; ++i)
+            write(lines[i % lines.size()]);
+
+        tail.store(h, std::memory_order_release);
+        return t != h;
+    }
+
+    bool empty() const
+    {
+        return head.load() == tail.load(std::memory_order_relaxed);
+    }
+
+    std::vector<Line> lines;
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+
+    // Set when the logging thread exits: once drained the ring can go
+    std::atomic<bool> abandoned{false};
+};
+
+namespace
+{
+std::atomic<uint64_t> next_logger_id{0};
+
+void write_line(
+    std::ostream& out,
+    timespec const& time,
+    ml::Severity severity,
+    std::string const& component,
+    std::string const& message)
+{
+    static const char* lut[5] =
+    {
+        "< CRITICAL! > ",
+        "< - ERROR - > ",
+        "< -warning- > ",
+        "<information> ",
+        "< - debug - > "
+    };
+
+    tm local;
+    char now[32];
+    auto offset = strftime(now, sizeof(now), "%F %T", localtime_r(&time.tv_sec, &local));
+    snprintf(now+offset, sizeof(now)-offset, ".%06ld", time.tv_nsec / 1000);
+
+    out << "["
+        << now
+        << "] "
+        << lut[static_cast<int>(severity)]
+        << component
+        << ": "
+        << message
+        << '\n';
+}
+}
+
+ml::AsyncLogger::AsyncLogger()
+    : AsyncLogger{std::cout, std::cerr, default_lines_per_thread}
+{
+}
+
+ml::AsyncLogger::AsyncLogger(std::ostream& out, std::ostream& err, size_t lines_per_thread)
+    : out(out),
+      err(err),
+      lines_per_thread{std::max<size_t>(lines_per_thread, 1)},
+      id{next_logger_id++},
+      writer{[this] { run_writer(); }}
+{
+}
+
+ml::AsyncLogger::~AsyncLogger()
+{
+    {
+        std::lock_guard<std::mutex> lock{wakeup_mutex};
+        stopping = true;
+    }
+    wakeup.notify_one();
+    writer.join();
+}
+
+uint64_t ml::AsyncLogger::dropped_lines() const
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+void ml::AsyncLogger::log(Severity severity, const std::string& message, const std::string& component)
+{
+    if (severity == Severity::critical)
+    {
+        // Critical lines typically precede an abort(): write them (and
+        // everything before them) before returning
+        std::lock_guard<std::mutex> lock{output_mutex};
+        write_pending_locked();
+
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        write_line(err, now, severity, component, message);
+        err.flush();
+        return;
+    }
+
+    if (!ring_for_this_thread().push(severity, message, component))
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Either the writer sees our line before it sleeps, or we see that it
+    // is sleeping and wake it
+    if (writer_waiting.load() && writer_waiting.exchange(false))
+    {
+        std::lock_guard<std::mutex> lock{wakeup_mutex};
+        wakeup.notify_one();
+    }
+}
+
+auto ml::AsyncLogger::ring_for_this_thread() -> Ring&
+{
+    struct ThreadRings
+    {
+        ~ThreadRings()
+        {
+            for (auto const& ring : rings)
+                ring.second->abandoned = true;
+        }
+
+        std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+    };
+
+    static thread_local ThreadRings thread_rings;
+    auto& mine = thread_rings.rings;
+
+    for (auto const& ring : mine)
+    {
+        if (ring.first == id)
+            return *ring.second;
+    }
+
+    // Forget the rings of loggers that have since been destroyed
+    mine.erase(
+        std::remove_if(mine.begin(), mine.end(), [](auto const& ring) { return ring.second.use_count() == 1; }),
+        mine.end());
+
+    auto const ring = std::make_shared<Ring>(lines_per_thread);
+    {
+        std::lock_guard<std::mutex> lock{rings_mutex};
+        rings.push_back(ring);
+    }
+    mine.emplace_back(id, ring);
+
+    return *ring;
+}
+
+bool ml::AsyncLogger::lines_queued()
+{
+    std::lock_guard<std::mutex> lock{rings_mutex};
+    return std::any_of(rings.begin(), rings.end(), [](auto const& ring) { return !ring->empty(); });
+}
+
+void ml::AsyncLogger::write_pending_locked()
+{
+    decltype(rings) current;
+    {
+        std::lock_guard<std::mutex> lock{rings_mutex};
+
+        // A ring whose thread has gone won't get any more lines
+        rings.erase(
+            std::remove_if(rings.begin(), rings.end(), [](auto const& ring) { return ring->abandoned && ring->empty(); }),
+            rings.end());
+
+        current = rings;
+    }
+
+    bool wrote_out{false};
+    bool wrote_err{false};
+
+    for (auto const& ring : current)
+    {
+        ring->drain(
+            [&](Ring::Line const& line)
+            {
+                auto const is_error = line.severity < Severity::informational;
+                write_line(is_error ? err : out, line.time, line.severity, line.component, line.message);
+                (is_error ? wrote_err : wrote_out) = true;
+            });
+    }
+
+    auto const dropped_now = dropped.load(std::memory_order_relaxed);
+    if (dropped_now != dropped_reported)
+    {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        write_line(err, now, Severity::warning, "logging",
+                   std::to_string(dropped_now - dropped_reported) + " log lines dropped (logging faster than they can be written)");
+        dropped_reported = dropped_now;
+        wrote_err = true;
+    }
+
+    if (wrote_out) out.flush();
+    if (wrote_err) err.flush();
+}
+
+void ml::AsyncLogger::run_writer()
+{
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> lock{output_mutex};
+            write_pending_locked();
+        }
+
+        std::unique_lock<std::mutex> lock{wakeup_mutex};
+        if (stopping)
+            break;
+
+        writer_waiting = true;
+        if (!lines_queued())
+            wakeup.wait_for(lock, std::chrono::seconds{1}, [this] { return stopping || !writer_waiting; });
+        writer_waiting = false;
+    }
+
+    std::lock_guard<std::mutex> lock{output_mutex};
+    write_pending_locked();
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <algorithm>
+#include <ostream>
+
+namespace geom = mir::geometry;
+
+namespace
+{
+// A horizontal extent [left, right) within a band
+struct Span
+{
+    int left;
+    int right;
+};
+
+bool operator==(Span const& lhs, Span const& rhs)
+{
+    return lhs.left == rhs.left && lhs.right == rhs.right;
+}
+
+using Spans = std::vector<Span>;
+
+bool is_empty(geom::Rectangle const& rect)
+{
+    return rect.size.width.as_int() <= 0 || rect.size.height.as_int() <= 0;
+}
+
+/// The spans of the band of rects covering the strip starting at y
+/// (i is advanced past any bands that end at or before y)
+Spans spans_at(std::vector<geom::Rectangle> const& rects, size_t& i, int y)
+{
+    while (i < rects.size() && rects[i].bottom().as_int() <= y)
+        ++i;
+
+    Spans spans;
+    if (i < rects.size() && rects[i].top().as_int() <= y)
+    {
+        auto const band_top = rects[i].top();
+        for (auto j = i; j < rects.size() && rects[j].top() == band_top; ++j)
+            spans.push_back({rects[j].left().as_int(), rects[j].right().as_int()});
+    }
+    return spans;
+}
+
+/// Combines two sorted, non-overlapping span lists: keep says whether a
+/// point that is (or isn't) in each input is in the result
+template<typename Keep>
+Spans combine(Spans const& a, Spans const& b, Keep keep)
+{
+    std::vector<int> edges;
+    edges.reserve(2*(a.size() + b.size()));
+    for (auto const& s : a) { edges.push_back(s.left); edges.push_back(s.right); }
+    for (auto const& s : b) { edges.push_back(s.left); edges.push_back(s.right); }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    Spans result;
+    auto ia = a.begin();
+    auto ib = b.begin();
+    for (size_t e = 0; e + 1 < edges.size(); ++e)
+    {
+        auto const x = edges[e];
+        while (ia != a.end() && ia->right <= x) ++ia;
+        while (ib != b.end() && ib->right <= x) ++ib;
+
+        bool const in_a = ia != a.end() && ia->left <= x;
+        bool const in_b = ib != b.end() && ib->left <= x;
+
+        if (keep(in_a, in_b))
+        {
+            if (!result.empty() && result.back().right == x)
+                result.back().right = edges[e+1];
+            else
+                result.push_back({x, edges[e+1]});
+        }
+    }
+    return result;
+}
+
+/// Sweeps down both regions one strip at a time (strips being delimited by
+/// the top and bottom of every band) combining their spans
+template<typename Keep>
+std::vector<geom::Rectangle> combine(
+    std::vector<geom::Rectangle> const& a,
+    std::vector<geom::Rectangle> const& b,
+    Keep keep)
+{
+    std::vector<int> ys;
+    ys.reserve(2*(a.size() + b.size()));
+    for (auto const& r : a) { ys.push_back(r.top().as_int()); ys.push_back(r.bottom().as_int()); }
+    for (auto const& r : b) { ys.push_back(r.top().as_int()); ys.push_back(r.bottom().as_int()); }
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+    std::vector<geom::Rectangle> result;
+    size_t ia = 0;
+    size_t ib = 0;
+    Spans previous;
+    size_t previous_band_start = 0;
+    int previous_bottom = 0;
+
+    for (size_t s = 0; s + 1 < ys.size(); ++s)
+    {
+        auto const top = ys[s];
+        auto const bottom = ys[s+1];
+
+        auto const spans = combine(spans_at(a, ia, top), spans_at(b, ib, top), keep);
+
+        if (spans.empty())
+        {
+            previous.clear();
+            continue;
+        }
+
+        if (!previous.empty() && previous_bottom == top && spans == previous)
+        {
+            // Same shape as the band above it: stretch that instead
+            for (auto i = previous_band_start; i != result.size(); ++i)
+                result[i].size.height = geom::Height{bottom - result[i].top().as_int()};
+        }
+        else
+        {
+            previous_band_start = result.size();
+            for (auto const& span : spans)
+                result.push_back({{span.left, top}, {span.right - span.left, bottom - top}});
+            previous = spans;
+        }
+        previous_bottom = bottom;
+    }
+
+    return result;
+}
+
+std::vector<geom::Rectangle> banded(geom::Rectangle const& rect)
+{
+    if (is_empty(rect))
+        return {};
+    return {rect};
+}
+}
+
+geom::Region::Region()
+{
+}
+
+geom::Region::Region(Rectangle const& rect)
+    : rectangles{banded(rect)}
+{
+}
+
+geom::Region::Region(std::initializer_list<Rectangle> const& rects)
+{
+    for (auto const& rect : rects)
+        unite(rect);
+}
+
+geom::Region::Region(std::vector<Rectangle> const& rects)
+{
+    for (auto const& rect : rects)
+        unite(rect);
+}
+
+void geom::Region::unite(Region const& other)
+{
+    if (other.rectangles.empty())
+        return;
+
+    if (rectangles.empty())
+    {
+        rectangles = other.rectangles;
+        return;
+    }
+
+    rectangles = combine(rectangles, other.rectangles, [](bool in_a, bool in_b) { return in_a || in_b; });
+}
+
+void geom::Region::subtract(Region const& other)
+{
+    if (rectangles.empty() || other.rectangles.empty())
+        return;
+
+    if (!other.bounding_rectangle().overlaps(bounding_rectangle()))
+        return;
+
+    rectangles = combine(rectangles, other.rectangles, [](bool in_a, bool in_b) { return in_a && !in_b; });
+}
+
+void geom::Region::intersect(Region const& other)
+{
+    if (rectangles.empty())
+        return;
+
+    if (other.rectangles.empty())
+    {
+        rectangles.clear();
+        return;
+    }
+
+    rectangles = combine(rectangles, other.rectangles, [](bool in_a, bool in_b) { return in_a && in_b; });
+}
+
+void geom::Region::translate(Displacement const& d)
+{
+    for (auto& rect : rectangles)
+        rect.top_left = rect.top_left + d;
+}
+
+void geom::Region::clear()
+{
+    rectangles.clear();
+}
+
+bool geom::Region::empty() const
+{
+    return rectangles.empty();
+}
+
+bool geom::Region::contains(Rectangle const& rect) const
+{
+    if (is_empty(rect))
+        return true;
+
+    Region remainder{rect};
+    remainder.subtract(*this);
+    return remainder.empty();
+}
+
+bool geom::Region::overlaps(Rectangle const& rect) const
+{
+    return std::any_of(rectangles.begin(), rectangles.end(),
+                       [&rect](Rectangle const& r) { return r.overlaps(rect); });
+}
+
+geom::Rectangle geom::Region::bounding_rectangle() const
+{
+    if (rectangles.empty())
+        return Rectangle{};
+
+    // Being banded, the first and last rectangles have the top and bottom
+    auto const top = rectangles.front().top();
+    auto const bottom = rectangles.back().bottom();
+    auto left = rectangles.front().left();
+    auto right = rectangles.front().right();
+
+    for (auto const& rect : rectangles)
+    {
+        left = std::min(left, rect.left());
+        right = std::max(right, rect.right());
+    }
+
+    return {{left, top}, {(right - left).as_int(), (bottom - top).as_int()}};
+}
+
+geom::Region::const_iterator geom::Region::begin() const
+{
+    return rectangles.begin();
+}
+
+geom::Region::const_iterator geom::Region::end() const
+{
+    return rectangles.end();
+}
+
+geom::Region::size_type geom::Region::size() const
+{
+    return rectangles.size();
+}
+
+bool geom::Region::operator==(Region const& other) const
+{
+    return rectangles == other.rectangles;
+}
+
+bool geom::Region::operator!=(Region const& other) const
+{
+    return !(*this == other);
+}
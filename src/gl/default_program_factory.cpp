@@ -19,10 +19,23 @@
 
 #include "mir/gl/default_program_factory.h"
 #include "mir/gl/program.h"
+#include "mir/gl/texture_budget.h"
 #include "recently_used_cache.h"
 
 namespace mgl = mir::gl;
 
+size_t const mgl::DefaultProgramFactory::default_texture_cache_budget{RecentlyUsedCache::default_budget_bytes};
+
+mgl::DefaultProgramFactory::DefaultProgramFactory()
+    : DefaultProgramFactory{std::make_shared<TextureBudget>(default_texture_cache_budget)}
+{
+}
+
+mgl::DefaultProgramFactory::DefaultProgramFactory(std::shared_ptr<TextureBudget> const& texture_budget)
+    : texture_budget{texture_budget}
+{
+}
+
 std::unique_ptr<mgl::Program>
 mgl::DefaultProgramFactory::create_gl_program(
     std::string const& vertex_shader,
@@ -35,5 +48,5 @@ mgl::DefaultProgramFactory::create_gl_program(
 
 std::unique_ptr<mgl::TextureCache> mgl::DefaultProgramFactory::create_texture_cache() const
 {
-    return std::make_unique<RecentlyUsedCache>();
+    return std::make_unique<RecentlyUsedCache>(texture_budget);
 }
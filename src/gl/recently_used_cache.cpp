@@ -29,22 +29,62 @@ namespace mgl = mir::gl;
 namespace geom = mir::geometry;
 namespace mrgl = mir::renderer::gl;
 
+size_t const mgl::RecentlyUsedCache::default_budget_bytes{128*1024*1024};
+
+mgl::RecentlyUsedCache::RecentlyUsedCache()
+    : RecentlyUsedCache{std::make_shared<TextureBudget>(default_budget_bytes)}
+{
+}
+
+mgl::RecentlyUsedCache::RecentlyUsedCache(std::shared_ptr<TextureBudget> const& budget)
+    : budget{budget}
+{
+}
+
+mgl::RecentlyUsedCache::~RecentlyUsedCache()
+{
+    budget->refund(bytes);
+}
+
 std::shared_ptr<mgl::Texture> mgl::RecentlyUsedCache::load(mg::Renderable const& renderable)
 {
     auto const& buffer = renderable.buffer();
     auto buffer_id = buffer->id();
-    auto& texture = textures[renderable.id()];
+    auto const content_serial = renderable.content_serial();
+    auto const inserted = textures.emplace(renderable.id(), Entry{});
+    auto& texture = inserted.first->second;
+    if (inserted.second)
+    {
+        lru.push_front(renderable.id());
+        texture.lru_position = lru.begin();
+    }
+    else
+    {
+        lru.splice(lru.begin(), lru, texture.lru_position);
+    }
     texture.texture->bind();
 
     auto const texture_source = dynamic_cast<mrgl::TextureSource*>(buffer->native_buffer_base());
     if (!texture_source)
         BOOST_THROW_EXCEPTION(std::logic_error("Buffer does not support GL rendering"));
 
-    if ((texture.last_bound_buffer != buffer_id) || (!texture.valid_binding))
+    if ((texture.last_bound_buffer != buffer_id) ||
+        (texture.last_bound_serial != content_serial) ||
+        (!texture.valid_binding))
     {
         texture_source->bind();
         texture.resource = buffer;
         texture.last_bound_buffer = buffer_id;
+        texture.last_bound_serial = content_serial;
+
+        auto const size = buffer->size();
+        auto const texture_bytes =
+            size_t(size.width.as_int()) * size.height.as_int() * MIR_BYTES_PER_PIXEL(buffer->pixel_format());
+        bytes += texture_bytes;
+        bytes -= texture.bytes;
+        budget->charge(texture_bytes);
+        budget->refund(texture.bytes);
+        texture.bytes = texture_bytes;
     }
     texture_source->secure_for_render();
 
@@ -62,19 +102,39 @@ void mgl::RecentlyUsedCache::invalidate()
 
 void mgl::RecentlyUsedCache::drop_unused()
 {
-    auto t = textures.begin();
-    while (t != textures.end())
+    // Textures in use can't go, so only the unused tail of the list is a
+    // candidate. Other caches' textures are in other GL contexts, so we can
+    // only free ours; they free theirs when they next drop_unused().
+    while (budget->exceeded() && !lru.empty())
+    {
+        auto const t = textures.find(lru.back());
+        if (t->second.used)
+            break;
+
+        bytes -= t->second.bytes;
+        budget->refund(t->second.bytes);
+        evicted_bytes += t->second.bytes;
+        ++evicted_textures;
+        lru.pop_back();
+        textures.erase(t);
+    }
+
+    for (auto& t : textures)
     {
-        auto& tex = t->second;
+        auto& tex = t.second;
         tex.resource.reset();
-        if (tex.used)
-        {
-            tex.used = false;
-            ++t;
-        }
-        else
-        {
-            t = textures.erase(t);
-        }
+
+        // Once we let go of the buffer its owner may refill it. Where the
+        // content serial tracks that, an unchanged buffer keeps its texture;
+        // otherwise a texture we didn't draw from can't be trusted to match.
+        if (!tex.used && tex.last_bound_serial == 0)
+            tex.valid_binding = false;
+
+        tex.used = false;
     }
 }
+
+auto mgl::RecentlyUsedCache::usage() const -> Usage
+{
+    return {textures.size(), bytes, evicted_textures, evicted_bytes};
+}
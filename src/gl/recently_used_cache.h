@@ -22,8 +22,10 @@
 
 #include "mir/gl/texture_cache.h"
 #include "mir/gl/texture.h"
+#include "mir/gl/texture_budget.h"
 #include "mir/graphics/buffer_id.h"
 #include "mir/graphics/renderable.h"
+#include <list>
 #include <unordered_map>
 
 namespace mir
@@ -31,14 +33,30 @@ namespace mir
 namespace graphics { class Buffer; }
 namespace gl
 {
+/**
+ * Keeps the textures of renderables that drop out of view (occluded,
+ * minimised, on another workspace...) so they needn't be recreated when
+ * they return, up to a budget that may be shared with other caches. Past
+ * the budget the least recently used are freed. If the renderable's content serial shows its buffer hasn't
+ * changed meanwhile, the texture isn't rebound (or re-uploaded) either.
+ */
 class RecentlyUsedCache : public TextureCache
 {
 public:
+    static size_t const default_budget_bytes;
+
+    RecentlyUsedCache();
+    explicit RecentlyUsedCache(std::shared_ptr<TextureBudget> const& budget);
+    ~RecentlyUsedCache();
+
     std::shared_ptr<Texture> load(graphics::Renderable const& renderable) override;
     void invalidate() override;
     void drop_unused() override;
+    Usage usage() const override;
 
 private:
+    using LruList = std::list<graphics::Renderable::ID>;
+
     struct Entry
     {
         Entry()
@@ -46,12 +64,20 @@ private:
         {}
         std::shared_ptr<Texture> texture;
         graphics::BufferID last_bound_buffer;
+        uint64_t last_bound_serial{0};
         bool used{true};
         bool valid_binding{false};
         std::shared_ptr<graphics::Buffer> resource;
+        size_t bytes{0};    // Our share of what's charged to the budget
+        LruList::iterator lru_position;
     };
 
+    std::shared_ptr<TextureBudget> const budget;
     std::unordered_map<graphics::Renderable::ID, Entry> textures;
+    LruList lru;    // Most recently used first
+    size_t bytes{0};    // Our share of what's charged to the budget
+    size_t evicted_textures{0};
+    size_t evicted_bytes{0};
 };
 }
 }
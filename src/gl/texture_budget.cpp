@@ -0,0 +1,39 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/gl/texture_budget.h"
+
+namespace mgl = mir::gl;
+
+mgl::TextureBudget::TextureBudget(size_t budget_bytes)
+    : budget_bytes{budget_bytes}
+{
+}
+
+void mgl::TextureBudget::charge(size_t bytes)
+{
+    charged_bytes += bytes;
+}
+
+void mgl::TextureBudget::refund(size_t bytes)
+{
+    charged_bytes -= bytes;
+}
+
+bool mgl::TextureBudget::exceeded() const
+{
+    return charged_bytes > budget_bytes;
+}
@@ -25,6 +25,7 @@
 
 #include <capnp/message.h>
 
+#include <cstddef>
 #include <cstring>
 
 struct MirEvent
@@ -73,10 +74,37 @@ struct MirEvent
     static mir::EventUPtr deserialize(std::string const& bytes);
     static std::string serialize(MirEvent const* event);
 
+    // Events are created and destroyed at input device rates, often on
+    // different threads: recycle them through a pool any thread can release to
+    static void* operator new(std::size_t size);
+    static void operator delete(void* block, std::size_t size);
+
 protected:
     MirEvent() = default;
 
-    ::capnp::MallocMessageBuilder message;
+    /// Enough for any input event, so building one needs no allocation
+    static std::size_t const first_segment_words = 128;
+
+    /**
+     * The builder's first segment, from a pool of zeroed segments.
+     * (capnp requires it zeroed, and zeroes the part it used when the
+     * builder is destroyed, so a recycled segment needn't be cleared again.)
+     */
+    struct FirstSegment
+    {
+        FirstSegment();
+        ~FirstSegment();
+        FirstSegment(FirstSegment const&) = delete;
+        FirstSegment& operator=(FirstSegment const&) = delete;
+
+        kj::ArrayPtr<::capnp::word> words() const;
+
+        ::capnp::word* const segment;
+    };
+
+    // Declared before the builder, so it is released after the builder zeroes it
+    FirstSegment first_segment;
+    ::capnp::MallocMessageBuilder message{first_segment.words()};
     mir::capnp::Event::Builder event{message.initRoot<mir::capnp::Event>()};
 };
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_LOGGING_ASYNC_LOGGER_H_
+#define MIR_LOGGING_ASYNC_LOGGER_H_
+
+#include "mir/logging/logger.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mir
+{
+namespace logging
+{
+/**
+ * Writes log lines in the same format as DumbConsoleLogger, but from a
+ * thread of its own.
+ *
+ * Each logging thread queues its lines in a ring of its own without
+ * locking, and the timestamps are formatted by the writer thread. If a
+ * thread logs faster than the lines can be written and its ring fills, the
+ * lines that don't fit are dropped and a count of them is logged instead.
+ */
+class AsyncLogger : public Logger
+{
+public:
+    static size_t const default_lines_per_thread = 512;
+
+    AsyncLogger();
+    AsyncLogger(std::ostream& out, std::ostream& err, size_t lines_per_thread);
+    ~AsyncLogger();
+
+    /// Lines dropped because their thread's ring was full
+    uint64_t dropped_lines() const;
+
+protected:
+    void log(Severity severity, const std::string& message, const std::string& component) override;
+
+private:
+    struct Ring;
+
+    Ring& ring_for_this_thread();
+    bool lines_queued();
+    void write_pending_locked();
+    void run_writer();
+
+    std::ostream& out;
+    std::ostream& err;
+    size_t const lines_per_thread;
+    uint64_t const id;
+
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+
+    std::mutex wakeup_mutex;
+    std::condition_variable wakeup;
+    std::atomic<bool> writer_waiting{false};
+    bool stopping{false};
+
+    std::mutex output_mutex;
+    std::atomic<uint64_t> dropped{0};
+    uint64_t dropped_reported{0};
+
+    std::thread writer;
+};
+}
+}
+
+#endif // MIR_LOGGING_ASYNC_LOGGER_H_
@@ -20,35 +20,48 @@
 #ifndef MIR_THREAD_SAFE_LIST_H_
 #define MIR_THREAD_SAFE_LIST_H_
 
-#include "mir/recursive_read_write_mutex.h"
-
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace mir
 {
 
 /*
  * Requirements for type 'Element'
- *  - for_each():
- *    - copy-assignable
  *  - add():
- *    - copy-assignable
+ *    - copy-constructible
  *    - conversion to bool: indicates whether this is a valid element
  *  - remove(), remove_all():
- *    - copy-assignable
- *    - Element{}: default construction should create an invalid element
  *    - bool operator==: equality of elements
- *    - bool operator!=: inequality of elements
- *  - clear():
- *    - copy-assignable
- *    - Element{}: value initialization should create an invalid element
+ *
+ * Notification is the hot path: for_each() walks an immutable snapshot of
+ * the list without taking locks or copying elements. Changes (the rare
+ * path) publish a new snapshot. An element removed while another thread
+ * is calling it is no longer called once remove() returns, and remove()
+ * waits for the calls in progress on other threads to finish.
+ *
+ * Each thread that iterates the list has a reader record, which only that
+ * thread writes: the epoch it started reading in and the elements it is
+ * calling. Writers use these to tell when a replaced snapshot can no
+ * longer be in use (epoch based reclamation) and to wait for calls to a
+ * removed element.
  */
 
 template<class Element>
 class ThreadSafeList
 {
 public:
+    ThreadSafeList() = default;
+    ~ThreadSafeList();
+
     void add(Element const& element);
     void remove(Element const& element);
     unsigned int remove_all(Element const& element);
@@ -56,130 +69,319 @@ public:
     void for_each(std::function<void(Element const& element)> const& f);
 
 private:
-    struct ListItem
+    ThreadSafeList(ThreadSafeList const&) = delete;
+    ThreadSafeList& operator=(ThreadSafeList const&) = delete;
+
+    struct Slot
     {
-        ListItem() {}
-        RecursiveReadWriteMutex mutex;
-        Element element{};
-        std::atomic<ListItem*> next{nullptr};
+        explicit Slot(Element const& element) : element(element) {}
+
+        Element const element;
+        std::atomic<bool> removed{false};
+    };
+
+    using Snapshot = std::vector<std::shared_ptr<Slot>>;
+
+    // Calls nested deeper than this (by elements iterating the same list)
+    // are tracked together, so removals wait for all of them
+    static unsigned int const max_nesting = 8;
+
+    struct Reader
+    {
+        explicit Reader(std::thread::id owner) : owner{owner} {}
+
+        std::thread::id const owner;
+        Reader* next{nullptr};
+
+        unsigned int depth{0};                          // Only used by the owner
+        std::atomic<std::uint64_t> epoch{0};            // 0 when not reading
+        std::atomic<Slot const*> calling[max_nesting]{};
+        std::atomic<bool> overflowed{false};
+    };
+
+    struct Reading;
+    struct Calling;
 
-        ~ListItem() { delete next.load(); }
-    } head;
+    // These require writer_mutex to be held
+    void publish(Snapshot* snapshot);
+    void reclaim_retired();
+
+    auto this_thread_reader() -> Reader&;
+    void wait_for_calls_to(Slot const& slot);
+    void notify_waiters();
+
+    std::atomic<Snapshot*> current{new Snapshot};
+    std::atomic<std::uint64_t> epoch{1};
+    std::atomic<Reader*> readers{nullptr};
+
+    std::mutex writer_mutex;
+    std::vector<std::pair<std::uint64_t, std::unique_ptr<Snapshot>>> retired;
+
+    std::mutex wait_mutex;
+    std::condition_variable calls_finished;
+    std::atomic<unsigned int> waiters{0};
 };
 
 template<class Element>
-void ThreadSafeList<Element>::for_each(
-    std::function<void(Element const& element)> const& f)
+struct ThreadSafeList<Element>::Reading
 {
-    ListItem* current_item = &head;
+    Reading(ThreadSafeList& list, Reader& reader) :
+        list(list), reader(reader), depth{reader.depth++}
+    {
+        // The epoch is published before the snapshot is loaded, so a writer
+        // replacing that snapshot sees it
+        if (depth == 0)
+            reader.epoch = list.epoch.load();
+        else if (depth == max_nesting)
+            reader.overflowed = true;
+    }
 
-    while (current_item)
+    ~Reading()
     {
-        RecursiveReadLock lock{current_item->mutex};
+        if (depth == 0)
+        {
+            reader.epoch = 0;
+        }
+        else if (depth == max_nesting)
+        {
+            reader.overflowed = false;
+            list.notify_waiters();
+        }
+        --reader.depth;
+    }
 
-        // We need to take a copy in case we recursively remove during call
-        if (auto const copy_of_element = current_item->element) f(copy_of_element);
+    ThreadSafeList& list;
+    Reader& reader;
+    unsigned int const depth;
+};
 
-        current_item = current_item->next;
+template<class Element>
+struct ThreadSafeList<Element>::Calling
+{
+    // Published before checking slot.removed, so either the removed
+    // element isn't called or its remover sees the call
+    Calling(ThreadSafeList& list, std::atomic<Slot const*>& call, Slot const& slot) :
+        list(list), call(call)
+    {
+        call = &slot;
+    }
+
+    ~Calling()
+    {
+        call = nullptr;
+        list.notify_waiters();
     }
+
+    ThreadSafeList& list;
+    std::atomic<Slot const*>& call;
+};
+
+template<class Element>
+ThreadSafeList<Element>::~ThreadSafeList()
+{
+    delete current.load();
+
+    for (auto reader = readers.load(); reader;)
+        delete std::exchange(reader, reader->next);
 }
 
 template<class Element>
-void ThreadSafeList<Element>::add(Element const& element)
+auto ThreadSafeList<Element>::this_thread_reader() -> Reader&
 {
-    ListItem* current_item = &head;
+    auto const self = std::this_thread::get_id();
 
-    do
+    // Only the few threads that iterate this list have records
+    for (auto reader = readers.load(); reader; reader = reader->next)
     {
-        // Note: we release the read lock to avoid two threads calling add at
-        // the same time mutually blocking the other's upgrade to write lock.
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element) continue;
-        }
+        if (reader->owner == self)
+            return *reader;
+    }
 
-        RecursiveWriteLock lock{current_item->mutex};
+    auto const reader = new Reader{self};
+    reader->next = readers.load();
+    while (!readers.compare_exchange_weak(reader->next, reader))
+        ;
 
-        if (!current_item->element)
+    return *reader;
+}
+
+template<class Element>
+void ThreadSafeList<Element>::for_each(
+    std::function<void(Element const& element)> const& f)
+{
+    auto& reader = this_thread_reader();
+    Reading const reading{*this, reader};
+
+    for (auto const& slot : *current.load())
+    {
+        if (reading.depth < max_nesting)
         {
-            current_item->element = element;
-            return;
+            Calling const calling{*this, reader.calling[reading.depth], *slot};
+            if (!slot->removed) f(slot->element);
+        }
+        else
+        {
+            if (!slot->removed) f(slot->element);
         }
     }
-    while (current_item->next && (current_item = current_item->next));
+}
 
-    // No empty Items so append a new one
-    auto new_item = new ListItem;
-    new_item->element = element;
+template<class Element>
+void ThreadSafeList<Element>::add(Element const& element)
+{
+    if (!element) return;
 
-    for (ListItem* expected{nullptr};
-        !current_item->next.compare_exchange_weak(expected, new_item);
-        expected = nullptr)
-    {
-        if (expected) current_item = expected;
-    }
+    auto const slot = std::make_shared<Slot>(element);
+
+    std::lock_guard<std::mutex> lock{writer_mutex};
+
+    auto const snapshot = new Snapshot{*current.load()};
+    snapshot->push_back(slot);
+    publish(snapshot);
 }
 
 template<class Element>
 void ThreadSafeList<Element>::remove(Element const& element)
 {
-    ListItem* current_item = &head;
+    std::shared_ptr<Slot> removed;
 
-    do
     {
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
-        }
+        std::lock_guard<std::mutex> lock{writer_mutex};
 
-        RecursiveWriteLock lock{current_item->mutex};
+        auto const& snapshot = *current.load();
+        auto const i = std::find_if(snapshot.begin(), snapshot.end(),
+            [&](std::shared_ptr<Slot> const& slot) { return slot->element == element; });
 
-        if (current_item->element == element)
-        {
-            current_item->element = Element{};
+        if (i == snapshot.end())
             return;
-        }
+
+        removed = *i;
+        removed->removed = true;
+
+        auto const updated = new Snapshot(snapshot.begin(), i);
+        updated->insert(updated->end(), i + 1, snapshot.end());
+        publish(updated);
     }
-    while ((current_item = current_item->next));
+
+    wait_for_calls_to(*removed);
 }
 
 template<class Element>
 unsigned int ThreadSafeList<Element>::remove_all(Element const& element)
 {
-    ListItem* current_item = &head;
-    auto removed = 0u;
+    Snapshot removed;
 
-    do
     {
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
-        }
-
-        RecursiveWriteLock lock{current_item->mutex};
+        std::lock_guard<std::mutex> lock{writer_mutex};
 
-        if (current_item->element == element)
+        auto const snapshot = new Snapshot;
+        for (auto const& slot : *current.load())
         {
-            current_item->element = Element{};
-            ++removed;
+            if (slot->element == element)
+            {
+                slot->removed = true;
+                removed.push_back(slot);
+            }
+            else
+            {
+                snapshot->push_back(slot);
+            }
         }
+
+        publish(snapshot);
     }
-    while ((current_item = current_item->next));
 
-    return removed;
+    for (auto const& slot : removed)
+        wait_for_calls_to(*slot);
+
+    return removed.size();
 }
 
 template<class Element>
 void ThreadSafeList<Element>::clear()
 {
-    ListItem* current_item = &head;
+    Snapshot removed;
+
+    {
+        std::lock_guard<std::mutex> lock{writer_mutex};
+
+        removed = *current.load();
+        for (auto const& slot : removed)
+            slot->removed = true;
 
-    do
+        publish(new Snapshot);
+    }
+
+    for (auto const& slot : removed)
+        wait_for_calls_to(*slot);
+}
+
+template<class Element>
+void ThreadSafeList<Element>::publish(Snapshot* snapshot)
+{
+    std::unique_ptr<Snapshot> replaced{current.exchange(snapshot)};
+    retired.emplace_back(epoch++, std::move(replaced));
+    reclaim_retired();
+}
+
+template<class Element>
+void ThreadSafeList<Element>::reclaim_retired()
+{
+    // A snapshot retired in an epoch before any reader started can't be in use
+    auto oldest_read = epoch.load();
+    for (auto reader = readers.load(); reader; reader = reader->next)
+    {
+        auto const read = reader->epoch.load();
+        if (read && read < oldest_read)
+            oldest_read = read;
+    }
+
+    retired.erase(
+        std::remove_if(retired.begin(), retired.end(),
+            [&](std::pair<std::uint64_t, std::unique_ptr<Snapshot>> const& snapshot)
+            { return snapshot.first < oldest_read; }),
+        retired.end());
+}
+
+template<class Element>
+void ThreadSafeList<Element>::wait_for_calls_to(Slot const& slot)
+{
+    auto const self = std::this_thread::get_id();
+
+    auto const calls_finished_elsewhere = [&]
+        {
+            for (auto reader = readers.load(); reader; reader = reader->next)
+            {
+                // Calls made by this thread (we are called from inside them) can't finish
+                if (reader->owner == self)
+                    continue;
+
+                if (reader->overflowed)
+                    return false;
+
+                for (auto const& call : reader->calling)
+                {
+                    if (call == &slot)
+                        return false;
+                }
+            }
+            return true;
+        };
+
+    std::unique_lock<std::mutex> lock{wait_mutex};
+    ++waiters;
+    calls_finished.wait(lock, calls_finished_elsewhere);
+    --waiters;
+}
+
+template<class Element>
+void ThreadSafeList<Element>::notify_waiters()
+{
+    if (waiters.load())
     {
-        RecursiveWriteLock lock{current_item->mutex};
-        current_item->element = Element{};
+        std::lock_guard<std::mutex> lock{wait_mutex};
+        calls_finished.notify_all();
     }
-    while ((current_item = current_item->next));
 }
 
 }
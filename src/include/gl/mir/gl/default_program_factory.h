@@ -20,15 +20,25 @@
 #define MIR_GL_DEFAULT_PROGRAM_FACTORY_H_
 
 #include "program_factory.h"
+#include <cstddef>
+#include <memory>
 #include <mutex>
 
 namespace mir
 {
 namespace gl
 {
+class TextureBudget;
+
 class DefaultProgramFactory : public ProgramFactory
 {
 public:
+    static size_t const default_texture_cache_budget;
+
+    DefaultProgramFactory();
+    /// \param texture_budget What the caches may keep textures in, shared with any other caches charged to it
+    explicit DefaultProgramFactory(std::shared_ptr<TextureBudget> const& texture_budget);
+
     std::unique_ptr<Program> create_gl_program(std::string const&, std::string const&) const override;
     std::unique_ptr<TextureCache> create_texture_cache() const override;
 
@@ -40,6 +50,7 @@ private:
      * have the same or shared EGL contexts.
      */
     std::mutex mutable mutex;
+    std::shared_ptr<TextureBudget> const texture_budget;
 };
 }
 }
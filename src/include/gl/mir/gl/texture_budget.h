@@ -0,0 +1,51 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GL_TEXTURE_BUDGET_H_
+#define MIR_GL_TEXTURE_BUDGET_H_
+
+#include <atomic>
+#include <cstddef>
+
+namespace mir
+{
+namespace gl
+{
+/**
+ * The memory that texture caches, together, may keep textures in. Each
+ * renderer has its own cache (textures can't move between their GL
+ * contexts) but they share one budget, so the limit holds however many
+ * outputs there are. Caches are charged from their compositor threads.
+ */
+class TextureBudget
+{
+public:
+    explicit TextureBudget(size_t budget_bytes);
+
+    void charge(size_t bytes);
+    void refund(size_t bytes);
+
+    /// Whether the textures charged so far take up more than the budget
+    bool exceeded() const;
+
+private:
+    size_t const budget_bytes;
+    std::atomic<size_t> charged_bytes{0};
+};
+}
+}
+
+#endif /* MIR_GL_TEXTURE_BUDGET_H_ */
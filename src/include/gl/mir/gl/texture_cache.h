@@ -21,6 +21,7 @@
 #define MIR_GL_TEXTURE_CACHE_H_
 
 #include <memory>
+#include <cstddef>
 
 namespace mir
 {
@@ -52,11 +53,23 @@ public:
     virtual void invalidate() = 0;
 
     /**
-     * Free textures that were not used (loaded) since the last
-     * drop/invalidate. Must be called with a current GL context.
+     * Release the buffers loaded since the last drop, and free textures
+     * that are no longer worth keeping: those that were not used (loaded)
+     * since the last drop, least recently used first, while the cache is
+     * over its budget. Must be called with a current GL context.
      */
     virtual void drop_unused() = 0;
 
+    struct Usage
+    {
+        size_t textures;            ///< Textures currently held
+        size_t bytes;               ///< Approximate memory they occupy
+        size_t evicted_textures;    ///< Textures freed so far
+        size_t evicted_bytes;       ///< Approximate memory freed so far
+    };
+
+    virtual Usage usage() const = 0;
+
 protected:
     TextureCache() = default;
 private:
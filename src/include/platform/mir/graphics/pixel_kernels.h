@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_PIXEL_KERNELS_H_
+#define MIR_GRAPHICS_PIXEL_KERNELS_H_
+
+#include "mir_toolkit/common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * Routines for shuffling 32-bit pixels about, vectorised (SSE2, AVX2 or NEON)
+ * where the CPU we're running on supports it.
+ *
+ * Strides are in pixels.
+ */
+namespace pixel
+{
+struct Kernels
+{
+    char const* name;
+
+    /// dst[i] = src[i] with its first and third bytes swapped (ARGB <-> ABGR). src may be dst.
+    void (*swap_red_blue)(uint32_t const* src, uint32_t* dst, size_t count);
+
+    /// dst[i] = src[count - 1 - i]. src and dst mustn't overlap.
+    void (*reverse)(uint32_t const* src, uint32_t* dst, size_t count);
+
+    void (*fill)(uint32_t* dst, size_t count, uint32_t value);
+
+    /// Copies a width x height image turned a quarter clockwise (so dst is height x width)
+    void (*rotate_clockwise)(
+        uint32_t const* src, size_t src_stride, size_t width, size_t height,
+        uint32_t* dst, size_t dst_stride);
+
+    /// Copies a width x height image turned a quarter anticlockwise (so dst is height x width)
+    void (*rotate_anticlockwise)(
+        uint32_t const* src, size_t src_stride, size_t width, size_t height,
+        uint32_t* dst, size_t dst_stride);
+};
+
+/// The fastest kernels the CPU supports (chosen on first use)
+auto best_kernels() -> Kernels const&;
+
+/// Every set of kernels the CPU supports, slowest (the portable ones) first
+auto supported_kernels() -> std::vector<Kernels const*>;
+
+inline void swap_red_blue(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    best_kernels().swap_red_blue(src, dst, count);
+}
+
+inline void fill(uint32_t* dst, size_t count, uint32_t value)
+{
+    best_kernels().fill(dst, count, value);
+}
+
+/// Fills a width x height rectangle of an image
+void fill(uint32_t* dst, size_t dst_stride, size_t width, size_t height, uint32_t value);
+
+/**
+ * Turns an image upside down in place, optionally swapping red and blue as it goes
+ */
+void flip_vertically(uint32_t* pixels, size_t stride, size_t width, size_t height, bool swap_red_blue);
+
+/**
+ * Copies a width x height image, turning it as an output with the given
+ * orientation needs: anticlockwise for mir_orientation_left and clockwise for
+ * mir_orientation_right (when dst is height x width).
+ */
+void copy_rotated(
+    uint32_t const* src, size_t src_stride, size_t width, size_t height,
+    uint32_t* dst, size_t dst_stride,
+    MirOrientation orientation);
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_PIXEL_KERNELS_H_ */
@@ -36,6 +36,7 @@ extern char const* const session_mediator_report_opt;
 extern char const* const msg_processor_report_opt;
 extern char const* const shared_library_prober_report_opt;
 extern char const* const shell_report_opt;
+extern char const* const xwayland_report_opt;
 extern char const* const compositor_report_opt;
 extern char const* const display_report_opt;
 extern char const* const legacy_input_report_opt;
@@ -47,8 +48,11 @@ extern char const* const touchspots_opt;
 extern char const* const cursor_opt;
 extern char const* const fatal_except_opt;
 extern char const* const debug_opt;
+extern char const* const async_log_opt;
 extern char const* const composite_delay_opt;
+extern char const* const texture_cache_budget_opt;
 extern char const* const enable_key_repeat_opt;
+extern char const* const coalesce_input_motion_opt;
 extern char const* const x11_display_opt;
 extern char const* const wayland_extensions_opt;
 extern char const* const enable_mirclient_opt;
@@ -26,6 +26,7 @@
 #include "mir/graphics/buffer_id.h"
 
 #include <memory>
+#include <cstdint>
 
 namespace mir
 {
@@ -43,11 +44,15 @@ public:
     virtual ~BufferStream() = default;
 
     virtual auto lock_compositor_buffer(void const* user_id) -> std::shared_ptr<graphics::Buffer> = 0;
+    /// The most recent buffer, which isn't returned to the client while the result is held
+    virtual auto snapshot_acquire() -> std::shared_ptr<graphics::Buffer> = 0;
     virtual auto stream_size() -> geometry::Size = 0;
     virtual auto buffers_ready_for_compositor(void const* user_id) const -> int = 0;
     virtual void drop_old_buffers() = 0;
     virtual auto has_submitted_buffer() const -> bool = 0;
     virtual auto framedropping() const -> bool = 0;
+    /// Changes each time \p buffer is submitted to the stream (zero if it never was)
+    virtual auto content_serial(graphics::Buffer const& buffer) const -> uint64_t = 0;
 };
 
 }
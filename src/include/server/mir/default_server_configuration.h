@@ -56,6 +56,7 @@ class Drawer;
 class DisplayBufferCompositorFactory;
 class Compositor;
 class CompositorReport;
+class OutputFrameTaps;
 }
 namespace frontend
 {
@@ -72,6 +73,7 @@ class DisplayChanger;
 class Screencast;
 class InputConfigurationChanger;
 class SurfaceStack;
+class XWaylandReport;
 }
 
 namespace shell
@@ -281,6 +283,7 @@ public:
     virtual std::shared_ptr<frontend::ConnectionCreator>      the_prompt_connection_creator();
     virtual std::shared_ptr<frontend::ConnectorReport>        the_connector_report();
     virtual std::shared_ptr<frontend::SurfaceStack>           the_frontend_surface_stack();
+    virtual std::shared_ptr<frontend::XWaylandReport>         the_xwayland_report();
     /** @} */
     /** @} */
 
@@ -424,6 +427,7 @@ protected:
 
     CachedPtr<frontend::ConnectorReport>   connector_report;
     CachedPtr<frontend::MessageProcessorReport> message_processor_report;
+    CachedPtr<frontend::XWaylandReport> xwayland_report;
     CachedPtr<frontend::SessionAuthorizer> session_authorizer;
     CachedPtr<frontend::EventSink> global_event_sink;
     CachedPtr<frontend::ConnectionCreator> connection_creator;
@@ -488,6 +492,10 @@ private:
 
     std::shared_ptr<scene::BroadcastingSessionEventSink> the_broadcasting_session_event_sink();
 
+    CachedPtr<compositor::OutputFrameTaps> output_frame_taps;
+
+    std::shared_ptr<compositor::OutputFrameTaps> the_output_frame_taps();
+
     auto report_factory(char const* report_opt) -> std::unique_ptr<report::ReportFactory>;
 
     CachedPtr<shell::detail::FrontendShell> frontend_shell;
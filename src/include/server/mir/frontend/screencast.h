@@ -26,6 +26,7 @@
 
 namespace mir
 {
+namespace geometry { class Region; }
 namespace graphics { class Buffer; }
 namespace frontend
 {
@@ -48,6 +49,13 @@ public:
     virtual std::shared_ptr<graphics::Buffer> capture(ScreencastSessionId id) = 0;
     virtual void capture(ScreencastSessionId id, std::shared_ptr<graphics::Buffer> const& buffer) = 0;
 
+    /**
+     * The area of the buffer from the session's last capture that changed
+     * since the capture before it, in buffer coordinates (before any mirroring).
+     * Empty when nothing had changed, so the last capture did no rendering.
+     */
+    virtual geometry::Region last_capture_damage(ScreencastSessionId id) = 0;
+
 protected:
     Screencast() = default;
     Screencast(Screencast const&) = delete;
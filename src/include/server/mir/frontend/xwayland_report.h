@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_XWAYLAND_REPORT_H_
+#define MIR_FRONTEND_XWAYLAND_REPORT_H_
+
+#include <chrono>
+
+namespace mir
+{
+namespace frontend
+{
+
+class XWaylandReport
+{
+public:
+    /// What caused Xwayland to be started
+    enum class Activation
+    {
+        client_connected,   ///< An X11 client connected to the display socket
+        prespawn,           ///< Started ahead of any client connecting
+        restart             ///< Restarted after Xwayland failed
+    };
+
+    virtual void spawning(Activation activation) = 0;
+
+    /// Xwayland is ready for clients, startup_time after it was activated
+    virtual void started(Activation activation, std::chrono::nanoseconds startup_time) = 0;
+    virtual void start_failed(Activation activation, std::chrono::nanoseconds waited) = 0;
+
+    /// Xwayland has had no clients for longer than the idle timeout
+    virtual void stopping_idle() = 0;
+    virtual void stopped(bool crashed) = 0;
+
+protected:
+    virtual ~XWaylandReport() = default;
+    XWaylandReport() = default;
+    XWaylandReport(XWaylandReport const&) = delete;
+    XWaylandReport& operator=(XWaylandReport const&) = delete;
+};
+
+}
+}
+
+#endif // MIR_FRONTEND_XWAYLAND_REPORT_H_
@@ -41,6 +41,17 @@ void miral::X11Support::operator()(mir::Server& server) const
     server.add_configuration_option(
         "xwayland-path",
         "Path to Xwayland executable", "/usr/bin/Xwayland");
+
+    server.add_configuration_option(
+        "xwayland-prespawn-delay",
+        "Seconds after startup to start Xwayland, instead of when the first X11 client connects",
+        mir::OptionType::integer);
+
+    server.add_configuration_option(
+        "xwayland-idle-timeout",
+        "Seconds Xwayland may go without X11 clients before it is stopped, to be started again when "
+        "the next X11 client connects (default: keep it running)",
+        mir::OptionType::integer);
 }
 
 miral::X11Support::~X11Support() = default;
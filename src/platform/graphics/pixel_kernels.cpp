@@ -0,0 +1,444 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MIR_PIXEL_KERNELS_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIR_PIXEL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace mgp = mir::graphics::pixel;
+
+namespace
+{
+uint32_t swap_red_blue_of(uint32_t pixel)
+{
+    return (pixel & 0xff00ff00) | ((pixel >> 16) & 0xff) | ((pixel & 0xff) << 16);
+}
+
+// The portable kernels, also used for whatever's left over by the vector ones
+
+void scalar_swap_red_blue(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    for (size_t i = 0; i != count; ++i)
+        dst[i] = swap_red_blue_of(src[i]);
+}
+
+void scalar_reverse(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    std::reverse_copy(src, src + count, dst);
+}
+
+void scalar_fill(uint32_t* dst, size_t count, uint32_t value)
+{
+    std::fill_n(dst, count, value);
+}
+
+void scalar_rotate_clockwise(
+    uint32_t const* src, size_t src_stride, size_t width, size_t height,
+    uint32_t* dst, size_t dst_stride)
+{
+    for (size_t row = 0; row != width; ++row)
+    {
+        auto const out = dst + row * dst_stride;
+        for (size_t col = 0; col != height; ++col)
+            out[col] = src[(height - 1 - col) * src_stride + row];
+    }
+}
+
+void scalar_rotate_anticlockwise(
+    uint32_t const* src, size_t src_stride, size_t width, size_t height,
+    uint32_t* dst, size_t dst_stride)
+{
+    for (size_t row = 0; row != width; ++row)
+    {
+        auto const out = dst + row * dst_stride;
+        for (size_t col = 0; col != height; ++col)
+            out[col] = src[col * src_stride + width - 1 - row];
+    }
+}
+
+mgp::Kernels const scalar_kernels{
+    "scalar",
+    &scalar_swap_red_blue,
+    &scalar_reverse,
+    &scalar_fill,
+    &scalar_rotate_clockwise,
+    &scalar_rotate_anticlockwise};
+
+#ifdef MIR_PIXEL_KERNELS_X86
+#define MIR_TARGET(isa) __attribute__((target(isa)))
+
+MIR_TARGET("sse2")
+void sse2_swap_red_blue(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    // No byte shuffle until SSSE3, but red and blue are each a 16-bit shift from home
+    auto const green_alpha = _mm_set1_epi32(0xff00ff00);
+    auto const low_byte = _mm_set1_epi32(0xff);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        auto const moved = _mm_or_si128(
+            _mm_and_si128(_mm_srli_epi32(v, 16), low_byte),
+            _mm_slli_epi32(_mm_and_si128(v, low_byte), 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_and_si128(v, green_alpha), moved));
+    }
+    scalar_swap_red_blue(src + i, dst + i, count - i);
+}
+
+MIR_TARGET("sse2")
+void sse2_reverse(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + count - 4 - i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+    scalar_reverse(src, dst + i, count - i);
+}
+
+MIR_TARGET("sse2")
+void sse2_fill(uint32_t* dst, size_t count, uint32_t value)
+{
+    auto const v = _mm_set1_epi32(value);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    scalar_fill(dst + i, count - i, value);
+}
+
+/// Loads a 4x4 block and turns each of its columns into a row
+MIR_TARGET("sse2")
+void sse2_load_transposed(uint32_t const* src, size_t src_stride, __m128i (&col)[4])
+{
+    auto const r0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+    auto const r1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + src_stride));
+    auto const r2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 2 * src_stride));
+    auto const r3 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 3 * src_stride));
+
+    auto const t0 = _mm_unpacklo_epi32(r0, r1);
+    auto const t1 = _mm_unpacklo_epi32(r2, r3);
+    auto const t2 = _mm_unpackhi_epi32(r0, r1);
+    auto const t3 = _mm_unpackhi_epi32(r2, r3);
+
+    col[0] = _mm_unpacklo_epi64(t0, t1);
+    col[1] = _mm_unpackhi_epi64(t0, t1);
+    col[2] = _mm_unpacklo_epi64(t2, t3);
+    col[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+MIR_TARGET("sse2")
+void sse2_rotate_clockwise(
+    uint32_t const* src, size_t src_stride, size_t width, size_t height,
+    uint32_t* dst, size_t dst_stride)
+{
+    auto const full_width = width & ~size_t{3};
+    auto const full_height = height & ~size_t{3};
+
+    // dst(row, col) = src(height - 1 - col, row): the blocks along the bottom
+    // of src go down the left of dst
+    for (size_t y = 0; y != full_height; y += 4)
+    {
+        auto const src_y = height - 4 - y;
+        for (size_t x = 0; x != full_width; x += 4)
+        {
+            __m128i col[4];
+            sse2_load_transposed(src + src_y * src_stride + x, src_stride, col);
+            for (int i = 0; i != 4; ++i)
+            {
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(dst + (x + i) * dst_stride + y),
+                    _mm_shuffle_epi32(col[i], _MM_SHUFFLE(0, 1, 2, 3)));
+            }
+        }
+    }
+
+    // What's left of the right-hand columns of src, and of its top rows
+    if (full_width != width)
+    {
+        scalar_rotate_clockwise(
+            src + full_width, src_stride, width - full_width, height,
+            dst + full_width * dst_stride, dst_stride);
+    }
+    if (full_height != height)
+    {
+        scalar_rotate_clockwise(
+            src, src_stride, full_width, height - full_height,
+            dst + full_height, dst_stride);
+    }
+}
+
+MIR_TARGET("sse2")
+void sse2_rotate_anticlockwise(
+    uint32_t const* src, size_t src_stride, size_t width, size_t height,
+    uint32_t* dst, size_t dst_stride)
+{
+    auto const full_width = width & ~size_t{3};
+    auto const full_height = height & ~size_t{3};
+    auto const spare_width = width - full_width;
+
+    // dst(row, col) = src(col, width - 1 - row): the blocks down the right of
+    // src go along the top of dst
+    for (size_t y = 0; y != full_height; y += 4)
+    {
+        for (size_t x = 0; x != full_width; x += 4)
+        {
+            auto const src_x = width - 4 - x;
+            __m128i col[4];
+            sse2_load_transposed(src + y * src_stride + src_x, src_stride, col);
+            for (int i = 0; i != 4; ++i)
+            {
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(dst + (x + 3 - i) * dst_stride + y),
+                    col[i]);
+            }
+        }
+    }
+
+    // What's left of the left-hand columns of src, and of its bottom rows
+    if (spare_width)
+    {
+        scalar_rotate_anticlockwise(
+            src, src_stride, spare_width, height,
+            dst + full_width * dst_stride, dst_stride);
+    }
+    if (full_height != height)
+    {
+        scalar_rotate_anticlockwise(
+            src + full_height * src_stride + spare_width, src_stride, full_width, height - full_height,
+            dst + full_height, dst_stride);
+    }
+}
+
+mgp::Kernels const sse2_kernels{
+    "sse2",
+    &sse2_swap_red_blue,
+    &sse2_reverse,
+    &sse2_fill,
+    &sse2_rotate_clockwise,
+    &sse2_rotate_anticlockwise};
+
+MIR_TARGET("avx2")
+void avx2_swap_red_blue(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    auto const order = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, order));
+    }
+    sse2_swap_red_blue(src + i, dst + i, count - i);
+}
+
+MIR_TARGET("avx2")
+void avx2_reverse(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    auto const order = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + count - 8 - i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permutevar8x32_epi32(v, order));
+    }
+    sse2_reverse(src, dst + i, count - i);
+}
+
+MIR_TARGET("avx2")
+void avx2_fill(uint32_t* dst, size_t count, uint32_t value)
+{
+    auto const v = _mm256_set1_epi32(value);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    sse2_fill(dst + i, count - i, value);
+}
+
+// Rotation is bound by scattered loads and stores rather than arithmetic, so
+// wider transposes don't buy anything over the SSE2 ones.
+mgp::Kernels const avx2_kernels{
+    "avx2",
+    &avx2_swap_red_blue,
+    &avx2_reverse,
+    &avx2_fill,
+    &sse2_rotate_clockwise,
+    &sse2_rotate_anticlockwise};
+
+#undef MIR_TARGET
+#endif // MIR_PIXEL_KERNELS_X86
+
+#ifdef MIR_PIXEL_KERNELS_NEON
+void neon_swap_red_blue(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        // De-interleave into one vector per byte of the pixel and swap two of them
+        auto v = vld4q_u8(reinterpret_cast<uint8_t const*>(src + i));
+        std::swap(v.val[0], v.val[2]);
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst + i), v);
+    }
+    scalar_swap_red_blue(src + i, dst + i, count - i);
+}
+
+void neon_reverse(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const v = vrev64q_u32(vld1q_u32(src + count - 4 - i));
+        vst1q_u32(dst + i, vcombine_u32(vget_high_u32(v), vget_low_u32(v)));
+    }
+    scalar_reverse(src, dst + i, count - i);
+}
+
+void neon_fill(uint32_t* dst, size_t count, uint32_t value)
+{
+    auto const v = vdupq_n_u32(value);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        vst1q_u32(dst + i, v);
+    scalar_fill(dst + i, count - i, value);
+}
+
+mgp::Kernels const neon_kernels{
+    "neon",
+    &neon_swap_red_blue,
+    &neon_reverse,
+    &neon_fill,
+    &scalar_rotate_clockwise,
+    &scalar_rotate_anticlockwise};
+#endif // MIR_PIXEL_KERNELS_NEON
+}
+
+auto mgp::supported_kernels() -> std::vector<Kernels const*>
+{
+    std::vector<Kernels const*> result{&scalar_kernels};
+
+#ifdef MIR_PIXEL_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        result.push_back(&sse2_kernels);
+    if (__builtin_cpu_supports("avx2"))
+        result.push_back(&avx2_kernels);
+#endif
+
+#ifdef MIR_PIXEL_KERNELS_NEON
+    result.push_back(&neon_kernels);
+#endif
+
+    return result;
+}
+
+auto mgp::best_kernels() -> Kernels const&
+{
+    static Kernels const& best = *supported_kernels().back();
+    return best;
+}
+
+void mgp::fill(uint32_t* dst, size_t dst_stride, size_t width, size_t height, uint32_t value)
+{
+    auto const& kernels = best_kernels();
+    for (size_t row = 0; row != height; ++row)
+        kernels.fill(dst + row * dst_stride, width, value);
+}
+
+void mgp::flip_vertically(uint32_t* pixels, size_t stride, size_t width, size_t height, bool swap_red_blue)
+{
+    if (height == 0)
+        return;
+
+    auto const& kernels = best_kernels();
+
+    // Swap rows a chunk at a time, so we don't need a row-sized temporary
+    size_t const chunk_size = 256;
+    uint32_t chunk[chunk_size];
+
+    for (size_t top = 0, bottom = height - 1; top < bottom; ++top, --bottom)
+    {
+        auto const top_row = pixels + top * stride;
+        auto const bottom_row = pixels + bottom * stride;
+
+        for (size_t x = 0; x < width; x += chunk_size)
+        {
+            auto const count = std::min(chunk_size, width - x);
+            std::memcpy(chunk, top_row + x, count * sizeof(uint32_t));
+            if (swap_red_blue)
+            {
+                kernels.swap_red_blue(bottom_row + x, top_row + x, count);
+                kernels.swap_red_blue(chunk, bottom_row + x, count);
+            }
+            else
+            {
+                std::memcpy(top_row + x, bottom_row + x, count * sizeof(uint32_t));
+                std::memcpy(bottom_row + x, chunk, count * sizeof(uint32_t));
+            }
+        }
+    }
+
+    if (swap_red_blue && height % 2)
+    {
+        auto const middle_row = pixels + height / 2 * stride;
+        kernels.swap_red_blue(middle_row, middle_row, width);
+    }
+}
+
+void mgp::copy_rotated(
+    uint32_t const* src, size_t src_stride, size_t width, size_t height,
+    uint32_t* dst, size_t dst_stride,
+    MirOrientation orientation)
+{
+    auto const& kernels = best_kernels();
+
+    switch (orientation)
+    {
+    case mir_orientation_left:
+        kernels.rotate_anticlockwise(src, src_stride, width, height, dst, dst_stride);
+        break;
+
+    case mir_orientation_right:
+        kernels.rotate_clockwise(src, src_stride, width, height, dst, dst_stride);
+        break;
+
+    case mir_orientation_inverted:
+        for (size_t row = 0; row != height; ++row)
+            kernels.reverse(src + (height - 1 - row) * src_stride, dst + row * dst_stride, width);
+        break;
+
+    case mir_orientation_normal:
+    default:
+        for (size_t row = 0; row != height; ++row)
+            std::memcpy(dst + row * dst_stride, src + row * src_stride, width * sizeof(uint32_t));
+        break;
+    }
+}
@@ -22,3 +22,4 @@
 // Define a key function to ensure libmirplatform contains the vtbl and typeinfo
 mir::graphics::WaylandAllocator::~WaylandAllocator() = default;
 mir::graphics::WaylandAllocator::WaylandAllocator() = default;
+mir::graphics::ShmSurfaceState::~ShmSurfaceState() = default;
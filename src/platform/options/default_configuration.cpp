@@ -42,14 +42,18 @@ char const* const mo::input_report_opt            = "input-report";
 char const* const mo::seat_report_opt            = "seat-report";
 char const* const mo::shared_library_prober_report_opt = "shared-library-prober-report";
 char const* const mo::shell_report_opt            = "shell-report";
+char const* const mo::xwayland_report_opt         = "xwayland-report";
 char const* const mo::name_opt                    = "name";
 char const* const mo::offscreen_opt               = "offscreen";
 char const* const mo::touchspots_opt              = "enable-touchspots";
 char const* const mo::cursor_opt                  = "cursor";
 char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
+char const* const mo::async_log_opt               = "async-log";
 char const* const mo::composite_delay_opt         = "composite-delay";
+char const* const mo::texture_cache_budget_opt    = "texture-cache-budget";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
+char const* const mo::coalesce_input_motion_opt   = "coalesce-input-motion";
 char const* const mo::x11_display_opt             = "x11-display-experimental";
 char const* const mo::wayland_extensions_opt      = "wayland-extensions";
 char const* const mo::enable_mirclient_opt        = "enable-mirclient";
@@ -182,11 +186,17 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "How to handle the SharedLibraryProber report. [{log,lttng,off}]")
         (shell_report_opt, po::value<std::string>()->default_value(off_opt_value),
          "How to handle the Shell report. [{log,off}]")
+        (xwayland_report_opt, po::value<std::string>()->default_value(off_opt_value),
+         "How to handle the XWayland report. [{log,off}]")
         (composite_delay_opt, po::value<int>()->default_value(0),
             "Compositor frame delay in milliseconds (how long to wait for new "
             "frames from clients before compositing). Higher values result in "
             "lower latency but risk causing frame skipping. "
             "Default: A negative value means decide automatically.")
+        (texture_cache_budget_opt, po::value<int>()->default_value(128),
+            "Memory (in MiB) the compositor may use, across all outputs, to "
+            "keep the textures of windows that are not currently visible, so "
+            "they are ready when shown again.")
         (name_opt, po::value<std::string>(),
             "When nested, the name Mir uses when registering with the host.")
         (offscreen_opt,
@@ -198,10 +208,17 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Cursor (mouse pointer) to use [{auto,null,software}]")
         (enable_key_repeat_opt, po::value<bool>()->default_value(true),
              "Enable server generated key repeat")
+        (coalesce_input_motion_opt, po::value<std::string>()->default_value(off_opt_value),
+            "Pass pointer and touch motion on at most once per frame per device, "
+            "merging the motion in between [{off,on,resample}]. "
+            "\"resample\" also predicts where the merged motion has got to by the time it is passed on.")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
             "This is only interesting for people doing Mir server or client development.")
+        (async_log_opt, "Write log lines from a background thread, so that logging "
+            "(e.g. by the *-report=log options) doesn't delay the threads doing it. "
+            "Lines are dropped (and counted) if they can't be written fast enough.")
         (enable_mirclient_opt, "Enable deprecated mirclient socket (for running old clients)")
         (console_provider,
             po::value<std::string>()->default_value("auto"),
@@ -23,6 +23,8 @@
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/executor.h"
 #include "mir/renderer/gl/context.h"
+#include "mir/graphics/wayland_allocator.h"
+#include "egl_context_executor.h"
 
 #define MIR_LOG_COMPONENT "wayland-gfx-helpers"
 #include "mir/log.h"
@@ -30,6 +32,7 @@
 #include <boost/throw_exception.hpp>
 #include <mutex>
 #include <atomic>
+#include <deque>
 
 #include MIR_SERVER_GL_H
 #include MIR_SERVER_GLEXT_H
@@ -40,6 +43,7 @@
 
 namespace mg = mir::graphics;
 namespace mgc = mir::graphics::common;
+namespace geom = mir::geometry;
 
 namespace mir
 {
@@ -302,6 +306,117 @@ private:
     }
 };
 
+/**
+ * A GL texture shared by the successive SHM buffers of one wl_surface
+ *
+ * Each buffer gets a serial number as it is imported, and we remember the damage
+ * its client reported. As long as we know the damage of every buffer since the
+ * one whose content is in the texture, binding a newer buffer only needs to
+ * upload the union of that damage. Otherwise (nothing uploaded yet, a change of
+ * size or format, or history we've already forgotten) the whole buffer is uploaded.
+ */
+class SharedShmTexture : public mg::ShmSurfaceState
+{
+public:
+    explicit SharedShmTexture(std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
+        : egl_delegate{std::move(egl_delegate)}
+    {
+    }
+
+    ~SharedShmTexture()
+    {
+        if (tex_id != 0)
+        {
+            egl_delegate->spawn(
+                [id = tex_id]()
+                {
+                    glDeleteTextures(1, &id);
+                });
+        }
+    }
+
+    /// Record a newly imported buffer, returning its serial
+    auto add_buffer(std::vector<geom::Rectangle> const& damage) -> uint64_t
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto const serial = ++last_serial;
+        history.emplace_back(serial, damage);
+        if (history.size() > max_history)
+            history.pop_front();
+        return serial;
+    }
+
+    /**
+     * Bind the texture, first bringing it up to date with buffer \p serial
+     *
+     * \note This must be called with a current GL context
+     */
+    void bind(
+        uint64_t serial,
+        geom::Size const& size,
+        MirPixelFormat format,
+        std::function<void()> const& upload_all,
+        std::function<void(std::vector<geom::Rectangle> const&)> const& upload_damage)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        bool const needs_initialisation = tex_id == 0;
+        if (needs_initialisation)
+        {
+            glGenTextures(1, &tex_id);
+        }
+        glBindTexture(GL_TEXTURE_2D, tex_id);
+        if (needs_initialisation)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+
+        if (serial == uploaded_serial)
+            return;
+
+        bool const history_complete =
+            uploaded_serial != 0 &&
+            uploaded_serial < serial &&
+            !history.empty() &&
+            history.front().first <= uploaded_serial + 1;
+
+        if (history_complete && size == uploaded_size && format == uploaded_format)
+        {
+            std::vector<geom::Rectangle> damage;
+            for (auto const& buffer : history)
+            {
+                if (buffer.first > uploaded_serial && buffer.first <= serial)
+                    damage.insert(damage.end(), buffer.second.begin(), buffer.second.end());
+            }
+            upload_damage(damage);
+        }
+        else
+        {
+            upload_all();
+        }
+
+        uploaded_serial = serial;
+        uploaded_size = size;
+        uploaded_format = format;
+    }
+
+private:
+    static size_t const max_history = 8;
+
+    std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
+
+    std::mutex mutex;
+    GLuint tex_id{0};
+    uint64_t last_serial{0};
+    std::deque<std::pair<uint64_t, std::vector<geom::Rectangle>>> history;
+    uint64_t uploaded_serial{0};
+    geom::Size uploaded_size;
+    MirPixelFormat uploaded_format{mir_pixel_format_invalid};
+};
+
 class WlShmBuffer :
     public mg::common::ShmBuffer,
     public mir::renderer::software::PixelSource
@@ -313,11 +428,15 @@ public:
         mir::geometry::Size const& size,
         mir::geometry::Stride stride,
         MirPixelFormat format,
-        std::function<void()>&& on_consumed)
+        std::function<void()>&& on_consumed,
+        std::shared_ptr<SharedShmTexture> surface_texture,
+        std::vector<geom::Rectangle> const& damage)
         : ShmBuffer(size, format, std::move(egl_delegate)),
           on_consumed{std::move(on_consumed)},
           buffer{std::move(buffer)},
-          stride_{stride}
+          stride_{stride},
+          surface_texture{std::move(surface_texture)},
+          serial{this->surface_texture->add_buffer(damage)}
     {
     }
 
@@ -328,18 +447,29 @@ public:
 
     void bind() override
     {
-        ShmBuffer::bind();
         std::lock_guard<std::mutex> lock{consumption_mutex};
-        if (!uploaded)
-        {
-            read_internal(
-                [this](unsigned char const* pixels)
-                {
-                    upload_to_texture(pixels, stride());
-                });
-            on_consumed();
-            on_consumed = [](){};
-        }
+        surface_texture->bind(
+            serial,
+            size(),
+            pixel_format(),
+            [this]()
+            {
+                read_internal(
+                    [this](unsigned char const* pixels)
+                    {
+                        upload_to_texture(pixels, stride());
+                    });
+            },
+            [this](std::vector<geom::Rectangle> const& damage)
+            {
+                read_internal(
+                    [this, &damage](unsigned char const* pixels)
+                    {
+                        upload_damage_to_texture(pixels, stride(), damage);
+                    });
+            });
+        on_consumed();
+        on_consumed = [](){};
     }
 
     void write(unsigned char const* /*pixels*/, size_t /*size*/) override
@@ -381,23 +511,34 @@ private:
     }
 
     std::mutex consumption_mutex;
-    bool uploaded{false};
     std::function<void()> on_consumed;
     SharedWlBuffer const buffer;
     mir::geometry::Stride const stride_;
+    std::shared_ptr<SharedShmTexture> const surface_texture;
+    uint64_t const serial;
 };
 
 auto mg::wayland::buffer_from_wl_shm(
     wl_resource* buffer,
     std::shared_ptr<Executor> executor,
     std::shared_ptr<common::EGLContextExecutor> egl_delegate,
-    std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer>
+    std::function<void()>&& on_consumed,
+    std::shared_ptr<ShmSurfaceState>& surface_state,
+    std::vector<geometry::Rectangle> const& damage) -> std::shared_ptr<Buffer>
 {
     auto const shm_buffer = wl_shm_buffer_get(buffer);
     if (!shm_buffer)
     {
         BOOST_THROW_EXCEPTION((std::logic_error{"Attempt to import a non-SHM buffer as a SHM buffer"}));
     }
+
+    auto surface_texture = std::dynamic_pointer_cast<SharedShmTexture>(surface_state);
+    if (!surface_texture)
+    {
+        surface_texture = std::make_shared<SharedShmTexture>(egl_delegate);
+        surface_state = surface_texture;
+    }
+
     return std::make_shared<WlShmBuffer>(
         SharedWlBuffer{buffer, std::move(executor)},
         std::move(egl_delegate),
@@ -407,5 +548,7 @@ auto mg::wayland::buffer_from_wl_shm(
         },
         mir::geometry::Stride{wl_shm_buffer_get_stride(shm_buffer)},
         wl_format_to_mir_format(wl_shm_buffer_get_format(shm_buffer)),
-        std::move(on_consumed));
+        std::move(on_consumed),
+        std::move(surface_texture),
+        damage);
 }
@@ -20,8 +20,11 @@
 #ifndef MIR_GRAPHICS_GL_WAYLAND_SHM_PROVIDER_H_
 #define MIR_GRAPHICS_GL_WAYLAND_SHM_PROVIDER_H_
 
+#include "mir/geometry/rectangle.h"
+
 #include <memory>
 #include <functional>
+#include <vector>
 
 struct wl_resource;
 
@@ -32,6 +35,7 @@ class Executor;
 namespace graphics
 {
 class Buffer;
+class ShmSurfaceState;
 
 namespace common
 {
@@ -52,13 +56,19 @@ namespace wayland
  * \param executor      [in]    An Executor that will defer work to the Wayland event loop
  * \param egl_delegate  [in]    An EGL-context-thread delegator
  * \param on_consumed   [in]    Closure to call when the compositor has consumed this buffer
+ * \param surface_state [in,out] Texture storage shared with the other buffers of the same
+ *                              surface; created on first use
+ * \param damage        [in]    The region of this buffer that differs from the surface's
+ *                              previous buffer
  * \return                      An mg::Buffer supporting being rendered from in GL and read by the CPU.
  */
 auto buffer_from_wl_shm(
     wl_resource* buffer,
     std::shared_ptr<Executor> executor,
     std::shared_ptr<common::EGLContextExecutor> egl_delegate,
-    std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer>;
+    std::function<void()>&& on_consumed,
+    std::shared_ptr<ShmSurfaceState>& surface_state,
+    std::vector<geometry::Rectangle> const& damage) -> std::shared_ptr<Buffer>;
 }
 }
 }
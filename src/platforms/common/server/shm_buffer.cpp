@@ -185,6 +185,57 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
     }
 }
 
+void mgc::ShmBuffer::upload_damage_to_texture(
+    void const* pixels,
+    geom::Stride const& stride,
+    std::vector<geom::Rectangle> const& damage)
+{
+    GLenum format, type;
+
+    if (mg::get_gl_pixel_format(pixel_format_, format, type))
+    {
+        auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format());
+        auto const stride_in_px = stride.as_int() / bytes_per_pixel;
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        geom::Rectangle const whole_buffer{{0, 0}, size()};
+        for (auto const& rect : damage)
+        {
+            auto const region = rect.intersection_with(whole_buffer);
+            if (region.size.width.as_int() <= 0 || region.size.height.as_int() <= 0)
+                continue;
+
+            // Rather than GL_UNPACK_SKIP_*, which GLES2 lacks, start from the first damaged pixel
+            auto const first_pixel =
+                static_cast<unsigned char const*>(pixels) +
+                region.top_left.y.as_int() * stride.as_int() +
+                region.top_left.x.as_int() * bytes_per_pixel;
+
+            glTexSubImage2D(
+                GL_TEXTURE_2D,
+                0,
+                region.top_left.x.as_int(), region.top_left.y.as_int(),
+                region.size.width.as_int(), region.size.height.as_int(),
+                format,
+                type,
+                first_pixel);
+        }
+
+        // Be nice to other users of the GL context by reverting our changes to shared state
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
+    }
+    else
+    {
+        mir::log_error(
+            "Buffer %i has non-GL-compatible pixel format %i; rendering will be incomplete",
+            id().as_value(),
+            pixel_format());
+    }
+}
+
 void mgc::MemoryBackedShmBuffer::write(unsigned char const* data, size_t data_size)
 {
     if (data_size != stride_.as_uint32_t()*size().height.as_uint32_t())
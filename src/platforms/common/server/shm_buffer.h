@@ -31,6 +31,8 @@
 
 #include MIR_SERVER_GL_H
 
+#include <vector>
+
 namespace mir
 {
 class ShmFile;
@@ -67,6 +69,18 @@ protected:
 
     /// \note This must be called with a current GL context
     void upload_to_texture(void const* pixels, geometry::Stride const& stride);
+
+    /**
+     * Update only the given regions of the currently bound texture
+     *
+     * The texture must already have storage of this buffer's size and format,
+     * such as from an earlier upload_to_texture().
+     * \note This must be called with a current GL context
+     */
+    void upload_damage_to_texture(
+        void const* pixels,
+        geometry::Stride const& stride,
+        std::vector<geometry::Rectangle> const& damage);
 private:
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
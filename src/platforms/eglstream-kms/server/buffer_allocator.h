@@ -77,7 +77,9 @@ public:
     auto buffer_from_shm(
         wl_resource* buffer,
         std::shared_ptr<Executor> wayland_executor,
-        std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer> override;
+        std::function<void()>&& on_consumed,
+        std::shared_ptr<ShmSurfaceState>& surface_state,
+        std::vector<geometry::Rectangle> const& damage) -> std::shared_ptr<Buffer> override;
 
 private:
     static void create_buffer_eglstream_resource(
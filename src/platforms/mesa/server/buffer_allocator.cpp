@@ -394,11 +394,15 @@ std::shared_ptr<mg::Buffer> mgm::BufferAllocator::buffer_from_resource(
 auto mgm::BufferAllocator::buffer_from_shm(
     wl_resource* buffer,
     std::shared_ptr<Executor> wayland_executor,
-    std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer>
+    std::function<void()>&& on_consumed,
+    std::shared_ptr<ShmSurfaceState>& surface_state,
+    std::vector<geometry::Rectangle> const& damage) -> std::shared_ptr<Buffer>
 {
     return mg::wayland::buffer_from_wl_shm(
         buffer,
         std::move(wayland_executor),
         egl_delegate,
-        std::move(on_consumed));
+        std::move(on_consumed),
+        surface_state,
+        damage);
 }
@@ -76,7 +76,9 @@ public:
 	std::function<void()>&&) override;
 
     std::shared_ptr<Buffer> buffer_from_shm(wl_resource* buffer, std::shared_ptr<mir::Executor> wayland_executor,
-                                            std::function<void()>&& on_consumed) override;
+                                            std::function<void()>&& on_consumed,
+                                            std::shared_ptr<ShmSurfaceState>& surface_state,
+                                            std::vector<geometry::Rectangle> const& damage) override;
 
 private:
     std::shared_ptr<EGLExtensions> const egl_extensions;
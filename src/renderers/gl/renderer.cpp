@@ -20,12 +20,14 @@
 
 #include "renderer.h"
 #include "mir/compositor/buffer_stream.h"
+#include "mir/compositor/compositor_report.h"
 #include "mir/gl/default_program_factory.h"
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/display_buffer.h"
 #include "mir/gl/tessellation_helpers.h"
 #include "mir/gl/texture_cache.h"
+#include "mir/gl/texture_budget.h"
 #include "mir/gl/texture.h"
 #include "mir/log.h"
 #include "mir/report_exception.h"
@@ -38,10 +40,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <iterator>
 #include <sstream>
 
 namespace mg = mir::graphics;
@@ -159,6 +165,28 @@ private:
     GLuint id;
 };
 
+/*
+ * Back buffers older than this are simply redrawn in full. Typical swap
+ * chains have two to four buffers.
+ */
+auto const max_tracked_buffer_age = 5u;
+
+/*
+ * Beyond this many damaged rectangles the cost of a scissored pass per
+ * rectangle outweighs the savings, so they're merged into one.
+ */
+auto const max_damage_rectangles = 16u;
+
+bool egl_supports_buffer_age()
+{
+    auto const display = eglGetCurrentDisplay();
+    if (display == EGL_NO_DISPLAY)
+        return false;
+
+    auto const extensions = eglQueryString(display, EGL_EXTENSIONS);
+    return extensions && strstr(extensions, "EGL_EXT_buffer_age");
+}
+
 using ProgramHandle = GLHandle<&glDeleteProgram>;
 using ShaderHandle = GLHandle<&glDeleteShader>;
 
@@ -335,13 +363,26 @@ mrg::Renderer::Program::Program(GLuint program_id)
 }
 
 mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
+    : Renderer(
+        display_buffer,
+        std::make_shared<mgl::TextureBudget>(mgl::DefaultProgramFactory::default_texture_cache_budget),
+        nullptr)
+{
+}
+
+mrg::Renderer::Renderer(
+    graphics::DisplayBuffer& display_buffer,
+    std::shared_ptr<mgl::TextureBudget> const& texture_budget,
+    std::shared_ptr<compositor::CompositorReport> const& report)
     : render_target(&display_buffer),
       clear_color{0.0f, 0.0f, 0.0f, 0.0f},
       default_program(family.add_program(vshader, default_fshader)),
       alpha_program(family.add_program(vshader, alpha_fshader)),
       program_factory{std::make_unique<ProgramFactory>()},
-      texture_cache(mgl::DefaultProgramFactory().create_texture_cache()),
-      display_transform(1)
+      texture_cache(mgl::DefaultProgramFactory(texture_budget).create_texture_cache()),
+      report{report},
+      display_transform(1),
+      buffer_age_supported{egl_supports_buffer_age()}
 {
     eglBindAPI(MIR_SERVER_EGL_OPENGL_API);
     EGLDisplay disp = eglGetCurrentDisplay();
@@ -411,14 +452,52 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 {
     render_target.bind();
 
+    auto frame_damage = damage_since_last_frame(renderables);
+    if (damage_history.empty())
+    {
+        // We know nothing about what the back buffers hold
+        frame_damage = geom::Rectangles{viewport};
+    }
+
+    damage_history.push_front(frame_damage);
+    if (damage_history.size() > max_tracked_buffer_age)
+        damage_history.pop_back();
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
+
+    if (auto const damage = damage_to_repaint())
+    {
+        for (auto const& rect : damage.value())
+        {
+            // Each pass clears and repaints its rectangle from scratch, so
+            // overlapping rectangles cost time but never double-blend.
+            damage_clip = rect;
+
+            glEnable(GL_SCISSOR_TEST);
+            set_scissor(rect);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glDisable(GL_SCISSOR_TEST);
+
+            for (auto const& r : renderables)
+            {
+                if (area_of(*r).overlaps(rect))
+                    draw(*r);
+            }
+        }
+
+        damage_clip = {};
+    }
+    else
     {
-        draw(*r);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        for (auto const& r : renderables)
+        {
+            draw(*r);
+        }
     }
 
     render_target.swap_buffers();
@@ -427,26 +506,177 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
     // does not affect screen contents so can happen after swap_buffers...
     texture_cache->drop_unused();
 
+    if (report)
+    {
+        auto const usage = texture_cache->usage();
+        report->texture_cache_usage(
+            this, usage.textures, usage.bytes, usage.evicted_textures, usage.evicted_bytes);
+    }
+
     while (auto const gl_error = glGetError())
         mir::log_debug("GL error: %d", gl_error);
 }
 
-void mrg::Renderer::draw(mg::Renderable const& renderable) const
+std::experimental::optional<geom::Rectangles> mrg::Renderer::damage_to_repaint() const
+{
+    /*
+     * The back buffer still holds what we drew "age" frames ago, so only the
+     * union of the damage from the frames since then needs repainting. An
+     * age of zero means the contents are undefined.
+     */
+    auto const age = back_buffer_age();
+    if (age <= 0 || static_cast<unsigned>(age) > damage_history.size())
+        return {};
+
+    geom::Rectangles damage;
+    for (auto frame = damage_history.begin(); frame != damage_history.begin() + age; ++frame)
+    {
+        for (auto const& rect : *frame)
+        {
+            auto const visible = rect.intersection_with(viewport);
+            if (visible.size.width.as_int() > 0 && visible.size.height.as_int() > 0)
+                damage.add(visible);
+        }
+    }
+
+    if (damage.size() > 0 && damage.bounding_rectangle().contains(viewport))
+        return {};
+
+    if (damage.size() > max_damage_rectangles)
+        damage = geom::Rectangles{damage.bounding_rectangle()};
+
+    return damage;
+}
+
+geom::Rectangle mrg::Renderer::area_of(mg::Renderable const& renderable) const
 {
+    // A transformed renderable may be drawn anywhere on the output
+    if (renderable.transformation() != glm::mat4(1))
+        return viewport;
+
     auto const clip_area = renderable.clip_area();
     if (clip_area)
+        return renderable.screen_position().intersection_with(clip_area.value());
+
+    return renderable.screen_position();
+}
+
+geom::Rectangles mrg::Renderer::damage_since_last_frame(mg::RenderableList const& renderables) const
+{
+    std::vector<DrawnRenderable> this_frame;
+    this_frame.reserve(renderables.size());
+    for (auto const& r : renderables)
+    {
+        auto const buffer = r->buffer();
+        this_frame.push_back(DrawnRenderable{
+            r->id(),
+            buffer ? buffer->id() : mg::BufferID{},
+            r->content_serial(),
+            area_of(*r),
+            r->alpha()});
+    }
+
+    geom::Rectangles damage;
+
+    // A client can refill and resubmit the buffer it last submitted, so an
+    // unchanged BufferID proves nothing by itself. Only an unchanged, tracked
+    // content serial says the pixels are the ones we drew last time.
+    auto const content_may_have_changed = [](DrawnRenderable const& was, DrawnRenderable const& now)
+        {
+            return now.content_serial == 0 || was.content_serial != now.content_serial;
+        };
+
+    auto const same_id = [](DrawnRenderable const& a, DrawnRenderable const& b) { return a.id == b.id; };
+    auto const in = [&same_id](std::vector<DrawnRenderable> const& list, DrawnRenderable const& r)
+        {
+            return std::any_of(list.begin(), list.end(), [&](DrawnRenderable const& e) { return same_id(e, r); });
+        };
+
+    // Anything that appeared or disappeared damages the area it covers
+    for (auto const& r : last_frame)
+        if (!in(this_frame, r))
+            damage.add(r.area);
+    for (auto const& r : this_frame)
+        if (!in(last_frame, r))
+            damage.add(r.area);
+
+    std::vector<DrawnRenderable> old_common, new_common;
+    std::copy_if(last_frame.begin(), last_frame.end(), std::back_inserter(old_common),
+                 [&](DrawnRenderable const& r) { return in(this_frame, r); });
+    std::copy_if(this_frame.begin(), this_frame.end(), std::back_inserter(new_common),
+                 [&](DrawnRenderable const& r) { return in(last_frame, r); });
+
+    if (!std::equal(old_common.begin(), old_common.end(), new_common.begin(), same_id))
+    {
+        // Restacked: rather than work out exactly what changed, repaint everything
+        damage.add(viewport);
+    }
+    else
+    {
+        for (auto i = 0u; i != new_common.size(); ++i)
+        {
+            auto const& was = old_common[i];
+            auto const& now = new_common[i];
+
+            if (was.area != now.area)
+            {
+                damage.add(was.area);
+                damage.add(now.area);
+            }
+            else if (was.buffer_id != now.buffer_id || was.alpha != now.alpha ||
+                     content_may_have_changed(was, now))
+            {
+                damage.add(now.area);
+            }
+        }
+    }
+
+    last_frame = std::move(this_frame);
+    return damage;
+}
+
+int mrg::Renderer::back_buffer_age() const
+{
+    if (!buffer_age_supported || !viewport_is_pixel_exact)
+        return 0;
+
+    // Render targets that draw into an FBO don't have an EGL back buffer
+    GLint framebuffer = -1;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    if (framebuffer != 0)
+        return 0;
+
+    EGLint age = 0;
+    if (!eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), EGL_BUFFER_AGE_EXT, &age))
+        return 0;
+
+    return age;
+}
+
+void mrg::Renderer::set_scissor(geom::Rectangle const& area) const
+{
+    glScissor(
+        area.top_left.x.as_int() -
+            viewport.top_left.x.as_int(),
+        viewport.top_left.y.as_int() +
+            viewport.size.height.as_int() -
+            area.top_left.y.as_int() -
+            area.size.height.as_int(),
+        area.size.width.as_int(),
+        area.size.height.as_int()
+    );
+}
+
+void mrg::Renderer::draw(mg::Renderable const& renderable) const
+{
+    auto scissor = renderable.clip_area();
+    if (damage_clip)
+        scissor = scissor ? scissor.value().intersection_with(damage_clip.value()) : damage_clip;
+
+    if (scissor)
     {
         glEnable(GL_SCISSOR_TEST);
-        glScissor(
-            clip_area.value().top_left.x.as_int() -
-                viewport.top_left.x.as_int(),
-            viewport.top_left.y.as_int() +
-                viewport.size.height.as_int() -
-                clip_area.value().top_left.y.as_int() -
-                clip_area.value().size.height.as_int(),
-            clip_area.value().size.width.as_int(), 
-            clip_area.value().size.height.as_int()
-        );
+        set_scissor(scissor.value());
     }
 
     auto const texture = std::dynamic_pointer_cast<mg::gl::Texture>(renderable.buffer());
@@ -628,7 +858,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
 
     glDisableVertexAttribArray(prog.texcoord_attr);
     glDisableVertexAttribArray(prog.position_attr);
-    if (renderable.clip_area())
+    if (scissor)
     {
         glDisable(GL_SCISSOR_TEST);
     }
@@ -674,6 +904,7 @@ void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
                       0.0f});
 
     viewport = rect;
+    damage_history.clear();
     update_gl_viewport();
 }
 
@@ -710,6 +941,15 @@ void mrg::Renderer::update_gl_viewport()
         GLint offset_y = (buf_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+
+        viewport_is_pixel_exact =
+            display_transform == glm::mat4(1) &&
+            buf_width == viewport.size.width.as_int() &&
+            buf_height == viewport.size.height.as_int();
+    }
+    else
+    {
+        viewport_is_pixel_exact = false;
     }
 }
 
@@ -719,12 +959,15 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
     if (new_display_transform != display_transform)
     {
         display_transform = new_display_transform;
+        damage_history.clear();
         update_gl_viewport();
     }
 }
 
 void mrg::Renderer::suspend()
 {
+    // Whatever is in the back buffers is no longer what we last drew
+    damage_history.clear();
     texture_cache->invalidate();
 }
 
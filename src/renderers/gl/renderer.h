@@ -23,20 +23,23 @@
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
 #include "mir/renderer/gl/render_target.h"
 
 #include MIR_SERVER_GL_H
+#include <deque>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 namespace mir
 {
-namespace gl { class TextureCache; }
+namespace gl { class TextureCache; class TextureBudget; }
 namespace graphics { class DisplayBuffer; }
+namespace compositor { class CompositorReport; }
 namespace renderer
 {
 namespace gl
@@ -60,6 +63,10 @@ class Renderer : public renderer::Renderer
 {
 public:
     Renderer(graphics::DisplayBuffer& display_buffer);
+    Renderer(
+        graphics::DisplayBuffer& display_buffer,
+        std::shared_ptr<mir::gl::TextureBudget> const& texture_budget,
+        std::shared_ptr<compositor::CompositorReport> const& report);
     virtual ~Renderer();
 
     // These are called with a valid GL context:
@@ -128,13 +135,41 @@ protected:
 private:
     void update_gl_viewport();
 
+    /**
+     * The state of a renderable as it was last drawn. Comparing this with
+     * the next frame's renderables tells us which parts of the output changed.
+     */
+    struct DrawnRenderable
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer_id;
+        uint64_t content_serial;
+        geometry::Rectangle area;
+        float alpha;
+    };
+
+    geometry::Rectangle area_of(graphics::Renderable const& renderable) const;
+    geometry::Rectangles damage_since_last_frame(graphics::RenderableList const& renderables) const;
+    std::experimental::optional<geometry::Rectangles> damage_to_repaint() const;
+    int back_buffer_age() const;
+    void set_scissor(geometry::Rectangle const& area) const;
+
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
     std::unique_ptr<mir::gl::TextureCache> const texture_cache;
+    std::shared_ptr<compositor::CompositorReport> const report; // May be null
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+
+    // Partial redraw is only used when the default framebuffer maps 1:1 onto
+    // the viewport and EGL can tell us how stale the back buffer is.
+    bool const buffer_age_supported;
+    bool viewport_is_pixel_exact{false};
+    std::vector<DrawnRenderable> mutable last_frame;
+    std::deque<geometry::Rectangles> mutable damage_history; // newest first
+    std::experimental::optional<geometry::Rectangle> mutable damage_clip;
 };
 
 }
@@ -19,12 +19,21 @@
 #include "renderer_factory.h"
 #include "renderer.h"
 #include "mir/graphics/display_buffer.h"
+#include "mir/gl/texture_budget.h"
 
 namespace mrg = mir::renderer::gl;
 
+mrg::RendererFactory::RendererFactory(
+    size_t texture_cache_budget,
+    std::shared_ptr<compositor::CompositorReport> const& report) :
+    texture_budget{std::make_shared<mir::gl::TextureBudget>(texture_cache_budget)},
+    report{report}
+{
+}
+
 std::unique_ptr<mir::renderer::Renderer>
 mrg::RendererFactory::create_renderer_for(
     graphics::DisplayBuffer& display_buffer)
 {
-    return std::make_unique<Renderer>(display_buffer);
+    return std::make_unique<Renderer>(display_buffer, texture_budget, report);
 }
@@ -21,8 +21,12 @@
 
 #include "mir/renderer/renderer_factory.h"
 
+#include <cstddef>
+
 namespace mir
 {
+namespace compositor { class CompositorReport; }
+namespace gl { class TextureBudget; }
 namespace renderer
 {
 namespace gl
@@ -31,8 +35,17 @@ namespace gl
 class RendererFactory : public renderer::RendererFactory
 {
 public:
+    /// \param texture_cache_budget Bytes of textures the renderers of all outputs, together, may keep
+    RendererFactory(
+        size_t texture_cache_budget,
+        std::shared_ptr<compositor::CompositorReport> const& report);
+
     std::unique_ptr<renderer::Renderer> create_renderer_for(
         graphics::DisplayBuffer& display_buffer) override;
+
+private:
+    std::shared_ptr<mir::gl::TextureBudget> const texture_budget;
+    std::shared_ptr<compositor::CompositorReport> const report;
 };
 
 }
@@ -34,7 +34,11 @@ namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace mf = mir::frontend;
 
-mc::BufferStreamFactory::BufferStreamFactory()
+mc::BufferStreamFactory::BufferStreamFactory(
+    std::shared_ptr<time::Clock> const& clock,
+    std::shared_ptr<time::AlarmFactory> const& alarms) :
+    clock{clock},
+    alarms{alarms}
 {
 }
 
@@ -49,5 +53,5 @@ std::shared_ptr<mc::BufferStream> mc::BufferStreamFactory::create_buffer_stream(
     mg::BufferProperties const& buffer_properties)
 {
     return std::make_shared<mc::Stream>(
-        buffer_properties.size, buffer_properties.format);
+        buffer_properties.size, buffer_properties.format, clock, alarms);
 }
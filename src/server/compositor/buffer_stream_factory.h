@@ -31,13 +31,20 @@ namespace graphics
 {
 class GraphicBufferAllocator;
 }
+namespace time
+{
+class AlarmFactory;
+class Clock;
+}
 namespace compositor
 {
 
 class BufferStreamFactory : public scene::BufferStreamFactory
 {
 public:
-    BufferStreamFactory();
+    BufferStreamFactory(
+        std::shared_ptr<time::Clock> const& clock,
+        std::shared_ptr<time::AlarmFactory> const& alarms);
 
     virtual ~BufferStreamFactory() {}
 
@@ -46,6 +53,10 @@ public:
         graphics::BufferProperties const& buffer_properties) override;
     virtual std::shared_ptr<BufferStream> create_buffer_stream(
         graphics::BufferProperties const&) override;
+
+private:
+    std::shared_ptr<time::Clock> const clock;
+    std::shared_ptr<time::AlarmFactory> const alarms;
 };
 
 }
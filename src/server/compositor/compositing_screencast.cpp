@@ -19,6 +19,7 @@
 #include "compositing_screencast.h"
 #include "screencast_display_buffer.h"
 #include "queueing_schedule.h"
+#include "output_frame_taps.h"
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/buffer_properties.h"
 #include "mir/graphics/display.h"
@@ -29,13 +30,18 @@
 #include "mir/graphics/transformation.h"
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/geometry/rectangles.h"
+#include "mir/geometry/region.h"
+#include "mir/scene/legacy_scene_change_notification.h"
 #include "mir/raii.h"
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+
 namespace mc = mir::compositor;
 namespace mf = mir::frontend;
 namespace mg = mir::graphics;
+namespace ms = mir::scene;
 namespace geom = mir::geometry;
 
 namespace
@@ -64,9 +70,36 @@ std::unique_ptr<mg::VirtualOutput> make_virtual_output(mg::Display& display, geo
     }
     return nullptr;
 }
+
+/// Maps damage within the capture region onto a buffer the region is scaled to fill
+geom::Region to_buffer_coordinates(geom::Region const& damage, geom::Rectangle const& region, geom::Size const& size)
+{
+    auto const scale = [](int value, int to, int from)
+        { return static_cast<int>(static_cast<int64_t>(value) * to / from); };
+    auto const scale_up = [](int value, int to, int from)
+        { return static_cast<int>((static_cast<int64_t>(value) * to + from - 1) / from); };
+
+    auto const region_width = region.size.width.as_int();
+    auto const region_height = region.size.height.as_int();
+    auto const width = size.width.as_int();
+    auto const height = size.height.as_int();
+
+    geom::Region result;
+    for (auto const& rect : damage)
+    {
+        auto const offset = rect.top_left - region.top_left;
+        auto const left = scale(offset.dx.as_int(), width, region_width);
+        auto const top = scale(offset.dy.as_int(), height, region_height);
+        auto const right = scale_up(offset.dx.as_int() + rect.size.width.as_int(), width, region_width);
+        auto const bottom = scale_up(offset.dy.as_int() + rect.size.height.as_int(), height, region_height);
+
+        result.unite(geom::Rectangle{{left, top}, {right - left, bottom - top}});
+    }
+    return result;
+}
 }
 
-class mc::detail::ScreencastSessionContext
+class mc::detail::ScreencastSessionContext : public FrameTap
 {
 public:
     ScreencastSessionContext(
@@ -82,23 +115,51 @@ public:
       display_buffer_compositor{db_compositor_factory.create_compositor_for(*display_buffer)},
       virtual_output{make_virtual_output(display, capture_region)},
       queue_size(capture_size),
-      mirror_mode(mirror_mode)
+      mirror_mode(mirror_mode),
+      capture_region(capture_region),
+      observer{std::make_shared<ms::LegacySceneChangeNotification>(
+          [this] { add_damage(this->capture_region); },
+          [this](int, geom::Rectangle const& damage) { add_damage(damage); })}
     {
         for (auto buffer : buffers)
             free_queue.schedule(buffer);
 
         scene->register_compositor(this);
+        scene->add_observer(observer);
         if (virtual_output)
             virtual_output->enable();
     }
     ~ScreencastSessionContext()
     {
+        scene->remove_observer(observer);
         scene->unregister_compositor(this);
     }
 
     std::shared_ptr<mg::Buffer> capture()
     {
         std::lock_guard<decltype(mutex)> lk(mutex);
+        reclaim_frame_buffers(lk);
+
+        // The output we're capturing has drawn the scene for us
+        auto const frame = take_copied_frame();
+        if (frame.buffer)
+        {
+            if (last_captured_buffer)
+                free_queue.schedule(last_captured_buffer);
+
+            frame.copy->wait();
+            last_captured_buffer = frame.buffer;
+            rendered(last_captured_buffer, take_damage());
+            return last_captured_buffer;
+        }
+
+        // Nothing we'd draw has changed, so the client can have the same image again
+        if (last_captured_buffer && !needs_redraw(*last_captured_buffer))
+        {
+            no_change();
+            return last_captured_buffer;
+        }
+
         if (queue_size != display_buffer->renderbuffer_size())
             display_buffer->set_renderbuffer_size(queue_size);
 
@@ -107,15 +168,27 @@ public:
         if (last_captured_buffer)
             free_queue.schedule(last_captured_buffer);
 
+        auto const damage = take_damage();
         display_buffer_compositor->composite(scene->scene_elements_for(this));
 
         last_captured_buffer = ready_queue.next_buffer();
+        rendered(last_captured_buffer, damage);
+        recheck_pending_frames();
         return last_captured_buffer;
     }
 
     void capture(std::shared_ptr<mg::Buffer> const& buffer)
     {
         std::lock_guard<decltype(mutex)> lk(mutex);
+        reclaim_frame_buffers(lk);
+
+        // The client is handing back a buffer that already holds the current image
+        if (!needs_redraw(*buffer))
+        {
+            no_change();
+            return;
+        }
+
         if (buffer->size() != display_buffer->renderbuffer_size())
             display_buffer->set_renderbuffer_size(buffer->size());
        
@@ -138,15 +211,171 @@ public:
         for(auto i = 0u; i < scheduled; i++)
             free_queue.schedule(free_queue.next_buffer());
 
+        auto const damage = take_damage();
         display_buffer_compositor->composite(scene->scene_elements_for(this));
         if (buffer != ready_queue.next_buffer())
             throw std::runtime_error("unable to capture to buffer");
 
         display_buffer->set_transformation(mg::transformation(mirror_mode));
         display_buffer->commit();
+        rendered(buffer, damage);
+        recheck_pending_frames();
+    }
+
+    geom::Region last_capture_damage()
+    {
+        std::lock_guard<decltype(damage_mutex)> lock{damage_mutex};
+        return last_damage;
+    }
+
+    /// Frames of an output can be copied only if they're exactly what we'd render for capture()
+    bool can_tap_output() const
+    {
+        return mirror_mode == mir_mirror_mode_none && queue_size == capture_region.size;
+    }
+
+    geom::Rectangle tapped_area() const override
+    {
+        return capture_region;
+    }
+
+    std::shared_ptr<mg::Buffer> acquire_frame_buffer() override
+    {
+        // Don't hold up the output's compositor while we're busy capturing
+        if (!mutex.try_lock())
+            return nullptr;
+
+        std::lock_guard<decltype(mutex)> lock{mutex, std::adopt_lock};
+        reclaim_frame_buffers(lock);
+        if (free_queue.num_scheduled() == 0)
+            return nullptr;
+
+        return free_queue.next_buffer();
+    }
+
+    void release_frame_buffer(
+        std::shared_ptr<mg::Buffer> const& buffer,
+        std::shared_ptr<FrameCopy> const& copy) override
+    {
+        {
+            // The output's compositor mustn't wait for mutex, so free_queue
+            // gets these back the next time it's held
+            std::lock_guard<decltype(frame_mutex)> lock{frame_mutex};
+            if (!copy)
+            {
+                returned_frame_buffers.push_back(buffer);
+            }
+            else
+            {
+                if (copied_frame.buffer)
+                    returned_frame_buffers.push_back(copied_frame.buffer);
+                copied_frame = {buffer, copy};
+            }
+        }
+
+        if (!copy)
+            frame_missed();
+    }
+
+    void frame_missed() override
+    {
+        // We'll have to draw whatever changed ourselves
+        add_damage(capture_region);
     }
 
 private:
+    /// Scene damage (clipped to the capture region) a buffer hasn't been redrawn for
+    struct BufferDamage
+    {
+        std::weak_ptr<mg::Buffer> buffer;
+        geom::Region damage;
+    };
+
+    /// The latest frame copied from the output we're capturing
+    struct CopiedFrame
+    {
+        std::shared_ptr<mg::Buffer> buffer;
+        std::shared_ptr<FrameCopy> copy;
+    };
+
+    void add_damage(geom::Rectangle const& area)
+    {
+        geom::Region damage{area};
+        damage.intersect(capture_region);
+        if (damage.empty())
+            return;
+
+        std::lock_guard<decltype(damage_mutex)> lock{damage_mutex};
+        damage_since_last_capture.unite(damage);
+        for (auto& drawn : drawn_buffers)
+            drawn.damage.unite(damage);
+    }
+
+    bool needs_redraw(mg::Buffer const& buffer)
+    {
+        std::lock_guard<decltype(damage_mutex)> lock{damage_mutex};
+        for (auto const& drawn : drawn_buffers)
+        {
+            if (drawn.buffer.lock().get() == &buffer)
+                return !drawn.damage.empty();
+        }
+        return true;
+    }
+
+    void no_change()
+    {
+        std::lock_guard<decltype(damage_mutex)> lock{damage_mutex};
+        last_damage.clear();
+    }
+
+    geom::Region take_damage()
+    {
+        std::lock_guard<decltype(damage_mutex)> lock{damage_mutex};
+        geom::Region damage;
+        std::swap(damage, damage_since_last_capture);
+        return damage;
+    }
+
+    void reclaim_frame_buffers(std::lock_guard<std::mutex> const&)
+    {
+        std::lock_guard<decltype(frame_mutex)> lock{frame_mutex};
+        for (auto const& buffer : returned_frame_buffers)
+            free_queue.schedule(buffer);
+        returned_frame_buffers.clear();
+    }
+
+    CopiedFrame take_copied_frame()
+    {
+        std::lock_guard<decltype(frame_mutex)> lock{frame_mutex};
+        CopiedFrame frame;
+        std::swap(frame, copied_frame);
+        return frame;
+    }
+
+    void recheck_pending_frames()
+    {
+        // Surfaces with more frames queued need us to come back for them
+        if (scene->frames_pending(this) > 0)
+            add_damage(capture_region);
+    }
+
+    void rendered(std::shared_ptr<mg::Buffer> const& buffer, geom::Region const& damage)
+    {
+        std::lock_guard<decltype(damage_mutex)> lock{damage_mutex};
+        drawn_buffers.erase(
+            std::remove_if(drawn_buffers.begin(), drawn_buffers.end(),
+                [&buffer](BufferDamage const& drawn)
+                {
+                    auto const b = drawn.buffer.lock();
+                    return !b || b == buffer;
+                }),
+            drawn_buffers.end());
+
+        // Anything damaged while we were compositing still needs drawing
+        drawn_buffers.push_back({buffer, damage_since_last_capture});
+        last_damage = to_buffer_coordinates(damage, capture_region, buffer->size());
+    }
+
     std::mutex mutex;
     std::shared_ptr<Scene> const scene;
     QueueingSchedule free_queue;
@@ -158,6 +387,17 @@ private:
     std::shared_ptr<mg::Buffer> last_captured_buffer;
     geom::Size queue_size;
     MirMirrorMode mirror_mode;
+    geom::Rectangle const capture_region;
+
+    std::mutex damage_mutex;
+    geom::Region damage_since_last_capture{capture_region};
+    std::vector<BufferDamage> drawn_buffers;
+    geom::Region last_damage;
+    std::shared_ptr<ms::LegacySceneChangeNotification> const observer;
+
+    std::mutex frame_mutex;
+    CopiedFrame copied_frame;
+    std::vector<std::shared_ptr<mg::Buffer>> returned_frame_buffers;
 };
 
 
@@ -166,11 +406,31 @@ mc::CompositingScreencast::CompositingScreencast(
     std::shared_ptr<mg::Display> const& display,
     std::shared_ptr<mg::GraphicBufferAllocator> const& buffer_allocator,
     std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory)
+    : CompositingScreencast(scene, display, buffer_allocator, db_compositor_factory, nullptr)
+{
+}
+
+mc::CompositingScreencast::CompositingScreencast(
+    std::shared_ptr<Scene> const& scene,
+    std::shared_ptr<mg::Display> const& display,
+    std::shared_ptr<mg::GraphicBufferAllocator> const& buffer_allocator,
+    std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
+    std::shared_ptr<OutputFrameTaps> const& output_frame_taps)
     : scene{scene},
       display{display},
       buffer_allocator{buffer_allocator},
-      db_compositor_factory{db_compositor_factory}
+      db_compositor_factory{db_compositor_factory},
+      output_frame_taps{output_frame_taps}
+{
+}
+
+mc::CompositingScreencast::~CompositingScreencast()
 {
+    if (output_frame_taps)
+    {
+        for (auto const& session : session_contexts)
+            output_frame_taps->remove(session.second);
+    }
 }
 
 mf::ScreencastSessionId mc::CompositingScreencast::create_session(
@@ -198,7 +458,12 @@ mf::ScreencastSessionId mc::CompositingScreencast::create_session(
     {
         buffer = buffer_allocator->alloc_buffer(mg::BufferProperties{size, pixel_format, buffer_usage});
     }
-    session_contexts[id] = create_session_context(region, size, buffers, mirror_mode);
+    auto const context = create_session_context(region, size, buffers, mirror_mode);
+    session_contexts[id] = context;
+
+    // When capturing exactly an output we can take copies of what it renders
+    if (output_frame_taps && context->can_tap_output())
+        output_frame_taps->add(context);
 
     return id;
 }
@@ -206,7 +471,13 @@ mf::ScreencastSessionId mc::CompositingScreencast::create_session(
 void mc::CompositingScreencast::destroy_session(mf::ScreencastSessionId id)
 {
     std::lock_guard<decltype(session_mutex)> lock{session_mutex};
-    session_contexts.erase(id);
+    auto const context = session_contexts.find(id);
+    if (context == session_contexts.end())
+        return;
+
+    if (output_frame_taps)
+        output_frame_taps->remove(context->second);
+    session_contexts.erase(context);
 }
 
 std::shared_ptr<mc::detail::ScreencastSessionContext> mc::CompositingScreencast::session(mf::ScreencastSessionId id)
@@ -248,3 +519,8 @@ void mc::CompositingScreencast::capture(
 {
     session(id)->capture(b);
 }
+
+geom::Region mc::CompositingScreencast::last_capture_damage(mf::ScreencastSessionId id)
+{
+    return session(id)->last_capture_damage();
+}
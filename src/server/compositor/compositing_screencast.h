@@ -36,6 +36,7 @@ class GraphicBufferAllocator;
 namespace compositor
 {
 class Scene;
+class OutputFrameTaps;
 namespace detail { struct ScreencastSessionContext; }
 
 class DisplayBufferCompositorFactory;
@@ -49,6 +50,16 @@ public:
         std::shared_ptr<graphics::GraphicBufferAllocator> const& buffer_allocator,
         std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory);
 
+    /// Sessions capturing exactly an output, 1:1, use copies of the output's frames from output_frame_taps
+    CompositingScreencast(
+        std::shared_ptr<Scene> const& scene,
+        std::shared_ptr<graphics::Display> const& display,
+        std::shared_ptr<graphics::GraphicBufferAllocator> const& buffer_allocator,
+        std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
+        std::shared_ptr<OutputFrameTaps> const& output_frame_taps);
+
+    ~CompositingScreencast();
+
     frontend::ScreencastSessionId create_session(
         geometry::Rectangle const& region,
         geometry::Size const& size,
@@ -58,6 +69,7 @@ public:
     void destroy_session(frontend::ScreencastSessionId id) override;
     std::shared_ptr<graphics::Buffer> capture(frontend::ScreencastSessionId id) override;
     void capture(frontend::ScreencastSessionId id, std::shared_ptr<graphics::Buffer> const& buffer) override;
+    geometry::Region last_capture_damage(frontend::ScreencastSessionId id) override;
 
 private:
     frontend::ScreencastSessionId next_available_session_id();
@@ -73,6 +85,7 @@ private:
     std::shared_ptr<graphics::Display> const display;
     std::shared_ptr<graphics::GraphicBufferAllocator> const buffer_allocator;
     std::shared_ptr<DisplayBufferCompositorFactory> const db_compositor_factory;
+    std::shared_ptr<OutputFrameTaps> const output_frame_taps;
 
     std::unordered_map<frontend::ScreencastSessionId,
                        std::shared_ptr<detail::ScreencastSessionContext>> session_contexts;
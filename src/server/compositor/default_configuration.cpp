@@ -24,6 +24,7 @@
 #include "multi_threaded_compositor.h"
 #include "gl/renderer_factory.h"
 #include "compositing_screencast.h"
+#include "output_frame_taps.h"
 #include "mir/main_loop.h"
 
 #include "mir/frontend/screencast.h"
@@ -31,6 +32,8 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+
 namespace mc = mir::compositor;
 namespace ms = mir::scene;
 namespace mf = mir::frontend;
@@ -39,9 +42,9 @@ std::shared_ptr<ms::BufferStreamFactory>
 mir::DefaultServerConfiguration::the_buffer_stream_factory()
 {
     return buffer_stream_factory(
-        []()
+        [this]()
         {
-            return std::make_shared<mc::BufferStreamFactory>();
+            return std::make_shared<mc::BufferStreamFactory>(the_clock(), the_main_loop());
         });
 }
 
@@ -72,10 +75,14 @@ mir::DefaultServerConfiguration::the_compositor()
             std::chrono::milliseconds const composite_delay(
                 the_options()->get<int>(options::composite_delay_opt));
 
+            // Outputs' frames are offered to screencasts capturing exactly those outputs
+            auto const db_compositor_factory = std::make_shared<mc::TappingDisplayBufferCompositorFactory>(
+                the_display_buffer_compositor_factory(), the_output_frame_taps());
+
             return std::make_shared<mc::MultiThreadedCompositor>(
                 the_display(),
                 the_scene(),
-                the_display_buffer_compositor_factory(),
+                db_compositor_factory,
                 the_shell(),
                 the_compositor_report(),
                 composite_delay,
@@ -86,9 +93,14 @@ mir::DefaultServerConfiguration::the_compositor()
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
-        []()
+        [this]()
         {
-            return std::make_shared<mir::renderer::gl::RendererFactory>();
+            auto const texture_cache_budget_mib =
+                the_options()->get<int>(options::texture_cache_budget_opt);
+
+            return std::make_shared<mir::renderer::gl::RendererFactory>(
+                size_t(std::max(texture_cache_budget_mib, 0)) * 1024 * 1024,
+                the_compositor_report());
         });
 }
 
@@ -101,7 +113,17 @@ std::shared_ptr<mf::Screencast> mir::DefaultServerConfiguration::the_screencast(
                 the_scene(),
                 the_display(),
                 the_buffer_allocator(),
-                the_display_buffer_compositor_factory()
+                the_display_buffer_compositor_factory(),
+                the_output_frame_taps()
                 );
         });
 }
+
+std::shared_ptr<mc::OutputFrameTaps> mir::DefaultServerConfiguration::the_output_frame_taps()
+{
+    return output_frame_taps(
+        []
+        {
+            return std::make_shared<mc::OutputFrameTaps>();
+        });
+}
@@ -31,12 +31,12 @@ void mc::DroppingSchedule::schedule(std::shared_ptr<mg::Buffer> const& buffer)
 {
     std::lock_guard<decltype(mutex)> lk(mutex);
     the_only_buffer = buffer;
+    scheduled = static_cast<bool>(the_only_buffer);
 }
 
 unsigned int mc::DroppingSchedule::num_scheduled()
 {
-    std::lock_guard<decltype(mutex)> lk(mutex);
-    if (the_only_buffer)
+    if (scheduled)
         return 1;
     else
         return 0;
@@ -49,5 +49,6 @@ std::shared_ptr<mg::Buffer> mc::DroppingSchedule::next_buffer()
         BOOST_THROW_EXCEPTION(std::logic_error("no buffer scheduled"));
     auto buffer = the_only_buffer;
     the_only_buffer = nullptr;
+    scheduled = false;
     return buffer;
 }
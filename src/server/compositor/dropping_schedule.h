@@ -19,6 +19,7 @@
 #ifndef MIR_COMPOSITOR_DROPPING_SCHEDULE_H_
 #define MIR_COMPOSITOR_DROPPING_SCHEDULE_H_
 #include "schedule.h"
+#include <atomic>
 #include <memory>
 #include <mutex>
 
@@ -38,6 +39,8 @@ public:
 private:
     std::mutex mutable mutex;
     std::shared_ptr<graphics::Buffer> the_only_buffer;
+    /// Whether there is the_only_buffer, readable without the mutex
+    std::atomic<bool> scheduled{false};
 };
 }
 }
@@ -18,8 +18,6 @@
 
 #include "multi_monitor_arbiter.h"
 #include "mir/graphics/buffer.h"
-#include "mir/graphics/graphic_buffer_allocator.h"
-#include "mir/frontend/event_sink.h"
 #include "schedule.h"
 #include <boost/throw_exception.hpp>
 #include <algorithm>
@@ -30,10 +28,9 @@ namespace mf = mir::frontend;
 
 mc::MultiMonitorArbiter::MultiMonitorArbiter(
     std::shared_ptr<Schedule> const& schedule) :
-    schedule(schedule)
+    schedules{schedule},
+    schedule{schedule.get()}
 {
-    // We're highly unlikely to have more than 6 outputs
-    current_buffer_users.reserve(6);
 }
 
 mc::MultiMonitorArbiter::~MultiMonitorArbiter()
@@ -45,14 +42,13 @@ std::shared_ptr<mg::Buffer> mc::MultiMonitorArbiter::compositor_acquire(composit
     std::lock_guard<decltype(mutex)> lk(mutex);
 
     // If there is no current buffer or there is, but this compositor is already using it...
-    if (!current_buffer || is_user_of_current_buffer(id))
+    if (!current_buffer || is_user_of_current_buffer(id, last_generation))
     {
         // And if there is a scheduled buffer
-        if (schedule->num_scheduled() > 0)
+        if (schedule.load()->num_scheduled() > 0)
         {
             // Advance the current buffer
-            current_buffer = schedule->next_buffer();
-            clear_current_users();
+            advance_current_buffer();
         }
         // Otherwise leave the current buffer alone
     }
@@ -73,10 +69,9 @@ std::shared_ptr<mg::Buffer> mc::MultiMonitorArbiter::snapshot_acquire()
 
     if (!current_buffer)
     {
-        if (schedule->num_scheduled() > 0)
+        if (schedule.load()->num_scheduled() > 0)
         {
-            current_buffer = schedule->next_buffer();
-            clear_current_users();
+            advance_current_buffer();
         }
         else
         {
@@ -90,67 +85,70 @@ std::shared_ptr<mg::Buffer> mc::MultiMonitorArbiter::snapshot_acquire()
 void mc::MultiMonitorArbiter::set_schedule(std::shared_ptr<Schedule> const& new_schedule)
 {
     std::lock_guard<decltype(mutex)> lk(mutex);
-    schedule = new_schedule;
+    if (std::find(schedules.begin(), schedules.end(), new_schedule) == schedules.end())
+        schedules.push_back(new_schedule);
+    schedule = new_schedule.get();
 }
 
 bool mc::MultiMonitorArbiter::buffer_ready_for(mc::CompositorID id)
 {
-    std::lock_guard<decltype(mutex)> lk(mutex);
     // If there are scheduled buffers then there is one ready for any compositor
-    if (schedule->num_scheduled() > 0)
+    if (schedule.load()->num_scheduled() > 0)
         return true;
+
+    // (Read after the schedule: the generation changes before a buffer is taken from it)
+    auto const generation = current_generation.load();
+
     // If we have a current buffer that the compositor isn't yet using, it is ready
-    else if (current_buffer && !is_user_of_current_buffer(id))
-        return true;
-    // There are no scheduled buffers and either no current buffer, or a current buffer already used by this compositor
-    else
-        return false;
+    // Otherwise there are no scheduled buffers and either no current buffer, or a
+    // current buffer already used by this compositor
+    return generation != 0 && !is_user_of_current_buffer(id, generation);
 }
 
 void mc::MultiMonitorArbiter::advance_schedule()
 {
     std::lock_guard<decltype(mutex)> lk(mutex);
-    if (schedule->num_scheduled() > 0)
+    if (schedule.load()->num_scheduled() > 0)
     {
-        current_buffer = schedule->next_buffer();
-        clear_current_users();
+        advance_current_buffer();
     } 
 }
 
+void mc::MultiMonitorArbiter::advance_current_buffer()
+{
+    // A new generation has no users, so this also clears the current users
+    current_generation = ++last_generation;
+    current_buffer = schedule.load()->next_buffer();
+}
+
 void mc::MultiMonitorArbiter::add_current_buffer_user(mc::CompositorID id)
 {
-    // First try and find an empty slot in our vector…
-    for (auto& slot : current_buffer_users)
-    {
-        if (!slot)
-        {
-            slot = id;
-            return;
-        }
-    }
-    //…no empty slot, so we'll need to grow the vector.
-    current_buffer_users.push_back({id});
+    if (is_user_of_current_buffer(id, last_generation))
+        return;
+
+    // Any slot not tagged with the current generation is free…
+    auto slot = std::find_if(
+        current_buffer_users.begin(),
+        current_buffer_users.end(),
+        [this](User const& user) { return user.generation.load(std::memory_order_relaxed) != last_generation; });
+
+    //…and if there isn't one, forgetting a user only costs that compositor an extra frame
+    if (slot == current_buffer_users.end())
+        slot = current_buffer_users.begin();
+
+    // Readers only trust the id once they've seen the current generation
+    slot->generation = 0;
+    slot->id = id;
+    slot->generation = last_generation;
 }
 
-bool mc::MultiMonitorArbiter::is_user_of_current_buffer(mir::compositor::CompositorID id)
+bool mc::MultiMonitorArbiter::is_user_of_current_buffer(mir::compositor::CompositorID id, uint64_t generation) const
 {
     return std::any_of(
         current_buffer_users.begin(),
         current_buffer_users.end(),
-        [id](auto const& slot)
+        [id, generation](User const& user)
         {
-            if (slot)
-            {
-                return *slot == id;
-            }
-            return false;
+            return user.generation.load() == generation && user.id.load() == id;
         });
 }
-
-void mc::MultiMonitorArbiter::clear_current_users()
-{
-    for (auto& slot : current_buffer_users)
-    {
-        slot = {};
-    }
-}
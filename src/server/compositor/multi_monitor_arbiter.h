@@ -21,10 +21,12 @@
 #include "mir/compositor/compositor_id.h"
 #include "mir/graphics/buffer_id.h"
 #include "buffer_acquisition.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <vector>
-#include <experimental/optional>
 
 namespace mir
 {
@@ -34,6 +36,14 @@ namespace compositor
 {
 class Schedule;
 
+/**
+ * Shares the buffers of a stream between the compositors showing it.
+ *
+ * Acquiring and advancing is serialised, but buffer_ready_for() (which is
+ * called for every stream on every frame) doesn't lock: the compositors
+ * using the current buffer are kept in atomic slots, tagged with a
+ * generation that changes whenever the current buffer does.
+ */
 class MultiMonitorArbiter : public BufferAcquisition 
 {
 public:
@@ -43,19 +53,33 @@ public:
 
     std::shared_ptr<graphics::Buffer> compositor_acquire(compositor::CompositorID id) override;
     std::shared_ptr<graphics::Buffer> snapshot_acquire() override;
+    /// The schedule is kept alive as long as the arbiter (as there may be unlocked readers of it)
     void set_schedule(std::shared_ptr<Schedule> const& schedule);
     bool buffer_ready_for(compositor::CompositorID id);
     void advance_schedule();
 
 private:
+    /// A compositor that has acquired the buffer of a given generation
+    struct User
+    {
+        std::atomic<compositor::CompositorID> id{nullptr};
+        std::atomic<uint64_t> generation{0};
+    };
+
+    void advance_current_buffer();
     void add_current_buffer_user(compositor::CompositorID id);
-    bool is_user_of_current_buffer(compositor::CompositorID id);
-    void clear_current_users();
+    bool is_user_of_current_buffer(compositor::CompositorID id, uint64_t generation) const;
 
     std::mutex mutable mutex;
     std::shared_ptr<graphics::Buffer> current_buffer;
-    std::vector<std::experimental::optional<compositor::CompositorID>> current_buffer_users;
-    std::shared_ptr<Schedule> schedule;
+    std::vector<std::shared_ptr<Schedule>> schedules;
+    std::atomic<Schedule*> schedule;
+
+    /// Zero while there is no current buffer
+    std::atomic<uint64_t> current_generation{0};
+    uint64_t last_generation{0};
+    // We're highly unlikely to have more than 6 outputs
+    std::array<User, 8> current_buffer_users;
 };
 
 }
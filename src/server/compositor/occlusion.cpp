@@ -17,10 +17,12 @@
  */
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/region.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "occlusion.h"
 
+#include <memory>
 #include <vector>
 
 using namespace mir::geometry;
@@ -29,37 +31,86 @@ using namespace mir::compositor;
 
 namespace
 {
-bool renderable_is_occluded(
-    Renderable const& renderable, 
+Rectangle const empty{};
+
+// A renderable confined to the part of it that is left visible
+class ClippedRenderable : public Renderable
+{
+public:
+    ClippedRenderable(std::shared_ptr<Renderable> const& renderable, Rectangle const& clip) :
+        renderable{renderable},
+        clip{clip}
+    {
+    }
+
+    ID id() const override { return renderable->id(); }
+    std::shared_ptr<Buffer> buffer() const override { return renderable->buffer(); }
+    Rectangle screen_position() const override { return renderable->screen_position(); }
+    std::experimental::optional<Rectangle> clip_area() const override { return clip; }
+    float alpha() const override { return renderable->alpha(); }
+    glm::mat4 transformation() const override { return renderable->transformation(); }
+    bool shaped() const override { return renderable->shaped(); }
+    std::vector<Rectangle> opaque_region() const override { return renderable->opaque_region(); }
+    unsigned int swap_interval() const override { return renderable->swap_interval(); }
+
+private:
+    std::shared_ptr<Renderable> const renderable;
+    Rectangle const clip;
+};
+
+class ClippedSceneElement : public SceneElement
+{
+public:
+    ClippedSceneElement(std::shared_ptr<SceneElement> const& element, Rectangle const& clip) :
+        element{element},
+        clipped{std::make_shared<ClippedRenderable>(element->renderable(), clip)}
+    {
+    }
+
+    std::shared_ptr<Renderable> renderable() const override { return clipped; }
+    void rendered() override { element->rendered(); }
+    void occluded() override { element->occluded(); }
+
+private:
+    std::shared_ptr<SceneElement> const element;
+    std::shared_ptr<Renderable> const clipped;
+};
+
+/// The part of the renderable within area that is not covered, or nothing if it's all covered
+Region visible_part_of(
+    Renderable const& renderable,
     Rectangle const& area,
-    std::vector<Rectangle>& coverage)
+    Region& coverage)
 {
     static glm::mat4 const identity(1);
-    static Rectangle const empty{};
 
     if (renderable.transformation() != identity)
-        return false;  // Weirdly transformed. Assume never occluded.
+        return Region{area};  // Weirdly transformed. Assume never occluded.
 
     auto const& window = renderable.screen_position();
     auto const& clipped_window = window.intersection_with(area);
 
     if (clipped_window == empty)
-        return true;  // Not in the area; definitely occluded.
+        return Region{};  // Not in the area; definitely occluded.
+
+    Region visible{clipped_window};
+    visible.subtract(coverage);
 
-    bool occluded = false;
-    for (auto const& r : coverage)
+    if (!visible.empty() && renderable.alpha() == 1.0f)
     {
-        if (r.contains(clipped_window))
+        if (!renderable.shaped())
+        {
+            coverage.unite(clipped_window);
+        }
+        else
         {
-            occluded = true;
-            break;
+            Region opaque{renderable.opaque_region()};
+            opaque.intersect(clipped_window);
+            coverage.unite(opaque);
         }
     }
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
-
-    return occluded;
+    return visible;
 }
 }
 
@@ -68,21 +119,32 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
     Rectangle const& area)
 {
     SceneElementSequence occluded;
-    std::vector<Rectangle> coverage;
+    Region coverage;
 
     auto it = elements.rbegin();
     while (it != elements.rend())
     {
         auto const renderable = (*it)->renderable();
-        if (renderable_is_occluded(*renderable, area, coverage))
+        auto const visible = visible_part_of(*renderable, area, coverage);
+        if (visible.empty())
         {
             occluded.insert(occluded.begin(), *it);
             it = SceneElementSequence::reverse_iterator(elements.erase(std::prev(it.base())));
+            continue;
         }
-        else
+
+        // Partially covered: there's no point drawing what's hidden. (The renderer can
+        // only clip to a rectangle, so that's the best we can do for a ragged remainder.)
+        auto const position = renderable->screen_position();
+        auto clip = renderable->clip_area().value_or(position).intersection_with(position);
+        auto const visible_bounds = visible.bounding_rectangle();
+        if (!visible_bounds.contains(clip.intersection_with(area)))
         {
-            it++;
+            clip = clip.intersection_with(visible_bounds);
+            *it = std::make_shared<ClippedSceneElement>(*it, clip);
         }
+
+        it++;
     }
 
     return occluded;
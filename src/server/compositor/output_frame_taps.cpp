@@ -0,0 +1,273 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "output_frame_taps.h"
+
+#include "mir/compositor/display_buffer_compositor.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/display_buffer.h"
+#include "mir/renderer/gl/render_target.h"
+#include "mir/renderer/gl/texture_target.h"
+
+#include MIR_SERVER_GL_H
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mrgl = mir::renderer::gl;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Feeds the frames rendered to a display buffer to the taps before posting them
+class TappedDisplayBuffer : public mg::DisplayBuffer,
+                            public mg::NativeDisplayBuffer,
+                            public mrgl::RenderTarget
+{
+public:
+    TappedDisplayBuffer(mg::DisplayBuffer& display_buffer, mrgl::RenderTarget& render_target, mc::OutputFrameTaps& taps)
+        : display_buffer{display_buffer},
+          render_target{render_target},
+          taps{taps}
+    {
+    }
+
+    geom::Rectangle view_area() const override
+    {
+        return display_buffer.view_area();
+    }
+
+    bool overlay(mg::RenderableList const& renderlist) override
+    {
+        return display_buffer.overlay(renderlist);
+    }
+
+    glm::mat2 transformation() const override
+    {
+        return display_buffer.transformation();
+    }
+
+    mg::NativeDisplayBuffer* native_display_buffer() override
+    {
+        return this;
+    }
+
+    void make_current() override
+    {
+        render_target.make_current();
+    }
+
+    void release_current() override
+    {
+        render_target.release_current();
+    }
+
+    void swap_buffers() override
+    {
+        taps.frame_rendered(*this);
+        render_target.swap_buffers();
+    }
+
+    void bind() override
+    {
+        render_target.bind();
+    }
+
+private:
+    mg::DisplayBuffer& display_buffer;
+    mrgl::RenderTarget& render_target;
+    mc::OutputFrameTaps& taps;
+};
+
+class TappedCompositor : public mc::DisplayBufferCompositor
+{
+public:
+    TappedCompositor(std::unique_ptr<TappedDisplayBuffer> display_buffer, mc::DisplayBufferCompositorFactory& factory)
+        : display_buffer{std::move(display_buffer)},
+          wrapped{factory.create_compositor_for(*this->display_buffer)}
+    {
+    }
+
+    void composite(mc::SceneElementSequence&& scene_sequence) override
+    {
+        wrapped->composite(std::move(scene_sequence));
+    }
+
+private:
+    std::unique_ptr<TappedDisplayBuffer> const display_buffer;
+    std::unique_ptr<mc::DisplayBufferCompositor> const wrapped;
+};
+
+/// The EGL_KHR_fence_sync entry points, which are null where it isn't supported
+struct FenceSync
+{
+    FenceSync()
+        : create_sync{reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"))},
+          destroy_sync{reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"))},
+          client_wait_sync{reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(eglGetProcAddress("eglClientWaitSyncKHR"))}
+    {
+    }
+
+    PFNEGLCREATESYNCKHRPROC const create_sync;
+    PFNEGLDESTROYSYNCKHRPROC const destroy_sync;
+    PFNEGLCLIENTWAITSYNCKHRPROC const client_wait_sync;
+};
+
+/// Waits on an EGL fence which, unlike a GL one, needs no context current
+class FencedFrameCopy : public mc::FrameCopy
+{
+public:
+    FencedFrameCopy(FenceSync const& fence_sync, EGLDisplay display, EGLSyncKHR fence)
+        : fence_sync{fence_sync},
+          display{display},
+          fence{fence}
+    {
+    }
+
+    ~FencedFrameCopy()
+    {
+        fence_sync.destroy_sync(display, fence);
+    }
+
+    void wait() override
+    {
+        fence_sync.client_wait_sync(display, fence, 0, EGL_FOREVER_KHR);
+    }
+
+private:
+    FenceSync const& fence_sync;
+    EGLDisplay const display;
+    EGLSyncKHR const fence;
+};
+
+/// A copy we've already waited for
+class FinishedFrameCopy : public mc::FrameCopy
+{
+public:
+    void wait() override
+    {
+    }
+};
+
+/// Fences the commands so far, or waits for them where that isn't possible
+auto fence_frame_copy() -> std::shared_ptr<mc::FrameCopy>
+{
+    static FenceSync const fence_sync;
+
+    if (fence_sync.create_sync && fence_sync.destroy_sync && fence_sync.client_wait_sync)
+    {
+        auto const display = eglGetCurrentDisplay();
+        auto const fence = fence_sync.create_sync(display, EGL_SYNC_FENCE_KHR, nullptr);
+        if (fence != EGL_NO_SYNC_KHR)
+        {
+            // Waiting on another thread can't flush this context's commands for us
+            glFlush();
+            return std::make_shared<FencedFrameCopy>(fence_sync, display, fence);
+        }
+    }
+
+    glFinish();
+    return std::make_shared<FinishedFrameCopy>();
+}
+
+/// Starts copying the bound framebuffer's bottom left size pixels into buffer
+auto copy_frame(mg::Buffer& buffer, geom::Size const& size) -> std::shared_ptr<mc::FrameCopy>
+{
+    auto const texture_target = dynamic_cast<mrgl::TextureTarget*>(buffer.native_buffer_base());
+    if (!texture_target || buffer.size() != size)
+        return nullptr;
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    texture_target->bind_for_write();
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, size.width.as_int(), size.height.as_int());
+    texture_target->commit();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture);
+
+    if (glGetError() != GL_NO_ERROR)
+        return nullptr;
+
+    return fence_frame_copy();
+}
+}
+
+void mc::OutputFrameTaps::add(std::shared_ptr<FrameTap> const& tap)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    taps.push_back(tap);
+}
+
+void mc::OutputFrameTaps::remove(std::shared_ptr<FrameTap> const& tap)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    taps.erase(std::remove(taps.begin(), taps.end(), tap), taps.end());
+}
+
+void mc::OutputFrameTaps::frame_rendered(mg::DisplayBuffer const& output)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    if (taps.empty())
+        return;
+
+    auto const area = output.view_area();
+
+    // Only a frame drawn to fill the framebuffer pixel for pixel is what a tap would draw itself
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    bool const pixel_exact =
+        output.transformation() == glm::mat2(1) &&
+        viewport[0] == 0 && viewport[1] == 0 &&
+        viewport[2] == area.size.width.as_int() &&
+        viewport[3] == area.size.height.as_int();
+
+    for (auto const& tap : taps)
+    {
+        if (tap->tapped_area() != area)
+            continue;
+
+        auto const buffer = pixel_exact ? tap->acquire_frame_buffer() : nullptr;
+        if (buffer)
+            tap->release_frame_buffer(buffer, copy_frame(*buffer, area.size));
+        else
+            tap->frame_missed();
+    }
+}
+
+mc::TappingDisplayBufferCompositorFactory::TappingDisplayBufferCompositorFactory(
+    std::shared_ptr<DisplayBufferCompositorFactory> const& wrapped,
+    std::shared_ptr<OutputFrameTaps> const& taps)
+    : wrapped{wrapped},
+      taps{taps}
+{
+}
+
+std::unique_ptr<mc::DisplayBufferCompositor>
+mc::TappingDisplayBufferCompositorFactory::create_compositor_for(mg::DisplayBuffer& display_buffer)
+{
+    auto const render_target = dynamic_cast<mrgl::RenderTarget*>(display_buffer.native_display_buffer());
+    if (!render_target)
+        return wrapped->create_compositor_for(display_buffer);
+
+    return std::make_unique<TappedCompositor>(
+        std::make_unique<TappedDisplayBuffer>(display_buffer, *render_target, *taps),
+        *wrapped);
+}
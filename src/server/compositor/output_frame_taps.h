@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_OUTPUT_FRAME_TAPS_H_
+#define MIR_COMPOSITOR_OUTPUT_FRAME_TAPS_H_
+
+#include "mir/compositor/display_buffer_compositor_factory.h"
+#include "mir/geometry/rectangle.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class Buffer;
+class DisplayBuffer;
+}
+namespace compositor
+{
+
+/// A frame being copied into a FrameTap's buffer
+class FrameCopy
+{
+public:
+    virtual ~FrameCopy() = default;
+
+    /// Blocks until the frame is in the buffer. May be called on any thread.
+    virtual void wait() = 0;
+
+protected:
+    FrameCopy() = default;
+    FrameCopy(FrameCopy const&) = delete;
+    FrameCopy& operator=(FrameCopy const&) = delete;
+};
+
+/**
+ * Something that wants copies of the frames rendered for an output, such as
+ * a screencast of exactly that output.
+ */
+class FrameTap
+{
+public:
+    virtual ~FrameTap() = default;
+
+    /// The area of an untransformed output, rendered at 1:1 scale, this wants frames of
+    virtual geometry::Rectangle tapped_area() const = 0;
+
+    /**
+     * A buffer of tapped_area()'s size to copy the next frame into, or
+     * nullptr if the frame can't be taken now.
+     */
+    virtual std::shared_ptr<graphics::Buffer> acquire_frame_buffer() = 0;
+
+    /**
+     * Hands back a buffer from acquire_frame_buffer(). If the new frame is
+     * being copied into it, copy is how to wait for that; otherwise it is
+     * nullptr.
+     */
+    virtual void release_frame_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        std::shared_ptr<FrameCopy> const& copy) = 0;
+
+    /// A frame was rendered for the area without a buffer being acquired for it
+    virtual void frame_missed() = 0;
+
+protected:
+    FrameTap() = default;
+    FrameTap(FrameTap const&) = delete;
+    FrameTap& operator=(FrameTap const&) = delete;
+};
+
+/**
+ * Copies the frames rendered by output compositors to any FrameTaps
+ * matching those outputs, just before the frames are posted.
+ */
+class OutputFrameTaps
+{
+public:
+    void add(std::shared_ptr<FrameTap> const& tap);
+    /// Once this returns the tap will not be called again
+    void remove(std::shared_ptr<FrameTap> const& tap);
+
+    /**
+     * Copies the frame rendered for output to the taps that match it.
+     * Must be called with the output's GL context current and the frame
+     * in the bound framebuffer.
+     */
+    void frame_rendered(graphics::DisplayBuffer const& output);
+
+private:
+    std::mutex mutex;
+    std::vector<std::shared_ptr<FrameTap>> taps;
+};
+
+/**
+ * Creates compositors (using another factory) whose frames are passed to
+ * OutputFrameTaps::frame_rendered() before being posted.
+ */
+class TappingDisplayBufferCompositorFactory : public DisplayBufferCompositorFactory
+{
+public:
+    TappingDisplayBufferCompositorFactory(
+        std::shared_ptr<DisplayBufferCompositorFactory> const& wrapped,
+        std::shared_ptr<OutputFrameTaps> const& taps);
+
+    std::unique_ptr<DisplayBufferCompositor> create_compositor_for(graphics::DisplayBuffer& display_buffer) override;
+
+private:
+    std::shared_ptr<DisplayBufferCompositorFactory> const wrapped;
+    std::shared_ptr<OutputFrameTaps> const taps;
+};
+
+}
+}
+
+#endif /* MIR_COMPOSITOR_OUTPUT_FRAME_TAPS_H_ */
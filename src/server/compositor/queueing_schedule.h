@@ -19,6 +19,7 @@
 #ifndef MIR_COMPOSITOR_QUEUEING_SCHEDULE_H_
 #define MIR_COMPOSITOR_QUEUEING_SCHEDULE_H_
 #include "schedule.h"
+#include <atomic>
 #include <memory>
 #include <deque>
 #include <mutex>
@@ -38,6 +39,8 @@ public:
 private:
     std::mutex mutable mutex;
     std::deque<std::shared_ptr<graphics::Buffer>> queue;
+    /// queue.size(), readable without the mutex
+    std::atomic<unsigned int> queued{0};
 };
 }
 }
@@ -30,6 +30,7 @@ class Schedule
 {
 public:
     virtual void schedule(std::shared_ptr<graphics::Buffer> const& buffer) = 0;
+    /// Called on every frame without holding any lock, so should be cheap and mustn't block
     virtual unsigned int num_scheduled() = 0;
     virtual std::shared_ptr<graphics::Buffer> next_buffer() = 0;
 
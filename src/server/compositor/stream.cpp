@@ -20,7 +20,11 @@
 #include "stream.h"
 #include "queueing_schedule.h"
 #include "dropping_schedule.h"
+#include "timed_schedule.h"
 #include "mir/graphics/buffer.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
+#include "mir/time/steady_clock.h"
 #include <boost/throw_exception.hpp>
 
 namespace mc = mir::compositor;
@@ -28,6 +32,14 @@ namespace geom = mir::geometry;
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
+namespace mt = mir::time;
+
+namespace
+{
+// We don't know when the next vblank of the outputs showing a stream will be,
+// so a timed buffer is taken as due up to a (60Hz) frame before its target
+std::chrono::milliseconds const presentation_lead{16};
+}
 
 enum class mc::Stream::ScheduleMode {
     Queueing,
@@ -36,13 +48,26 @@ enum class mc::Stream::ScheduleMode {
 
 mc::Stream::Stream(
     geom::Size size, MirPixelFormat pf) :
+    Stream(size, pf, std::make_shared<mt::SteadyClock>(), nullptr)
+{
+}
+
+mc::Stream::Stream(
+    geom::Size size, MirPixelFormat pf,
+    std::shared_ptr<mt::Clock> const& clock,
+    std::shared_ptr<mt::AlarmFactory> const& alarms) :
     schedule_mode(ScheduleMode::Queueing),
-    schedule(std::make_shared<mc::QueueingSchedule>()),
+    timed(false),
+    queueing_schedule(std::make_shared<mc::QueueingSchedule>()),
+    dropping_schedule(std::make_shared<mc::DroppingSchedule>()),
+    timed_schedule(std::make_shared<mc::TimedSchedule>(clock, presentation_lead)),
+    schedule(queueing_schedule),
     arbiter(std::make_shared<mc::MultiMonitorArbiter>(schedule)),
     size(size),
     pf(pf),
     first_frame_posted(false),
-    frame_callback{[](auto){}}
+    frame_callback{[](auto){}},
+    due_alarm{alarms ? alarms->create_alarm([this] { wake_compositor_when_due(); }) : nullptr}
 {
 }
 
@@ -58,12 +83,91 @@ void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
         first_frame_posted = true;
         pf = buffer->pixel_format();
         size = buffer->size();
+        record_submission(buffer, lk);
+        if (timed)
+        {
+            transition_schedule(untimed_schedule(lk), lk);
+            timed = false;
+        }
         schedule->schedule(buffer);
     }
+    notify_frame_posted(buffer->size());
+}
+
+void mc::Stream::submit_buffer_at(std::shared_ptr<mg::Buffer> const& buffer, mt::Timestamp target)
+{
+    if (!buffer)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
+
+    mir::optional_value<mt::Timestamp> wakeup;
+    {
+        std::lock_guard<decltype(mutex)> lk(mutex);
+        first_frame_posted = true;
+        pf = buffer->pixel_format();
+        size = buffer->size();
+        record_submission(buffer, lk);
+        if (!timed)
+        {
+            transition_schedule(timed_schedule, lk);
+            timed = true;
+        }
+        timed_schedule->schedule(buffer, target);
+        wakeup = timed_schedule->next_due_time();
+    }
+
+    // Only wake the compositor once there's something for it to show
+    if (timed_schedule->num_scheduled())
+        notify_frame_posted(buffer->size());
+
+    if (due_alarm && wakeup)
+        due_alarm->reschedule_for(wakeup.value());
+}
+
+void mc::Stream::record_submission(std::shared_ptr<mg::Buffer> const& buffer, std::lock_guard<std::mutex> const&)
+{
+    // Forget buffers that have since been freed (Wayland clients get a new mg::Buffer per commit)
+    for (auto i = content_serials.begin(); i != content_serials.end();)
+    {
+        if (i->second.buffer.expired())
+            i = content_serials.erase(i);
+        else
+            ++i;
+    }
+
+    content_serials[buffer.get()] = Submission{buffer, ++last_content_serial};
+}
+
+auto mc::Stream::content_serial(mg::Buffer const& buffer) const -> uint64_t
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    auto const submission = content_serials.find(&buffer);
+    if (submission == content_serials.end() || submission->second.buffer.expired())
+        return 0;
+    return submission->second.serial;
+}
+
+void mc::Stream::wake_compositor_when_due()
+{
+    geom::Size current_size;
+    mir::optional_value<mt::Timestamp> wakeup;
     {
-        std::lock_guard<decltype(callback_mutex)> lock{callback_mutex};
-        frame_callback(buffer->size());
+        std::lock_guard<decltype(mutex)> lk(mutex);
+        if (!timed)
+            return;
+        current_size = size;
+        wakeup = timed_schedule->next_due_time();
     }
+
+    notify_frame_posted(current_size);
+
+    if (wakeup)
+        due_alarm->reschedule_for(wakeup.value());
+}
+
+void mc::Stream::notify_frame_posted(geom::Size const& size)
+{
+    std::lock_guard<decltype(callback_mutex)> lock{callback_mutex};
+    frame_callback(size);
 }
 
 void mc::Stream::with_most_recent_buffer_do(std::function<void(mg::Buffer&)> const& fn)
@@ -72,6 +176,12 @@ void mc::Stream::with_most_recent_buffer_do(std::function<void(mg::Buffer&)> con
     fn(*arbiter->snapshot_acquire());
 }
 
+auto mc::Stream::snapshot_acquire() -> std::shared_ptr<mg::Buffer>
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    return arbiter->snapshot_acquire();
+}
+
 MirPixelFormat mc::Stream::pixel_format() const
 {
     std::lock_guard<decltype(mutex)> lk(mutex);
@@ -99,16 +209,14 @@ geom::Size mc::Stream::stream_size()
 void mc::Stream::allow_framedropping(bool dropping)
 {
     std::lock_guard<decltype(mutex)> lk(mutex); 
-    if (dropping && schedule_mode == ScheduleMode::Queueing)
-    {
-        transition_schedule(std::make_shared<mc::DroppingSchedule>(), lk);
-        schedule_mode = ScheduleMode::Dropping;
-    }
-    else if (!dropping && schedule_mode == ScheduleMode::Dropping)
-    {
-        transition_schedule(std::make_shared<mc::QueueingSchedule>(), lk);
-        schedule_mode = ScheduleMode::Queueing;
-    }
+    auto const new_mode = dropping ? ScheduleMode::Dropping : ScheduleMode::Queueing;
+    if (new_mode == schedule_mode)
+        return;
+
+    schedule_mode = new_mode;
+    // A timed stream keeps presenting on time: the mode applies once it stops
+    if (!timed)
+        transition_schedule(untimed_schedule(lk), lk);
 }
 
 bool mc::Stream::framedropping() const
@@ -116,12 +224,25 @@ bool mc::Stream::framedropping() const
     return schedule_mode == ScheduleMode::Dropping;
 }
 
+auto mc::Stream::untimed_schedule(std::lock_guard<std::mutex> const&) const -> std::shared_ptr<Schedule> const&
+{
+    return schedule_mode == ScheduleMode::Dropping ? dropping_schedule : queueing_schedule;
+}
+
 void mc::Stream::transition_schedule(
-    std::shared_ptr<mc::Schedule>&& new_schedule, std::lock_guard<std::mutex> const&)
+    std::shared_ptr<mc::Schedule> const& new_schedule, std::lock_guard<std::mutex> const&)
 {
     std::vector<std::shared_ptr<mg::Buffer>> transferred_buffers;
-    while(schedule->num_scheduled())
-        transferred_buffers.emplace_back(schedule->next_buffer());
+    if (schedule == timed_schedule)
+    {
+        // Buffers that aren't due yet still need to go somewhere
+        transferred_buffers = timed_schedule->take_all();
+    }
+    else
+    {
+        while(schedule->num_scheduled())
+            transferred_buffers.emplace_back(schedule->next_buffer());
+    }
     for(auto& buffer : transferred_buffers)
         new_schedule->schedule(buffer);
     schedule = new_schedule;
@@ -130,7 +251,7 @@ void mc::Stream::transition_schedule(
 
 int mc::Stream::buffers_ready_for_compositor(void const* id) const
 {
-    std::lock_guard<decltype(mutex)> lk(mutex); 
+    // The arbiter answers this without locking: it's asked on every frame
     if (arbiter->buffer_ready_for(id))
         return 1;
     return 0;
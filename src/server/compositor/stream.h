@@ -25,30 +25,40 @@
 #include "mir/frontend/buffer_stream_id.h"
 #include "mir/lockable_callback.h"
 #include "mir/geometry/size.h"
+#include "mir/time/types.h"
 #include "multi_monitor_arbiter.h"
 #include <mutex>
 #include <memory>
 #include <set>
+#include <unordered_map>
 
 namespace mir
 {
 namespace frontend { class ClientBuffers; }
+namespace time { class Alarm; class AlarmFactory; class Clock; }
 namespace compositor
 {
 class Schedule;
+class TimedSchedule;
 class Stream : public BufferStream
 {
 public:
     Stream(geometry::Size sz, MirPixelFormat format);
+    /// Buffers submitted for a time are due on clock, and alarms wake the compositor when they are
+    Stream(geometry::Size sz, MirPixelFormat format,
+        std::shared_ptr<time::Clock> const& clock,
+        std::shared_ptr<time::AlarmFactory> const& alarms);
     ~Stream();
 
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) override;
+    void submit_buffer_at(std::shared_ptr<graphics::Buffer> const& buffer, time::Timestamp target) override;
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec) override;
     MirPixelFormat pixel_format() const override;
     void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) override;
     std::shared_ptr<graphics::Buffer>
         lock_compositor_buffer(void const* user_id) override;
+    auto snapshot_acquire() -> std::shared_ptr<graphics::Buffer> override;
     geometry::Size stream_size() override;
     void allow_framedropping(bool) override;
     bool framedropping() const override;
@@ -56,21 +66,44 @@ public:
     void drop_old_buffers() override;
     bool has_submitted_buffer() const override;
     void set_scale(float scale) override;
+    auto content_serial(graphics::Buffer const& buffer) const -> uint64_t override;
 
 private:
     enum class ScheduleMode;
-    void transition_schedule(std::shared_ptr<Schedule>&& new_schedule, std::lock_guard<std::mutex> const&);
+    void transition_schedule(std::shared_ptr<Schedule> const& new_schedule, std::lock_guard<std::mutex> const&);
+    auto untimed_schedule(std::lock_guard<std::mutex> const&) const -> std::shared_ptr<Schedule> const&;
+    void wake_compositor_when_due();
+    void notify_frame_posted(geometry::Size const& size);
+    void record_submission(std::shared_ptr<graphics::Buffer> const& buffer, std::lock_guard<std::mutex> const&);
 
     std::mutex mutable mutex;
     ScheduleMode schedule_mode;
+    /// Whether the client is submitting buffers for a time (which overrides schedule_mode)
+    bool timed;
+    // Created once and switched between, as the arbiter keeps every schedule it's given
+    std::shared_ptr<Schedule> const queueing_schedule;
+    std::shared_ptr<Schedule> const dropping_schedule;
+    std::shared_ptr<TimedSchedule> const timed_schedule;
     std::shared_ptr<Schedule> schedule;
     std::shared_ptr<MultiMonitorArbiter> const arbiter;
     geometry::Size size; 
     MirPixelFormat pf;
     bool first_frame_posted;
 
+    struct Submission
+    {
+        std::weak_ptr<graphics::Buffer> buffer;
+        uint64_t serial;
+    };
+    /// The serial of each buffer's latest submission, bumped every time a buffer is (re)submitted
+    std::unordered_map<graphics::Buffer const*, Submission> content_serials;
+    uint64_t last_content_serial{0};
+
     std::mutex callback_mutex;
     std::function<void(geometry::Size const&)> frame_callback;
+
+    /// Wakes the compositor when the next timed buffer is due (null if there are no alarms)
+    std::unique_ptr<time::Alarm> const due_alarm;
 };
 }
 }
@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timed_schedule.h"
+#include "mir/time/clock.h"
+
+#include <boost/throw_exception.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mt = mir::time;
+
+namespace
+{
+int64_t const nothing_scheduled = std::numeric_limits<int64_t>::max();
+
+int64_t ticks_of(mt::Timestamp time)
+{
+    return time.time_since_epoch().count();
+}
+}
+
+mc::TimedSchedule::TimedSchedule(std::shared_ptr<mt::Clock> const& clock, mt::Duration lead) :
+    clock{clock},
+    lead{lead},
+    earliest_target{nothing_scheduled}
+{
+}
+
+void mc::TimedSchedule::schedule(std::shared_ptr<mg::Buffer> const& buffer)
+{
+    schedule(buffer, clock->now());
+}
+
+void mc::TimedSchedule::schedule(std::shared_ptr<mg::Buffer> const& buffer, mt::Timestamp target)
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    auto it = std::find_if(entries.begin(), entries.end(), [&](Entry const& e) { return e.buffer == buffer; });
+    if (it != entries.end())
+        entries.erase(it);
+
+    auto const position = std::upper_bound(entries.begin(), entries.end(), target,
+        [](mt::Timestamp target, Entry const& e) { return target < e.target; });
+    entries.insert(position, Entry{target, buffer});
+    update_earliest(lk);
+}
+
+unsigned int mc::TimedSchedule::num_scheduled()
+{
+    auto const earliest = earliest_target.load();
+    if (earliest != nothing_scheduled && earliest <= ticks_of(clock->now() + lead))
+        return 1;
+    else
+        return 0;
+}
+
+std::shared_ptr<mg::Buffer> mc::TimedSchedule::next_buffer()
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    auto const due_by = clock->now() + lead;
+    auto const not_due = std::upper_bound(entries.begin(), entries.end(), due_by,
+        [](mt::Timestamp due_by, Entry const& e) { return due_by < e.target; });
+
+    if (not_due == entries.begin())
+        BOOST_THROW_EXCEPTION(std::logic_error("no buffer scheduled"));
+
+    auto buffer = std::prev(not_due)->buffer;
+    entries.erase(entries.begin(), not_due);
+    update_earliest(lk);
+    return buffer;
+}
+
+auto mc::TimedSchedule::next_due_time() const -> optional_value<mt::Timestamp>
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    auto const due_by = clock->now() + lead;
+    auto const not_due = std::upper_bound(entries.begin(), entries.end(), due_by,
+        [](mt::Timestamp due_by, Entry const& e) { return due_by < e.target; });
+
+    if (not_due == entries.end())
+        return {};
+    return not_due->target - lead;
+}
+
+auto mc::TimedSchedule::take_all() -> std::vector<std::shared_ptr<mg::Buffer>>
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    std::vector<std::shared_ptr<mg::Buffer>> buffers;
+    for (auto& entry : entries)
+        buffers.emplace_back(std::move(entry.buffer));
+    entries.clear();
+    update_earliest(lk);
+    return buffers;
+}
+
+void mc::TimedSchedule::update_earliest(std::lock_guard<std::mutex> const&)
+{
+    earliest_target = entries.empty() ? nothing_scheduled : ticks_of(entries.front().target);
+}
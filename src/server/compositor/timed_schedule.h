@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_TIMED_SCHEDULE_H_
+#define MIR_COMPOSITOR_TIMED_SCHEDULE_H_
+
+#include "schedule.h"
+#include "mir/optional_value.h"
+#include "mir/time/types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace graphics { class Buffer; }
+namespace time { class Clock; }
+namespace compositor
+{
+/**
+ * Holds buffers until the time the client wants them presented.
+ *
+ * A buffer is due once its target time falls within lead of the clock: that
+ * is, before the next vblank the compositor can expect to present on. Only
+ * due buffers count as scheduled, and next_buffer() gives the latest of
+ * them, dropping any earlier ones (which could now only be shown late).
+ * Buffers without a target are due straight away.
+ */
+class TimedSchedule : public Schedule
+{
+public:
+    TimedSchedule(std::shared_ptr<time::Clock> const& clock, time::Duration lead);
+
+    void schedule(std::shared_ptr<graphics::Buffer> const& buffer) override;
+    void schedule(std::shared_ptr<graphics::Buffer> const& buffer, time::Timestamp target);
+    /// 1 if a buffer is due, otherwise 0
+    unsigned int num_scheduled() override;
+    std::shared_ptr<graphics::Buffer> next_buffer() override;
+
+    /// When the earliest buffer that isn't yet due will be
+    auto next_due_time() const -> optional_value<time::Timestamp>;
+    /// Takes every buffer, due or not, in order of their targets
+    auto take_all() -> std::vector<std::shared_ptr<graphics::Buffer>>;
+
+private:
+    struct Entry
+    {
+        time::Timestamp target;
+        std::shared_ptr<graphics::Buffer> buffer;
+    };
+
+    void update_earliest(std::lock_guard<std::mutex> const&);
+
+    std::shared_ptr<time::Clock> const clock;
+    time::Duration const lead;
+
+    std::mutex mutable mutex;
+    /// Sorted by target
+    std::vector<Entry> entries;
+    /// The first target (in clock ticks), readable without the mutex
+    std::atomic<int64_t> earliest_target;
+};
+}
+}
+#endif /* MIR_COMPOSITOR_TIMED_SCHEDULE_H_ */
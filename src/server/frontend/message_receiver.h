@@ -32,13 +32,17 @@ namespace detail
 class MessageReceiver
 {
 public:
-    //receive message from the socket. 'handler' will be called when 'buffer' has been filled with exactly 'size'
-    typedef std::function<void(boost::system::error_code const&, size_t)> MirReadHandler;
-    virtual void async_receive_msg(MirReadHandler const& handler, boost::asio::mutable_buffers_1 const& buffer) = 0;
-    virtual boost::system::error_code receive_msg(boost::asio::mutable_buffers_1 const& buffer) = 0;
-    virtual size_t available_bytes() = 0;
+    //'handler' will be called once there is something to read, or the connection has been lost
+    typedef std::function<void(boost::system::error_code const&)> MirReadableHandler;
+    virtual void async_wait_readable(MirReadableHandler const& handler) = 0;
+
+    //read as much as is available (up to the size of 'buffer') without blocking, appending any fds
+    //that arrive with it to 'fds'. Returns the number of bytes read, which may be 0.
+    virtual size_t receive_available(
+        boost::asio::mutable_buffers_1 const& buffer,
+        std::vector<Fd>& fds,
+        boost::system::error_code& error) = 0;
     virtual SessionCredentials client_creds() = 0;
-    virtual void receive_fds(std::vector<Fd>& fds) = 0;
 
 protected:
     MessageReceiver() = default;
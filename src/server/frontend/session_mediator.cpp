@@ -64,6 +64,7 @@
 #include "mir/executor.h"
 
 #include "mir/geometry/rectangles.h"
+#include "mir/geometry/region.h"
 #include "protobuf_buffer_packer.h"
 #include "protobuf_input_converter.h"
 
@@ -95,6 +96,20 @@ mg::GammaCurve convert_string_to_gamma_curve(std::string const& str_bytes)
     std::copy(std::begin(str_bytes), std::end(str_bytes), reinterpret_cast<char*>(out.data()));
     return out;
 }
+
+void pack_damage(
+    geom::Region const& damage,
+    google::protobuf::RepeatedPtrField<mir::protobuf::Rectangle>& protobuf_damage)
+{
+    for (auto const& rect : damage)
+    {
+        auto const protobuf_rect = protobuf_damage.Add();
+        protobuf_rect->set_left(rect.top_left.x.as_int());
+        protobuf_rect->set_top(rect.top_left.y.as_int());
+        protobuf_rect->set_width(rect.size.width.as_uint32_t());
+        protobuf_rect->set_height(rect.size.height.as_uint32_t());
+    }
+}
 }
 
 mf::SessionMediator::SessionMediator(
@@ -463,7 +478,11 @@ void mf::SessionMediator::submit_buffer(
     auto b = buffer_cache.at(buffer_id);
     ipc_operations->unpack_buffer(request_msg, *b);
 
-    stream->submit_buffer(std::make_shared<AutoSendBuffer>(b, executor, event_sink));
+    auto const buffer = std::make_shared<AutoSendBuffer>(b, executor, event_sink);
+    if (request->has_target_time())
+        stream->submit_buffer_at(buffer, mir::time::Timestamp{std::chrono::nanoseconds{request->target_time()}});
+    else
+        stream->submit_buffer(buffer);
 
     done->Run();
 }
@@ -942,6 +961,9 @@ void mf::SessionMediator::create_screencast(
             *protobuf_screencast->mutable_buffer_stream()->mutable_buffer(),
             buffer.get(),
             msg_type);
+        pack_damage(
+            screencast->last_capture_damage(screencast_session_id),
+            *protobuf_screencast->mutable_buffer_stream()->mutable_buffer()->mutable_damage());
     }
 
     protobuf_screencast->mutable_screencast_id()->set_value(
@@ -981,18 +1003,20 @@ void mf::SessionMediator::screencast_buffer(
     pack_protobuf_buffer(*protobuf_buffer,
                          buffer.get(),
                          msg_type);
+    pack_damage(screencast->last_capture_damage(screencast_session_id), *protobuf_buffer->mutable_damage());
 
     done->Run();
 }
 
 void mf::SessionMediator::screencast_to_buffer(
     mir::protobuf::ScreencastRequest const* request,
-    mir::protobuf::Void*,
+    mir::protobuf::ScreencastCapture* response,
     google::protobuf::Closure* done)
 {
     ScreencastSessionId const screencast_session_id{request->id().value()};
     auto buffer = buffer_cache.at(mg::BufferID{request->buffer_id()});
     screencast->capture(screencast_session_id, buffer);
+    pack_damage(screencast->last_capture_damage(screencast_session_id), *response->mutable_damage());
     done->Run();
 }
 
@@ -29,6 +29,7 @@
 #include <boost/signals2.hpp>
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 
 #include <sys/types.h>
@@ -39,6 +40,12 @@ namespace bs = boost::system;
 
 namespace mfd = mir::frontend::detail;
 
+namespace
+{
+// Room for a good few typical messages; a larger message grows the buffer to fit
+size_t const initial_receive_buffer_size{16*1024};
+}
+
 mfd::SocketConnection::SocketConnection(
     std::shared_ptr<mfd::MessageReceiver> const& message_receiver,
     int id_,
@@ -47,7 +54,8 @@ mfd::SocketConnection::SocketConnection(
      : message_receiver(message_receiver),
        id_(id_),
        connections(connections),
-       processor(processor)
+       processor(processor),
+       received(initial_receive_buffer_size)
 {
 }
 
@@ -58,75 +66,101 @@ mfd::SocketConnection::~SocketConnection() noexcept
 
 void mfd::SocketConnection::read_next_message()
 {
-    auto callback = std::bind(&mfd::SocketConnection::on_read_size,
+    auto callback = std::bind(&mfd::SocketConnection::on_readable,
                         this, std::placeholders::_1);
-    message_receiver->async_receive_msg(callback, ba::buffer(header, header_size));
+    message_receiver->async_wait_readable(callback);
 }
 
-void mfd::SocketConnection::on_read_size(const boost::system::error_code& error)
+void mfd::SocketConnection::on_readable(const boost::system::error_code& wait_error)
 {
-    if (error)
+    if (wait_error)
     {
         connections->remove(id());
-        BOOST_THROW_EXCEPTION(std::runtime_error(error.message()));
+        BOOST_THROW_EXCEPTION(std::runtime_error(wait_error.message()));
     }
 
-    unsigned char const high_byte = header[0];
-    unsigned char const low_byte = header[1];
-    size_t const body_size = (high_byte << 8) + low_byte;
+    // Keep what's left of a partly received message at the start, with room after it
+    if (received_begin != 0)
+    {
+        std::copy(received.begin() + received_begin, received.begin() + received_end, received.begin());
+        received_end -= received_begin;
+        received_begin = 0;
+    }
+    if (received_end == received.size())
+        received.resize(2 * received.size());
 
-    body.resize(body_size);
+    std::vector<Fd> fds;
+    boost::system::error_code error;
+    received_end += message_receiver->receive_available(
+        ba::buffer(received.data() + received_end, received.size() - received_end),
+        fds,
+        error);
+    received_fds.insert(received_fds.end(), fds.begin(), fds.end());
 
-    if (message_receiver->available_bytes() >= body_size)
+    if (error)
     {
-        on_new_message(message_receiver->receive_msg(ba::buffer(body)));
+        connections->remove(id());
+        BOOST_THROW_EXCEPTION(std::runtime_error(error.message()));
+    }
+
+    if (dispatch_received_messages())
+    {
+        read_next_message();
     }
     else
     {
-        auto callback = std::bind(&mfd::SocketConnection::on_new_message,
-                                  this, std::placeholders::_1);
-        message_receiver->async_receive_msg(callback, ba::buffer(body));
+        connections->remove(id());
     }
 }
 
-void mfd::SocketConnection::on_new_message(const boost::system::error_code& error)
+bool mfd::SocketConnection::dispatch_received_messages()
 try
 {
-    if (error)
+    for (;;)
     {
-        BOOST_THROW_EXCEPTION(std::runtime_error(error.message()));
-    }
+        auto const available = received_end - received_begin;
+        if (available < header_size)
+            return true;
 
-    mir::protobuf::wire::Invocation invocation;
-    invocation.ParseFromArray(body.data(), body.size());
+        auto const message = received.data() + received_begin;
+        unsigned char const high_byte = message[0];
+        unsigned char const low_byte = message[1];
+        size_t const body_size = (high_byte << 8) + low_byte;
 
-    int const v = invocation.has_protocol_version() ?
-                  invocation.protocol_version() :
-                  -1;
-    if (v <  mir::protobuf::oldest_compatible_protocol_version() ||
-        v >= mir::protobuf::next_incompatible_protocol_version())
-        BOOST_THROW_EXCEPTION(std::runtime_error("Unsupported protocol version"));
+        if (available < header_size + body_size)
+            return true;
 
-    std::vector<mir::Fd> fds;
-    if (invocation.side_channel_fds() > 0)
-    {
-        fds.resize(invocation.side_channel_fds());
-        message_receiver->receive_fds(fds);
-    }
+        invocation.ParseFromArray(message + header_size, body_size);
 
-    if (!client_pid)
-    {
-        client_pid = message_receiver->client_creds().pid();
-        processor->client_pid(client_pid);
-    }
+        int const v = invocation.has_protocol_version() ?
+                      invocation.protocol_version() :
+                      -1;
+        if (v <  mir::protobuf::oldest_compatible_protocol_version() ||
+            v >= mir::protobuf::next_incompatible_protocol_version())
+            BOOST_THROW_EXCEPTION(std::runtime_error("Unsupported protocol version"));
 
-    if (processor->dispatch(invocation, fds))
-    {
-        read_next_message();
-    }
-    else
-    {
-        connections->remove(id());
+        // Any fds follow the message, sent with a byte of their own
+        size_t const fd_count = invocation.side_channel_fds();
+        size_t const message_size = header_size + body_size + (fd_count > 0 ? 1 : 0);
+
+        if (available < message_size)
+            return true;
+
+        if (received_fds.size() < fd_count)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Expected file descriptors were not received"));
+
+        std::vector<mir::Fd> fds{received_fds.begin(), received_fds.begin() + fd_count};
+        received_fds.erase(received_fds.begin(), received_fds.begin() + fd_count);
+        received_begin += message_size;
+
+        if (!client_pid)
+        {
+            client_pid = message_receiver->client_creds().pid();
+            processor->client_pid(client_pid);
+        }
+
+        if (!processor->dispatch(invocation, fds))
+            return false;
     }
 }
 catch (std::exception& e)
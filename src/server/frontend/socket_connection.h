@@ -21,9 +21,15 @@
 #define MIR_FRONTEND_DETAIL_SOCKET_CONNECTION_H_
 
 #include "mir/frontend/connections.h"
+#include "mir/fd.h"
+
+#include "mir_protobuf_wire.pb.h"
 
 #include <boost/asio.hpp>
 
+#include <deque>
+#include <vector>
+
 #include <sys/types.h>
 
 namespace mir
@@ -52,8 +58,9 @@ public:
 
 private:
     void on_response_sent(boost::system::error_code const& error, std::size_t);
-    void on_new_message(const boost::system::error_code& ec);
-    void on_read_size(const boost::system::error_code& ec);
+    void on_readable(boost::system::error_code const& error);
+    /// Returns false if the processor wants the connection closed
+    bool dispatch_received_messages();
 
     std::shared_ptr<MessageReceiver> const message_receiver;
     int const id_;
@@ -61,8 +68,15 @@ private:
     std::shared_ptr<MessageProcessor> processor;
 
     static size_t const header_size = 2;
-    char header[header_size];
-    std::vector<char> body;
+
+    /// Bytes read but not yet dispatched are [received_begin, received_end)
+    std::vector<char> received;
+    size_t received_begin{0};
+    size_t received_end{0};
+    /// Side channel fds read but not yet dispatched, in the order they arrived
+    std::deque<Fd> received_fds;
+    /// Reused for every message, so parsing reuses its storage
+    mir::protobuf::wire::Invocation invocation;
 
     int client_pid = 0;
 };
@@ -17,32 +17,46 @@
  */
 
 #include "socket_messenger.h"
-#include "mir/frontend/client_constants.h"
-#include "mir/variable_length_array.h"
-#include "mir/fd_socket_transmission.h"
 #include "mir/raii.h"
 
 #include <boost/throw_exception.hpp>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <stdexcept>
+#include <system_error>
 
 namespace mf = mir::frontend;
 namespace mfd = mf::detail;
 namespace bs = boost::system;
 namespace ba = boost::asio;
 
+namespace
+{
+// A client that lets this much go unread is not keeping up with its
+// messages, and is disconnected rather than allowed to consume more memory
+size_t const max_backlog_bytes{4*1024*1024};
+
+// The most messages gathered into a single sendmsg()
+size_t const max_messages_per_write{64};
+
+// The most fds the kernel lets be sent at once (SCM_MAX_FD)
+size_t const max_fds_per_read{253};
+}
+
 mfd::SocketMessenger::SocketMessenger(std::shared_ptr<ba::local::stream_protocol::socket> const& socket)
     : socket(socket),
       socket_fd{IntOwnedFd{socket->native_handle()}}
 {
     // Make the socket non-blocking to avoid hanging the server when a client
-    // is unresponsive. Also increase the send buffer size to 64KiB to allow
-    // more leeway for transient client freezes.
+    // is unresponsive: whatever the socket won't take is queued and written
+    // when it becomes writable. Also increase the send buffer size to 64KiB
+    // to allow more leeway for transient client freezes.
     // See https://bugs.launchpad.net/mir/+bug/1350207
-    // TODO: Rework the messenger to support asynchronous sends
     socket->non_blocking(true);
     boost::asio::socket_base::send_buffer_size option(64*1024);
     socket->set_option(option);
@@ -74,72 +88,277 @@ mf::SessionCredentials mfd::SocketMessenger::client_creds()
 void mfd::SocketMessenger::send(char const* data, size_t length, FdSets const& fd_set)
 {
     static size_t const header_size{2};
-    mir::VariableLengthArray<mf::serialization_buffer_size> whole_message{header_size + length};
 
-    whole_message.data()[0] = static_cast<unsigned char>((length >> 8) & 0xff);
-    whole_message.data()[1] = static_cast<unsigned char>((length >> 0) & 0xff);
-    std::copy(data, data + length, whole_message.data() + header_size);
+    PendingMessage message{std::vector<char>(header_size + length), fd_set, 0, 0};
+    message.bytes[0] = static_cast<char>((length >> 8) & 0xff);
+    message.bytes[1] = static_cast<char>((length >> 0) & 0xff);
+    std::copy(data, data + length, message.bytes.data() + header_size);
 
-    std::unique_lock<std::mutex> lg(message_lock);
+    std::lock_guard<std::mutex> lg(message_lock);
 
-    // TODO: This should be asynchronous, but we are not making sure
-    // that a potential call to send_fds is executed _after_ this
-    // function has completed (if it would be executed asynchronously.
-    // NOTE: we rely on this synchronous behavior as per the comment in
-    // mf::SessionMediator::create_surface
-    ba::write(*socket, ba::buffer(whole_message.data(), whole_message.size()));
+    if (dropped)
+        return;
 
-    for (auto const& fds : fd_set)
-        mir::send_fds(socket_fd, fds);
+    backlog_bytes += message.bytes.size();
+    backlog.push_back(std::move(message));
+
+    // Messages (and their fds) are written strictly in the order they were
+    // sent. NOTE: mf::SessionMediator::create_surface relies on this ordering.
+    // If we're already waiting for the socket to become writable the
+    // message simply joins the queue.
+    if (!write_pending)
+        flush_backlog();
+
+    // Anything left of this message is written later, by which time the
+    // caller may have released the fds: keep our own copies
+    if (!backlog.empty())
+        retain_fds(backlog.back());
+
+    if (backlog_bytes > max_backlog_bytes)
+        drop_connection();
 }
 
-void mfd::SocketMessenger::async_receive_msg(
-    MirReadHandler const& handler,
-    ba::mutable_buffers_1 const& buffer)
+void mfd::SocketMessenger::flush_backlog()
 {
-    boost::asio::async_read(
-         *socket,
-         buffer,
-         boost::asio::transfer_exactly(ba::buffer_size(buffer)),
-         handler);
+    while (!backlog.empty())
+    {
+        auto& front = backlog.front();
+
+        if (front.bytes_sent == front.bytes.size())
+        {
+            if (!send_fd_sets(front))
+                return;
+
+            backlog_bytes -= front.bytes.size();
+            backlog.pop_front();
+            continue;
+        }
+
+        // Gather as many whole messages as we can into one write, stopping
+        // after any that has fds: those must arrive before what follows
+        iovec iov[max_messages_per_write];
+        size_t n_iov{0};
+        for (auto& message : backlog)
+        {
+            iov[n_iov].iov_base = message.bytes.data() + message.bytes_sent;
+            iov[n_iov].iov_len = message.bytes.size() - message.bytes_sent;
+            ++n_iov;
+
+            if (!message.fds.empty() || n_iov == max_messages_per_write)
+                break;
+        }
+
+        msghdr header{};
+        header.msg_iov = iov;
+        header.msg_iovlen = n_iov;
+
+        auto const sent = sendmsg(socket_fd, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                wait_for_writable();
+            else
+                drop_connection();
+            return;
+        }
+
+        auto remaining = static_cast<size_t>(sent);
+        while (remaining > 0)
+        {
+            auto& message = backlog.front();
+            auto const written = std::min(remaining, message.bytes.size() - message.bytes_sent);
+            message.bytes_sent += written;
+            remaining -= written;
+
+            if (message.bytes_sent < message.bytes.size() || !message.fds.empty())
+                break;
+
+            backlog_bytes -= message.bytes.size();
+            backlog.pop_front();
+        }
+    }
 }
 
-bs::error_code mfd::SocketMessenger::receive_msg(
-    ba::mutable_buffers_1 const& buffer)
+bool mfd::SocketMessenger::send_fd_sets(PendingMessage& message)
 {
-    bs::error_code e;
-    size_t nread = 0;
-
-    while (nread < ba::buffer_size(buffer))
+    while (message.fd_sets_sent < message.fds.size())
     {
-        nread += boost::asio::read(
-             *socket,
-             ba::mutable_buffers_1{buffer + nread},
-             e);
+        auto const& fds = message.fds[message.fd_sets_sent];
+
+        if (!fds.empty())
+        {
+            // The fds travel with a dummy byte, as in mir::send_fds()
+            char dummy_iov_data = 'M';
+            iovec iov{&dummy_iov_data, 1};
+
+            auto const fds_bytes = fds.size() * sizeof(int);
+            std::vector<char> control(CMSG_SPACE(fds_bytes), 0);
+
+            msghdr header{};
+            header.msg_iov = &iov;
+            header.msg_iovlen = 1;
+            header.msg_control = control.data();
+            header.msg_controllen = control.size();
+
+            auto const cmsg = CMSG_FIRSTHDR(&header);
+            cmsg->cmsg_len = CMSG_LEN(fds_bytes);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+
+            auto data = reinterpret_cast<int*>(CMSG_DATA(cmsg));
+            for (auto const& fd : fds)
+                *data++ = fd;
+
+            if (sendmsg(socket_fd, &header, MSG_NOSIGNAL | MSG_DONTWAIT) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
 
-        if (e && e != ba::error::would_block)
-            break;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    wait_for_writable();
+                else
+                    drop_connection();
+                return false;
+            }
+        }
+
+        ++message.fd_sets_sent;
+    }
+
+    return true;
+}
+
+void mfd::SocketMessenger::retain_fds(PendingMessage& message)
+{
+    for (auto i = message.fd_sets_sent; i != message.fds.size(); ++i)
+    {
+        for (auto& fd : message.fds[i])
+        {
+            int const copy = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+            if (copy < 0)
+            {
+                drop_connection();
+                return;
+            }
+            fd = mir::Fd{copy};
+        }
     }
+}
 
-    return e;
+void mfd::SocketMessenger::wait_for_writable()
+{
+    if (write_pending)
+        return;
+
+    write_pending = true;
+
+    // The wait completes on the IPC thread, which then carries on flushing
+    std::weak_ptr<SocketMessenger> const weak_self{shared_from_this()};
+    socket->async_write_some(
+        ba::null_buffers(),
+        [weak_self](bs::error_code const& error, size_t)
+        {
+            if (auto const self = weak_self.lock())
+                self->on_writable(error);
+        });
+}
+
+void mfd::SocketMessenger::on_writable(bs::error_code const& error)
+{
+    std::lock_guard<std::mutex> lg(message_lock);
+
+    write_pending = false;
+
+    if (error || dropped)
+        return;
+
+    flush_backlog();
 }
 
-void mfd::SocketMessenger::receive_fds(std::vector<Fd>& fds)
+void mfd::SocketMessenger::drop_connection()
 {
-    static char buffer;
-    mir::receive_data(socket_fd, &buffer, 1, fds);
+    // A connection we can no longer write to coherently is shut down: the
+    // pending read sees the hangup and the session is torn down as usual
+    dropped = true;
+    backlog.clear();
+    backlog_bytes = 0;
+    ::shutdown(socket_fd, SHUT_RDWR);
 }
 
-size_t mfd::SocketMessenger::available_bytes()
+void mfd::SocketMessenger::async_wait_readable(MirReadableHandler const& handler)
 {
-    // We call available_bytes() once the client is talking to us
-    // so this is a pragmatic place to grab the session credentials
+    socket->async_read_some(
+        ba::null_buffers(),
+        [handler](bs::error_code const& error, size_t) { handler(error); });
+}
+
+size_t mfd::SocketMessenger::receive_available(
+    ba::mutable_buffers_1 const& buffer,
+    std::vector<Fd>& fds,
+    bs::error_code& error)
+{
+    // We only read once the client is talking to us, so this
+    // is a pragmatic place to grab the session credentials
     if (session_creds.pid() == 0)
         update_session_creds();
 
-    boost::asio::socket_base::bytes_readable command{true};
-    socket->io_control(command);
-    return command.get();
+    iovec iov;
+    iov.iov_base = ba::buffer_cast<void*>(buffer);
+    iov.iov_len = ba::buffer_size(buffer);
+
+    // The kernel ends a read with the byte fds were sent with, so one read never gets more than one set
+    union {
+        cmsghdr cmh;
+        char control[CMSG_SPACE(max_fds_per_read * sizeof(int))];
+    } control_un;
+
+    msghdr msgh;
+    msgh.msg_name = nullptr;
+    msgh.msg_namelen = 0;
+    msgh.msg_iov = &iov;
+    msgh.msg_iovlen = 1;
+    msgh.msg_control = control_un.control;
+    msgh.msg_controllen = sizeof(control_un.control);
+    msgh.msg_flags = 0;
+
+    ssize_t result;
+    do
+    {
+        result = recvmsg(socket_fd, &msgh, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    }
+    while (result < 0 && errno == EINTR);
+
+    if (result < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            error = bs::error_code{errno, bs::system_category()};
+        return 0;
+    }
+
+    if (result == 0)
+    {
+        error = ba::error::eof;
+        return 0;
+    }
+
+    for (auto cmsg = CMSG_FIRSTHDR(&msgh); cmsg; cmsg = CMSG_NXTHDR(&msgh, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            auto const data = reinterpret_cast<int const*>(CMSG_DATA(cmsg));
+            auto const count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i != count; ++i)
+                fds.push_back(Fd{data[i]});
+        }
+    }
+
+    if (msgh.msg_flags & MSG_CTRUNC)
+        error = bs::error_code{EMSGSIZE, bs::system_category()};
+
+    return result;
 }
 
 void mfd::SocketMessenger::set_passcred(int opt)
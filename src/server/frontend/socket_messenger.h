@@ -21,7 +21,10 @@
 #include "message_sender.h"
 #include "message_receiver.h"
 #include "mir/frontend/session_credentials.h"
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -30,28 +33,52 @@ namespace frontend
 namespace detail
 {
 class SocketMessenger : public MessageSender,
-                        public MessageReceiver
+                        public MessageReceiver,
+                        public std::enable_shared_from_this<SocketMessenger>
 {
 public:
     SocketMessenger(std::shared_ptr<boost::asio::local::stream_protocol::socket> const& socket);
 
     void send(char const* data, size_t length, FdSets const& fds) override;
 
-    void async_receive_msg(MirReadHandler const& handler, boost::asio::mutable_buffers_1 const& buffer) override;
-    boost::system::error_code receive_msg(boost::asio::mutable_buffers_1 const& buffer) override;
-    size_t available_bytes() override;
+    void async_wait_readable(MirReadableHandler const& handler) override;
+    size_t receive_available(
+        boost::asio::mutable_buffers_1 const& buffer,
+        std::vector<Fd>& fds,
+        boost::system::error_code& error) override;
     SessionCredentials client_creds() override;
-    void receive_fds(std::vector<Fd>& fds) override;
 
 private:
     void set_passcred(int opt);
     void update_session_creds();
     SessionCredentials creator_creds() const;
 
+    /// A framed message (and the fds that follow it) not yet fully written
+    struct PendingMessage
+    {
+        std::vector<char> bytes;
+        FdSets fds;
+        size_t bytes_sent;
+        size_t fd_sets_sent;
+    };
+
+    // These require message_lock to be held
+    void flush_backlog();
+    bool send_fd_sets(PendingMessage& message);
+    void retain_fds(PendingMessage& message);
+    void wait_for_writable();
+    void drop_connection();
+
+    void on_writable(boost::system::error_code const& error);
+
     std::shared_ptr<boost::asio::local::stream_protocol::socket> socket;
     mir::Fd socket_fd;
 
     std::mutex message_lock;
+    std::deque<PendingMessage> backlog;
+    size_t backlog_bytes{0};
+    bool write_pending{false};
+    bool dropped{false};
     SessionCredentials session_creds{0, 0, 0};
 };
 }
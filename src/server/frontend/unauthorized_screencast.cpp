@@ -17,6 +17,7 @@
  */
 
 #include "unauthorized_screencast.h"
+#include "mir/geometry/region.h"
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
@@ -50,3 +51,9 @@ void mf::UnauthorizedScreencast::capture(mf::ScreencastSessionId, std::shared_pt
     BOOST_THROW_EXCEPTION(
         std::runtime_error("Process is not authorized to capture screencasts"));
 }
+
+mir::geometry::Region mf::UnauthorizedScreencast::last_capture_damage(mf::ScreencastSessionId)
+{
+    BOOST_THROW_EXCEPTION(
+        std::runtime_error("Process is not authorized to capture screencasts"));
+}
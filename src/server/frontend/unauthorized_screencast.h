@@ -38,6 +38,7 @@ public:
     void destroy_session(frontend::ScreencastSessionId id) override;
     std::shared_ptr<graphics::Buffer> capture(frontend::ScreencastSessionId id) override;
     void capture(ScreencastSessionId id, std::shared_ptr<graphics::Buffer> const& buffer) override;
+    geometry::Region last_capture_damage(ScreencastSessionId id) override;
 };
 
 }
@@ -0,0 +1,126 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyboard_state_tracker.h"
+#include "keymap_cache.h"
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <algorithm>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+
+namespace
+{
+// XKB keycodes are evdev scancodes offset by 8
+uint32_t const xkb_keycode_offset = 8;
+}
+
+mf::KeyboardState::KeyboardState(
+    std::shared_ptr<CompiledKeymap const> const& keymap,
+    std::unordered_set<uint32_t> const& pressed)
+    : keymap_{keymap},
+      state{xkb_state_new(keymap->keymap()), &xkb_state_unref}
+{
+    for (auto const scancode : pressed)
+        xkb_state_update_key(state.get(), scancode + xkb_keycode_offset, XKB_KEY_DOWN);
+
+    update_modifiers();
+}
+
+mf::KeyboardState::~KeyboardState() = default;
+
+void mf::KeyboardState::key(uint32_t scancode, bool down)
+{
+    xkb_state_update_key(state.get(), scancode + xkb_keycode_offset, down ? XKB_KEY_DOWN : XKB_KEY_UP);
+    update_modifiers();
+}
+
+void mf::KeyboardState::update_modifiers()
+{
+    modifiers_.depressed = xkb_state_serialize_mods(state.get(), XKB_STATE_MODS_DEPRESSED);
+    modifiers_.latched = xkb_state_serialize_mods(state.get(), XKB_STATE_MODS_LATCHED);
+    modifiers_.locked = xkb_state_serialize_mods(state.get(), XKB_STATE_MODS_LOCKED);
+    modifiers_.group = xkb_state_serialize_layout(state.get(), XKB_STATE_LAYOUT_EFFECTIVE);
+}
+
+mf::KeyboardStateTracker::KeyboardStateTracker(std::shared_ptr<KeymapCache> const& keymaps)
+    : keymaps{keymaps}
+{
+}
+
+mf::KeyboardStateTracker::~KeyboardStateTracker() = default;
+
+template<typename F>
+void mf::KeyboardStateTracker::for_each_state(F const& f)
+{
+    states.erase(
+        std::remove_if(states.begin(), states.end(), [](auto const& state) { return state.expired(); }),
+        states.end());
+
+    for (auto const& state : states)
+        f(*state.lock());
+}
+
+auto mf::KeyboardStateTracker::state_for(mi::Keymap const& names) -> std::shared_ptr<KeyboardState const>
+{
+    auto const keymap = keymaps->keymap_for(names);
+
+    std::shared_ptr<KeyboardState> result;
+    for (auto const& state : states)
+    {
+        auto const live = state.lock();
+        if (live && live->keymap() == keymap)
+            result = live;
+    }
+
+    if (!result)
+    {
+        result = std::make_shared<KeyboardState>(keymap, pressed);
+        states.push_back(result);
+    }
+
+    most_recent = result;
+    return result;
+}
+
+void mf::KeyboardStateTracker::key(uint32_t scancode, bool down)
+{
+    // Anything repeated or out of step with the seat would throw XKB's state off
+    if (down ? !pressed.insert(scancode).second : !pressed.erase(scancode))
+        return;
+
+    for_each_state([&](KeyboardState& state) { state.key(scancode, down); });
+}
+
+void mf::KeyboardStateTracker::sync_pressed(std::vector<uint32_t> const& scancodes)
+{
+    std::unordered_set<uint32_t> const now_pressed{scancodes.begin(), scancodes.end()};
+
+    std::vector<uint32_t> released;
+    for (auto const scancode : pressed)
+    {
+        if (!now_pressed.count(scancode))
+            released.push_back(scancode);
+    }
+
+    for (auto const scancode : released)
+        key(scancode, false);
+
+    for (auto const scancode : now_pressed)
+        key(scancode, true);
+}
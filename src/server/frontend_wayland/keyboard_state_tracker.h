@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_KEYBOARD_STATE_TRACKER_H
+#define MIR_FRONTEND_KEYBOARD_STATE_TRACKER_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+// from <xkbcommon/xkbcommon.h>
+struct xkb_state;
+
+namespace mir
+{
+namespace input
+{
+class Keymap;
+}
+namespace frontend
+{
+class CompiledKeymap;
+class KeymapCache;
+
+/// Modifier state as serialised for wl_keyboard.modifiers
+struct KeyboardModifiers
+{
+    uint32_t depressed{0};
+    uint32_t latched{0};
+    uint32_t locked{0};
+    uint32_t group{0};
+};
+
+inline bool operator==(KeyboardModifiers const& lhs, KeyboardModifiers const& rhs)
+{
+    return lhs.depressed == rhs.depressed &&
+        lhs.latched == rhs.latched &&
+        lhs.locked == rhs.locked &&
+        lhs.group == rhs.group;
+}
+
+inline bool operator!=(KeyboardModifiers const& lhs, KeyboardModifiers const& rhs)
+{
+    return !(lhs == rhs);
+}
+
+/// The XKB state of the seat's keyboard as seen through one keymap
+class KeyboardState
+{
+public:
+    KeyboardState(std::shared_ptr<CompiledKeymap const> const& keymap, std::unordered_set<uint32_t> const& pressed);
+    ~KeyboardState();
+
+    auto keymap() const -> std::shared_ptr<CompiledKeymap const> const& { return keymap_; }
+    auto modifiers() const -> KeyboardModifiers const& { return modifiers_; }
+
+    void key(uint32_t scancode, bool down);
+
+private:
+    KeyboardState(KeyboardState const&) = delete;
+    KeyboardState& operator=(KeyboardState const&) = delete;
+
+    void update_modifiers();
+
+    std::shared_ptr<CompiledKeymap const> const keymap_;
+    std::unique_ptr<xkb_state, void (*)(xkb_state*)> const state;
+    KeyboardModifiers modifiers_;
+};
+
+/**
+ * Tracks the seat's keyboard state once for all the wl_keyboards using it,
+ * applying each key press and release as it happens.
+ * Should only be used from the Wayland thread.
+ */
+class KeyboardStateTracker
+{
+public:
+    explicit KeyboardStateTracker(std::shared_ptr<KeymapCache> const& keymaps);
+    ~KeyboardStateTracker();
+
+    /// The state seen through the keymap named. This is kept up to date for as long as it is held.
+    auto state_for(input::Keymap const& names) -> std::shared_ptr<KeyboardState const>;
+
+    void key(uint32_t scancode, bool down);
+
+    /// Brings the tracked state into line with the keys actually held, applying only the differences
+    void sync_pressed(std::vector<uint32_t> const& scancodes);
+
+private:
+    KeyboardStateTracker(KeyboardStateTracker const&) = delete;
+    KeyboardStateTracker& operator=(KeyboardStateTracker const&) = delete;
+
+    template<typename F>
+    void for_each_state(F const& f);
+
+    std::shared_ptr<KeymapCache> const keymaps;
+    std::unordered_set<uint32_t> pressed;
+    std::vector<std::weak_ptr<KeyboardState>> states;
+    /// Keeps locked modifiers (and the like) across the last keyboard going away
+    std::shared_ptr<KeyboardState> most_recent;
+};
+}
+}
+
+#endif // MIR_FRONTEND_KEYBOARD_STATE_TRACKER_H
@@ -0,0 +1,166 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keymap_cache.h"
+
+#include "mir/anonymous_shm_file.h"
+#include "mir/input/keymap.h"
+
+#include <xkbcommon/xkbcommon.h>
+#include <boost/throw_exception.hpp>
+
+#include <stdexcept>
+#include <sstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/memfd.h>
+#include <sys/syscall.h>
+
+// Older libcs don't know about seals
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+
+namespace
+{
+auto compile(xkb_context* context, mi::Keymap const& names) -> xkb_keymap*
+{
+    xkb_rule_names const rule_names = {
+        "evdev",
+        names.model.c_str(),
+        names.layout.c_str(),
+        names.variant.c_str(),
+        names.options.c_str()
+    };
+
+    if (auto const keymap = xkb_keymap_new_from_names(context, &rule_names, XKB_KEYMAP_COMPILE_NO_FLAGS))
+        return keymap;
+
+    std::stringstream message;
+    message << "Failed to compile keymap " << names;
+    BOOST_THROW_EXCEPTION(std::runtime_error(message.str()));
+}
+
+auto keymap_text(xkb_keymap* keymap) -> std::string
+{
+    std::unique_ptr<char, void(*)(void*)> const text{
+        xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1),
+        free};
+
+    if (!text)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to get keymap as text"));
+
+    return text.get();
+}
+
+/// A memfd holding size bytes of data, sealed against any change, or an invalid Fd if that isn't possible
+auto sealed_copy(char const* data, size_t size) -> mir::Fd
+{
+    mir::Fd fd{static_cast<int>(syscall(SYS_memfd_create, "mir-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING))};
+    if (fd == mir::Fd::invalid)
+        return {};
+
+    for (size_t written = 0; written != size;)
+    {
+        auto const result = write(fd, data + written, size - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return {};
+        }
+        written += result;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1)
+        return {};
+
+    return fd;
+}
+}
+
+mf::CompiledKeymap::CompiledKeymap(xkb_context* context, mi::Keymap const& names)
+    : xkb_keymap_{compile(context, names), &xkb_keymap_unref},
+      text{keymap_text(xkb_keymap_.get())},
+      size{text.size() + 1},
+      sealed_fd{sealed_copy(text.c_str(), size)}
+{
+    if (sealed_fd != Fd::invalid)
+        std::string{}.swap(text);
+}
+
+mf::CompiledKeymap::~CompiledKeymap() = default;
+
+auto mf::CompiledKeymap::keymap() const -> xkb_keymap*
+{
+    return xkb_keymap_.get();
+}
+
+auto mf::CompiledKeymap::client_fd() const -> Fd
+{
+    if (sealed_fd != Fd::invalid)
+        return sealed_fd;
+
+    // Without seals a client could change what every other client sees, so each gets its own
+    AnonymousShmFile shm_buffer{size};
+    memcpy(shm_buffer.base_ptr(), text.c_str(), size);
+    return Fd{dup(shm_buffer.fd())};
+}
+
+auto mf::CompiledKeymap::client_size() const -> size_t
+{
+    return size;
+}
+
+mf::KeymapCache::KeymapCache()
+    : context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref}
+{
+}
+
+mf::KeymapCache::~KeymapCache() = default;
+
+auto mf::KeymapCache::keymap_for(mi::Keymap const& names) -> std::shared_ptr<CompiledKeymap const>
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+
+    auto& entry = keymaps[Names{names.model, names.layout, names.variant, names.options}];
+    auto keymap = entry.lock();
+
+    if (!keymap)
+    {
+        keymap = std::make_shared<CompiledKeymap const>(context.get(), names);
+        entry = keymap;
+
+        for (auto i = keymaps.begin(); i != keymaps.end();)
+        {
+            if (i->second.expired())
+                i = keymaps.erase(i);
+            else
+                ++i;
+        }
+    }
+
+    most_recent = keymap;
+    return keymap;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_KEYMAP_CACHE_H
+#define MIR_FRONTEND_KEYMAP_CACHE_H
+
+#include "mir/fd.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+// from <xkbcommon/xkbcommon.h>
+struct xkb_keymap;
+struct xkb_context;
+
+namespace mir
+{
+namespace input
+{
+class Keymap;
+}
+namespace frontend
+{
+
+/// An XKB keymap compiled from RMLVO names, along with its text form for sending to clients
+class CompiledKeymap
+{
+public:
+    /// Throws std::runtime_error if the names don't describe a keymap
+    CompiledKeymap(xkb_context* context, input::Keymap const& names);
+    ~CompiledKeymap();
+
+    /// Not to be modified; it may be shared by many keyboards
+    auto keymap() const -> xkb_keymap*;
+
+    /**
+     * An fd holding the NUL terminated text form, for a wl_keyboard.keymap event.
+     * This is the same sealed, read-only memfd each time if the kernel allows,
+     * otherwise a new private copy.
+     */
+    auto client_fd() const -> Fd;
+    auto client_size() const -> size_t;
+
+private:
+    CompiledKeymap(CompiledKeymap const&) = delete;
+    CompiledKeymap& operator=(CompiledKeymap const&) = delete;
+
+    std::unique_ptr<xkb_keymap, void (*)(xkb_keymap*)> const xkb_keymap_;
+    std::string text;   ///< Only kept if sealed_fd couldn't be created
+    size_t const size;
+    Fd sealed_fd;
+};
+
+/**
+ * Compiles each distinct keymap once and shares the result between all the
+ * keyboards using it.
+ */
+class KeymapCache
+{
+public:
+    KeymapCache();
+    ~KeymapCache();
+
+    auto keymap_for(input::Keymap const& names) -> std::shared_ptr<CompiledKeymap const>;
+
+private:
+    KeymapCache(KeymapCache const&) = delete;
+    KeymapCache& operator=(KeymapCache const&) = delete;
+
+    using Names = std::tuple<std::string, std::string, std::string, std::string>;
+
+    std::mutex mutex;
+    std::unique_ptr<xkb_context, void (*)(xkb_context*)> const context;
+    std::map<Names, std::weak_ptr<CompiledKeymap const>> keymaps;
+    /// Keeps the current keymap alive while no keyboards are bound
+    std::shared_ptr<CompiledKeymap const> most_recent;
+};
+}
+}
+
+#endif // MIR_FRONTEND_KEYMAP_CACHE_H
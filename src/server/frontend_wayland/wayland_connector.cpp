@@ -548,7 +548,9 @@ public:
     auto buffer_from_shm(
         wl_resource* buffer,
         std::shared_ptr<mir::Executor> wayland_executor,
-        std::function<void()>&& on_consumed)
+        std::function<void()>&& on_consumed,
+        std::shared_ptr<mg::ShmSurfaceState>&,
+        std::vector<mir::geometry::Rectangle> const&)
         -> std::shared_ptr<mir::graphics::Buffer> override
     {
         return mf::WlShmBuffer::mir_buffer_from_wl_buffer(
@@ -66,7 +66,7 @@ void mf::WaylandInputDispatcher::set_focus(bool has_focus)
 
     seat->for_each_listener(client, [wl_surface = wl_surface, has_focus = has_focus](WlKeyboard* keyboard)
         {
-            keyboard->focussed(wl_surface, has_focus);
+            keyboard->focussed(wl_surface->raw_resource(), has_focus);
         });
 }
 
@@ -119,6 +119,7 @@ void mf::WaylandInputDispatcher::handle_keyboard_event(std::chrono::milliseconds
     {
         int const scancode = mir_keyboard_event_scan_code(event);
         bool const down = action == mir_keyboard_action_down;
+        seat->key(scancode, down);
         seat->for_each_listener(client, [&ms, scancode, down](WlKeyboard* keyboard)
             {
                 keyboard->key(ms, scancode, down);
@@ -19,13 +19,11 @@
 #include "wl_keyboard.h"
 
 #include "wayland_utils.h"
-#include "wl_surface.h"
+#include "keymap_cache.h"
 
 #include "mir/executor.h"
-#include "mir/anonymous_shm_file.h"
 #include "mir/input/keymap.h"
 
-#include <xkbcommon/xkbcommon.h>
 #include <boost/throw_exception.hpp>
 
 #include <cstring> // memcpy
@@ -37,12 +35,11 @@ namespace mi = mir::input;
 mf::WlKeyboard::WlKeyboard(
     wl_resource* new_resource,
     mir::input::Keymap const& initial_keymap,
+    std::shared_ptr<KeyboardStateTracker> const& keyboard_states,
     std::function<void(WlKeyboard*)> const& on_destroy,
     std::function<std::vector<uint32_t>()> const& acquire_current_keyboard_state)
     : Keyboard(new_resource, Version<6>()),
-      keymap{nullptr, &xkb_keymap_unref},
-      state{nullptr, &xkb_state_unref},
-      context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref},
+      keyboard_states{keyboard_states},
       on_destroy{on_destroy},
       acquire_current_keyboard_state{acquire_current_keyboard_state}
 {
@@ -71,19 +68,14 @@ mf::WlKeyboard::~WlKeyboard()
 void mf::WlKeyboard::key(std::chrono::milliseconds const& ms, int scancode, bool down)
 {
     auto const serial = wl_display_next_serial(wl_client_get_display(client));
-    /*
-     * HACK! Maintain our own XKB state, so we can serialise it for
-     * wl_keyboard_send_modifiers
-     */
-    xkb_key_direction const xkb_state = down ? XKB_KEY_DOWN : XKB_KEY_UP;
     auto const wayland_state = down ? KeyState::pressed : KeyState::released;
 
-    xkb_state_update_key(state.get(), scancode + 8, xkb_state);
+    // The seat has already applied this key to the shared state
     send_key_event(serial, ms.count(), scancode, wayland_state);
     update_modifier_state();
 }
 
-void mf::WlKeyboard::focussed(WlSurface* surface, bool focussed)
+void mf::WlKeyboard::focussed(wl_resource* surface, bool focussed)
 {
     auto const serial = wl_display_next_serial(wl_client_get_display(client));
     if (focussed)
@@ -91,7 +83,7 @@ void mf::WlKeyboard::focussed(WlSurface* surface, bool focussed)
         // TODO: Send the surface's keymap here
 
         auto const keyboard_state = acquire_current_keyboard_state();
-        update_keyboard_state(keyboard_state);
+        keyboard_states->sync_pressed(keyboard_state);
 
         wl_array key_state;
         wl_array_init(&key_state);
@@ -114,55 +106,26 @@ void mf::WlKeyboard::focussed(WlSurface* surface, bool focussed)
                 keyboard_state.size() * sizeof(decltype(keyboard_state)::value_type));
         }
 
-        send_enter_event(serial, surface->raw_resource(), &key_state);
+        send_enter_event(serial, surface, &key_state);
         wl_array_release(&key_state);
+
+        // The client learns the modifiers from the event after every enter,
+        // even if they haven't changed since it last had focus
+        send_modifiers();
     }
     else
     {
-        send_leave_event(serial, surface->raw_resource());
+        send_leave_event(serial, surface);
     }
 }
 
-void mf::WlKeyboard::update_keyboard_state(std::vector<uint32_t> const& keyboard_state)
-{
-    // Rebuild xkb state
-    state = decltype(state)(xkb_state_new(keymap.get()), &xkb_state_unref);
-    for (auto scancode : keyboard_state)
-    {
-        xkb_state_update_key(state.get(), scancode + 8, XKB_KEY_DOWN);
-    }
-
-    update_modifier_state();
-}
-
 void mf::WlKeyboard::set_keymap(mi::Keymap const& new_keymap)
 {
-    xkb_rule_names const names = {
-        "evdev",
-        new_keymap.model.c_str(),
-        new_keymap.layout.c_str(),
-        new_keymap.variant.c_str(),
-        new_keymap.options.c_str()
-    };
-    keymap = decltype(keymap){
-        xkb_keymap_new_from_names(
-            context.get(),
-            &names,
-            XKB_KEYMAP_COMPILE_NO_FLAGS),
-        &xkb_keymap_unref};
-
-    // TODO: We might need to copy across the existing depressed keys?
-    state = decltype(state)(xkb_state_new(keymap.get()), &xkb_state_unref);
-
-    std::unique_ptr<char, void(*)(void*)> buffer{xkb_keymap_get_as_string(keymap.get(), XKB_KEYMAP_FORMAT_TEXT_V1), free};
-    auto length = strlen(buffer.get());
-
-    mir::AnonymousShmFile shm_buffer{length};
-    memcpy(shm_buffer.base_ptr(), buffer.get(), length);
-
-    send_keymap_event(KeymapFormat::xkb_v1,
-                      Fd{IntOwnedFd{shm_buffer.fd()}},
-                      length);
+    // Compiling a keymap is slow, so each distinct keymap is only compiled once and shared
+    state = keyboard_states->state_for(new_keymap);
+
+    auto const& keymap = state->keymap();
+    send_keymap_event(KeymapFormat::xkb_v1, keymap->client_fd(), keymap->client_size());
 }
 
 void mf::WlKeyboard::update_modifier_state()
@@ -170,35 +133,19 @@ void mf::WlKeyboard::update_modifier_state()
     // TODO?
     // assert_on_wayland_event_loop()
 
-    auto new_depressed_mods = xkb_state_serialize_mods(
-        state.get(),
-        XKB_STATE_MODS_DEPRESSED);
-    auto new_latched_mods = xkb_state_serialize_mods(
-        state.get(),
-        XKB_STATE_MODS_LATCHED);
-    auto new_locked_mods = xkb_state_serialize_mods(
-        state.get(),
-        XKB_STATE_MODS_LOCKED);
-    auto new_group = xkb_state_serialize_layout(
-        state.get(),
-        XKB_STATE_LAYOUT_EFFECTIVE);
-
-    if ((new_depressed_mods != mods_depressed) ||
-        (new_latched_mods != mods_latched) ||
-        (new_locked_mods != mods_locked) ||
-        (new_group != group))
-    {
-        mods_depressed = new_depressed_mods;
-        mods_latched = new_latched_mods;
-        mods_locked = new_locked_mods;
-        group = new_group;
-
-        send_modifiers_event(wl_display_get_serial(wl_client_get_display(client)),
-                             mods_depressed,
-                             mods_latched,
-                             mods_locked,
-                             group);
-    }
+    if (state->modifiers() != modifiers)
+        send_modifiers();
+}
+
+void mf::WlKeyboard::send_modifiers()
+{
+    modifiers = state->modifiers();
+
+    send_modifiers_event(wl_display_get_serial(wl_client_get_display(client)),
+                         modifiers.depressed,
+                         modifiers.latched,
+                         modifiers.locked,
+                         modifiers.group);
 }
 
 void mf::WlKeyboard::release()
@@ -208,5 +155,6 @@ void mf::WlKeyboard::release()
 
 void mir::frontend::WlKeyboard::resync_keyboard()
 {
-    update_keyboard_state(acquire_current_keyboard_state());
+    keyboard_states->sync_pressed(acquire_current_keyboard_state());
+    update_modifier_state();
 }
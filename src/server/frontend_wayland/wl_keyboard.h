@@ -20,16 +20,12 @@
 #define MIR_FRONTEND_WL_KEYBOARD_H
 
 #include "wayland_wrapper.h"
+#include "keyboard_state_tracker.h"
 
 #include <vector>
 #include <functional>
 #include <chrono>
 
-// from <xkbcommon/xkbcommon.h>
-struct xkb_keymap;
-struct xkb_state;
-struct xkb_context;
-
 namespace mir
 {
 
@@ -42,7 +38,6 @@ class Keymap;
 
 namespace frontend
 {
-class WlSurface;
 
 class WlKeyboard : public wayland::Keyboard
 {
@@ -50,31 +45,30 @@ public:
     WlKeyboard(
         wl_resource* new_resource,
         mir::input::Keymap const& initial_keymap,
+        std::shared_ptr<KeyboardStateTracker> const& keyboard_states,
         std::function<void(WlKeyboard*)> const& on_destroy,
         std::function<std::vector<uint32_t>()> const& acquire_current_keyboard_state);
 
     ~WlKeyboard();
 
     void key(std::chrono::milliseconds const& ms, int scancode, bool down);
-    void focussed(WlSurface* surface, bool focussed);
+    void focussed(wl_resource* surface, bool focussed);
     void set_keymap(mir::input::Keymap const& new_keymap);
     void resync_keyboard();
 
 private:
     void update_modifier_state();
-    void update_keyboard_state(std::vector<uint32_t> const& keyboard_state);
+    void send_modifiers();
 
-    std::unique_ptr<xkb_keymap, void (*)(xkb_keymap *)> keymap;
-    std::unique_ptr<xkb_state, void (*)(xkb_state *)> state;
-    std::unique_ptr<xkb_context, void (*)(xkb_context *)> const context;
+    /// Shared by all the seat's keyboards, and kept up to date by it
+    std::shared_ptr<KeyboardStateTracker> const keyboard_states;
+    std::shared_ptr<KeyboardState const> state;
 
     std::function<void(WlKeyboard*)> on_destroy;
     std::function<std::vector<uint32_t>()> const acquire_current_keyboard_state;
 
-    uint32_t mods_depressed{0};
-    uint32_t mods_latched{0};
-    uint32_t mods_locked{0};
-    uint32_t group{0};
+    /// As last sent to the client
+    KeyboardModifiers modifiers;
 
     void release() override;
 };
@@ -37,6 +37,11 @@ std::vector<geom::Rectangle> mf::WlRegion::rectangle_vector()
     return rects;
 }
 
+bool mf::WlRegion::is_exact() const
+{
+    return exact;
+}
+
 mf::WlRegion* mf::WlRegion::from(wl_resource* resource)
 {
     void* raw = wl_resource_get_user_data(resource);
@@ -59,5 +64,6 @@ void mf::WlRegion::subtract(int32_t x, int32_t y, int32_t width, int32_t height)
     (void)y;
     (void)width;
     (void)height;
+    exact = false;
     log_warning("WlRegion::subtract not implemented. ignoring.");
 }
@@ -39,6 +39,9 @@ public:
 
     std::vector<geometry::Rectangle> rectangle_vector();
 
+    /// False if the rectangles over-approximate the region (subtract() is not yet implemented)
+    bool is_exact() const;
+
     static WlRegion* from(wl_resource* resource);
 
 private:
@@ -47,6 +50,7 @@ private:
     void subtract(int32_t x, int32_t y, int32_t width, int32_t height) override;
 
     std::vector<geometry::Rectangle> rects;
+    bool exact{true};
 };
 
 }
@@ -25,6 +25,8 @@
 #include "wl_keyboard.h"
 #include "wl_pointer.h"
 #include "wl_touch.h"
+#include "keymap_cache.h"
+#include "keyboard_state_tracker.h"
 
 #include "mir/executor.h"
 #include "mir/client/event.h"
@@ -161,6 +163,7 @@ mf::WlSeat::WlSeat(
     std::shared_ptr<mir::Executor> const& executor)
     :   Global(display, Version<6>()),
         keymap{std::make_unique<input::Keymap>()},
+        keyboard_states{std::make_shared<KeyboardStateTracker>(std::make_shared<KeymapCache>())},
         config_observer{
             std::make_shared<ConfigObserver>(
                 *keymap,
@@ -215,6 +218,11 @@ void mf::WlSeat::spawn(std::function<void()>&& work)
     executor->spawn(std::move(work));
 }
 
+void mf::WlSeat::key(uint32_t scancode, bool down)
+{
+    keyboard_states->key(scancode, down);
+}
+
 void mf::WlSeat::bind(wl_resource* new_wl_seat)
 {
     new Instance{new_wl_seat, this};
@@ -249,6 +257,7 @@ void mf::WlSeat::Instance::get_keyboard(wl_resource* new_keyboard)
         new WlKeyboard{
             new_keyboard,
             *seat->keymap,
+            seat->keyboard_states,
             [listeners = seat->keyboard_listeners, client = client](WlKeyboard* listener)
             {
                 listeners->unregister_listener(client, listener);
@@ -46,6 +46,7 @@ namespace frontend
 class WlPointer;
 class WlKeyboard;
 class WlTouch;
+class KeyboardStateTracker;
 
 class WlSeat : public wayland::Seat::Global
 {
@@ -66,6 +67,9 @@ public:
 
     void spawn(std::function<void()>&& work);
 
+    /// Applies a key press or release to the state shared by all the seat's keyboards
+    void key(uint32_t scancode, bool down);
+
     class ListenerTracker
     {
     public:
@@ -103,6 +107,7 @@ private:
     class Instance;
 
     std::unique_ptr<mir::input::Keymap> const keymap;
+    std::shared_ptr<KeyboardStateTracker> const keyboard_states;
     std::shared_ptr<ConfigObserver> const config_observer;
 
     // listener list are shared pointers so devices can keep them around long enough to remove themselves
@@ -46,6 +46,20 @@ namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
 
+namespace
+{
+geom::Rectangle damage_rectangle(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    // Clients commonly damage {0, 0, INT32_MAX, INT32_MAX} to mean "everything".
+    // Clamp to something far larger than any buffer, so later arithmetic can't overflow.
+    int32_t const limit = 1 << 24;
+    auto const clamp = [](int32_t value, int32_t min, int32_t max) { return std::min(std::max(value, min), max); };
+
+    return {{clamp(x, -limit, limit), clamp(y, -limit, limit)},
+            {clamp(width, 0, limit), clamp(height, 0, limit)}};
+}
+}
+
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()},
       destroyed{deleted_flag_for_resource(resource)}
@@ -63,10 +77,15 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    damage.insert(end(damage), begin(source.damage), end(source.damage));
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -75,6 +94,7 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 {
     return offset ||
            input_shape ||
+           opaque_region ||
            surface_data_invalidated;
 }
 
@@ -186,7 +206,7 @@ void mf::WlSurface::populate_surface_data(std::vector<shell::StreamSpecification
 {
     geometry::Displacement offset = parent_offset + offset_;
 
-    buffer_streams.push_back(msh::StreamSpecification{stream, offset, {}});
+    buffer_streams.push_back(msh::StreamSpecification{stream, offset, {}, opaque_region});
     geom::Rectangle surface_rect = {geom::Point{} + offset, buffer_size_.value_or(geom::Size{})};
     if (input_shape)
     {
@@ -258,20 +278,13 @@ void mf::WlSurface::attach(std::experimental::optional<wl_resource*> const& buff
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    // Surface and buffer coordinates coincide until we support buffer scale and transform
+    pending.damage.push_back(damage_rectangle(x, y, width, height));
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    pending.damage.push_back(damage_rectangle(x, y, width, height));
 }
 
 void mf::WlSurface::frame(wl_resource* new_callback)
@@ -281,8 +294,13 @@ void mf::WlSurface::frame(wl_resource* new_callback)
 
 void mf::WlSurface::set_opaque_region(std::experimental::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    // A null region means nothing is known to be opaque. So does a region we can't represent exactly: claiming
+    // too much is opaque would hide whatever is beneath it.
+    auto const wl_region = region ? WlRegion::from(region.value()) : nullptr;
+    if (wl_region && wl_region->is_exact())
+        pending.opaque_region = wl_region->rectangle_vector();
+    else
+        pending.opaque_region = std::vector<geom::Rectangle>{};
 }
 
 void mf::WlSurface::set_input_region(std::experimental::optional<wl_resource*> const& region)
@@ -313,6 +331,9 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    if (state.opaque_region)
+        opaque_region = state.opaque_region.value();
+
     if (state.buffer)
     {
         wl_resource * buffer = *state.buffer;
@@ -337,12 +358,19 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
 
             std::shared_ptr<graphics::Buffer> mir_buffer;
 
-            if (wl_shm_buffer_get(buffer))
+            if (auto const shm_buffer = wl_shm_buffer_get(buffer))
             {
+                geom::Rectangle const whole_buffer{
+                    {0, 0},
+                    {wl_shm_buffer_get_width(shm_buffer), wl_shm_buffer_get_height(shm_buffer)}};
+
+                // A client that doesn't report damage gets the whole buffer uploaded, as before
                 mir_buffer = allocator->buffer_from_shm(
                     buffer,
                     executor,
-                    std::move(executor_send_frame_callbacks));
+                    std::move(executor_send_frame_callbacks),
+                    shm_state,
+                    state.damage.empty() ? std::vector<geom::Rectangle>{whole_buffer} : state.damage);
                 tracepoint(
                     mir_server_wayland,
                     sw_buffer_committed,
@@ -401,6 +429,9 @@ void mf::WlSurface::commit()
     if (pending.input_shape && *pending.input_shape == input_shape)
         pending.input_shape = std::experimental::nullopt;
 
+    if (pending.opaque_region && *pending.opaque_region == opaque_region)
+        pending.opaque_region = std::experimental::nullopt;
+
     // order is important
     auto const state = std::move(pending);
     pending = WlSurfaceState();
@@ -37,6 +37,7 @@ class Executor;
 namespace graphics
 {
 class WaylandAllocator;
+class ShmSurfaceState;
 }
 namespace scene
 {
@@ -82,8 +83,12 @@ struct WlSurfaceState
 
     std::experimental::optional<geometry::Displacement> offset;
     std::experimental::optional<std::experimental::optional<std::vector<geometry::Rectangle>>> input_shape;
+    std::experimental::optional<std::vector<geometry::Rectangle>> opaque_region;
     std::vector<std::shared_ptr<Callback>> frame_callbacks;
 
+    // in buffer coordinates, as we don't yet support buffer scale or transform
+    std::vector<geometry::Rectangle> damage;
+
 private:
     // only set to true if invalidate_surface_data() is called
     // surface_data_needs_refresh() returns true if this is true, or if other things are changed which mandate a refresh
@@ -162,6 +167,8 @@ private:
     std::experimental::optional<geometry::Size> buffer_size_;
     std::vector<std::shared_ptr<WlSurfaceState::Callback>> frame_callbacks;
     std::experimental::optional<std::vector<mir::geometry::Rectangle>> input_shape;
+    std::vector<mir::geometry::Rectangle> opaque_region;
+    std::shared_ptr<graphics::ShmSurfaceState> shm_state;
     std::map<void const*, std::function<void()>> destroy_listeners;
     std::shared_ptr<bool> const destroyed;
 
@@ -28,9 +28,16 @@ namespace mf = mir::frontend;
 mf::XWaylandConnector::XWaylandConnector(
     const int xdisplay,
     std::shared_ptr<WaylandConnector> const& wayland_connector,
-    std::string const& xwayland_path) :
+    std::string const& xwayland_path,
+    std::shared_ptr<XWaylandReport> const& report,
+    std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+    XWaylandLifecycle const& lifecycle) :
     start_xwayland{wayland_connector->get_extension("x11-support") ?
-        [=]{ return std::make_unique<XWaylandServer>(xdisplay, wayland_connector, xwayland_path); } :
+        [=]
+        {
+            return std::make_unique<XWaylandServer>(
+                xdisplay, wayland_connector, xwayland_path, report, alarm_factory, lifecycle);
+        } :
         decltype(start_xwayland){[]{ return std::unique_ptr<XWaylandServer>{}; }}}
 {
 }
@@ -20,20 +20,23 @@
 #define MIR_FRONTEND_XWAYLAND_CONNECTOR_H
 
 #include "mir/frontend/connector.h"
+#include "xwayland_server.h"
 
 namespace mir
 {
 namespace frontend
 {
 class WaylandConnector;
-class XWaylandServer;
 class XWaylandConnector : public Connector
 {
 public:
     XWaylandConnector(
         const int xdisplay,
         std::shared_ptr<WaylandConnector> const& wayland_connector,
-        std::string const& xwayland_path);
+        std::string const& xwayland_path,
+        std::shared_ptr<XWaylandReport> const& report,
+        std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+        XWaylandLifecycle const& lifecycle);
     ~XWaylandConnector() override;
 
     void start() override;
@@ -17,9 +17,11 @@
 
 #include "mir/default_server_configuration.h"
 #include "mir/log.h"
+#include "mir/main_loop.h"
 #include "wayland_connector.h"
 #include "xwayland_connector.h"
 
+#include <chrono>
 #include <string>
 
 #include "mir/options/default_configuration.h"
@@ -30,6 +32,14 @@ namespace mo = mir::options;
 
 namespace
 {
+auto seconds_option(mo::Option const& options, char const* name) -> std::experimental::optional<std::chrono::milliseconds>
+{
+    if (options.is_set(name))
+        return std::chrono::seconds{options.get<int>(name)};
+
+    return std::experimental::nullopt;
+}
+
 struct NullConnector : mf::Connector
 {
     void start() override
@@ -67,10 +77,16 @@ std::shared_ptr<mf::Connector> mir::DefaultServerConfiguration::the_xwayland_con
             try
             {
                 auto wayland_connector = std::static_pointer_cast<mf::WaylandConnector>(the_wayland_connector());
+                mf::XWaylandLifecycle lifecycle;
+                lifecycle.prespawn_delay = seconds_option(*options, "xwayland-prespawn-delay");
+                lifecycle.idle_timeout = seconds_option(*options, "xwayland-idle-timeout");
                 return std::make_shared<mf::XWaylandConnector>(
                     options->get<int>(mo::x11_display_opt),
                     wayland_connector,
-                    options->get<std::string>("xwayland-path"));
+                    options->get<std::string>("xwayland-path"),
+                    the_xwayland_report(),
+                    the_main_loop(),
+                    lifecycle);
             }
             catch (...)
             {
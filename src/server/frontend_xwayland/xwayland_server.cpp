@@ -26,10 +26,13 @@
 #include "mir/fd.h"
 #include "mir/log.h"
 #include "mir/terminate_with_current_exception.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
 #include <mir/thread_name.h>
 
 #include <csignal>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -47,34 +50,58 @@ using namespace std::chrono_literals;
 mf::XWaylandServer::XWaylandServer(
     const int xdisplay,
     std::shared_ptr<mf::WaylandConnector> wayland_connector,
-    std::string const& xwayland_path) :
+    std::string const& xwayland_path,
+    std::shared_ptr<XWaylandReport> const& report,
+    std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+    XWaylandLifecycle const& lifecycle) :
     wayland_connector{wayland_connector},
     dispatcher{std::make_shared<md::MultiplexingDispatchable>()},
     xserver_thread{std::make_unique<dispatch::ThreadedDispatcher>(
         "Mir/X11 Reader", dispatcher, []() { terminate_with_current_exception(); })},
     sockets{xdisplay},
     afd_dispatcher{
-        std::make_shared<md::ReadableFd>(Fd{IntOwnedFd{sockets.abstract_socket_fd}}, [this]{ new_spawn_thread(); })},
+        std::make_shared<md::ReadableFd>(
+            Fd{IntOwnedFd{sockets.abstract_socket_fd}},
+            [this]{ new_spawn_thread(Activation::client_connected); })},
     fd_dispatcher{
-        std::make_shared<md::ReadableFd>(Fd{IntOwnedFd{sockets.socket_fd}}, [this] { new_spawn_thread(); })},
-    xwayland_path{xwayland_path}
+        std::make_shared<md::ReadableFd>(
+            Fd{IntOwnedFd{sockets.socket_fd}},
+            [this] { new_spawn_thread(Activation::client_connected); })},
+    xwayland_path{xwayland_path},
+    report{report},
+    idle_timeout{lifecycle.idle_timeout},
+    prespawn_alarm{lifecycle.prespawn_delay ?
+        alarm_factory->create_alarm([this]{ new_spawn_thread(Activation::prespawn); }) :
+        std::unique_ptr<time::Alarm>{}},
+    idle_alarm{lifecycle.idle_timeout ?
+        alarm_factory->create_alarm([this]{ stop_if_idle(); }) :
+        std::unique_ptr<time::Alarm>{}}
 {
-    dispatcher->add_watch(afd_dispatcher);
-    dispatcher->add_watch(fd_dispatcher);
+    watch_sockets();
+
+    if (prespawn_alarm)
+        prespawn_alarm->reschedule_in(lifecycle.prespawn_delay.value());
 }
 
 mf::XWaylandServer::~XWaylandServer()
 {
     mir::log_info("Deiniting xwayland server");
 
+    if (prespawn_alarm)
+        prespawn_alarm->cancel();
+
+    if (idle_alarm)
+        idle_alarm->cancel();
+
     // Terminate any running xservers
     {
         std::lock_guard<decltype(spawn_thread_mutex)> lock(spawn_thread_mutex);
 
+        // Also stops Xwayland being started again
+        spawn_thread_terminate = true;
+
         if (spawn_thread_xserver_status > 0)
         {
-            spawn_thread_terminate = true;
-
             if (kill(spawn_thread_pid, SIGTERM) == 0)
             {
                 std::this_thread::sleep_for(100ms);// After 100ms...
@@ -89,14 +116,17 @@ mf::XWaylandServer::~XWaylandServer()
 
     if (spawn_thread.joinable())
         spawn_thread.join();
+
+    unwatch_sockets();
 }
 
 void mf::XWaylandServer::spawn()
 {
     set_thread_name("XWaylandServer::spawn");
 
+    // For the ready pipe the server end is the one read from
     enum { server, client, size };
-    int wl_client_fd[size], wm_fd[size];
+    int wl_client_fd[size], wm_fd[size], ready_fd[size];
 
     int xserver_spawn_tries = 0;
     std::unique_lock<decltype(spawn_thread_mutex)> lock{spawn_thread_mutex};
@@ -109,6 +139,7 @@ void mf::XWaylandServer::spawn()
           return;
         }
         spawn_thread_xserver_status = STARTING;
+        spawn_thread_idle_stop = false;
         xserver_spawn_tries++;
 
         if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, wl_client_fd) < 0)
@@ -125,7 +156,15 @@ void mf::XWaylandServer::spawn()
             return; // doesn't reach here
         }
 
+        if (pipe2(ready_fd, O_CLOEXEC) < 0)
+        {
+            // "Shouldn't happen" but continuing is weird.
+            mir::fatal_error("ready fd pipe failed");
+            return; // doesn't reach here
+        }
+
         mir::log_info("Starting Xwayland");
+        report->spawning(spawn_thread_activation);
         spawn_thread_pid = fork();
 
         switch (spawn_thread_pid)
@@ -137,23 +176,34 @@ void mf::XWaylandServer::spawn()
         case 0:
             close(wl_client_fd[server]);
             close(wm_fd[server]);
-            execl_xwayland(wl_client_fd[client], wm_fd[client]);
+            close(ready_fd[server]);
+            execl_xwayland(wl_client_fd[client], wm_fd[client], ready_fd[client]);
             return; // Keep compiler happy (doesn't reach here)
 
         default:
             close(wl_client_fd[client]);
             close(wm_fd[client]);
-            connect_wm_to_xwayland(wl_client_fd[server], wm_fd[server], lock);
+            close(ready_fd[client]);
+            connect_wm_to_xwayland(wl_client_fd[server], wm_fd[server], ready_fd[server], lock);
             if (spawn_thread_xserver_status != STARTING)
             {
                 // Reset the tries since the server started
                 xserver_spawn_tries = 0;
             }
 
+            spawn_thread_activation = Activation::restart;
+            spawn_thread_activated_at = std::chrono::steady_clock::now();
             break;
         }
     }
     while (spawn_thread_xserver_status != STOPPED);
+
+    auto const terminating = spawn_thread_terminate;
+    lock.unlock();
+
+    // Start again when the next client connects
+    if (!terminating)
+        watch_sockets();
 }
 
 namespace
@@ -177,7 +227,7 @@ bool set_cloexec(int fd, bool cloexec) {
 }
 }
 
-void mf::XWaylandServer::execl_xwayland(int wl_client_client_fd, int wm_client_fd)
+void mf::XWaylandServer::execl_xwayland(int wl_client_client_fd, int wm_client_fd, int ready_client_fd)
 {
     setenv("EGL_PLATFORM", "DRM", 1);
 
@@ -205,14 +255,12 @@ void mf::XWaylandServer::execl_xwayland(int wl_client_client_fd, int wm_client_f
     mir::log_error("Failed to duplicate xwayland wm FD");
     auto const wm_fd_str = std::to_string(wm_fd);
 
-    auto const dsp_str = ":" + std::to_string(sockets.xdisplay);
+    auto const ready_fd = dup(ready_client_fd);
+    if (ready_fd < 0)
+        mir::log_error("Failed to duplicate xwayland ready FD");
+    auto const ready_fd_str = std::to_string(ready_fd);
 
-    // Propagate SIGUSR1 to parent process
-    struct sigaction action;
-    sigemptyset(&action.sa_mask);
-    action.sa_flags = 0;
-    action.sa_handler = SIG_IGN;
-    sigaction(SIGUSR1, &action, nullptr);
+    auto const dsp_str = ":" + std::to_string(sockets.xdisplay);
 
     execl(
         xwayland_path.c_str(),
@@ -222,42 +270,48 @@ void mf::XWaylandServer::execl_xwayland(int wl_client_client_fd, int wm_client_f
         "-listen", abstract_socket_fd_str.c_str(),
         "-listen", socket_fd_str.c_str(),
         "-wm", wm_fd_str.c_str(),
+        "-displayfd", ready_fd_str.c_str(),
         "-terminate",
         NULL);
 }
 
 namespace
 {
-bool spin_wait_for(sig_atomic_t& xserver_ready)
+/// Xwayland writes the display number to the -displayfd pipe once it is ready for clients
+bool wait_for_ready(mir::Fd const& ready_fd, std::chrono::milliseconds timeout)
 {
-    auto const end = std::chrono::steady_clock::now() + 5s;
+    auto const end = std::chrono::steady_clock::now() + timeout;
 
-    while (std::chrono::steady_clock::now() < end && !xserver_ready)
+    for (;;)
     {
-        std::this_thread::sleep_for(100ms);
+        auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            end - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0)
+            return false;
+
+        pollfd ready{ready_fd, POLLIN, 0};
+        auto const result = poll(&ready, 1, static_cast<int>(remaining.count()));
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return false;
+
+        char display[16];
+        auto const bytes = read(ready_fd, display, sizeof display);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+
+        // Reaching the end of the pipe without reading anything means Xwayland exited without becoming ready
+        return bytes > 0;
     }
-
-    return xserver_ready;
 }
 }
 
 void mf::XWaylandServer::connect_wm_to_xwayland(
-    int wl_client_server_fd, int wm_server_fd, std::unique_lock<decltype(spawn_thread_mutex)>& spawn_thread_lock)
+    int wl_client_server_fd, int wm_server_fd, int ready_server_fd,
+    std::unique_lock<decltype(spawn_thread_mutex)>& spawn_thread_lock)
 {
-    // We need to set up the signal handling before connecting wl_client_server_fd
-    static sig_atomic_t xserver_ready{ false };
-
-    // In practice, there ought to be no contention on xserver_ready, but let's be certain
-    static std::mutex xserver_ready_mutex;
-    std::lock_guard<decltype(xserver_ready_mutex)> lock{xserver_ready_mutex};
-    xserver_ready = false;
-
-    struct sigaction action;
-    struct sigaction old_action;
-    action.sa_handler = [](int) { xserver_ready = true; };
-    sigemptyset(&action.sa_mask);
-    action.sa_flags = 0;
-    sigaction(SIGUSR1, &action, &old_action);
+    Fd const ready_fd{ready_server_fd};
 
     wl_client* client = nullptr;
     {
@@ -280,34 +334,49 @@ void mf::XWaylandServer::connect_wm_to_xwayland(
         }
     }
 
-    //The client can connect, now wait for it to signal ready (SIGUSR1)
-    auto const xwayland_startup_timed_out = !spin_wait_for(xserver_ready);
-    sigaction(SIGUSR1, &old_action, nullptr);
-
-    if (xwayland_startup_timed_out)
+    // The client can connect, now wait for it to say it's ready
+    if (!wait_for_ready(ready_fd, 5s))
     {
+        report->start_failed(spawn_thread_activation, std::chrono::steady_clock::now() - spawn_thread_activated_at);
         mir::log_info("Stalled start of Xserver, trying to start again!");
+
+        // Don't leave it behind to compete with the next one for the sockets
+        kill(spawn_thread_pid, SIGKILL);
+        waitpid(spawn_thread_pid, nullptr, 0);
         close(wm_server_fd);
         return;
     }
 
-    XWaylandWM wm{wayland_connector, client, wm_server_fd};
-    mir::log_info("XServer is running");
-    spawn_thread_xserver_status = RUNNING;
     auto const pid = spawn_thread_pid; // For clarity only as this is only written on this thread
-
-    // Unlock access to spawn_thread_* while Xwayland is running
-    spawn_thread_lock.unlock();
     int status;
-    waitpid(pid, &status, 0);  // Blocking
+
+    {
+        XWaylandWM wm{wayland_connector, client, wm_server_fd, [this](bool idle) { idle_changed(idle); }};
+        mir::log_info("XServer is running");
+        report->started(spawn_thread_activation, std::chrono::steady_clock::now() - spawn_thread_activated_at);
+        spawn_thread_xserver_status = RUNNING;
+        spawn_thread_wm = &wm;
+
+        // Unlock access to spawn_thread_* while Xwayland is running
+        spawn_thread_lock.unlock();
+        waitpid(pid, &status, 0);  // Blocking
+
+        // So stop_if_idle() doesn't use the WM as it goes
+        spawn_thread_lock.lock();
+        spawn_thread_wm = nullptr;
+        spawn_thread_lock.unlock();
+    }
+
     spawn_thread_lock.lock();
 
-    if (WIFEXITED(status) || spawn_thread_terminate) {
+    if (WIFEXITED(status) || spawn_thread_terminate || spawn_thread_idle_stop) {
         mir::log_info("Xserver stopped");
+        report->stopped(false);
         spawn_thread_xserver_status = STOPPED;
     } else {
         // Failed, crash or killed
         mir::log_info("Xserver crashed or got killed");
+        report->stopped(true);
         spawn_thread_xserver_status = FAILED;
     }
 }
@@ -342,7 +411,8 @@ int create_socket(struct sockaddr_un *addr, size_t path_size) {
             unlink(addr->sun_path);
           return -1;
     	}
-    	if (listen(fd, 1) < 0) {
+    	// Clients wait here while Xwayland starts
+    	if (listen(fd, SOMAXCONN) < 0) {
     		mir::fatal_error("Failed to listen to socket %c%s",
     			addr->sun_path[0] ? addr->sun_path[0] : '@',
     			addr->sun_path + 1);
@@ -460,15 +530,75 @@ mf::XWaylandServer::SocketFd::~SocketFd()
     close(socket_fd);
 }
 
-void mf::XWaylandServer::new_spawn_thread()
+void mf::XWaylandServer::new_spawn_thread(Activation activation)
 {
-    std::lock_guard<decltype(spawn_thread_mutex)> lock(spawn_thread_mutex);
+    // If the lock is held Xwayland is being started or stopped already
+    std::unique_lock<decltype(spawn_thread_mutex)> lock{spawn_thread_mutex, std::try_to_lock};
+    if (!lock || spawn_thread_terminate) return;
 
     // Don't run the server more then once!
     if (spawn_thread_xserver_status > 0) return;
 
+    // Xwayland accepts the connections waiting on the sockets itself
+    unwatch_sockets();
+
     spawn_thread_xserver_status = STARTING;
+    spawn_thread_activation = activation;
+    spawn_thread_activated_at = std::chrono::steady_clock::now();
 
     if (spawn_thread.joinable()) spawn_thread.join();
     spawn_thread = std::thread{&mf::XWaylandServer::spawn, this};
 }
+
+void mf::XWaylandServer::watch_sockets()
+{
+    std::lock_guard<decltype(watch_mutex)> lock{watch_mutex};
+
+    if (watching_sockets) return;
+
+    dispatcher->add_watch(afd_dispatcher);
+    dispatcher->add_watch(fd_dispatcher);
+    watching_sockets = true;
+}
+
+void mf::XWaylandServer::unwatch_sockets()
+{
+    std::lock_guard<decltype(watch_mutex)> lock{watch_mutex};
+
+    if (!watching_sockets) return;
+
+    dispatcher->remove_watch(afd_dispatcher);
+    dispatcher->remove_watch(fd_dispatcher);
+    watching_sockets = false;
+}
+
+void mf::XWaylandServer::idle_changed(bool idle)
+{
+    xserver_idle = idle;
+
+    if (!idle_alarm)
+        return;
+
+    if (idle)
+        idle_alarm->reschedule_in(idle_timeout.value());
+    else
+        idle_alarm->cancel();
+}
+
+void mf::XWaylandServer::stop_if_idle()
+{
+    // If the lock is held Xwayland is being started or stopped, so isn't idle
+    std::unique_lock<decltype(spawn_thread_mutex)> lock{spawn_thread_mutex, std::try_to_lock};
+    if (!lock || !xserver_idle || spawn_thread_xserver_status != RUNNING || !spawn_thread_wm) return;
+
+    if (spawn_thread_wm->has_other_clients())
+    {
+        // Perhaps they'll have gone by then
+        idle_alarm->reschedule_in(idle_timeout.value());
+        return;
+    }
+
+    report->stopping_idle();
+    spawn_thread_idle_stop = true;
+    kill(spawn_thread_pid, SIGTERM);
+}
@@ -19,6 +19,11 @@
 #ifndef MIR_FRONTEND_XWAYLAND_SERVER_H
 #define MIR_FRONTEND_XWAYLAND_SERVER_H
 
+#include "mir/frontend/xwayland_report.h"
+
+#include <atomic>
+#include <chrono>
+#include <experimental/optional>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -32,25 +37,61 @@ class ReadableFd;
 class ThreadedDispatcher;
 class MultiplexingDispatchable;
 } /*dispatch */
+namespace time
+{
+class Alarm;
+class AlarmFactory;
+}
 namespace frontend
 {
 class WaylandConnector;
+class XWaylandWM;
+
+/// When Xwayland is started and stopped. By default it is started when the first X11 client connects and then
+/// kept running.
+struct XWaylandLifecycle
+{
+    /// Start Xwayland this long after Mir without waiting for a client, so the first client doesn't wait for it
+    std::experimental::optional<std::chrono::milliseconds> prespawn_delay;
+    /// Stop Xwayland once it has had no X clients (other than our window manager) for about this long. It is started
+    /// again when a client next connects.
+    std::experimental::optional<std::chrono::milliseconds> idle_timeout;
+};
 
 class XWaylandServer
 {
 public:
-    XWaylandServer(const int xdisp, std::shared_ptr<WaylandConnector> wayland_connector, std::string const& xwayland_path);
+    XWaylandServer(
+        const int xdisp,
+        std::shared_ptr<WaylandConnector> wayland_connector,
+        std::string const& xwayland_path,
+        std::shared_ptr<XWaylandReport> const& report,
+        std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+        XWaylandLifecycle const& lifecycle);
     ~XWaylandServer();
 
 private:
+    using Activation = XWaylandReport::Activation;
+
     /// Forks off the XWayland process
     void spawn();
     /// Called after fork() if we should turn into XWayland
-    void execl_xwayland(int wl_client_client_fd, int wm_client_fd);
+    void execl_xwayland(int wl_client_client_fd, int wm_client_fd, int ready_client_fd);
     /// Called after fork() if we should continue on as Mir
     void connect_wm_to_xwayland(
-        int wl_client_server_fd, int wm_server_fd, std::unique_lock<std::mutex>& spawn_thread_lock);
-    void new_spawn_thread();
+        int wl_client_server_fd, int wm_server_fd, int ready_server_fd,
+        std::unique_lock<std::mutex>& spawn_thread_lock);
+    void new_spawn_thread(Activation activation);
+
+    /// Connections queue on the sockets while these are not watched, until Xwayland accepts them
+    void watch_sockets();
+    void unwatch_sockets();
+
+    /// Called by the window manager whenever Xwayland gains its first window or loses its last one
+    void idle_changed(bool idle);
+    /// Clients without windows can't be seen coming and going, so once there are no windows this asks the window
+    /// manager every idle_timeout whether any clients remain
+    void stop_if_idle();
 
     struct SocketFd
     {
@@ -75,13 +116,27 @@ private:
     SocketFd const sockets;
     std::shared_ptr<dispatch::ReadableFd> const afd_dispatcher;
     std::shared_ptr<dispatch::ReadableFd> const fd_dispatcher;
+    std::mutex watch_mutex;
+    bool watching_sockets{false};
     std::string const xwayland_path;
+    std::shared_ptr<XWaylandReport> const report;
+    std::experimental::optional<std::chrono::milliseconds> const idle_timeout;
 
     std::mutex mutable spawn_thread_mutex;
     std::thread spawn_thread;
     pid_t spawn_thread_pid;
     Status spawn_thread_xserver_status{Status::STOPPED};
     bool spawn_thread_terminate{false};
+    bool spawn_thread_idle_stop{false};
+    Activation spawn_thread_activation{Activation::client_connected};
+    std::chrono::steady_clock::time_point spawn_thread_activated_at;
+    XWaylandWM* spawn_thread_wm{nullptr}; ///< Set while Xwayland is running
+
+    std::atomic<bool> xserver_idle{false};
+
+    /// The alarm callbacks only try spawn_thread_mutex, so these can be used while holding it
+    std::unique_ptr<time::Alarm> const prespawn_alarm;
+    std::unique_ptr<time::Alarm> const idle_alarm;
 };
 } /* frontend */
 } /* mir */
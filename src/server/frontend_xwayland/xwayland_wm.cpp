@@ -35,6 +35,7 @@
 #include <unistd.h>
 #include <sstream>
 #include <boost/throw_exception.hpp>
+#include <xcb/xcbext.h>
 
 #ifndef ARRAY_LENGTH
 #define ARRAY_LENGTH(a) mir::frontend::length_of(a)
@@ -94,14 +95,19 @@ auto data_buffer_to_debug_string(T* data, size_t elements) -> std::string
 }
 }
 
-mf::XWaylandWM::XWaylandWM(std::shared_ptr<WaylandConnector> wayland_connector, wl_client* wayland_client, int fd)
+mf::XWaylandWM::XWaylandWM(
+    std::shared_ptr<WaylandConnector> wayland_connector,
+    wl_client* wayland_client,
+    int fd,
+    std::function<void(bool idle)> const& idle_changed)
     : wm_fd{fd},
       xcb_connection{xcb_connect_to_fd(wm_fd, nullptr)},
       xcb_atom{xcb_connection},
       wayland_connector(wayland_connector),
       dispatcher{std::make_shared<mir::dispatch::MultiplexingDispatchable>()},
       wayland_client{wayland_client},
-      wm_shell{std::static_pointer_cast<XWaylandWMShell>(wayland_connector->get_extension("x11-support"))}
+      wm_shell{std::static_pointer_cast<XWaylandWMShell>(wayland_connector->get_extension("x11-support"))},
+      idle_changed{idle_changed}
 {
     if (xcb_connection_has_error(xcb_connection))
     {
@@ -162,6 +168,11 @@ mf::XWaylandWM::XWaylandWM(std::shared_ptr<WaylandConnector> wayland_connector,
 
     create_wm_window();
     xcb_flush(xcb_connection);
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        idle_changed(surfaces.empty());
+    }
 }
 
 mf::XWaylandWM::~XWaylandWM()
@@ -195,6 +206,8 @@ mf::XWaylandWM::~XWaylandWM()
         event_thread.reset();
     }
 
+    pending_property_replies.clear();
+
     // xcb_cursors == 2 when its empty
     if (xcb_cursors.size() != 2)
     {
@@ -318,10 +331,28 @@ void mf::XWaylandWM::run_on_wayland_thread(std::function<void()>&& work)
     wayland_connector->run_on_wayland_display([work = move(work)](auto){ work(); });
 }
 
+void mf::XWaylandWM::get_property_async(
+    xcb_window_t window,
+    xcb_atom_t property,
+    std::function<void(xcb_get_property_reply_t*)>&& handler)
+{
+    xcb_get_property_cookie_t const cookie = xcb_get_property(
+        xcb_connection,
+        0, // don't delete
+        window,
+        property,
+        XCB_ATOM_ANY,
+        0,
+        2048);
+
+    pending_property_replies.push_back({cookie, std::move(handler)});
+}
+
 /* Events */
 void mf::XWaylandWM::handle_events()
 {
-    bool got_events = false;
+    // Replies may have already been read off the connection by a blocking call on another thread
+    bool got_events = handle_replies();
 
     while (xcb_generic_event_t* const event = xcb_poll_for_event(xcb_connection))
     {
@@ -341,12 +372,54 @@ void mf::XWaylandWM::handle_events()
         got_events = true;
     }
 
+    // Polling for events reads everything available, including any replies we are waiting on
+    if (handle_replies())
+        got_events = true;
+
     if (got_events)
     {
         xcb_flush(xcb_connection);
     }
 }
 
+auto mf::XWaylandWM::handle_replies() -> bool
+{
+    bool got_replies = false;
+
+    while (!pending_property_replies.empty())
+    {
+        void* reply{nullptr};
+        xcb_generic_error_t* error{nullptr};
+        if (!xcb_poll_for_reply(xcb_connection, pending_property_replies.front().cookie.sequence, &reply, &error))
+            break;
+
+        free(error);
+        std::unique_ptr<xcb_get_property_reply_t, void(*)(void*)> const property_reply{
+            static_cast<xcb_get_property_reply_t*>(reply),
+            free};
+
+        // The handler may request more properties, so take it off the queue before calling it
+        auto const handler = std::move(pending_property_replies.front().handler);
+        pending_property_replies.pop_front();
+
+        try
+        {
+            handler(property_reply.get());
+        }
+        catch (...)
+        {
+            log(
+                logging::Severity::warning,
+                MIR_LOG_COMPONENT,
+                std::current_exception(),
+                "Failed to handle xcb property reply.");
+        }
+        got_replies = true;
+    }
+
+    return got_replies;
+}
+
 void mf::XWaylandWM::handle_event(xcb_generic_event_t* event)
 {
     int type = event->response_type & ~0x80;
@@ -432,33 +505,22 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
         }
         else
         {
-            xcb_get_property_cookie_t const cookie = xcb_get_property(
-                xcb_connection,
-                0, // don't delete
-                event->window,
-                event->atom,
-                XCB_ATOM_ANY,
-                0,
-                2048);
-
-            xcb_get_property_reply_t* const reply = xcb_get_property_reply(xcb_connection, cookie, NULL);
-
-            auto const prop_name = get_atom_name(event->atom);
-            auto const reply_str = get_reply_debug_string(reply);
-
-            log_debug(
-                "XCB_PROPERTY_NOTIFY (%s).%s: %s",
-                get_window_debug_string(event->window).c_str(),
-                prop_name.c_str(),
-                reply_str.c_str());
-
-            free(reply);
+            auto const window = event->window;
+            auto const atom = event->atom;
+            get_property_async(window, atom, [this, window, atom](xcb_get_property_reply_t* reply)
+                {
+                    log_debug(
+                        "XCB_PROPERTY_NOTIFY (%s).%s: %s",
+                        get_window_debug_string(window).c_str(),
+                        get_atom_name(atom).c_str(),
+                        get_reply_debug_string(reply).c_str());
+                });
         }
     }
 
     if (auto const surface = get_wm_surface(event->window))
     {
-        surface.value()->dirty_properties();
+        surface.value()->property_changed(event->atom);
     }
 }
 
@@ -488,6 +550,9 @@ void mf::XWaylandWM::handle_create_notify(xcb_create_notify_event_t *event)
                     std::runtime_error(get_window_debug_string(event->window) + " created, but already known"));
 
             surfaces[event->window] = surface;
+
+            if (surfaces.size() == 1)
+                idle_changed(false);
         }
     }
 }
@@ -523,6 +588,9 @@ void mf::XWaylandWM::handle_destroy_notify(xcb_destroy_notify_event_t *event)
         {
             surface = iter->second;
             surfaces.erase(iter);
+
+            if (surfaces.empty())
+                idle_changed(true);
         }
     }
 
@@ -542,11 +610,18 @@ void mf::XWaylandWM::handle_map_request(xcb_map_request_event_t *event)
 
     if (auto const surface = get_wm_surface(event->window))
     {
-        surface.value()->read_properties();
-        surface.value()->set_workspace(0);
-        surface.value()->apply_mir_state_to_window(mir_window_state_restored); // TODO: get the actual state
-        xcb_map_window(xcb_connection, event->window);
-        xcb_flush(xcb_connection);
+        auto const window = event->window;
+
+        // Hold off mapping until the properties are in, so the scene surface is created with them
+        surface.value()->read_properties([this, window]()
+            {
+                if (auto const surface = get_wm_surface(window))
+                {
+                    surface.value()->set_workspace(0);
+                    surface.value()->apply_mir_state_to_window(mir_window_state_restored); // TODO: get the actual state
+                    xcb_map_window(xcb_connection, window);
+                }
+            });
     }
 }
 
@@ -801,6 +876,7 @@ void mf::XWaylandWM::wm_get_resources()
 
     xcb_prefetch_extension_data(xcb_connection, &xcb_xfixes_id);
     xcb_prefetch_extension_data(xcb_connection, &xcb_composite_id);
+    xcb_prefetch_extension_data(xcb_connection, &xcb_res_id);
 
     formats_cookie = xcb_render_query_pict_formats(xcb_connection);
 
@@ -808,6 +884,11 @@ void mf::XWaylandWM::wm_get_resources()
     if (!xfixes || !xfixes->present)
         log_warning("xfixes not available");
 
+    auto const res = xcb_get_extension_data(xcb_connection, &xcb_res_id);
+    res_available = res && res->present;
+    if (!res_available)
+        log_warning("XRes not available, so Xwayland can't tell when it has no clients");
+
     xfixes_cookie = xcb_xfixes_query_version(xcb_connection, XCB_XFIXES_MAJOR_VERSION, XCB_XFIXES_MINOR_VERSION);
     xfixes_reply = xcb_xfixes_query_version_reply(xcb_connection, xfixes_cookie, NULL);
 
@@ -835,6 +916,28 @@ void mf::XWaylandWM::wm_get_resources()
     free(formats_reply);
 }
 
+auto mf::XWaylandWM::has_other_clients() const -> bool
+{
+    if (!res_available)
+        return true;
+
+    auto const reply = xcb_res_query_clients_reply(xcb_connection, xcb_res_query_clients(xcb_connection), nullptr);
+    if (!reply)
+        return true;
+
+    // The X server lists itself (with a resource base of zero) as well as us
+    auto const our_resource_base = xcb_get_setup(xcb_connection)->resource_id_base;
+    bool others{false};
+    for (auto i = xcb_res_query_clients_clients_iterator(reply); i.rem; xcb_res_client_next(&i))
+    {
+        if (i.data->resource_base != 0 && i.data->resource_base != our_resource_base)
+            others = true;
+    }
+
+    free(reply);
+    return others;
+}
+
 auto mf::XWaylandWM::get_reply_debug_string(xcb_get_property_reply_t* reply) -> std::string
 {
     if (reply == nullptr)
@@ -920,11 +1023,16 @@ auto mf::XWaylandWM::get_reply_string(xcb_get_property_reply_t* reply) -> std::e
 
 auto mf::XWaylandWM::get_atom_name(xcb_atom_t atom) -> std::string
 {
-    // TODO: cache, for cheaper lookup or eliminate usage altogether
-
     if (atom == XCB_ATOM_NONE)
         return "None";
 
+    {
+        std::lock_guard<std::mutex> lock{atom_names_mutex};
+        auto const cached = atom_names.find(atom);
+        if (cached != atom_names.end())
+            return cached->second;
+    }
+
     xcb_get_atom_name_cookie_t const cookie = xcb_get_atom_name(xcb_connection, atom);
     xcb_get_atom_name_reply_t* const reply = xcb_get_atom_name_reply(xcb_connection, cookie, nullptr);
 
@@ -935,6 +1043,9 @@ auto mf::XWaylandWM::get_atom_name(xcb_atom_t atom) -> std::string
         auto const name_data = xcb_get_atom_name_name(reply);
         auto const name_len = xcb_get_atom_name_name_length(reply);
         name = std::string{name_data, name_data + name_len};
+
+        std::lock_guard<std::mutex> lock{atom_names_mutex};
+        atom_names[atom] = name;
     }
     else
     {
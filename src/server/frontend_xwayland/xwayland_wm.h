@@ -23,15 +23,19 @@
 #include "wayland_connector.h"
 #include "xcb_atoms.h"
 
+#include <deque>
+#include <functional>
 #include <map>
 #include <thread>
 #include <experimental/optional>
 #include <mutex>
+#include <unordered_map>
 
 #include <wayland-server-core.h>
 
 #include <X11/Xcursor/Xcursor.h>
 #include <xcb/composite.h>
+#include <xcb/res.h>
 #include <xcb/xcb.h>
 #include <xcb/xfixes.h>
 
@@ -62,7 +66,13 @@ private:
     xcb_connection_t* const xcb_connection;
 
 public:
-    XWaylandWM(std::shared_ptr<WaylandConnector> wayland_connector, wl_client* wayland_client, int fd);
+    /// idle_changed is called with true whenever there are no X11 windows, and with false when the first one is
+    /// created. It is called once on construction.
+    XWaylandWM(
+        std::shared_ptr<WaylandConnector> wayland_connector,
+        wl_client* wayland_client,
+        int fd,
+        std::function<void(bool idle)> const& idle_changed);
     ~XWaylandWM();
 
     auto get_xcb_connection() const -> xcb_connection_t*
@@ -70,9 +80,23 @@ public:
         return xcb_connection;
     }
 
+    /// Whether any X client other than the WM is connected, even one without windows (such as xset or xrdb).
+    /// If the X server can't tell us (it lacks the XRes extension) this assumes there is one.
+    /// May be called from any thread; it waits for the X server to reply.
+    auto has_other_clients() const -> bool;
+
     auto get_wm_surface(xcb_window_t xcb_window) -> std::experimental::optional<std::shared_ptr<XWaylandWMSurface>>;
     void run_on_wayland_thread(std::function<void()>&& work);
 
+    /// Requests a property of a window without waiting for the reply
+    /// Once the reply arrives handler is called with it (or with null if there was an error) from the event loop
+    /// Replies are handled in the order they were requested
+    /// Should only be called on the XCB event thread
+    void get_property_async(
+        xcb_window_t window,
+        xcb_atom_t property,
+        std::function<void(xcb_get_property_reply_t*)>&& handler);
+
     XCBAtoms const xcb_atom;
 
 private:
@@ -108,6 +132,8 @@ private:
     // Event handeling
     void handle_events();
     void handle_event(xcb_generic_event_t* event);
+    /// Returns if any replies were handled
+    auto handle_replies() -> bool;
 
     // Events
     void handle_create_notify(xcb_create_notify_event_t *event);
@@ -124,6 +150,20 @@ private:
 
     std::mutex mutex;
 
+    struct PendingPropertyReply
+    {
+        xcb_get_property_cookie_t cookie;
+        std::function<void(xcb_get_property_reply_t*)> handler;
+    };
+
+    /// Requests that have not been answered yet, in the order they were sent
+    /// Only accessed on the XCB event thread
+    std::deque<PendingPropertyReply> pending_property_replies;
+
+    /// Atom names never change while the X server is running, so only need to be looked up once
+    std::mutex atom_names_mutex;
+    std::unordered_map<xcb_atom_t, std::string> atom_names;
+
     // Cursor
     xcb_cursor_t xcb_cursor_image_load_cursor(const XcursorImage *img);
     xcb_cursor_t xcb_cursor_images_load_cursor(const XcursorImages *images);
@@ -133,6 +173,7 @@ private:
     std::shared_ptr<dispatch::MultiplexingDispatchable> const dispatcher;
     wl_client* const wayland_client;
     std::shared_ptr<XWaylandWMShell> const wm_shell;
+    std::function<void(bool idle)> const idle_changed;
 
     xcb_screen_t *xcb_screen;
     xcb_window_t xcb_window;
@@ -143,6 +184,7 @@ private:
     xcb_window_t xcb_selection_window;
     xcb_selection_request_event_t xcb_selection_request;
     xcb_render_pictforminfo_t xcb_format_rgb, xcb_format_rgba;
+    bool res_available{false};
     const xcb_query_extension_reply_t *xfixes;
     std::unique_ptr<dispatch::ThreadedDispatcher> event_thread;
     xcb_visualid_t xcb_visual_id;
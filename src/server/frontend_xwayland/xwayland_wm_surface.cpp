@@ -67,6 +67,19 @@ auto wm_resize_edge_to_mir_resize_edge(uint32_t wm_resize_edge) -> std::experime
     default:                                    return std::experimental::nullopt;
     }
 }
+
+auto tracked_property_types(mf::XCBAtoms const& xcb_atom) -> std::map<xcb_atom_t, xcb_atom_t>
+{
+    return {
+        {XCB_ATOM_WM_CLASS, XCB_ATOM_STRING},
+        {XCB_ATOM_WM_NAME, XCB_ATOM_STRING},
+        {XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW},
+        {xcb_atom.wm_protocols, TYPE_WM_PROTOCOLS},
+        {xcb_atom.wm_normal_hints, TYPE_WM_NORMAL_HINTS},
+        {xcb_atom.net_wm_window_type, XCB_ATOM_ATOM},
+        {xcb_atom.net_wm_name, XCB_ATOM_STRING},
+        {xcb_atom.motif_wm_hints, TYPE_MOTIF_WM_HINTS}};
+}
 }
 
 mf::XWaylandWMSurface::XWaylandWMSurface(
@@ -78,7 +91,7 @@ mf::XWaylandWMSurface::XWaylandWMSurface(
       seat(seat),
       shell(shell),
       window(event->window),
-      props_dirty(true),
+      property_types{tracked_property_types(wm->xcb_atom)},
       init{
           event->parent,
           {event->x, event->y},
@@ -249,12 +262,6 @@ void mf::XWaylandWMSurface::wm_change_state_client_message(uint32_t const (&data
     set_window_state(new_window_state);
 }
 
-void mf::XWaylandWMSurface::dirty_properties()
-{
-    std::lock_guard<std::mutex> lock{mutex};
-    props_dirty = true;
-}
-
 void mf::XWaylandWMSurface::set_surface(WlSurface* wl_surface)
 {
     // We assume we are on the Wayland thread
@@ -354,64 +361,71 @@ void mf::XWaylandWMSurface::unmap()
     xcb_flush(xwm->get_xcb_connection());
 }
 
-void mf::XWaylandWMSurface::read_properties()
+void mf::XWaylandWMSurface::read_properties(std::function<void()>&& then)
 {
-    std::lock_guard<std::mutex> lock{mutex};
+    // Replies are handled in order, so then() goes with the last request
+    auto const last = std::prev(property_types.end());
+    for (auto property = property_types.begin(); property != last; ++property)
+        request_property(property->first, property->second, {});
 
-    if (!props_dirty)
-        return;
-    props_dirty = false;
-
-    std::map<xcb_atom_t, xcb_atom_t> props;
-    props[XCB_ATOM_WM_CLASS] = XCB_ATOM_STRING;
-    props[XCB_ATOM_WM_NAME] = XCB_ATOM_STRING;
-    props[XCB_ATOM_WM_TRANSIENT_FOR] = XCB_ATOM_WINDOW;
-    props[xwm->xcb_atom.wm_protocols] = TYPE_WM_PROTOCOLS;
-    props[xwm->xcb_atom.wm_normal_hints] = TYPE_WM_NORMAL_HINTS;
-    props[xwm->xcb_atom.net_wm_window_type] = XCB_ATOM_ATOM;
-    props[xwm->xcb_atom.net_wm_name] = XCB_ATOM_STRING;
-    props[xwm->xcb_atom.motif_wm_hints] = TYPE_MOTIF_WM_HINTS;
-
-    std::map<xcb_atom_t, xcb_get_property_cookie_t> cookies;
-    for (const auto &atom : props)
+    request_property(last->first, last->second, std::move(then));
+}
+
+void mf::XWaylandWMSurface::property_changed(xcb_atom_t property)
+{
+    auto const type = property_types.find(property);
+    if (type != property_types.end())
+        request_property(property, type->second, {});
+}
+
+void mf::XWaylandWMSurface::request_property(xcb_atom_t property, xcb_atom_t type, std::function<void()>&& then)
+{
+    std::weak_ptr<XWaylandWMSurface> const weak_self{shared_from_this()};
+
+    xwm->get_property_async(
+        window,
+        property,
+        [weak_self, property, type, then = std::move(then)](xcb_get_property_reply_t* reply)
+        {
+            if (auto const self = weak_self.lock())
+                self->apply_property(property, type, reply);
+
+            if (then)
+                then();
+        });
+}
+
+void mf::XWaylandWMSurface::apply_property(xcb_atom_t property, xcb_atom_t type, xcb_get_property_reply_t* reply)
+{
+    if (!reply)
     {
-        xcb_get_property_cookie_t cookie =
-            xcb_get_property(xwm->get_xcb_connection(), 0, window, atom.first, XCB_ATOM_ANY, 0, 2048);
-        cookies[atom.first] = cookie;
+        // Bad window, usually
+        return;
     }
 
-    properties.deleteWindow = 0;
+    // A type of None means the property is not set
+    bool const is_set = reply->type != XCB_ATOM_NONE;
+    std::experimental::optional<std::string> new_title;
 
-    for (const auto &atom_ptr : props)
     {
-        xcb_atom_t atom = atom_ptr.first;
-        xcb_get_property_reply_t *reply = xcb_get_property_reply(xwm->get_xcb_connection(), cookies[atom], nullptr);
-        if (!reply)
-        {
-            // Bad window, usually
-            continue;
-        }
+        std::lock_guard<std::mutex> lock{mutex};
 
-        if (reply->type == XCB_ATOM_NONE)
-        {
-            // No such info
-            free(reply);
-            continue;
-        }
+        auto const old_title = title(lock);
 
-        switch (props[atom])
+        switch (type)
         {
         case XCB_ATOM_STRING:
         {
-            char *p = strndup(reinterpret_cast<char *>(xcb_get_property_value(reply)),
-                              xcb_get_property_value_length(reply));
-            if (atom == XCB_ATOM_WM_CLASS) {
-                properties.appId = std::string(p);
-            } else if (atom == XCB_ATOM_WM_NAME || xwm->xcb_atom.net_wm_name) {
-                properties.title = std::string(p);
-            } else {
-                free(p);
-            }
+            auto const data = reinterpret_cast<char const*>(xcb_get_property_value(reply));
+            std::string const value{
+                is_set ? std::string{data, strnlen(data, xcb_get_property_value_length(reply))} : std::string{}};
+
+            if (property == XCB_ATOM_WM_CLASS)
+                properties.appId = value;
+            else if (property == XCB_ATOM_WM_NAME)
+                properties.wm_name = value;
+            else if (property == xwm->xcb_atom.net_wm_name)
+                properties.net_wm_name = value;
             break;
         }
         case XCB_ATOM_WINDOW:
@@ -420,13 +434,17 @@ void mf::XWaylandWMSurface::read_properties()
         }
         case XCB_ATOM_ATOM:
         {
-            if (atom == xwm->xcb_atom.net_wm_window_type)
+            if (property == xwm->xcb_atom.net_wm_window_type)
             {
             }
             break;
         }
         case TYPE_WM_PROTOCOLS:
         {
+            properties.deleteWindow = 0;
+            if (!is_set)
+                break;
+
             xcb_atom_t *atoms = reinterpret_cast<xcb_atom_t *>(xcb_get_property_value(reply));
             for (uint32_t i = 0; i < reply->value_len; ++i)
                 if (atoms[i] == xwm->xcb_atom.wm_delete_window)
@@ -443,10 +461,26 @@ void mf::XWaylandWMSurface::read_properties()
             break;
         }
 
-        free(reply);
+        if (title(lock) != old_title)
+            new_title = title(lock);
+    }
+
+    if (new_title)
+    {
+        if (auto const scene_surface = weak_scene_surface.lock())
+        {
+            shell::SurfaceSpecification mods;
+            mods.name = new_title.value();
+            shell->modify_surface(scene_surface->session().lock(), scene_surface, mods);
+        }
     }
 }
 
+auto mf::XWaylandWMSurface::title(std::lock_guard<std::mutex> const&) const -> std::string const&
+{
+    return properties.net_wm_name.empty() ? properties.wm_name : properties.net_wm_name;
+}
+
 void mf::XWaylandWMSurface::move_resize(uint32_t detail)
 {
     if (detail == _NET_WM_MOVERESIZE_MOVE)
@@ -509,8 +543,8 @@ void mf::XWaylandWMSurface::create_scene_surface_if_needed(WlSurface* wl_surface
         creating_scene_surface = true;
 
         params.type = mir_window_type_freestyle;
-        if (!properties.title.empty())
-            params.name = properties.title;
+        if (!title(lock).empty())
+            params.name = title(lock);
         if (!properties.appId.empty())
             params.application_id = properties.appId;
         params.size = wl_surface->buffer_size().value_or(init.size);
@@ -21,6 +21,8 @@
 #include "wl_surface.h"
 #include "xwayland_wm.h"
 
+#include <map>
+#include <memory>
 #include <mutex>
 #include <chrono>
 
@@ -127,7 +129,7 @@ class XWaylandWM;
 class XWaylandSurfaceRole;
 class XWaylandSurfaceObserver;
 
-class XWaylandWMSurface
+class XWaylandWMSurface : public std::enable_shared_from_this<XWaylandWMSurface>
 {
 public:
     XWaylandWMSurface(
@@ -145,8 +147,12 @@ public:
 
     void net_wm_state_client_message(uint32_t const (&data)[5]);
     void wm_change_state_client_message(uint32_t const (&data)[5]);
-    void dirty_properties();
-    void read_properties();
+    /// Requests all the properties we track, calling then() once they have been applied
+    /// Should only be called on the XCB event thread
+    void read_properties(std::function<void()>&& then);
+    /// Requests the property again if it is one we track
+    /// Should only be called on the XCB event thread
+    void property_changed(xcb_atom_t property);
     void set_surface(WlSurface* wl_surface); ///< Should only be called on the Wayland thread
     void set_workspace(int workspace);
     void apply_mir_state_to_window(MirWindowState new_state);
@@ -182,6 +188,16 @@ private:
 
     auto latest_input_timestamp(std::lock_guard<std::mutex> const&) -> std::chrono::nanoseconds;
 
+    /// Requests a single property and applies the reply, calling then() (if set) afterwards
+    void request_property(xcb_atom_t property, xcb_atom_t type, std::function<void()>&& then);
+
+    /// Updates properties from the reply and passes a changed title on to the scene surface
+    /// Should NOT be called under lock
+    void apply_property(xcb_atom_t property, xcb_atom_t type, xcb_get_property_reply_t* reply);
+
+    /// _NET_WM_NAME is preferred, as it is UTF-8
+    auto title(std::lock_guard<std::mutex> const&) const -> std::string const&;
+
     XWaylandWM* const xwm;
     WlSeat& seat;
     std::shared_ptr<shell::Shell> const shell;
@@ -193,10 +209,13 @@ private:
     /// Should only be modified by set_wm_state()
     WindowState window_state;
 
-    bool props_dirty;
+    /// The properties we track, and the type each is read as
+    std::map<xcb_atom_t, xcb_atom_t> const property_types;
+
     struct
     {
-        std::string title;
+        std::string wm_name;
+        std::string net_wm_name;
         std::string appId;
         int deleteWindow;
     } properties;
@@ -106,6 +106,16 @@ public:
         return true;
     }
 
+    std::vector<geom::Rectangle> opaque_region() const override
+    {
+        return {};
+    }
+
+    uint64_t content_serial() const override
+    {
+        return 0;
+    }
+
     void move_to(geom::Point new_position)
     {
         std::lock_guard<std::mutex> lock{position_mutex};
@@ -180,14 +180,7 @@ private:
 std::shared_ptr<mi::Surface> topmost_surface_containing_point(
     std::shared_ptr<mi::Scene> const& targets, geom::Point const& point)
 {
-    std::shared_ptr<mi::Surface> top_surface_at_point;
-    targets->for_each([&top_surface_at_point, &point]
-        (std::shared_ptr<mi::Surface> const& surface) 
-        {
-            if (surface->input_area_contains(point))
-                top_surface_at_point = surface;
-        });
-    return top_surface_at_point;
+    return targets->input_surface_at(point);
 }
 
 bool is_empty(std::shared_ptr<mg::CursorImage> const& image)
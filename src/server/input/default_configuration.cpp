@@ -19,6 +19,7 @@
 #include "mir/default_server_configuration.h"
 
 #include "key_repeat_dispatcher.h"
+#include "motion_coalescing_dispatcher.h"
 #include "event_filter_chain_dispatcher.h"
 #include "config_changer.h"
 #include "cursor_controller.h"
@@ -140,8 +141,25 @@ mir::DefaultServerConfiguration::the_input_dispatcher()
             // lp:1675357: Disable generation of key repeat events on nested servers
             auto enable_repeat = options->get<bool>(options::enable_key_repeat_opt);
 
+            std::shared_ptr<mi::InputDispatcher> next_dispatcher = the_event_filter_chain_dispatcher();
+
+            auto const coalesce = options->get<std::string>(options::coalesce_input_motion_opt);
+            if (coalesce == "on" || coalesce == "resample")
+            {
+                // No vblank timing reaches the input stack: assume a 60Hz frame
+                std::chrono::milliseconds const frame_interval{16};
+
+                next_dispatcher = std::make_shared<mi::MotionCoalescingDispatcher>(
+                    next_dispatcher, the_main_loop(), the_clock(), frame_interval, coalesce == "resample");
+            }
+            else if (coalesce != options::off_opt_value)
+            {
+                throw AbnormalExit(std::string("Invalid ") + options::coalesce_input_motion_opt + " option: " +
+                                   coalesce + " (valid options are: \"off\", \"on\" and \"resample\")");
+            }
+
             return std::make_shared<mi::KeyRepeatDispatcher>(
-                the_event_filter_chain_dispatcher(), the_main_loop(), the_cookie_authority(),
+                next_dispatcher, the_main_loop(), the_cookie_authority(),
                 enable_repeat, key_repeat_timeout, key_repeat_delay, false);
         });
 }
@@ -261,7 +279,9 @@ mir::DefaultServerConfiguration::the_input_reading_multiplexer()
     return input_reading_multiplexer(
         []() -> std::shared_ptr<mir::dispatch::MultiplexingDispatchable>
         {
-            return std::make_shared<mir::dispatch::MultiplexingDispatchable>();
+            // Only the input thread dispatches this, so batching costs no parallelism
+            return std::make_shared<mir::dispatch::MultiplexingDispatchable>(
+                mir::dispatch::MultiplexingDispatchable::max_batch_size);
         }
     );
 }
@@ -0,0 +1,303 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "motion_coalescing_dispatcher.h"
+
+#include "mir/events/event_private.h"
+#include "mir/events/event_builders.h"
+#include "mir/time/alarm_factory.h"
+#include "mir/time/alarm.h"
+#include "mir/time/clock.h"
+
+#include <algorithm>
+
+namespace mi = mir::input;
+namespace mev = mir::events;
+
+struct mi::MotionCoalescingDispatcher::DeviceState
+{
+    /// Ends the current interval
+    std::unique_ptr<time::Alarm> alarm;
+    /// Whether an interval is running: motion is being held back until it ends
+    bool throttled{false};
+    /// The held back motion, merged into one event
+    std::shared_ptr<MirEvent> pending;
+    /// The last two motions received, for resampling
+    std::shared_ptr<MirEvent const> previous;
+    std::shared_ptr<MirEvent const> latest;
+};
+
+std::chrono::milliseconds const mi::MotionCoalescingDispatcher::max_prediction{8};
+
+namespace
+{
+MirInputEvent const* input_event_of(MirEvent const& event)
+{
+    if (event.type() != mir_event_type_input)
+        return nullptr;
+    return event.to_input();
+}
+
+/// Motion that can be merged with adjacent motion without losing a transition
+bool is_motion(MirInputEvent const& event)
+{
+    switch (event.input_type())
+    {
+    case mir_input_event_type_pointer:
+    {
+        auto const pev = event.to_pointer();
+        return pev->action() == mir_pointer_action_motion && pev->hscroll() == 0 && pev->vscroll() == 0;
+    }
+
+    case mir_input_event_type_touch:
+    {
+        auto const tev = event.to_touch();
+        for (size_t i = 0; i != tev->pointer_count(); ++i)
+        {
+            if (tev->action(i) != mir_touch_action_change)
+                return false;
+        }
+        return tev->pointer_count() > 0;
+    }
+
+    default:
+        return false;
+    }
+}
+
+/// Whether two motion events differ only in where things are
+bool can_merge(MirInputEvent const& earlier, MirInputEvent const& later)
+{
+    if (earlier.input_type() != later.input_type() ||
+        earlier.device_id() != later.device_id() ||
+        earlier.modifiers() != later.modifiers())
+        return false;
+
+    if (later.input_type() == mir_input_event_type_pointer)
+        return earlier.to_pointer()->buttons() == later.to_pointer()->buttons();
+
+    auto const earlier_touch = earlier.to_touch();
+    auto const later_touch = later.to_touch();
+    if (earlier_touch->pointer_count() != later_touch->pointer_count())
+        return false;
+
+    for (size_t i = 0; i != later_touch->pointer_count(); ++i)
+    {
+        if (earlier_touch->id(i) != later_touch->id(i))
+            return false;
+    }
+    return true;
+}
+
+float extrapolate(float p0, float p1, float alpha)
+{
+    return p1 + (p1 - p0) * alpha;
+}
+}
+
+mi::MotionCoalescingDispatcher::MotionCoalescingDispatcher(
+    std::shared_ptr<InputDispatcher> const& next_dispatcher,
+    std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+    std::shared_ptr<time::Clock> const& clock,
+    std::chrono::milliseconds frame_interval,
+    bool resample)
+    : next_dispatcher{next_dispatcher},
+      alarm_factory{alarm_factory},
+      clock{clock},
+      frame_interval{frame_interval},
+      resample{resample}
+{
+}
+
+mi::MotionCoalescingDispatcher::~MotionCoalescingDispatcher() = default;
+
+bool mi::MotionCoalescingDispatcher::dispatch(std::shared_ptr<MirEvent const> const& event)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+
+    auto const iev = input_event_of(*event);
+    if (!iev || !is_motion(*iev))
+    {
+        // Whatever happened, it happened after the motion we're holding back
+        for (auto& device : devices)
+        {
+            flush_locked(lock, *device.second);
+            if (iev && device.first == iev->device_id())
+                device.second->previous = device.second->latest = nullptr;
+        }
+        ready.push_back(event);
+        return deliver(lock, event.get());
+    }
+
+    auto& state = state_for_locked(lock, iev->device_id());
+
+    if (state.pending && !can_merge(*state.pending->to_input(), *iev))
+        flush_locked(lock, state);
+
+    if (state.latest && !can_merge(*state.latest->to_input(), *iev))
+        state.latest = nullptr;
+    state.previous = state.latest;
+    state.latest = event;
+
+    if (!state.throttled)
+    {
+        state.throttled = true;
+        state.alarm->reschedule_in(frame_interval);
+        ready.push_back(event);
+        return deliver(lock, event.get());
+    }
+
+    std::shared_ptr<MirEvent> merged = mev::clone_event(*event);
+    if (state.pending && iev->input_type() == mir_input_event_type_pointer)
+    {
+        auto const held = state.pending->to_input()->to_pointer();
+        auto const pev = merged->to_input()->to_pointer();
+        pev->set_dx(held->dx() + pev->dx());
+        pev->set_dy(held->dy() + pev->dy());
+    }
+    state.pending = merged;
+
+    // Anything flushed by a change of device state still has to go
+    return deliver(lock, nullptr);
+}
+
+void mi::MotionCoalescingDispatcher::start()
+{
+    next_dispatcher->start();
+}
+
+void mi::MotionCoalescingDispatcher::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        for (auto& device : devices)
+            flush_locked(lock, *device.second);
+        deliver(lock, nullptr);
+    }
+    next_dispatcher->stop();
+}
+
+auto mi::MotionCoalescingDispatcher::state_for_locked(std::unique_lock<std::mutex> const&, MirInputDeviceId id)
+    -> DeviceState&
+{
+    auto& state = devices[id];
+    if (!state)
+    {
+        state = std::make_unique<DeviceState>();
+        state->alarm = alarm_factory->create_alarm([this, id] { end_of_interval(id); });
+    }
+    return *state;
+}
+
+void mi::MotionCoalescingDispatcher::end_of_interval(MirInputDeviceId id)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+
+    auto const device = devices.find(id);
+    if (device == devices.end())
+        return;
+
+    auto& state = *device->second;
+    if (!state.pending)
+    {
+        // Nothing moved: the next motion can go straight through
+        state.throttled = false;
+        return;
+    }
+
+    flush_locked(lock, state);
+    state.alarm->reschedule_in(frame_interval);
+    deliver(lock, nullptr);
+}
+
+void mi::MotionCoalescingDispatcher::flush_locked(std::unique_lock<std::mutex> const&, DeviceState& state)
+{
+    if (!state.pending)
+        return;
+
+    auto const event = std::move(state.pending);
+    state.pending = nullptr;
+
+    if (resample && state.previous && state.latest)
+    {
+        auto const t0 = state.previous->to_input()->event_time();
+        auto const t1 = state.latest->to_input()->event_time();
+        auto const now = std::chrono::duration_cast<std::chrono::nanoseconds>(clock->now().time_since_epoch());
+        auto const target = std::min<std::chrono::nanoseconds>(now, t1 + max_prediction);
+
+        // Only predict from a recent, steady motion
+        if (t0 < t1 && t1 - t0 <= frame_interval && t1 < target)
+        {
+            auto const alpha = float((target - t1).count()) / (t1 - t0).count();
+            auto const iev = event->to_input();
+
+            if (iev->input_type() == mir_input_event_type_pointer)
+            {
+                auto const p0 = state.previous->to_input()->to_pointer();
+                auto const pev = iev->to_pointer();
+                pev->set_x(extrapolate(p0->x(), pev->x(), alpha));
+                pev->set_y(extrapolate(p0->y(), pev->y(), alpha));
+            }
+            else
+            {
+                auto const t0_touch = state.previous->to_input()->to_touch();
+                auto const tev = iev->to_touch();
+                for (size_t i = 0; i != tev->pointer_count(); ++i)
+                {
+                    tev->set_x(i, extrapolate(t0_touch->x(i), tev->x(i), alpha));
+                    tev->set_y(i, extrapolate(t0_touch->y(i), tev->y(i), alpha));
+                }
+            }
+            iev->set_event_time(target);
+        }
+    }
+
+    ready.push_back(event);
+}
+
+auto mi::MotionCoalescingDispatcher::deliver(std::unique_lock<std::mutex>& lock, MirEvent const* event) -> bool
+{
+    // The thread already passing events on will pass these on after its own
+    if (delivering)
+        return true;
+
+    delivering = true;
+    auto result = true;
+
+    while (!ready.empty())
+    {
+        auto const next = std::move(ready.front());
+        ready.pop_front();
+
+        lock.unlock();
+        try
+        {
+            auto const dispatched = next_dispatcher->dispatch(next);
+            if (next.get() == event)
+                result = dispatched;
+        }
+        catch (...)
+        {
+            lock.lock();
+            delivering = false;
+            throw;
+        }
+        lock.lock();
+    }
+
+    delivering = false;
+    return result;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_MOTION_COALESCING_DISPATCHER_H_
+#define MIR_INPUT_MOTION_COALESCING_DISPATCHER_H_
+
+#include "mir/input/input_dispatcher.h"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace mir
+{
+namespace time
+{
+class AlarmFactory;
+class Alarm;
+class Clock;
+}
+namespace input
+{
+/**
+ * Limits the pointer and touch motion passed on to one event per device per
+ * frame interval.
+ *
+ * The first motion from a device is passed on straight away. Further motion
+ * within the interval is merged into a single event (with the latest
+ * position and the sum of the relative motion) that is passed on when the
+ * interval ends. Anything else - button presses, scrolling, touches starting
+ * or ending, keys - first flushes any motion held back, so the order of
+ * transitions is kept.
+ *
+ * When resampling, a held back position is extrapolated from the last two
+ * motions to when it is passed on (by at most max_prediction).
+ *
+ * Events are passed on without holding the lock, by one thread at a time
+ * and in the order they became ready.
+ */
+class MotionCoalescingDispatcher : public InputDispatcher
+{
+public:
+    static std::chrono::milliseconds const max_prediction;
+
+    MotionCoalescingDispatcher(
+        std::shared_ptr<InputDispatcher> const& next_dispatcher,
+        std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+        std::shared_ptr<time::Clock> const& clock,
+        std::chrono::milliseconds frame_interval,
+        bool resample);
+    ~MotionCoalescingDispatcher();
+
+    // InputDispatcher
+    bool dispatch(std::shared_ptr<MirEvent const> const& event) override;
+    void start() override;
+    void stop() override;
+
+private:
+    struct DeviceState;
+
+    auto state_for_locked(std::unique_lock<std::mutex> const&, MirInputDeviceId id) -> DeviceState&;
+    void flush_locked(std::unique_lock<std::mutex> const&, DeviceState& state);
+    void end_of_interval(MirInputDeviceId id);
+
+    /// Passes on the ready events, returning what passing on event returned
+    auto deliver(std::unique_lock<std::mutex>& lock, MirEvent const* event) -> bool;
+
+    std::shared_ptr<InputDispatcher> const next_dispatcher;
+    std::shared_ptr<time::AlarmFactory> const alarm_factory;
+    std::shared_ptr<time::Clock> const clock;
+    std::chrono::milliseconds const frame_interval;
+    bool const resample;
+
+    std::mutex mutex;
+    std::unordered_map<MirInputDeviceId, std::unique_ptr<DeviceState>> devices;
+    std::deque<std::shared_ptr<MirEvent const>> ready;
+    bool delivering{false};
+};
+}
+}
+
+#endif // MIR_INPUT_MOTION_COALESCING_DISPATCHER_H_
@@ -93,6 +93,16 @@ public:
         return true;
     }
 
+    std::vector<geom::Rectangle> opaque_region() const override
+    {
+        return {};
+    }
+
+    uint64_t content_serial() const override
+    {
+        return 0;
+    }
+
 // TouchspotRenderable    
     void move_center_to(geom::Point pos)
     {
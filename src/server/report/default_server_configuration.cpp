@@ -133,3 +133,11 @@ auto mir::DefaultServerConfiguration::the_shell_report() -> std::shared_ptr<shel
         });
 }
 
+auto mir::DefaultServerConfiguration::the_xwayland_report() -> std::shared_ptr<mf::XWaylandReport>
+{
+    return xwayland_report(
+        [this]()->std::shared_ptr<mf::XWaylandReport>
+        {
+            return report_factory(options::xwayland_report_opt)->create_xwayland_report();
+        });
+}
@@ -132,6 +132,23 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_bypassed = nbypassed;
 }
 
+void mrl::CompositorReport::TextureCacheUsage::log(ml::Logger& logger, SubCompositorId id)
+{
+    char msg[160];
+    snprintf(msg, sizeof msg, "Renderer %p texture cache holds %zu textures (%zu KiB), "
+             "evicted %zu textures (%zu KiB) since last report",
+             id,
+             textures,
+             bytes / 1024,
+             evicted_textures - last_reported_evicted_textures,
+             (evicted_bytes - last_reported_evicted_bytes) / 1024);
+
+    logger.log(ml::Severity::informational, msg, component);
+
+    last_reported_evicted_textures = evicted_textures;
+    last_reported_evicted_bytes = evicted_bytes;
+}
+
 void mrl::CompositorReport::finished_frame(SubCompositorId id)
 {
     std::lock_guard<std::mutex> lock(mutex);
@@ -154,6 +171,9 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
 
         for (auto& i : instance)
             i.second.log(*logger, i.first);
+
+        for (auto& t : texture_cache)
+            t.second.log(*logger, t.first);
     }
 
     if (inst.bypassed != inst.prev_bypassed || inst.nframes == 1)
@@ -177,6 +197,7 @@ void mrl::CompositorReport::stopped()
 
     std::lock_guard<std::mutex> lock(mutex);
     instance.clear();
+    texture_cache.clear();
 }
 
 void mrl::CompositorReport::scheduled()
@@ -184,3 +205,16 @@ void mrl::CompositorReport::scheduled()
     std::lock_guard<std::mutex> lock(mutex);
     last_scheduled = now();
 }
+
+void mrl::CompositorReport::texture_cache_usage(
+    SubCompositorId id,
+    size_t textures, size_t bytes,
+    size_t evicted_textures, size_t evicted_bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& usage = texture_cache[id];
+    usage.textures = textures;
+    usage.bytes = bytes;
+    usage.evicted_textures = evicted_textures;
+    usage.evicted_bytes = evicted_bytes;
+}
@@ -50,6 +50,10 @@ public:
     void started() override;
     void stopped() override;
     void scheduled() override;
+    void texture_cache_usage(
+        SubCompositorId id,
+        size_t textures, size_t bytes,
+        size_t evicted_textures, size_t evicted_bytes) override;
 
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
@@ -79,8 +83,22 @@ private:
         void log(mir::logging::Logger& logger, SubCompositorId id);
     };
 
+    struct TextureCacheUsage
+    {
+        size_t textures = 0;
+        size_t bytes = 0;
+        size_t evicted_textures = 0;
+        size_t evicted_bytes = 0;
+
+        size_t last_reported_evicted_textures = 0;
+        size_t last_reported_evicted_bytes = 0;
+
+        void log(mir::logging::Logger& logger, SubCompositorId id);
+    };
+
     std::mutex mutex; // Protects the following...
     std::unordered_map<SubCompositorId, Instance> instance;
+    std::unordered_map<SubCompositorId, TextureCacheUsage> texture_cache;
     TimePoint last_scheduled;
     TimePoint last_report;
 };
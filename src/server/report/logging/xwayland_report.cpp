@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "xwayland_report.h"
+
+#include "mir/logging/logger.h"
+
+#include <sstream>
+
+namespace ml = mir::logging;
+namespace mrl = mir::report::logging;
+
+namespace
+{
+char const* const component = "frontend::XWayland";
+
+auto to_string(mir::frontend::XWaylandReport::Activation activation) -> char const*
+{
+    switch (activation)
+    {
+    case mir::frontend::XWaylandReport::Activation::client_connected:
+        return "client connected";
+    case mir::frontend::XWaylandReport::Activation::prespawn:
+        return "prespawn";
+    case mir::frontend::XWaylandReport::Activation::restart:
+        return "restart";
+    }
+
+    return "unknown";
+}
+
+auto in_ms(std::chrono::nanoseconds duration) -> double
+{
+    return std::chrono::duration<double, std::milli>{duration}.count();
+}
+}
+
+mrl::XWaylandReport::XWaylandReport(std::shared_ptr<ml::Logger> const& log) :
+    logger(log)
+{
+}
+
+void mrl::XWaylandReport::spawning(Activation activation)
+{
+    std::stringstream ss;
+    ss << "Spawning Xwayland (" << to_string(activation) << ")";
+    logger->log(ml::Severity::informational, ss.str(), component);
+}
+
+void mrl::XWaylandReport::started(Activation activation, std::chrono::nanoseconds startup_time)
+{
+    std::stringstream ss;
+    ss << "Xwayland ready " << in_ms(startup_time) << "ms after activation (" << to_string(activation) << ")";
+    logger->log(ml::Severity::informational, ss.str(), component);
+}
+
+void mrl::XWaylandReport::start_failed(Activation activation, std::chrono::nanoseconds waited)
+{
+    std::stringstream ss;
+    ss << "Xwayland failed to start, gave up after " << in_ms(waited) << "ms (" << to_string(activation) << ")";
+    logger->log(ml::Severity::warning, ss.str(), component);
+}
+
+void mrl::XWaylandReport::stopping_idle()
+{
+    logger->log(ml::Severity::informational, "Stopping Xwayland as it has no clients", component);
+}
+
+void mrl::XWaylandReport::stopped(bool crashed)
+{
+    logger->log(
+        crashed ? ml::Severity::warning : ml::Severity::informational,
+        crashed ? "Xwayland crashed or was killed" : "Xwayland stopped",
+        component);
+}
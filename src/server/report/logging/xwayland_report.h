@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_LOGGING_XWAYLAND_REPORT_H_
+#define MIR_REPORT_LOGGING_XWAYLAND_REPORT_H_
+
+#include "mir/frontend/xwayland_report.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace logging
+{
+class Logger;
+}
+namespace report
+{
+namespace logging
+{
+
+class XWaylandReport : public frontend::XWaylandReport
+{
+public:
+    XWaylandReport(std::shared_ptr<mir::logging::Logger> const& log);
+
+    void spawning(Activation activation) override;
+    void started(Activation activation, std::chrono::nanoseconds startup_time) override;
+    void start_failed(Activation activation, std::chrono::nanoseconds waited) override;
+    void stopping_idle() override;
+    void stopped(bool crashed) override;
+
+private:
+    std::shared_ptr<mir::logging::Logger> const logger;
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_LOGGING_XWAYLAND_REPORT_H_ */
@@ -62,3 +62,11 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::texture_cache_usage(
+    SubCompositorId id,
+    size_t textures, size_t bytes,
+    size_t evicted_textures, size_t evicted_bytes)
+{
+    mir_tracepoint(mir_server_compositor, texture_cache_usage, id, textures, bytes, evicted_textures, evicted_bytes);
+}
@@ -90,6 +90,19 @@ TRACEPOINT_EVENT(
     )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    texture_cache_usage,
+    TP_ARGS(void const*, id, size_t, textures, size_t, bytes, size_t, evicted_textures, size_t, evicted_bytes),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(size_t, textures, textures)
+        ctf_integer(size_t, bytes, bytes)
+        ctf_integer(size_t, evicted_textures, evicted_textures)
+        ctf_integer(size_t, evicted_bytes, evicted_bytes)
+    )
+)
+
 #endif /* MIR_LTTNG_COMPOSITOR_REPORT_TP_H_ */
 
 #include <lttng/tracepoint-event.h>
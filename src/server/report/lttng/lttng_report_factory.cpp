@@ -77,3 +77,8 @@ std::shared_ptr<mir::shell::ShellReport> mir::report::LttngReportFactory::create
 {
     BOOST_THROW_EXCEPTION(std::logic_error("Not implemented"));
 }
+
+std::shared_ptr<mir::frontend::XWaylandReport> mir::report::LttngReportFactory::create_xwayland_report()
+{
+    BOOST_THROW_EXCEPTION(std::logic_error("Not implemented"));
+}
@@ -51,3 +51,7 @@ void mrn::CompositorReport::stopped()
 void mrn::CompositorReport::scheduled()
 {
 }
+
+void mrn::CompositorReport::texture_cache_usage(SubCompositorId, size_t, size_t, size_t, size_t)
+{
+}
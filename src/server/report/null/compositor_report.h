@@ -39,6 +39,10 @@ public:
     void started() override;
     void stopped() override;
     void scheduled() override;
+    void texture_cache_usage(
+        SubCompositorId id,
+        size_t textures, size_t bytes,
+        size_t evicted_textures, size_t evicted_bytes) override;
 };
 
 } // namespace compositor
@@ -27,6 +27,7 @@
 #include "seat_report.h"
 #include "shell_report.h"
 #include "scene_report.h"
+#include "xwayland_report.h"
 #include "mir/logging/null_shared_library_prober_report.h"
 
 std::shared_ptr<mir::compositor::CompositorReport> mir::report::NullReportFactory::create_compositor_report()
@@ -79,6 +80,11 @@ std::shared_ptr<mir::shell::ShellReport> mir::report::NullReportFactory::create_
     return std::make_shared<null::ShellReport>();
 }
 
+std::shared_ptr<mir::frontend::XWaylandReport> mir::report::NullReportFactory::create_xwayland_report()
+{
+    return std::make_shared<null::XWaylandReport>();
+}
+
 std::shared_ptr<mir::compositor::CompositorReport> mir::report::null_compositor_report()
 {
     return NullReportFactory{}.create_compositor_report();
@@ -0,0 +1,25 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "xwayland_report.h"
+
+namespace mrn = mir::report::null;
+
+void mrn::XWaylandReport::spawning(Activation /*activation*/) {}
+void mrn::XWaylandReport::started(Activation /*activation*/, std::chrono::nanoseconds /*startup_time*/) {}
+void mrn::XWaylandReport::start_failed(Activation /*activation*/, std::chrono::nanoseconds /*waited*/) {}
+void mrn::XWaylandReport::stopping_idle() {}
+void mrn::XWaylandReport::stopped(bool /*crashed*/) {}
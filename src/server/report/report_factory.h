@@ -33,6 +33,7 @@ namespace frontend
 class ConnectorReport;
 class SessionMediatorObserver;
 class MessageProcessorReport;
+class XWaylandReport;
 }
 namespace graphics
 {
@@ -65,6 +66,7 @@ public:
     virtual std::shared_ptr<input::SeatObserver> create_seat_report() = 0;
     virtual std::shared_ptr<SharedLibraryProberReport> create_shared_library_prober_report() = 0;
     virtual std::shared_ptr<shell::ShellReport> create_shell_report() = 0;
+    virtual std::shared_ptr<frontend::XWaylandReport> create_xwayland_report() = 0;
 
 protected:
     ReportFactory() = default;
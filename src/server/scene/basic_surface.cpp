@@ -171,6 +171,12 @@ void ms::SurfaceObservers::application_id_set_to(Surface const* surf, std::strin
                  { observer->application_id_set_to(surf, application_id); });
 }
 
+void ms::SurfaceObservers::input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region)
+{
+    for_each([&](std::shared_ptr<SurfaceObserver> const& observer)
+                 { observer->input_region_set_to(surf, region); });
+}
+
 ms::BasicSurface::ProofOfMutexLock::ProofOfMutexLock(std::unique_lock<std::mutex> const& lock)
 {
     if (!lock.owns_lock())
@@ -365,9 +371,18 @@ std::shared_ptr<mf::BufferStream> ms::BasicSurface::primary_buffer_stream() cons
 }
 
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
+{
+    {
+        std::lock_guard<std::mutex> lock(guard);
+        custom_input_rectangles = input_rectangles;
+    }
+    observers->input_region_set_to(this, input_rectangles);
+}
+
+auto ms::BasicSurface::input_region() const -> std::vector<geom::Rectangle>
 {
     std::lock_guard<std::mutex> lock(guard);
-    custom_input_rectangles = input_rectangles;
+    return custom_input_rectangles;
 }
 
 void ms::BasicSurface::resize(geom::Size const& desired_size)
@@ -821,6 +836,7 @@ public:
         std::experimental::optional<geom::Rectangle> const& clip_area,
         glm::mat4 const& transform,
         float alpha,
+        std::vector<geom::Rectangle> const& opaque_region,
         mg::Renderable::ID id)
     : underlying_buffer_stream{stream},
       compositor_id{compositor_id},
@@ -828,6 +844,7 @@ public:
       screen_position_(position),
       clip_area_(clip_area),
       transformation_(transform),
+      opaque_region_(opaque_region),
       id_(id)
     {
     }
@@ -848,6 +865,11 @@ public:
         return compositor_buffer;
     }
 
+    uint64_t content_serial() const override
+    {
+        return underlying_buffer_stream->content_serial(*buffer());
+    }
+
     geom::Rectangle screen_position() const override
     { return screen_position_; }
 
@@ -863,6 +885,9 @@ public:
     bool shaped() const override
     { return mg::contains_alpha(underlying_buffer_stream->pixel_format()); }
 
+    std::vector<geom::Rectangle> opaque_region() const override
+    { return opaque_region_; }
+
     mg::Renderable::ID id() const override
     { return id_; }
 private:
@@ -873,6 +898,7 @@ private:
     geom::Rectangle const screen_position_;
     std::experimental::optional<geom::Rectangle> const clip_area_;
     glm::mat4 const transformation_;
+    std::vector<geom::Rectangle> const opaque_region_;
     mg::Renderable::ID const id_;
 };
 }
@@ -956,11 +982,22 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
             else
                 size = info.stream->stream_size();
 
+            geom::Rectangle const position{content_top_left_ + info.displacement, std::move(size)};
+
+            std::vector<geom::Rectangle> opaque_region;
+            for (auto const& r : info.opaque_region)
+            {
+                auto const on_screen = geom::Rectangle{r.top_left + as_displacement(position.top_left), r.size}
+                    .intersection_with(position);
+                if (on_screen.size.width > geom::Width{} && on_screen.size.height > geom::Height{})
+                    opaque_region.push_back(on_screen);
+            }
+
             list.emplace_back(std::make_shared<SurfaceSnapshot>(
                 info.stream, id,
-                geom::Rectangle{content_top_left_ + info.displacement, std::move(size)},
+                position,
                 clip_area_,
-                transformation_matrix, surface_alpha, info.stream.get()));
+                transformation_matrix, surface_alpha, opaque_region, info.stream.get()));
         }
     }
     return list;
@@ -96,6 +96,7 @@ public:
     void set_reception_mode(input::InputReceptionMode mode) override;
 
     void set_input_region(std::vector<geometry::Rectangle> const& input_rectangles) override;
+    auto input_region() const -> std::vector<geometry::Rectangle> override;
 
     void resize(geometry::Size const& size) override;
     geometry::Point top_left() const override;
@@ -16,13 +16,20 @@
  * Authored By: Alexandros Frantzis <alexandros.frantzis@canonical.com>
  */
 
+
 #include "gl_pixel_buffer.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/pixel_kernels.h"
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/gl/texture_source.h"
 
 #include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <boost/throw_exception.hpp>
+#include <EGL/egl.h>
 #include MIR_SERVER_GL_H
 #include MIR_SERVER_GLEXT_H
 
@@ -39,16 +46,96 @@ bool is_big_endian()
     return (*reinterpret_cast<char*>(&n) != 1);
 }
 
-inline uint32_t abgr_to_argb(uint32_t p)
+/*
+ * Pixel pack buffers, mapping and fences are core in GLES 3 and GL 3, but
+ * the GLES 2 headers we build against don't declare them.
+ */
+GLenum const pixel_pack_buffer = 0x88EB;
+GLenum const stream_read = 0x88E1;
+GLbitfield const map_read_bit = 0x0001;
+GLenum const sync_gpu_commands_complete = 0x9117;
+GLbitfield const sync_flush_commands_bit = 0x0001;
+uint64_t const timeout_ignored = 0xFFFFFFFFFFFFFFFFull;
+
+/// Enough to read one buffer back while the one before is being copied out
+unsigned int const pixel_pack_ring_size = 3;
+
+using Sync = void*;
+
+int gl_major_version()
 {
-    return ((p << 16) & 0x00ff0000) | /* Move R to new position */
-           ((p) & 0x0000ff00) |       /* G remains at same position */
-           ((p >> 16) & 0x000000ff) | /* Move B to new position */
-           ((p) & 0xff000000);        /* A remains at same position */
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    if (!version)
+        return 0;
+
+    // "OpenGL ES 3.2 Mesa..." or, for desktop GL, "4.6 (Core Profile) Mesa..."
+    char const* const es_prefix = "OpenGL ES ";
+    auto const number = strncmp(version, es_prefix, strlen(es_prefix)) == 0 ?
+        version + strlen(es_prefix) :
+        version;
+
+    return std::atoi(number);
 }
 
 }
 
+/// A ring of buffers glReadPixels() can write into while we get on with something else
+struct ms::GLPixelBuffer::PixelPackBuffers
+{
+    struct Readback
+    {
+        GLuint pbo;
+        Sync fence;
+        geom::Size size;
+        GLuint format;
+    };
+
+    static auto create_if_supported() -> std::unique_ptr<PixelPackBuffers>
+    {
+        if (gl_major_version() < 3)
+            return nullptr;
+
+        auto buffers = std::make_unique<PixelPackBuffers>();
+        buffers->map_buffer_range = reinterpret_cast<decltype(map_buffer_range)>(
+            eglGetProcAddress("glMapBufferRange"));
+        buffers->unmap_buffer = reinterpret_cast<decltype(unmap_buffer)>(
+            eglGetProcAddress("glUnmapBuffer"));
+        buffers->fence_sync = reinterpret_cast<decltype(fence_sync)>(
+            eglGetProcAddress("glFenceSync"));
+        buffers->client_wait_sync = reinterpret_cast<decltype(client_wait_sync)>(
+            eglGetProcAddress("glClientWaitSync"));
+        buffers->delete_sync = reinterpret_cast<decltype(delete_sync)>(
+            eglGetProcAddress("glDeleteSync"));
+
+        if (!buffers->map_buffer_range || !buffers->unmap_buffer ||
+            !buffers->fence_sync || !buffers->client_wait_sync || !buffers->delete_sync)
+            return nullptr;
+
+        glGenBuffers(pixel_pack_ring_size, buffers->pbos);
+        return buffers;
+    }
+
+    /// Must be called with the context current
+    void release()
+    {
+        for (auto const& readback : pending)
+            delete_sync(readback.fence);
+        pending.clear();
+        glDeleteBuffers(pixel_pack_ring_size, pbos);
+    }
+
+    void* (*map_buffer_range)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    GLboolean (*unmap_buffer)(GLenum target);
+    Sync (*fence_sync)(GLenum condition, GLbitfield flags);
+    GLenum (*client_wait_sync)(Sync sync, GLbitfield flags, uint64_t timeout);
+    void (*delete_sync)(Sync sync);
+
+    GLuint pbos[pixel_pack_ring_size];
+    GLsizeiptr capacity[pixel_pack_ring_size]{};
+    unsigned int next{0};
+    std::deque<Readback> pending;
+};
+
 ms::GLPixelBuffer::GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_context)
     : gl_context{std::move(gl_context)},
       tex{0}, fbo{0}, gl_pixel_format{0}, pixels_need_y_flip{false}
@@ -73,6 +160,8 @@ ms::GLPixelBuffer::~GLPixelBuffer() noexcept
     if (tex != 0 || fbo != 0)
         gl_context->make_current();
 
+    if (pixel_pack_buffers)
+        pixel_pack_buffers->release();
     if (tex != 0)
         glDeleteTextures(1, &tex);
     if (fbo != 0)
@@ -93,17 +182,16 @@ void ms::GLPixelBuffer::prepare()
         glGenFramebuffers(1, &fbo);
 
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    if (!checked_for_pixel_pack_buffers)
+    {
+        pixel_pack_buffers = PixelPackBuffers::create_if_supported();
+        checked_for_pixel_pack_buffers = true;
+    }
 }
 
-void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
+void ms::GLPixelBuffer::attach(graphics::Buffer& buffer)
 {
-    auto width = buffer.size().width.as_uint32_t();
-    auto height = buffer.size().height.as_uint32_t();
-
-    pixels.resize(width * height * 4);
-
-    prepare();
-
     auto const texture_source =
         dynamic_cast<mir::renderer::gl::TextureSource*>(
             buffer.native_buffer_base());
@@ -112,52 +200,142 @@ void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
     texture_source->gl_bind_to_texture();
 
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+}
+
+auto ms::GLPixelBuffer::read_pixels(geom::Size size, void* destination) -> GLuint
+{
+    auto const width = size.width.as_uint32_t();
+    auto const height = size.height.as_uint32_t();
 
     /* First try to get pixels as BGRA */
     glGetError();
-    gl_pixel_format = GL_BGRA_EXT;
-    glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
+    GLuint format = GL_BGRA_EXT;
+    glReadPixels(0, 0, width, height, format, GL_UNSIGNED_BYTE, destination);
 
     /* If getting pixels as BGRA failed, fall back to RGBA */
     if (glGetError() != GL_NO_ERROR)
     {
-        gl_pixel_format = GL_RGBA;
-        glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
+        format = GL_RGBA;
+        glReadPixels(0, 0, width, height, format, GL_UNSIGNED_BYTE, destination);
     }
 
-    size_ = buffer.size();
-    pixels_need_y_flip = true;
+    return format;
 }
 
-void const* ms::GLPixelBuffer::as_argb_8888()
+void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
 {
-    if (pixels_need_y_flip)
+    begin_fill_from(buffer);
+
+    while (pixel_pack_buffers && !pixel_pack_buffers->pending.empty())
+        complete_fill();
+}
+
+void ms::GLPixelBuffer::begin_fill_from(graphics::Buffer& buffer)
+{
+    auto const size = buffer.size();
+
+    if (!pixel_pack_buffers)
+        pixels.resize(size.width.as_uint32_t() * size.height.as_uint32_t() * 4);
+
+    prepare();
+    attach(buffer);
+
+    if (!pixel_pack_buffers)
     {
-        auto const stride_val = stride().as_uint32_t();
-        auto const height = size_.height.as_uint32_t();
+        gl_pixel_format = read_pixels(size, pixels.data());
+        size_ = size;
+        pixels_need_y_flip = true;
+        return;
+    }
 
-        std::vector<char> tmp(stride_val);
+    auto& ring = *pixel_pack_buffers;
 
-        for (unsigned int i = 0; i < height / 2; i++)
-        {
-            /* Store line i */
-            tmp.assign(&pixels[i * stride_val], &pixels[(i + 1) * stride_val]);
+    // Make room by collecting the oldest, if the caller didn't
+    if (ring.pending.size() == pixel_pack_ring_size)
+        complete_fill();
 
-            /* Copy line height - i - 1 to line i */
-            copy_and_convert_pixel_line(&pixels[(height - i - 1) * stride_val],
-                                        &pixels[i * stride_val]);
+    auto const slot = ring.next;
+    ring.next = (ring.next + 1) % pixel_pack_ring_size;
 
-            /* Copy stored line (i) to height - i - 1 */
-            copy_and_convert_pixel_line(tmp.data(),
-                                        &pixels[(height - i - 1) * stride_val]);
-        }
+    GLsizeiptr const bytes = size.width.as_uint32_t() * size.height.as_uint32_t() * 4;
+    glBindBuffer(pixel_pack_buffer, ring.pbos[slot]);
+    if (ring.capacity[slot] < bytes)
+    {
+        glBufferData(pixel_pack_buffer, bytes, nullptr, stream_read);
+        ring.capacity[slot] = bytes;
+    }
+
+    /* With a pixel pack buffer bound this returns without waiting for the GPU */
+    auto const format = read_pixels(size, nullptr);
+    auto const fence = ring.fence_sync(sync_gpu_commands_complete, 0);
+    glBindBuffer(pixel_pack_buffer, 0);
+
+    ring.pending.push_back({ring.pbos[slot], fence, size, format});
+}
 
-        /* Process middle line if there is one */
-        if (height % 2 == 1)
+void ms::GLPixelBuffer::complete_fill()
+{
+    if (!pixel_pack_buffers || pixel_pack_buffers->pending.empty())
+        return;
+
+    auto& ring = *pixel_pack_buffers;
+    auto const readback = ring.pending.front();
+    ring.pending.pop_front();
+
+    gl_context->make_current();
+
+    ring.client_wait_sync(readback.fence, sync_flush_commands_bit, timeout_ignored);
+    ring.delete_sync(readback.fence);
+
+    auto const width = readback.size.width.as_uint32_t();
+    auto const height = readback.size.height.as_uint32_t();
+    GLsizeiptr const bytes = width * height * 4;
+    pixels.resize(bytes);
+
+    glBindBuffer(pixel_pack_buffer, readback.pbo);
+    if (auto const mapped = static_cast<uint32_t const*>(
+            ring.map_buffer_range(pixel_pack_buffer, 0, bytes, map_read_bit)))
+    {
+        /* Turn the rows (which GL gives bottom first) the right way up as we copy them out */
+        auto const dest = reinterpret_cast<uint32_t*>(pixels.data());
+        for (uint32_t row = 0; row < height; row++)
         {
-            copy_and_convert_pixel_line(&pixels[(height / 2) * stride_val],
-                                        &pixels[(height / 2) * stride_val]);
+            auto const src_row = mapped + (height - 1 - row) * width;
+            auto const dest_row = dest + row * width;
+            if (readback.format == GL_RGBA)
+                mg::pixel::swap_red_blue(src_row, dest_row, width);
+            else
+                memcpy(dest_row, src_row, width * 4);
         }
+        ring.unmap_buffer(pixel_pack_buffer);
+    }
+    else
+    {
+        std::fill(pixels.begin(), pixels.end(), 0);
+    }
+    glBindBuffer(pixel_pack_buffer, 0);
+
+    size_ = readback.size;
+    gl_pixel_format = readback.format;
+    pixels_need_y_flip = false;
+}
+
+unsigned int ms::GLPixelBuffer::max_pending_fills() const
+{
+    return pixel_pack_buffers ? pixel_pack_ring_size : 1;
+}
+
+void const* ms::GLPixelBuffer::as_argb_8888()
+{
+    if (pixels_need_y_flip)
+    {
+        /* glReadPixels() gives us the rows bottom first, and RGBA needs converting to ARGB */
+        mg::pixel::flip_vertically(
+            reinterpret_cast<uint32_t*>(pixels.data()),
+            size_.width.as_uint32_t(),
+            size_.width.as_uint32_t(),
+            size_.height.as_uint32_t(),
+            gl_pixel_format == GL_RGBA);
 
         pixels_need_y_flip = false;
     }
@@ -174,21 +352,3 @@ geom::Stride ms::GLPixelBuffer::stride() const
 {
     return geom::Stride{size_.width.as_uint32_t() * sizeof(uint32_t)};
 }
-
-void ms::GLPixelBuffer::copy_and_convert_pixel_line(char* src, char* dst)
-{
-    if (gl_pixel_format == GL_RGBA)
-    {
-        /* Convert from abgr_8888 to argb_8888 while copying */
-        auto pixels_src = reinterpret_cast<uint32_t*>(src);
-        auto pixels_dst = reinterpret_cast<uint32_t*>(dst);
-        auto const width = size_.width.as_uint32_t();
-
-        for (uint32_t n = 0; n < width; n++)
-            pixels_dst[n] = abgr_to_argb(pixels_src[n]);
-    }
-    else if (src != dst)
-    {
-        std::copy(src, src + stride().as_uint32_t(), dst);
-    }
-}
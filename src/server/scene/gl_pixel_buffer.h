@@ -50,17 +50,25 @@ public:
     ~GLPixelBuffer() noexcept;
 
     void fill_from(graphics::Buffer& buffer);
+    void begin_fill_from(graphics::Buffer& buffer) override;
+    void complete_fill() override;
+    unsigned int max_pending_fills() const override;
     void const* as_argb_8888();
     geometry::Size size() const;
     geometry::Stride stride() const;
 
 private:
+    struct PixelPackBuffers;
+
     void prepare();
-    void copy_and_convert_pixel_line(char* src, char* dst);
+    void attach(graphics::Buffer& buffer);
+    auto read_pixels(geometry::Size size, void* destination) -> GLuint;
 
     std::unique_ptr<renderer::gl::Context> const gl_context;
     GLuint tex;
     GLuint fbo;
+    bool checked_for_pixel_pack_buffers{false};
+    std::unique_ptr<PixelPackBuffers> pixel_pack_buffers; // nullptr if GL can't read back asynchronously
     std::vector<char> pixels;
     GLuint gl_pixel_format;
     bool pixels_need_y_flip;
@@ -45,6 +45,29 @@ public:
      */
     virtual void fill_from(graphics::Buffer& buffer) = 0;
 
+    /**
+     * Starts extracting the contents of a graphics::Buffer without waiting
+     * for them to arrive.
+     *
+     * Up to max_pending_fills() may be outstanding. Each is finished, oldest
+     * first, by complete_fill(), after which as_argb_8888(), size() and
+     * stride() describe it. By default this is just fill_from().
+     *
+     * \param [in] buffer the buffer to get the pixels of
+     */
+    virtual void begin_fill_from(graphics::Buffer& buffer) { fill_from(buffer); }
+
+    /**
+     * Waits for the oldest outstanding begin_fill_from() to finish.
+     */
+    virtual void complete_fill() {}
+
+    /**
+     * How many begin_fill_from() calls may be outstanding at once. This may
+     * only be known once the PixelBuffer has been used.
+     */
+    virtual unsigned int max_pending_fills() const { return 1; }
+
     /**
      * The pixels in 0xAARRGGBB format.
      *
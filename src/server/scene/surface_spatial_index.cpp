@@ -0,0 +1,242 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_spatial_index.h"
+#include "mir/scene/surface.h"
+
+#include <algorithm>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+struct ms::SurfaceSpatialIndex::Entry
+{
+    std::shared_ptr<Surface> const surface;
+    /// Entries with a higher order are stacked above those with a lower one
+    uint64_t order;
+    geom::Rectangle bounds;
+    bool oversized;
+};
+
+namespace
+{
+int const cell_shift = 8;     // 256x256 cells
+int const max_cells = 1024;   // ...beyond which a surface is "oversized"
+int const layer_shift = 48;   // order is the layer followed by a sequence number
+
+int cell_of(int coordinate)
+{
+    // Rounding towards -∞, as cells extend into negative coordinates
+    return coordinate >= 0 ? coordinate >> cell_shift : -((-coordinate - 1) >> cell_shift) - 1;
+}
+
+uint64_t cell_key(int x, int y)
+{
+    return (uint64_t{static_cast<uint32_t>(x)} << 32) | static_cast<uint32_t>(y);
+}
+
+bool is_empty(geom::Rectangle const& rect)
+{
+    return rect.size.width.as_int() <= 0 || rect.size.height.as_int() <= 0;
+}
+
+/// Bounds of the area BasicSurface::input_area_contains() can accept input in
+geom::Rectangle input_area_bounds(ms::Surface const& surface)
+{
+    auto const content = surface.input_bounds();
+    auto const region = surface.input_region();
+
+    if (region.empty())
+        return content;
+
+    // A custom input region is relative to the content, and may extend beyond it
+    bool found{false};
+    int left{0}, top{0}, right{0}, bottom{0};
+    for (auto const& rect : region)
+    {
+        if (is_empty(rect))
+            continue;
+
+        auto const l = content.left().as_int() + rect.left().as_int();
+        auto const t = content.top().as_int() + rect.top().as_int();
+        auto const r = l + rect.size.width.as_int();
+        auto const b = t + rect.size.height.as_int();
+
+        left = found ? std::min(left, l) : l;
+        top = found ? std::min(top, t) : t;
+        right = found ? std::max(right, r) : r;
+        bottom = found ? std::max(bottom, b) : b;
+        found = true;
+    }
+
+    if (!found)
+        return {};
+
+    return {{left, top}, {right - left, bottom - top}};
+}
+
+auto const is_below = [](auto const* lhs, auto const* rhs) { return lhs->order < rhs->order; };
+
+template<typename Cell>
+void insert_in_order(Cell& cell, typename Cell::value_type entry)
+{
+    cell.insert(std::upper_bound(cell.begin(), cell.end(), entry, is_below), entry);
+}
+
+template<typename Cell>
+void erase(Cell& cell, typename Cell::value_type entry)
+{
+    auto const i = std::find(cell.begin(), cell.end(), entry);
+    if (i != cell.end())
+        cell.erase(i);
+}
+
+template<typename Action>
+void for_each_cell(geom::Rectangle const& bounds, Action const& action)
+{
+    auto const x0 = cell_of(bounds.left().as_int());
+    auto const x1 = cell_of(bounds.right().as_int() - 1);
+    auto const y0 = cell_of(bounds.top().as_int());
+    auto const y1 = cell_of(bounds.bottom().as_int() - 1);
+
+    for (auto y = y0; y <= y1; ++y)
+        for (auto x = x0; x <= x1; ++x)
+            action(cell_key(x, y));
+}
+
+int64_t cell_count(geom::Rectangle const& bounds)
+{
+    auto const columns = int64_t{cell_of(bounds.right().as_int() - 1)} - cell_of(bounds.left().as_int()) + 1;
+    auto const rows = int64_t{cell_of(bounds.bottom().as_int() - 1)} - cell_of(bounds.top().as_int()) + 1;
+    return columns * rows;
+}
+}
+
+ms::SurfaceSpatialIndex::SurfaceSpatialIndex()
+    : next_sequence{0}
+{
+}
+
+ms::SurfaceSpatialIndex::~SurfaceSpatialIndex() = default;
+
+void ms::SurfaceSpatialIndex::place_on_top(std::shared_ptr<Surface> const& surface, unsigned layer)
+{
+    auto& entry = entries[surface.get()];
+
+    if (entry)
+        remove_from_cells(entry.get());
+    else
+        entry.reset(new Entry{surface, 0, {}, false});
+
+    entry->order = (uint64_t{layer} << layer_shift) | next_sequence++;
+    entry->bounds = input_area_bounds(*surface);
+    insert_into_cells(entry.get());
+}
+
+void ms::SurfaceSpatialIndex::remove(Surface const* surface)
+{
+    auto const i = entries.find(surface);
+    if (i == entries.end())
+        return;
+
+    remove_from_cells(i->second.get());
+    entries.erase(i);
+}
+
+void ms::SurfaceSpatialIndex::update(Surface const* surface)
+{
+    auto const i = entries.find(surface);
+    if (i == entries.end())
+        return;
+
+    auto const entry = i->second.get();
+    auto const bounds = input_area_bounds(*entry->surface);
+    if (bounds == entry->bounds)
+        return;
+
+    remove_from_cells(entry);
+    entry->bounds = bounds;
+    insert_into_cells(entry);
+}
+
+void ms::SurfaceSpatialIndex::clear()
+{
+    cells.clear();
+    oversized.clear();
+    entries.clear();
+}
+
+auto ms::SurfaceSpatialIndex::topmost_accepting_input_at(geometry::Point point) const -> std::shared_ptr<Surface>
+{
+    static Cell const no_entries;
+
+    auto const found = cells.find(cell_key(cell_of(point.x.as_int()), cell_of(point.y.as_int())));
+    auto const& local = found != cells.end() ? found->second : no_entries;
+
+    // Walk both lists from the top down, interleaving them by order
+    auto l = local.rbegin();
+    auto o = oversized.rbegin();
+    while (l != local.rend() || o != oversized.rend())
+    {
+        auto const entry = (o == oversized.rend() || (l != local.rend() && is_below(*o, *l))) ? *l++ : *o++;
+
+        if (entry->bounds.contains(point) && entry->surface->input_area_contains(point))
+            return entry->surface;
+    }
+
+    return {};
+}
+
+void ms::SurfaceSpatialIndex::insert_into_cells(Entry* entry)
+{
+    entry->oversized = false;
+
+    if (is_empty(entry->bounds))
+        return;
+
+    if (cell_count(entry->bounds) > max_cells)
+    {
+        entry->oversized = true;
+        insert_in_order(oversized, entry);
+        return;
+    }
+
+    for_each_cell(entry->bounds, [&](uint64_t key) { insert_in_order(cells[key], entry); });
+}
+
+void ms::SurfaceSpatialIndex::remove_from_cells(Entry* entry)
+{
+    if (is_empty(entry->bounds))
+        return;
+
+    if (entry->oversized)
+    {
+        erase(oversized, entry);
+        return;
+    }
+
+    for_each_cell(entry->bounds,
+        [&](uint64_t key)
+        {
+            auto const cell = cells.find(key);
+            if (cell == cells.end())
+                return;
+
+            erase(cell->second, entry);
+            if (cell->second.empty())
+                cells.erase(cell);
+        });
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
+#define MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
+
+#include "mir/geometry/point.h"
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+class Surface;
+
+/**
+ * Finds the topmost surface accepting input at a point without visiting
+ * every surface in the scene.
+ *
+ * Surfaces are bucketed into a uniform grid of cells by the bounds of their
+ * input area (the content area, or the extent of a custom input region), each
+ * cell listing its surfaces in stacking order. A lookup only tests the
+ * surfaces in the cell containing the point, topmost first, and doesn't
+ * allocate.
+ *
+ * The index is not synchronized: the owner is expected to serialize access
+ * and to call update() whenever a surface's input area may have changed.
+ */
+class SurfaceSpatialIndex
+{
+public:
+    SurfaceSpatialIndex();
+    ~SurfaceSpatialIndex();
+
+    /// Puts surface above all others on the same layer (adding it if it isn't indexed)
+    void place_on_top(std::shared_ptr<Surface> const& surface, unsigned layer);
+    void remove(Surface const* surface);
+    /// Re-reads the input area of surface (ignored if it isn't indexed)
+    void update(Surface const* surface);
+    void clear();
+
+    /// The topmost surface whose input area contains point, or null
+    auto topmost_accepting_input_at(geometry::Point point) const -> std::shared_ptr<Surface>;
+
+private:
+    SurfaceSpatialIndex(SurfaceSpatialIndex const&) = delete;
+    SurfaceSpatialIndex& operator=(SurfaceSpatialIndex const&) = delete;
+
+    struct Entry;
+    /// Sorted bottom to top
+    using Cell = std::vector<Entry*>;
+
+    void insert_into_cells(Entry* entry);
+    void remove_from_cells(Entry* entry);
+
+    std::unordered_map<Surface const*, std::unique_ptr<Entry>> entries;
+    std::unordered_map<uint64_t, Cell> cells;
+    /// Surfaces whose input area spans too many cells to list in each
+    Cell oversized;
+    uint64_t next_sequence;
+};
+}
+}
+
+#endif /* MIR_SCENE_SURFACE_SPATIAL_INDEX_H_ */
@@ -109,11 +109,11 @@ private:
 };
 
 /**
- * A SurfaceDepthLayerObserver must not outlive the SurfaceStack it was created for
+ * A StackedSurfaceObserver must not outlive the SurfaceStack it was created for
  */
-struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
+struct StackedSurfaceObserver : ms::NullSurfaceObserver
 {
-    SurfaceDepthLayerObserver(ms::SurfaceStack* stack)
+    StackedSurfaceObserver(ms::SurfaceStack* stack)
         : stack{stack}
     {
     }
@@ -124,6 +124,21 @@ struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
         stack->raise(surface);
     }
 
+    void content_resized_to(ms::Surface const* surface, geom::Size const& /*content_size*/) override
+    {
+        stack->input_area_changed(surface);
+    }
+
+    void moved_to(ms::Surface const* surface, geom::Point const& /*top_left*/) override
+    {
+        stack->input_area_changed(surface);
+    }
+
+    void input_region_set_to(ms::Surface const* surface, std::vector<geom::Rectangle> const& /*region*/) override
+    {
+        stack->input_area_changed(surface);
+    }
+
 private:
     ms::SurfaceStack* stack;
 };
@@ -134,7 +149,7 @@ ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
     scene_changed{false},
-    surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)}
+    surface_observer{std::make_shared<StackedSurfaceObserver>(this)}
 {
 }
 
@@ -268,9 +283,10 @@ void ms::SurfaceStack::add_surface(
 {
     {
         RecursiveWriteLock lg(guard);
+        // Observe first, so that changes made while the surface is indexed aren't missed
+        surface->add_observer(surface_observer);
         insert_surface_at_top_of_depth_layer(surface);
         create_rendering_tracker_for(surface);
-        surface->add_observer(surface_observer);
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface);
@@ -293,6 +309,7 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
             if (surface != layer.end())
             {
                 layer.erase(surface);
+                input_index.remove(keep_alive.get());
                 rendering_trackers.erase(keep_alive.get());
                 keep_alive->remove_observer(surface_observer);
                 found_surface = true;
@@ -309,37 +326,27 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     // TODO: error logging when surface not found
 }
 
-namespace
+auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
+-> std::shared_ptr<Surface>
 {
-template <typename Container>
-struct InReverse {
-    Container& container;
-    auto begin() -> decltype(container.rbegin()) { return container.rbegin(); }
-    auto end() -> decltype(container.rend()) { return container.rend(); }
-};
-
-template <typename Container>
-InReverse<Container> in_reverse(Container& container) { return InReverse<Container>{container}; }
+    // TODO There's a lack of clarity about how the input area will
+    // TODO be maintained and whether this test will detect clicks on
+    // TODO decorations (it should) as these may be outside the area
+    // TODO known to the client.  But it works for now.
+    RecursiveReadLock lg(guard);
+    return input_index.topmost_accepting_input_at(cursor);
 }
 
-auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
--> std::shared_ptr<Surface>
+auto ms::SurfaceStack::input_surface_at(geometry::Point point) -> std::shared_ptr<mi::Surface>
 {
     RecursiveReadLock lg(guard);
-    for (auto const& layer : in_reverse(surface_layers))
-    {
-        for (auto const& surface : in_reverse(layer))
-        {
-            // TODO There's a lack of clarity about how the input area will
-            // TODO be maintained and whether this test will detect clicks on
-            // TODO decorations (it should) as these may be outside the area
-            // TODO known to the client.  But it works for now.
-            if (surface->input_area_contains(cursor))
-                    return surface;
-        }
-    }
+    return input_index.topmost_accepting_input_at(point);
+}
 
-    return {};
+void ms::SurfaceStack::input_area_changed(Surface const* surface)
+{
+    RecursiveWriteLock lg(guard);
+    input_index.update(surface);
 }
 
 void ms::SurfaceStack::for_each(std::function<void(std::shared_ptr<mi::Surface> const&)> const& callback)
@@ -450,6 +457,7 @@ void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(std::shared_ptr<Surf
     if (surface_layers.size() <= depth_index)
         surface_layers.resize(depth_index + 1);
     surface_layers[depth_index].push_back(surface);
+    input_index.place_on_top(surface, depth_index);
 }
 
 void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observer)
@@ -25,6 +25,7 @@
 #include "mir/compositor/scene.h"
 #include "mir/scene/observer.h"
 #include "mir/input/scene.h"
+#include "surface_spatial_index.h"
 #include "mir/recursive_read_write_mutex.h"
 
 #include "mir/basic_observers.h"
@@ -85,6 +86,7 @@ public:
 
     // From Scene
     void for_each(std::function<void(std::shared_ptr<input::Surface> const&)> const& callback) override;
+    auto input_surface_at(geometry::Point point) -> std::shared_ptr<input::Surface> override;
 
     virtual void remove_surface(std::weak_ptr<Surface> const& surface) override;
 
@@ -98,6 +100,9 @@ public:
 
     auto surface_at(geometry::Point) const -> std::shared_ptr<Surface> override;
 
+    /// Called when surface may have moved, been resized, or had its input region changed
+    void input_area_changed(Surface const* surface);
+
     void add_observer(std::shared_ptr<Observer> const& observer) override;
     void remove_observer(std::weak_ptr<Observer> const& observer) override;
 
@@ -126,6 +131,8 @@ private:
      * The inner vectors contain the list of surfaces on each layer (bottom to top)
      */
     std::vector<std::vector<std::shared_ptr<Surface>>> surface_layers;
+    /// The surfaces in surface_layers, indexed for hit-testing
+    SurfaceSpatialIndex input_index;
     std::map<Surface*,std::shared_ptr<RenderingTracker>> rendering_trackers;
     std::set<compositor::CompositorID> registered_compositors;
     
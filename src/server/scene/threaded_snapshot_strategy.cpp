@@ -21,9 +21,11 @@
 #include "mir/compositor/buffer_stream.h"
 #include "mir/thread_name.h"
 
+#include <algorithm>
 #include <deque>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 namespace geom = mir::geometry;
 namespace ms = mir::scene;
@@ -39,6 +41,12 @@ struct WorkItem
     ms::SnapshotCallback const snapshot_taken;
 };
 
+struct PendingSnapshot
+{
+    std::shared_ptr<graphics::Buffer> const buffer;
+    ms::SnapshotCallback const snapshot_taken;
+};
+
 class SnapshottingFunctor
 {
 public:
@@ -52,32 +60,52 @@ public:
         mir::set_thread_name("Mir/Snapshot");
         std::unique_lock<std::mutex> lock{work_mutex};
 
-        while (running)
+        // Readbacks begun, oldest first
+        std::deque<PendingSnapshot> pending;
+
+        while (running || !pending.empty())
         {
-            while (running && work.empty())
+            while (running && work.empty() && pending.empty())
                 work_cv.wait(lock);
 
-            if (running)
+            // Start reading back as many queued snapshots as the pixel buffer can overlap...
+            std::vector<WorkItem> started;
+            auto const max_pending = std::max(pixels->max_pending_fills(), 1u);
+            while (running && !work.empty() && pending.size() + started.size() < max_pending)
             {
-                auto wi = work.front();
+                started.push_back(work.front());
                 work.pop_front();
+            }
 
-                lock.unlock();
+            lock.unlock();
 
-                take_snapshot(wi);
+            for (auto const& wi : started)
+                pending.push_back(begin_snapshot(wi));
 
-                lock.lock();
+            // ...then finish the oldest, picking up any new work before finishing the next
+            if (!pending.empty())
+            {
+                complete_snapshot(pending.front());
+                pending.pop_front();
             }
+
+            lock.lock();
         }
     }
 
-    void take_snapshot(WorkItem const& wi)
+    auto begin_snapshot(WorkItem const& wi) -> PendingSnapshot
+    {
+        // The client can't have the buffer back until it has been read
+        auto const buffer = wi.stream->snapshot_acquire();
+        pixels->begin_fill_from(*buffer);
+        return {buffer, wi.snapshot_taken};
+    }
+
+    void complete_snapshot(PendingSnapshot const& snapshot)
     {
-        wi.stream->with_most_recent_buffer_do([this](mir::graphics::Buffer& buffer) {
-            pixels->fill_from(buffer);
-        });
+        pixels->complete_fill();
 
-        wi.snapshot_taken(
+        snapshot.snapshot_taken(
             ms::Snapshot{pixels->size(),
                      pixels->stride(),
                      pixels->as_argb_8888()});
@@ -179,7 +179,7 @@ msd::BasicDecoration::BasicDecoration(
               return session;
           }()},
       buffer_streams{std::make_unique<BufferStreams>(session)},
-      renderer{std::make_unique<Renderer>(buffer_allocator, static_geometry)},
+      renderer{std::make_unique<Renderer>(buffer_allocator, static_geometry, Renderer::Text::instance())},
       window_surface{window_surface},
       decoration_surface{shell->create_surface(session, *creation_params(), nullptr)},
       window_state{new_window_state()},
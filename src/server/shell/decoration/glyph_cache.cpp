@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "glyph_cache.h"
+
+#include <algorithm>
+
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+
+msd::GlyphCache::GlyphCache(size_t capacity)
+    : capacity{std::max(capacity, size_t{1})}
+{
+}
+
+auto msd::GlyphCache::key_for(geom::Height height, char32_t code_point) -> uint64_t
+{
+    return (uint64_t(height.as_uint32_t()) << 32) | code_point;
+}
+
+auto msd::GlyphCache::find(geom::Height height, char32_t code_point) -> Glyph const*
+{
+    auto const found = index.find(key_for(height, code_point));
+    if (found == index.end())
+        return nullptr;
+
+    entries.splice(entries.begin(), entries, found->second);
+    return &found->second->glyph;
+}
+
+auto msd::GlyphCache::insert(geom::Height height, char32_t code_point, Glyph glyph) -> Glyph const&
+{
+    auto const key = key_for(height, code_point);
+
+    auto const found = index.find(key);
+    if (found != index.end())
+    {
+        entries.erase(found->second);
+        index.erase(found);
+    }
+
+    if (entries.size() >= capacity)
+    {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+
+    entries.push_front(Entry{key, std::move(glyph)});
+    index[key] = entries.begin();
+    return entries.front().glyph;
+}
+
+auto msd::GlyphCache::size() const -> size_t
+{
+    return entries.size();
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SHELL_DECORATION_GLYPH_CACHE_H_
+#define MIR_SHELL_DECORATION_GLYPH_CACHE_H_
+
+#include "mir/geometry/size.h"
+#include "mir/geometry/displacement.h"
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace shell
+{
+namespace decoration
+{
+/// Rasterized glyphs, kept so redrawing a title doesn't need FreeType
+/// The least recently used glyph is evicted when the cache is full
+class GlyphCache
+{
+public:
+    struct Glyph
+    {
+        geometry::Displacement bearing;    ///< From the pen position to the top left of the coverage mask
+        geometry::Displacement advance;
+        geometry::Size size;
+        std::vector<unsigned char> coverage;
+    };
+
+    /// Enough for the titles of a good number of windows at a couple of sizes
+    static size_t const max_cached_glyphs = 1024;
+
+    /// A capacity of zero is taken as one, as the glyph just inserted is always kept
+    explicit GlyphCache(size_t capacity = max_cached_glyphs);
+
+    /// The glyph for code_point at height, if cached (it is then the most recently used)
+    auto find(geometry::Height height, char32_t code_point) -> Glyph const*;
+    auto insert(geometry::Height height, char32_t code_point, Glyph glyph) -> Glyph const&;
+    auto size() const -> size_t;
+
+private:
+    GlyphCache(GlyphCache const&) = delete;
+    GlyphCache& operator=(GlyphCache const&) = delete;
+
+    struct Entry
+    {
+        uint64_t key;
+        Glyph glyph;
+    };
+
+    static auto key_for(geometry::Height height, char32_t code_point) -> uint64_t;
+
+    size_t const capacity;
+    std::list<Entry> entries; ///< Most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+};
+}
+}
+}
+
+#endif // MIR_SHELL_DECORATION_GLYPH_CACHE_H_
@@ -20,8 +20,10 @@
 #include "renderer.h"
 #include "window.h"
 #include "input.h"
+#include "glyph_cache.h"
 
 #include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/graphics/pixel_kernels.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/geometry/displacement.h"
 #include "mir/log.h"
@@ -31,6 +33,7 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <algorithm>
 #include <locale>
 #include <codecvt>
 
@@ -106,10 +109,10 @@ inline void render_row(
         return;
     geom::X const right = std::min(left.x + as_delta(length), as_x(buf_size.width));
     left.x = std::max(left.x, geom::X{});
+    if (right <= left.x)
+        return;
     uint32_t* const start = data + (left.y.as_int() * buf_size.width.as_int()) + left.x.as_int();
-    uint32_t* const end = start + right.as_int() - left.x.as_int();
-    for (uint32_t* i = start; i < end; i++)
-        *i = color;
+    mg::pixel::fill(start, right.as_int() - left.x.as_int(), color);
 }
 
 inline void render_close_icon(
@@ -188,13 +191,16 @@ private:
     std::mutex mutex;
     FT_Library library;
     FT_Face face;
+    geom::Height char_size;
+    GlyphCache glyphs;
 
     void set_char_size(geom::Height height);
     void rasterize_glyph(char32_t glyph);
+    auto cached_glyph(geom::Height height, char32_t glyph) -> GlyphCache::Glyph const&;
     void render_glyph(
         Pixel* buf,
         geom::Size buf_size,
-        FT_Bitmap const* glyph,
+        GlyphCache::Glyph const& glyph,
         geom::Point top_left,
         Pixel color);
 
@@ -290,34 +296,21 @@ void msd::Renderer::Text::Impl::render(
         return;
     }
 
-    try
-    {
-        set_char_size(height_pixels);
-    }
-    catch (std::runtime_error const& error)
-    {
-        log_warning(error.what());
-        return;
-    }
-
     auto const utf32 = utf8_to_utf32(text);
 
     for (char32_t const glyph : utf32)
     {
         try
         {
-            rasterize_glyph(glyph);
+            auto const& cached = cached_glyph(height_pixels, glyph);
 
             geom::Point glyph_top_left =
                 top_left +
-                geom::Displacement{
-                    face->glyph->bitmap_left,
-                    height_pixels.as_int() - face->glyph->bitmap_top};
-            render_glyph(buf, buf_size, &face->glyph->bitmap, glyph_top_left, color);
-
-            top_left += geom::Displacement{
-                face->glyph->advance.x / 64,
-                face->glyph->advance.y / 64};
+                geom::Displacement{0, height_pixels.as_int()} +
+                cached.bearing;
+            render_glyph(buf, buf_size, cached, glyph_top_left, color);
+
+            top_left += cached.advance;
         }
         catch (std::runtime_error const& error)
         {
@@ -328,9 +321,14 @@ void msd::Renderer::Text::Impl::render(
 
 void msd::Renderer::Text::Impl::set_char_size(geom::Height height)
 {
+    if (height == char_size)
+        return;
+
     if (auto const error = FT_Set_Pixel_Sizes(face, 0, height.as_int()))
         BOOST_THROW_EXCEPTION(std::runtime_error(
             "Setting char size failed with error " + std::to_string(error)));
+
+    char_size = height;
 }
 
 void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
@@ -346,18 +344,44 @@ void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
             "Failed to render glyph " + std::to_string(glyph_index)));
 }
 
+auto msd::Renderer::Text::Impl::cached_glyph(geom::Height height, char32_t glyph) -> GlyphCache::Glyph const&
+{
+    if (auto const cached = glyphs.find(height, glyph))
+        return *cached;
+
+    set_char_size(height);
+    rasterize_glyph(glyph);
+
+    auto const slot = face->glyph;
+    auto const& bitmap = slot->bitmap;
+
+    GlyphCache::Glyph rasterized{
+        geom::Displacement{slot->bitmap_left, -slot->bitmap_top},
+        geom::Displacement{slot->advance.x / 64, slot->advance.y / 64},
+        geom::Size{bitmap.width, bitmap.rows},
+        std::vector<unsigned char>(bitmap.width * bitmap.rows)};
+
+    for (unsigned int row = 0; row < bitmap.rows; row++)
+    {
+        auto const src = bitmap.buffer + row * bitmap.pitch;
+        std::copy(src, src + bitmap.width, rasterized.coverage.begin() + row * bitmap.width);
+    }
+
+    return glyphs.insert(height, glyph, std::move(rasterized));
+}
+
 void msd::Renderer::Text::Impl::render_glyph(
     Pixel* buf,
     geom::Size buf_size,
-    FT_Bitmap const* glyph,
+    GlyphCache::Glyph const& glyph,
     geom::Point top_left,
     Pixel color)
 {
     geom::X const buffer_left = std::max(top_left.x, geom::X{});
-    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph->width}, as_x(buf_size.width));
+    geom::X const buffer_right = std::min(top_left.x + as_delta(glyph.size.width), as_x(buf_size.width));
 
     geom::Y const buffer_top = std::max(top_left.y, geom::Y{});
-    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph->rows}, as_y(buf_size.height));
+    geom::Y const buffer_bottom = std::min(top_left.y + as_delta(glyph.size.height), as_y(buf_size.height));
 
     geom::Displacement const glyph_offset = as_displacement(top_left);
 
@@ -367,7 +391,7 @@ void msd::Renderer::Text::Impl::render_glyph(
     for (geom::Y buffer_y = buffer_top; buffer_y < buffer_bottom; buffer_y += geom::DeltaY{1})
     {
         geom::Y const glyph_y = buffer_y - glyph_offset.dy;
-        unsigned char* const glyph_row = glyph->buffer + glyph_y.as_int() * glyph->pitch;
+        unsigned char const* const glyph_row = glyph.coverage.data() + glyph_y.as_int() * glyph.size.width.as_int();
         Pixel* const buffer_row = buf + buffer_y.as_int() * buf_size.width.as_int();
 
         for (geom::X buffer_x = buffer_left; buffer_x < buffer_right; buffer_x += geom::DeltaX{1})
@@ -435,7 +459,8 @@ auto msd::Renderer::Text::Impl::utf8_to_utf32(std::string const& text) -> std::u
 
 msd::Renderer::Renderer(
     std::shared_ptr<graphics::GraphicBufferAllocator> const& buffer_allocator,
-    std::shared_ptr<StaticGeometry const> const& static_geometry)
+    std::shared_ptr<StaticGeometry const> const& static_geometry,
+    std::shared_ptr<Text> const& text)
     : buffer_allocator{buffer_allocator},
       focused_theme{
           default_focused_background,
@@ -462,7 +487,7 @@ msd::Renderer::Renderer(
               render_minimize_icon}},
       },
       static_geometry{static_geometry},
-      text{Text::instance()}
+      text{text}
 {
 }
 
@@ -509,7 +534,7 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     if (input_state.buttons() != buttons)
     {
         // If the number of buttons or their location changed, redraw the whole titlebar
-        // Otherwise if the buttons are in the same place, just redraw them
+        // Otherwise if the buttons are in the same place, just redraw the ones that changed
         if (input_state.buttons().size() != buttons.size())
         {
             needs_titlebar_redraw = true;
@@ -523,7 +548,6 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
             }
         }
         buttons = input_state.buttons();
-        needs_titlebar_buttons_redraw = true;
     }
 }
 
@@ -557,9 +581,10 @@ auto msd::Renderer::render_titlebar() -> std::experimental::optional<std::shared
             current_theme->text_color);
     }
 
-    if (needs_titlebar_redraw || needs_titlebar_buttons_redraw)
+    for (unsigned i = 0; i < buttons.size(); i++)
     {
-        for (auto const& button : buttons)
+        auto const& button = buttons[i];
+        if (needs_titlebar_redraw || i >= drawn_buttons.size() || !(button == drawn_buttons[i]))
         {
             auto const icon = button_icons.find(button.function);
             if (icon != button_icons.end())
@@ -595,9 +620,9 @@ auto msd::Renderer::render_titlebar() -> std::experimental::optional<std::shared
     }
 
     needs_titlebar_redraw = false;
-    needs_titlebar_buttons_redraw = false;
+    drawn_buttons = buttons;
 
-    return make_buffer(titlebar_pixels.get(), titlebar_size);
+    return make_buffer(titlebar_buffers, titlebar_pixels.get(), titlebar_size);
 }
 
 auto msd::Renderer::render_left_border() -> std::experimental::optional<std::shared_ptr<mg::Buffer>>
@@ -605,7 +630,7 @@ auto msd::Renderer::render_left_border() -> std::experimental::optional<std::sha
     if (!area(left_border_size))
         return std::experimental::nullopt;
     update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), left_border_size);
+    return make_buffer(left_border_buffers, solid_color_pixels.get(), left_border_size);
 }
 
 auto msd::Renderer::render_right_border() -> std::experimental::optional<std::shared_ptr<mg::Buffer>>
@@ -613,7 +638,7 @@ auto msd::Renderer::render_right_border() -> std::experimental::optional<std::sh
     if (!area(right_border_size))
         return std::experimental::nullopt;
     update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), right_border_size);
+    return make_buffer(right_border_buffers, solid_color_pixels.get(), right_border_size);
 }
 
 auto msd::Renderer::render_bottom_border() -> std::experimental::optional<std::shared_ptr<mg::Buffer>>
@@ -621,7 +646,7 @@ auto msd::Renderer::render_bottom_border() -> std::experimental::optional<std::s
     if (!area(bottom_border_size))
         return std::experimental::nullopt;
     update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), bottom_border_size);
+    return make_buffer(bottom_border_buffers, solid_color_pixels.get(), bottom_border_size);
 }
 
 void msd::Renderer::update_solid_color_pixels()
@@ -643,7 +668,35 @@ void msd::Renderer::update_solid_color_pixels()
     needs_solid_color_redraw = false;
 }
 
+auto msd::Renderer::BufferPool::acquire(mg::GraphicBufferAllocator& allocator, geom::Size size)
+    -> std::shared_ptr<mg::Buffer>
+{
+    // Any buffer only we hold a reference to isn't in use by a stream or the compositor
+    auto const unused = [](std::shared_ptr<mg::Buffer> const& buffer) { return buffer.use_count() == 1; };
+
+    // Buffers of the wrong size won't be useful again
+    buffers.erase(
+        std::remove_if(
+            buffers.begin(),
+            buffers.end(),
+            [&](auto const& buffer) { return unused(buffer) && buffer->size() != size; }),
+        buffers.end());
+
+    auto const found = std::find_if(buffers.begin(), buffers.end(), unused);
+    if (found != buffers.end())
+        return *found;
+
+    // A stream holds on to at most a couple of buffers
+    size_t const max_pooled_buffers = 3;
+
+    auto const buffer = allocator.alloc_software_buffer(size, buffer_format);
+    if (buffers.size() < max_pooled_buffers)
+        buffers.push_back(buffer);
+    return buffer;
+}
+
 auto msd::Renderer::make_buffer(
+    BufferPool& pool,
     uint32_t const* pixels,
     geometry::Size size) -> std::experimental::optional<std::shared_ptr<mg::Buffer>>
 {
@@ -652,7 +705,7 @@ auto msd::Renderer::make_buffer(
         log_warning("Failed to draw SSD: tried to create zero size buffer");
         return std::experimental::nullopt;
     }
-    std::shared_ptr<graphics::Buffer> const buffer = buffer_allocator->alloc_software_buffer(size, buffer_format);
+    std::shared_ptr<graphics::Buffer> const buffer = pool.acquire(*buffer_allocator, size);
     auto const pixel_source = dynamic_cast<mrs::PixelSource*>(buffer->native_buffer_base());
     if (!pixel_source)
     {
@@ -47,9 +47,12 @@ auto const bytes_per_pixel = 4;
 class Renderer
 {
 public:
+    class Text;
+
     Renderer(
         std::shared_ptr<graphics::GraphicBufferAllocator> const& buffer_allocator,
-        std::shared_ptr<StaticGeometry const> const& static_geometry);
+        std::shared_ptr<StaticGeometry const> const& static_geometry,
+        std::shared_ptr<Text> const& text);
 
     void update_state(WindowState const& window_state, InputState const& input_state);
     auto render_titlebar() -> std::experimental::optional<std::shared_ptr<graphics::Buffer>>;
@@ -57,9 +60,9 @@ public:
     auto render_right_border() -> std::experimental::optional<std::shared_ptr<graphics::Buffer>>;
     auto render_bottom_border() -> std::experimental::optional<std::shared_ptr<graphics::Buffer>>;
 
-private:
     using Pixel = uint32_t;
 
+    /// Renders window titles (shared by all decorations)
     class Text
     {
     public:
@@ -83,6 +86,7 @@ private:
         static std::weak_ptr<Text> singleton;
     };
 
+private:
     /// A visual theme for a decoration
     /// Focused and unfocused windows use a different theme
     struct Theme
@@ -105,6 +109,17 @@ private:
             Pixel color)> const render_icon; ///< Draws button's icon to the given buffer
     };
 
+    /// Buffers handed out to a stream, to be refilled once the compositor is done with them
+    class BufferPool
+    {
+    public:
+        auto acquire(graphics::GraphicBufferAllocator& allocator, geometry::Size size)
+            -> std::shared_ptr<graphics::Buffer>;
+
+    private:
+        std::vector<std::shared_ptr<graphics::Buffer>> buffers;
+    };
+
     std::shared_ptr<graphics::GraphicBufferAllocator> buffer_allocator;
     Theme const focused_theme;
     Theme const unfocused_theme;
@@ -123,14 +138,20 @@ private:
     std::unique_ptr<Pixel[]> titlebar_pixels; // can be nullptr
 
     bool needs_titlebar_redraw{true};
-    bool needs_titlebar_buttons_redraw{true};
     std::string name;
     std::vector<ButtonInfo> buttons;
+    std::vector<ButtonInfo> drawn_buttons; ///< The buttons as they are in titlebar_pixels
+
+    BufferPool titlebar_buffers;
+    BufferPool left_border_buffers;
+    BufferPool right_border_buffers;
+    BufferPool bottom_border_buffers;
 
     std::shared_ptr<Text> const text;
 
     void update_solid_color_pixels();
     auto make_buffer(
+        BufferPool& pool,
         Pixel const* pixels,
         geometry::Size size) -> std::experimental::optional<std::shared_ptr<graphics::Buffer>>;
     static auto alloc_pixels(geometry::Size size) -> std::unique_ptr<Pixel[]>;
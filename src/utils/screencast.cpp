@@ -27,10 +27,12 @@
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
 
 #include <boost/program_options.hpp>
 
 #include <algorithm>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -262,10 +264,15 @@ public:
 
             std::this_thread::sleep_until(time_point);
         }
+
+        finish(stream);
     }
 
     virtual void capture_to(std::ostream& stream) = 0;
 
+    /// Writes out any capture still in flight
+    virtual void finish(std::ostream&) {}
+
 protected:
     Screencast(int number_of_captures, double capture_fps)
         : number_of_captures{number_of_captures},
@@ -339,6 +346,10 @@ public:
             EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
             EGL_NONE};
 
+        static EGLint const es3_context_attribs[] = {
+            EGL_CONTEXT_CLIENT_VERSION, 3,
+            EGL_NONE };
+
         static EGLint const context_attribs[] = {
             EGL_CONTEXT_CLIENT_VERSION, 2,
             EGL_NONE };
@@ -363,7 +374,10 @@ public:
         if (egl_surface == EGL_NO_SURFACE)
             throw std::runtime_error("Failed to create EGL screencast surface");
 
-        egl_context = eglCreateContext(egl_display, egl_config, EGL_NO_CONTEXT, context_attribs);
+        // GLES 3 lets us read back asynchronously, but GLES 2 will do
+        egl_context = eglCreateContext(egl_display, egl_config, EGL_NO_CONTEXT, es3_context_attribs);
+        if (egl_context == EGL_NO_CONTEXT)
+            egl_context = eglCreateContext(egl_display, egl_config, EGL_NO_CONTEXT, context_attribs);
         if (egl_context == EGL_NO_CONTEXT)
             throw std::runtime_error("Failed to create EGL context for screencast");
 
@@ -383,10 +397,33 @@ public:
         int const rgba_pixel_size{4};
         auto const frame_size_bytes = rgba_pixel_size * width * height;
         buffer.resize(frame_size_bytes);
+
+        auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+        use_pixel_pack_buffers = version && strncmp(version, "OpenGL ES 3", 11) == 0;
+        if (use_pixel_pack_buffers)
+        {
+            glGenBuffers(2, pixel_pack_buffers);
+            for (auto const pbo : pixel_pack_buffers)
+            {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+                glBufferData(GL_PIXEL_PACK_BUFFER, frame_size_bytes, nullptr, GL_STREAM_READ);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
     }
 
     ~EGLScreencast()
     {
+        if (use_pixel_pack_buffers)
+        {
+            for (auto const fence : fences)
+            {
+                if (fence)
+                    glDeleteSync(fence);
+            }
+            glDeleteBuffers(2, pixel_pack_buffers);
+        }
+
         eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
         eglDestroySurface(egl_display, egl_surface);
         eglDestroyContext(egl_display, egl_context);
@@ -395,6 +432,22 @@ public:
 
     void capture_to(std::ostream& stream) override
     {
+        if (use_pixel_pack_buffers)
+        {
+            // Start reading this capture back, and write out the last one while the GPU gets on with it
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_pack_buffers[current]);
+            glReadPixels(0, 0, width, height, read_pixel_format, GL_UNSIGNED_BYTE, nullptr);
+            fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            if (eglSwapBuffers(egl_display, egl_surface) != EGL_TRUE)
+                throw std::runtime_error("Failed to swap screencast surface buffers");
+
+            current ^= 1;
+            write_out(current, stream);
+            return;
+        }
+
         void* data = buffer.data();
         glReadPixels(0, 0, width, height, read_pixel_format, GL_UNSIGNED_BYTE, data);
 
@@ -410,15 +463,43 @@ public:
         write_out_future.wait();
     }
 
+    void finish(std::ostream& stream) override
+    {
+        if (use_pixel_pack_buffers)
+            write_out(current ^ 1, stream);
+    }
+
     std::string pixel_format() override
     {
         return read_pixel_format == GL_BGRA_EXT ? "BGRA" : "RGBA";
     }
 
 private:
+    void write_out(int index, std::ostream& stream)
+    {
+        if (!fences[index])
+            return;
+
+        glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fences[index]);
+        fences[index] = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_pack_buffers[index]);
+        if (auto const pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, buffer.size(), GL_MAP_READ_BIT))
+        {
+            stream.write(static_cast<char const*>(pixels), buffer.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
     unsigned int const width;
     unsigned int const height;
     std::vector<char> buffer;
+    bool use_pixel_pack_buffers;
+    GLuint pixel_pack_buffers[2];
+    GLsync fences[2]{nullptr, nullptr};
+    int current{0};
     EGLDisplay egl_display;
     EGLContext egl_context;
     EGLSurface egl_surface;
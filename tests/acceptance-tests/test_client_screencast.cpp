@@ -211,3 +211,61 @@ TEST_F(Screencast, can_cast_to_buffer_sync)
     mir_screencast_release_sync(screencast);
     mir_connection_release(connection);
 }
+
+TEST_F(Screencast, capture_to_buffer_reports_what_changed_since_the_previous_capture)
+{
+    EXPECT_CALL(mock_authorizer, screencast_is_allowed(_))
+        .WillOnce(Return(true));
+    auto const connection = mir_connect_sync(new_connection().c_str(), __PRETTY_FUNCTION__);
+
+    auto const buffer = mir_connection_allocate_buffer_sync(
+        connection, default_width, default_height, default_pixel_format);
+    ASSERT_TRUE(buffer);
+
+    MirScreencastSpec* spec = mir_create_screencast_spec(connection);
+    mir_screencast_spec_set_number_of_buffers(spec, 0);
+    mir_screencast_spec_set_capture_region(spec, &default_capture_region);
+    auto screencast = mir_screencast_create_sync(spec);
+    mir_screencast_spec_release(spec);
+
+    // Nothing has been drawn into the buffer yet, so all of it changes
+    ASSERT_THAT(mir_screencast_capture_to_buffer_sync(screencast, buffer), Eq(mir_screencast_success));
+    ASSERT_THAT(mir_screencast_get_num_damage_rectangles(screencast), Eq(1u));
+    auto const damage = mir_screencast_get_damage_rectangle(screencast, 0);
+    EXPECT_THAT(damage.left, Eq(0));
+    EXPECT_THAT(damage.top, Eq(0));
+    EXPECT_THAT(damage.width, Eq(default_width));
+    EXPECT_THAT(damage.height, Eq(default_height));
+
+    // Nothing on screen has changed since
+    ASSERT_THAT(mir_screencast_capture_to_buffer_sync(screencast, buffer), Eq(mir_screencast_success));
+    EXPECT_THAT(mir_screencast_get_num_damage_rectangles(screencast), Eq(0u));
+
+    mir_screencast_release_sync(screencast);
+    mir_connection_release(connection);
+}
+
+TEST_F(Screencast, buffer_stream_reports_what_changed_since_the_previous_capture)
+{
+    EXPECT_CALL(mock_authorizer, screencast_is_allowed(_))
+        .WillOnce(Return(true));
+    auto const connection = mir_connect_sync(new_connection().c_str(), __PRETTY_FUNCTION__);
+
+    auto spec = create_default_screencast_spec(connection);
+    mir_screencast_spec_set_number_of_buffers(spec, 1);
+    auto screencast = mir_screencast_create_sync(spec);
+    mir_screencast_spec_release(spec);
+    ASSERT_TRUE(mir_screencast_is_valid(screencast));
+
+    // The first capture is made as the screencast is created
+    ASSERT_THAT(mir_screencast_get_num_damage_rectangles(screencast), Eq(1u));
+    auto const damage = mir_screencast_get_damage_rectangle(screencast, 0);
+    EXPECT_THAT(damage.width, Eq(default_width));
+    EXPECT_THAT(damage.height, Eq(default_height));
+
+    mir_buffer_stream_swap_buffers_sync(mir_screencast_get_buffer_stream(screencast));
+    EXPECT_THAT(mir_screencast_get_num_damage_rectangles(screencast), Eq(0u));
+
+    mir_screencast_release_sync(screencast);
+    mir_connection_release(connection);
+}
@@ -491,6 +491,16 @@ namespace
             mir_presentation_chain_submit_buffer(chain, buffer, tavailable, this);
         }
 
+        void submit_to(MirPresentationChain* chain, std::chrono::steady_clock::time_point target)
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            if (!avail)
+                throw std::runtime_error("test problem");
+            avail = false;
+            auto const target_time = std::chrono::duration_cast<std::chrono::nanoseconds>(target.time_since_epoch());
+            mir_presentation_chain_submit_buffer_at(chain, buffer, target_time.count(), tavailable, this);
+        }
+
         static void tavailable(MirBuffer*, void* ctxt)
         {
             TrackedBuffer* buf = reinterpret_cast<TrackedBuffer*>(ctxt);
@@ -623,3 +633,22 @@ TEST_F(PresentationChain, fifo_queues_clears_out_on_transition_to_mailbox)
     for (auto i = 0u; i < buffers.size() - 1; i++)
         EXPECT_TRUE(buffers[i]->wait_ready(5s));
 }
+
+TEST_F(PresentationChain, buffer_submitted_for_a_later_time_is_not_presented_before_then)
+{
+    SurfaceWithChainFromStart window(
+        connection, mir_present_mode_fifo, size, pf);
+    std::atomic<unsigned int> counter{ 0u };
+    TrackedBuffer shown_first{connection, counter};
+    TrackedBuffer shown_later{connection, counter};
+
+    shown_first.submit_to(window.chain());
+    auto const target = std::chrono::steady_clock::now() + 500ms;
+    shown_later.submit_to(window.chain(), target);
+
+    // The first buffer comes back once the later one replaces it on screen,
+    // which the server may do up to a (60Hz) frame before the target
+    EXPECT_TRUE(shown_first.wait_ready(5s));
+    EXPECT_THAT(std::chrono::steady_clock::now(), Ge(target - 17ms));
+    EXPECT_FALSE(shown_later.is_ready());
+}
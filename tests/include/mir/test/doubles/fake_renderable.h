@@ -80,6 +80,16 @@ public:
         return !rectangular;
     }
 
+    void set_opaque_region(std::vector<geometry::Rectangle> const& region)
+    {
+        opaque = region;
+    }
+
+    std::vector<geometry::Rectangle> opaque_region() const override
+    {
+        return opaque;
+    }
+
     void set_buffer(std::shared_ptr<graphics::Buffer> b)
     {
         buf = b;
@@ -90,6 +100,11 @@ public:
         return buf;
     }
 
+    uint64_t content_serial() const override
+    {
+        return 0;
+    }
+
     geometry::Rectangle screen_position() const override
     {
         return rect;
@@ -110,6 +125,7 @@ private:
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    std::vector<geometry::Rectangle> opaque;
 };
 
 } // namespace doubles
@@ -45,6 +45,8 @@ struct MockBufferStream : public compositor::BufferStream
             .WillByDefault(testing::Invoke(this, &MockBufferStream::buffers_ready));
         ON_CALL(*this, with_most_recent_buffer_do(testing::_))
             .WillByDefault(testing::InvokeArgument<0>(testing::ByRef(*buffer)));
+        ON_CALL(*this, snapshot_acquire())
+            .WillByDefault(testing::Return(buffer));
         ON_CALL(*this, acquire_client_buffer(testing::_))
             .WillByDefault(testing::InvokeArgument<0>(nullptr));
         ON_CALL(*this, has_submitted_buffer())
@@ -59,6 +61,7 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD1(release_client_buffer, void(graphics::Buffer*));
     MOCK_METHOD1(lock_compositor_buffer,
                  std::shared_ptr<graphics::Buffer>(void const*));
+    MOCK_METHOD0(snapshot_acquire, std::shared_ptr<graphics::Buffer>());
     MOCK_METHOD1(set_frame_posted_callback, void(std::function<void(geometry::Size const&)> const&));
 
     MOCK_METHOD0(get_stream_pixel_format, MirPixelFormat());
@@ -72,9 +75,11 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD0(drop_client_requests, void());
 
     MOCK_METHOD1(submit_buffer, void(std::shared_ptr<graphics::Buffer> const&));
+    MOCK_METHOD2(submit_buffer_at, void(std::shared_ptr<graphics::Buffer> const&, time::Timestamp));
     MOCK_METHOD1(with_most_recent_buffer_do, void(std::function<void(graphics::Buffer&)> const&));
     MOCK_CONST_METHOD0(pixel_format, MirPixelFormat());
     MOCK_CONST_METHOD0(has_submitted_buffer, bool());
+    MOCK_CONST_METHOD1(content_serial, uint64_t(graphics::Buffer const&));
     MOCK_METHOD1(disassociate_buffer, void(graphics::BufferID));
     MOCK_METHOD1(associate_buffer, void(graphics::BufferID));
     MOCK_METHOD1(set_scale, void(float));
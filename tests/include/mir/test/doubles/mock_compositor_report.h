@@ -46,6 +46,8 @@ public:
     MOCK_METHOD0(started, void());
     MOCK_METHOD0(stopped, void());
     MOCK_METHOD0(scheduled, void());
+    MOCK_METHOD5(texture_cache_usage,
+                 void(compositor::CompositorReport::SubCompositorId, size_t, size_t, size_t, size_t));
 };
 
 } // namespace doubles
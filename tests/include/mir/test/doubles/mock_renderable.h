@@ -55,6 +55,8 @@ struct MockRenderable : public graphics::Renderable
     MOCK_CONST_METHOD0(transformation, glm::mat4());
     MOCK_CONST_METHOD0(visible, bool());
     MOCK_CONST_METHOD0(shaped, bool());
+    MOCK_CONST_METHOD0(opaque_region, std::vector<geometry::Rectangle>());
+    MOCK_CONST_METHOD0(content_serial, uint64_t());
     MOCK_CONST_METHOD0(swap_interval, unsigned int());
 };
 }
@@ -20,6 +20,7 @@
 #define MIR_TEST_DOUBLES_MOCK_SCREENCAST_H_
 
 #include "mir/frontend/screencast.h"
+#include "mir/geometry/region.h"
 
 #include <gmock/gmock.h>
 
@@ -45,6 +46,7 @@ public:
                  std::shared_ptr<graphics::Buffer>(
                      frontend::ScreencastSessionId));
     MOCK_METHOD2(capture, void(frontend::ScreencastSessionId, std::shared_ptr<graphics::Buffer> const&));
+    MOCK_METHOD1(last_capture_damage, geometry::Region(frontend::ScreencastSessionId));
 };
 
 }
@@ -20,6 +20,7 @@
 #define MIR_TEST_DOUBLES_NULL_SCREENCAST_H_
 
 #include "mir/frontend/screencast.h"
+#include "mir/geometry/region.h"
 
 namespace mir
 {
@@ -48,6 +49,11 @@ public:
         return nullptr;
     }
     void capture(frontend::ScreencastSessionId, std::shared_ptr<graphics::Buffer> const&) {}
+
+    geometry::Region last_capture_damage(frontend::ScreencastSessionId)
+    {
+        return {};
+    }
 };
 
 }
@@ -46,6 +46,11 @@ public:
         return stub_compositor_buffer;
     }
 
+    std::shared_ptr<graphics::Buffer> snapshot_acquire() override
+    {
+        return stub_compositor_buffer;
+    }
+
     geometry::Size stream_size() override
     {
         return geometry::Size();
@@ -65,6 +70,10 @@ public:
     {
         if (b) ++nready;
     }
+    void submit_buffer_at(std::shared_ptr<graphics::Buffer> const& b, time::Timestamp) override
+    {
+        submit_buffer(b);
+    }
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& fn) override
     {
         fn(*stub_compositor_buffer);
@@ -72,6 +81,7 @@ public:
     MirPixelFormat pixel_format() const override { return mir_pixel_format_abgr_8888; }
     void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
     bool has_submitted_buffer() const override { return true; }
+    uint64_t content_serial(graphics::Buffer const&) const override { return 0; }
     void set_scale(float) override {}
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
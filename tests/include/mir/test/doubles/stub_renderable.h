@@ -90,6 +90,14 @@ public:
     {
         return false;
     }
+    std::vector<geometry::Rectangle> opaque_region() const override
+    {
+        return {};
+    }
+    uint64_t content_serial() const override
+    {
+        return 0;
+    }
     unsigned int swap_interval() const override
     {
         return 1;
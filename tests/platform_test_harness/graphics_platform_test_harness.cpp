@@ -496,6 +496,16 @@ void basic_software_buffer_drawing(
             return mg::contains_alpha(buffer_->pixel_format());
         }
 
+        auto opaque_region() const -> std::vector<mir::geometry::Rectangle> override
+        {
+            return {};
+        }
+
+        auto content_serial() const -> uint64_t override
+        {
+            return 0;
+        }
+
         auto clip_area() const -> std::experimental::optional<mir::geometry::Rectangle> override
         {
             return std::experimental::optional<mir::geometry::Rectangle>{};
@@ -17,6 +17,7 @@
  */
 
 #include "src/server/compositor/compositing_screencast.h"
+#include "src/server/compositor/output_frame_taps.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/scene.h"
@@ -24,17 +25,23 @@
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/geometry/rectangles.h"
+#include "mir/geometry/region.h"
 #include "mir/renderer/gl/render_target.h"
+#include "mir/scene/observer.h"
+#include "mir/scene/surface_observer.h"
 
 #include "mir/test/doubles/null_display.h"
 #include "mir/test/doubles/null_display_buffer_compositor_factory.h"
 #include "mir/test/doubles/stub_display_configuration.h"
 #include "mir/test/doubles/stub_gl_buffer_allocator.h"
 #include "mir/test/doubles/mock_buffer.h"
+#include "mir/test/doubles/mock_display_buffer.h"
+#include "mir/test/doubles/mock_egl.h"
 #include "mir/test/doubles/mock_gl.h"
 #include "mir/test/doubles/stub_scene.h"
 #include "mir/test/doubles/stub_scene_element.h"
 #include "mir/test/doubles/mock_scene.h"
+#include "mir/test/doubles/mock_surface.h"
 
 #include "mir/test/as_render_target.h"
 #include "mir/test/fake_shared.h"
@@ -48,6 +55,7 @@
 
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
+namespace ms = mir::scene;
 namespace mf = mir::frontend;
 namespace mtd = mir::test::doubles;
 namespace mt = mir::test;
@@ -494,8 +502,12 @@ TEST_F(CompositingScreencastTest, uses_requested_number_of_buffers)
         .WillOnce(Return(mt::fake_shared(buffers[2])))
         .WillOnce(Return(mt::fake_shared(buffers[3])));
 
+    NiceMock<mtd::MockScene> mock_scene;
+    std::shared_ptr<ms::Observer> observer;
+    ON_CALL(mock_scene, add_observer(_)).WillByDefault(SaveArg<0>(&observer));
+
     mc::CompositingScreencast screencast_local{
-        mt::fake_shared(stub_scene),
+        mt::fake_shared(mock_scene),
         mt::fake_shared(stub_display),
         mt::fake_shared(mock_buffer_allocator),
         mt::fake_shared(stub_db_compositor_factory)};
@@ -508,7 +520,235 @@ TEST_F(CompositingScreencastTest, uses_requested_number_of_buffers)
     {
         auto buffer = screencast_local.capture(session_id);
         ASSERT_EQ(&buffers[i], buffer.get());
+        observer->scene_changed();
     }
 }
 
+namespace
+{
+struct DamageTrackingScreencast : CompositingScreencastTest
+{
+    DamageTrackingScreencast()
+    {
+        using namespace testing;
+        ON_CALL(mock_scene, add_observer(_)).WillByDefault(SaveArg<0>(&observer));
+        ON_CALL(*surface, add_observer(_)).WillByDefault(SaveArg<0>(&surface_observer));
+    }
+
+    // At the origin, so only partly inside the capture region
+    std::shared_ptr<testing::NiceMock<mtd::MockSurface>> const surface{
+        std::make_shared<testing::NiceMock<mtd::MockSurface>>()};
+    std::shared_ptr<ms::SurfaceObserver> surface_observer;
+    geom::Rectangle const region{{100, 100}, {400, 200}};
+    geom::Size const size{200, 100};
+    testing::NiceMock<mtd::MockScene> mock_scene;
+    MockDisplayBufferCompositorFactory mock_db_compositor_factory;
+    std::shared_ptr<ms::Observer> observer;
+    mc::CompositingScreencast screencast_local{
+        mt::fake_shared(mock_scene),
+        mt::fake_shared(stub_display),
+        mt::fake_shared(stub_buffer_allocator),
+        mt::fake_shared(mock_db_compositor_factory)};
+};
+}
+
+TEST_F(DamageTrackingScreencast, does_not_recomposite_when_nothing_has_changed)
+{
+    using namespace testing;
+
+    auto session_id = screencast_local.create_session(region, size, default_pixel_format, 2, default_mirror_mode);
+
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(1);
+
+    auto const first = screencast_local.capture(session_id);
+    auto const second = screencast_local.capture(session_id);
+
+    EXPECT_THAT(second, Eq(first));
+    EXPECT_TRUE(screencast_local.last_capture_damage(session_id).empty());
+}
+
+TEST_F(DamageTrackingScreencast, recomposites_after_scene_changes)
+{
+    using namespace testing;
+
+    auto session_id = screencast_local.create_session(region, size, default_pixel_format, 2, default_mirror_mode);
+
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(2);
+
+    screencast_local.capture(session_id);
+    observer->scene_changed();
+    screencast_local.capture(session_id);
+
+    EXPECT_THAT(screencast_local.last_capture_damage(session_id), Eq(geom::Region{{{0, 0}, size}}));
+}
+
+TEST_F(DamageTrackingScreencast, recomposites_while_frames_are_pending)
+{
+    using namespace testing;
+
+    auto session_id = screencast_local.create_session(region, size, default_pixel_format, 2, default_mirror_mode);
 
+    EXPECT_CALL(mock_scene, frames_pending(_)).WillOnce(Return(1)).WillRepeatedly(Return(0));
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(2);
+
+    screencast_local.capture(session_id);
+    screencast_local.capture(session_id);
+    screencast_local.capture(session_id);
+}
+
+TEST_F(DamageTrackingScreencast, reports_surface_damage_in_buffer_coordinates)
+{
+    using namespace testing;
+
+    auto session_id = screencast_local.create_session(region, size, default_pixel_format, 2, default_mirror_mode);
+    observer->surface_added(surface);
+    screencast_local.capture(session_id);
+
+    surface_observer->frame_posted(surface.get(), 1, {150, 120});
+    screencast_local.capture(session_id);
+
+    EXPECT_THAT(screencast_local.last_capture_damage(session_id), Eq(geom::Region{{{0, 0}, {25, 10}}}));
+}
+
+TEST_F(DamageTrackingScreencast, ignores_damage_outside_the_capture_region)
+{
+    using namespace testing;
+
+    auto session_id = screencast_local.create_session(region, size, default_pixel_format, 2, default_mirror_mode);
+    observer->surface_added(surface);
+
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(1);
+
+    screencast_local.capture(session_id);
+    surface_observer->frame_posted(surface.get(), 1, {100, 100});
+    screencast_local.capture(session_id);
+}
+
+TEST_F(DamageTrackingScreencast, redraws_only_client_buffers_that_are_out_of_date)
+{
+    using namespace testing;
+
+    auto const buffer1 = std::make_shared<mtd::StubGLBuffer>(size);
+    auto const buffer2 = std::make_shared<mtd::StubGLBuffer>(size);
+    auto session_id = screencast_local.create_session(region, size, default_pixel_format, 0, default_mirror_mode);
+
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(3);
+
+    screencast_local.capture(session_id, buffer1);
+    screencast_local.capture(session_id, buffer2);
+    screencast_local.capture(session_id, buffer1);
+    screencast_local.capture(session_id, buffer2);
+
+    observer->scene_changed();
+    screencast_local.capture(session_id, buffer1);
+    EXPECT_FALSE(screencast_local.last_capture_damage(session_id).empty());
+}
+
+namespace
+{
+struct OutputTappingScreencast : CompositingScreencastTest
+{
+    OutputTappingScreencast()
+    {
+        using namespace testing;
+        ON_CALL(output, view_area()).WillByDefault(Return(output_area));
+        ON_CALL(output, transformation()).WillByDefault(Return(glm::mat2(1)));
+        ON_CALL(mock_gl, glGetIntegerv(GL_VIEWPORT, _))
+            .WillByDefault(Invoke([](GLenum, GLint* viewport)
+                {
+                    GLint const full_output[]{0, 0, 640, 480};
+                    std::copy(full_output, full_output + 4, viewport);
+                }));
+    }
+
+    geom::Rectangle const output_area{{1920, 0}, {640, 480}};
+    testing::NiceMock<mtd::MockEGL> mock_egl;
+    testing::NiceMock<mtd::MockDisplayBuffer> output;
+    std::shared_ptr<mc::OutputFrameTaps> const taps{std::make_shared<mc::OutputFrameTaps>()};
+    MockDisplayBufferCompositorFactory mock_db_compositor_factory;
+    mc::CompositingScreencast screencast_local{
+        mt::fake_shared(stub_scene),
+        mt::fake_shared(stub_display),
+        mt::fake_shared(stub_buffer_allocator),
+        mt::fake_shared(mock_db_compositor_factory),
+        taps};
+};
+}
+
+TEST_F(OutputTappingScreencast, captures_copied_output_frame_without_compositing)
+{
+    using namespace testing;
+
+    auto session_id = screencast_local.create_session(
+        output_area, output_area.size, default_pixel_format, 2, mir_mirror_mode_none);
+
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, 640, 480));
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(0);
+
+    taps->frame_rendered(output);
+    auto const buffer = screencast_local.capture(session_id);
+
+    EXPECT_THAT(buffer, NotNull());
+    EXPECT_THAT(screencast_local.last_capture_damage(session_id), Eq(geom::Region{{{0, 0}, output_area.size}}));
+}
+
+TEST_F(OutputTappingScreencast, waits_for_output_frame_copy_before_returning_it)
+{
+    using namespace testing;
+
+    auto const fence = reinterpret_cast<EGLSyncKHR>(0x5eed);
+    ON_CALL(mock_egl, eglCreateSyncKHR(_, _, _)).WillByDefault(Return(fence));
+
+    auto session_id = screencast_local.create_session(
+        output_area, output_area.size, default_pixel_format, 2, mir_mirror_mode_none);
+
+    taps->frame_rendered(output);
+
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, fence, _, _));
+    screencast_local.capture(session_id);
+}
+
+TEST_F(OutputTappingScreencast, reuses_buffers_the_output_hands_back)
+{
+    using namespace testing;
+
+    screencast_local.create_session(
+        output_area, output_area.size, default_pixel_format, 2, mir_mirror_mode_none);
+
+    // Each copied frame replaces the last, which is free for the next
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(_, _, _, _, _, _, _, _)).Times(4);
+
+    for (auto i = 0; i != 4; ++i)
+        taps->frame_rendered(output);
+}
+
+TEST_F(OutputTappingScreencast, composites_when_output_frame_was_missed)
+{
+    using namespace testing;
+
+    auto session_id = screencast_local.create_session(
+        output_area, output_area.size, default_pixel_format, 2, mir_mirror_mode_none);
+    screencast_local.capture(session_id);
+
+    ON_CALL(output, transformation()).WillByDefault(Return(glm::mat2(0, 1, -1, 0)));
+
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(_, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(1);
+
+    taps->frame_rendered(output);
+    screencast_local.capture(session_id);
+}
+
+TEST_F(OutputTappingScreencast, mirrored_sessions_do_not_tap_the_output)
+{
+    using namespace testing;
+
+    auto session_id = screencast_local.create_session(
+        output_area, output_area.size, default_pixel_format, 2, mir_mirror_mode_vertical);
+
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(_, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_db_compositor_factory.mock_db_compositor, composite_(_)).Times(1);
+
+    taps->frame_rendered(output);
+    screencast_local.capture(session_id);
+}
@@ -21,8 +21,13 @@
 #include "mir/test/doubles/stub_buffer_allocator.h"
 #include "src/server/compositor/multi_monitor_arbiter.h"
 #include "src/server/compositor/schedule.h"
+#include "src/server/compositor/queueing_schedule.h"
 
 #include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
 using namespace testing;
 namespace mt = mir::test;
 namespace mtd = mir::test::doubles;
@@ -661,3 +666,39 @@ TEST_F(MultiMonitorArbiter, second_compositor_advances_schedule_after_both_aquir
     auto cbuffer4 = arbiter.compositor_acquire(&comp_id2);
     EXPECT_THAT(cbuffer1, Not(IsSameBufferAs(cbuffer4)));
 }
+
+TEST_F(MultiMonitorArbiter, compositors_see_the_last_buffer_when_racing_the_producer)
+{
+    auto const queue = std::make_shared<mc::QueueingSchedule>();
+    mc::MultiMonitorArbiter arbiter{queue};
+
+    int const num_compositors{4};
+    std::atomic<bool> done{false};
+    std::vector<std::shared_ptr<mg::Buffer>> last_acquired(num_compositors);
+
+    std::vector<std::thread> compositors;
+    for (auto i = 0; i != num_compositors; ++i)
+    {
+        compositors.emplace_back(
+            [&, i]
+            {
+                auto const id = &last_acquired[i];
+                while (!done || arbiter.buffer_ready_for(id))
+                {
+                    if (arbiter.buffer_ready_for(id))
+                        last_acquired[i] = arbiter.compositor_acquire(id);
+                    else
+                        std::this_thread::yield();
+                }
+            });
+    }
+
+    for (auto i = 0; i != 10000; ++i)
+        queue->schedule(buffers[i % num_buffers]);
+    done = true;
+
+    for (auto& compositor : compositors)
+        compositor.join();
+
+    EXPECT_THAT(last_acquired, Each(IsSameBufferAs(buffers[9999 % num_buffers])));
+}
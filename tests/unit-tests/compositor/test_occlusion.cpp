@@ -125,6 +125,64 @@ TEST_F(OcclusionFilterTest, shaped_window_occludes_nothing)
     EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
 }
 
+TEST_F(OcclusionFilterTest, shaped_window_occludes_what_is_below_its_opaque_region)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {10, 10}}, 1.0f, false);
+    top->set_opaque_region({{{11, 11}, {8, 8}}});
+    auto covered = std::make_shared<mtd::FakeRenderable>(12, 12, 5, 5);
+    auto uncovered = std::make_shared<mtd::FakeRenderable>(10, 10, 5, 5);
+    auto elements = scene_elements_from({uncovered, covered, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(covered));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(uncovered, top));
+}
+
+TEST_F(OcclusionFilterTest, translucent_shaped_window_ignores_its_opaque_region)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {10, 10}}, 0.5f, false);
+    top->set_opaque_region({{{10, 10}, {10, 10}}});
+    auto bottom = std::make_shared<mtd::FakeRenderable>(12, 12, 5, 5);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
+
+TEST_F(OcclusionFilterTest, window_covered_by_several_windows_together_is_occluded)
+{
+    auto left = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 200);
+    auto right = std::make_shared<mtd::FakeRenderable>(100, 0, 100, 200);
+    auto bottom = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto elements = scene_elements_from({bottom, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
+TEST_F(OcclusionFilterTest, partially_covered_window_is_clipped_to_its_visible_part)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 200);
+    auto bottom = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    ASSERT_THAT(elements.size(), Eq(2u));
+    EXPECT_THAT(elements[1]->renderable(), Eq(top));
+
+    auto const clipped = elements[0]->renderable();
+    EXPECT_THAT(clipped->id(), Eq(bottom->id()));
+    EXPECT_THAT(clipped->screen_position(), Eq(bottom->screen_position()));
+    EXPECT_THAT(clipped->clip_area(), Eq(std::experimental::make_optional(Rectangle{{100, 50}, {50, 100}})));
+}
+
 TEST_F(OcclusionFilterTest, identical_window_occluded)
 {
     auto top = std::make_shared<mtd::FakeRenderable>(10, 10, 10, 10);
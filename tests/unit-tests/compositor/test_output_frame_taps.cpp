@@ -0,0 +1,222 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/output_frame_taps.h"
+#include "mir/compositor/display_buffer_compositor.h"
+#include "mir/graphics/transformation.h"
+
+#include "mir/test/doubles/mock_egl.h"
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_gl_display_buffer.h"
+#include "mir/test/doubles/mock_display_buffer.h"
+#include "mir/test/doubles/stub_gl_buffer.h"
+#include "mir/test/as_render_target.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct MockFrameTap : mc::FrameTap
+{
+    MOCK_CONST_METHOD0(tapped_area, geom::Rectangle());
+    MOCK_METHOD0(acquire_frame_buffer, std::shared_ptr<mg::Buffer>());
+    MOCK_METHOD2(release_frame_buffer, void(std::shared_ptr<mg::Buffer> const&, std::shared_ptr<mc::FrameCopy> const&));
+    MOCK_METHOD0(frame_missed, void());
+};
+
+struct StubDisplayBufferCompositor : mc::DisplayBufferCompositor
+{
+    void composite(mc::SceneElementSequence&&) override {}
+};
+
+/// Remembers the display buffer it was last asked to make a compositor for
+struct RecordingDisplayBufferCompositorFactory : mc::DisplayBufferCompositorFactory
+{
+    std::unique_ptr<mc::DisplayBufferCompositor> create_compositor_for(mg::DisplayBuffer& db) override
+    {
+        display_buffer = &db;
+        return std::make_unique<StubDisplayBufferCompositor>();
+    }
+
+    mg::DisplayBuffer* display_buffer{nullptr};
+};
+
+struct OutputFrameTaps : Test
+{
+    OutputFrameTaps()
+    {
+        ON_CALL(output, view_area()).WillByDefault(Return(output_area));
+        ON_CALL(output, transformation()).WillByDefault(Return(mg::transformation(mir_orientation_normal)));
+        ON_CALL(mock_gl, glGetIntegerv(GL_VIEWPORT, _))
+            .WillByDefault(Invoke([this](GLenum, GLint* viewport) { std::copy(viewport_, viewport_ + 4, viewport); }));
+        ON_CALL(*tap, tapped_area()).WillByDefault(Return(output_area));
+
+        taps->add(tap);
+        compositor = factory.create_compositor_for(output);
+    }
+
+    void render_frame()
+    {
+        mt::as_render_target(*wrapped_factory->display_buffer)->swap_buffers();
+    }
+
+    geom::Rectangle const output_area{{1920, 0}, {640, 480}};
+    GLint viewport_[4]{0, 0, 640, 480};
+    NiceMock<mtd::MockEGL> mock_egl;
+    NiceMock<mtd::MockGL> mock_gl;
+    NiceMock<mtd::MockGLDisplayBuffer> output;
+    std::shared_ptr<NiceMock<MockFrameTap>> const tap{std::make_shared<NiceMock<MockFrameTap>>()};
+    std::shared_ptr<mc::OutputFrameTaps> const taps{std::make_shared<mc::OutputFrameTaps>()};
+    std::shared_ptr<RecordingDisplayBufferCompositorFactory> const wrapped_factory{
+        std::make_shared<RecordingDisplayBufferCompositorFactory>()};
+    mc::TappingDisplayBufferCompositorFactory factory{wrapped_factory, taps};
+    std::unique_ptr<mc::DisplayBufferCompositor> compositor;
+};
+}
+
+TEST_F(OutputFrameTaps, wrapped_display_buffer_matches_the_output)
+{
+    ASSERT_THAT(wrapped_factory->display_buffer, NotNull());
+    EXPECT_THAT(wrapped_factory->display_buffer, Ne(&output));
+    EXPECT_THAT(wrapped_factory->display_buffer->view_area(), Eq(output_area));
+}
+
+TEST_F(OutputFrameTaps, copies_frame_before_it_is_posted)
+{
+    auto const buffer = std::make_shared<mtd::StubGLBuffer>(output_area.size);
+    EXPECT_CALL(*tap, acquire_frame_buffer()).WillOnce(Return(buffer));
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, 640, 480));
+    EXPECT_CALL(*tap, release_frame_buffer(Eq(buffer), NotNull()));
+    EXPECT_CALL(output, swap_buffers());
+
+    render_frame();
+}
+
+TEST_F(OutputFrameTaps, copy_is_fenced_for_the_tap_to_wait_on)
+{
+    auto const buffer = std::make_shared<mtd::StubGLBuffer>(output_area.size);
+    auto const fence = reinterpret_cast<EGLSyncKHR>(0x5eed);
+    std::shared_ptr<mc::FrameCopy> copy;
+
+    EXPECT_CALL(*tap, acquire_frame_buffer()).WillOnce(Return(buffer));
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _)).WillOnce(Return(fence));
+    EXPECT_CALL(mock_gl, glFlush());
+    EXPECT_CALL(mock_gl, glFinish()).Times(0);
+    EXPECT_CALL(*tap, release_frame_buffer(Eq(buffer), _)).WillOnce(SaveArg<1>(&copy));
+
+    render_frame();
+    ASSERT_THAT(copy, NotNull());
+
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, fence, _, EGL_FOREVER_KHR));
+    copy->wait();
+
+    EXPECT_CALL(mock_egl, eglDestroySyncKHR(_, fence));
+    copy.reset();
+}
+
+TEST_F(OutputFrameTaps, copy_is_finished_if_it_cannot_be_fenced)
+{
+    auto const buffer = std::make_shared<mtd::StubGLBuffer>(output_area.size);
+    EXPECT_CALL(*tap, acquire_frame_buffer()).WillOnce(Return(buffer));
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, _, _)).WillOnce(Return(EGL_NO_SYNC_KHR));
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glFinish());
+    EXPECT_CALL(*tap, release_frame_buffer(Eq(buffer), NotNull()));
+
+    render_frame();
+}
+
+TEST_F(OutputFrameTaps, does_not_offer_frames_of_other_outputs)
+{
+    ON_CALL(*tap, tapped_area()).WillByDefault(Return(geom::Rectangle{{0, 0}, {640, 480}}));
+
+    EXPECT_CALL(*tap, acquire_frame_buffer()).Times(0);
+    EXPECT_CALL(*tap, frame_missed()).Times(0);
+    EXPECT_CALL(output, swap_buffers());
+
+    render_frame();
+}
+
+TEST_F(OutputFrameTaps, scaled_frames_are_missed)
+{
+    viewport_[2] = 1280;
+    viewport_[3] = 960;
+
+    EXPECT_CALL(*tap, acquire_frame_buffer()).Times(0);
+    EXPECT_CALL(*tap, frame_missed());
+
+    render_frame();
+}
+
+TEST_F(OutputFrameTaps, transformed_frames_are_missed)
+{
+    ON_CALL(output, transformation()).WillByDefault(Return(mg::transformation(mir_orientation_left)));
+
+    EXPECT_CALL(*tap, acquire_frame_buffer()).Times(0);
+    EXPECT_CALL(*tap, frame_missed());
+
+    render_frame();
+}
+
+TEST_F(OutputFrameTaps, frame_is_missed_when_tap_has_no_buffer)
+{
+    EXPECT_CALL(*tap, acquire_frame_buffer()).WillOnce(Return(nullptr));
+    EXPECT_CALL(*tap, frame_missed());
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(_, _, _, _, _, _, _, _)).Times(0);
+
+    render_frame();
+}
+
+TEST_F(OutputFrameTaps, buffer_is_handed_back_uncopied_if_copying_fails)
+{
+    auto const buffer = std::make_shared<mtd::StubGLBuffer>(output_area.size);
+    EXPECT_CALL(*tap, acquire_frame_buffer()).WillOnce(Return(buffer));
+    EXPECT_CALL(mock_gl, glGetError()).WillRepeatedly(Return(GL_INVALID_OPERATION));
+    EXPECT_CALL(*tap, release_frame_buffer(Eq(buffer), IsNull()));
+
+    render_frame();
+}
+
+TEST_F(OutputFrameTaps, removed_tap_is_not_called)
+{
+    taps->remove(tap);
+
+    EXPECT_CALL(*tap, tapped_area()).Times(0);
+    EXPECT_CALL(*tap, acquire_frame_buffer()).Times(0);
+
+    render_frame();
+}
+
+TEST_F(OutputFrameTaps, display_buffers_without_gl_are_not_wrapped)
+{
+    NiceMock<mtd::MockDisplayBuffer> non_gl_output;
+
+    factory.create_compositor_for(non_gl_output);
+
+    EXPECT_THAT(wrapped_factory->display_buffer, Eq(&non_gl_output));
+}
@@ -19,6 +19,7 @@
 #include "mir/test/doubles/stub_buffer.h"
 #include "mir/test/doubles/stub_buffer_allocator.h"
 #include "mir/test/doubles/mock_event_sink.h"
+#include "mir/test/doubles/advanceable_clock.h"
 #include "mir/test/fake_shared.h"
 #include "src/server/compositor/stream.h"
 #include "mir/scene/null_surface_observer.h"
@@ -27,6 +28,7 @@
 #include <gtest/gtest.h>
 #include "mir/test/gmock_fixes.h"
 using namespace testing;
+using namespace std::chrono_literals;
 namespace mf = mir::frontend;
 namespace mt = mir::test;
 namespace mtd = mir::test::doubles;
@@ -135,6 +137,23 @@ TEST_F(Stream, tracks_has_buffer)
     EXPECT_TRUE(stream.has_submitted_buffer());
 }
 
+TEST_F(Stream, content_serial_changes_each_time_a_buffer_is_submitted)
+{
+    EXPECT_THAT(stream.content_serial(*buffers[0]), Eq(0u));
+
+    stream.submit_buffer(buffers[0]);
+    auto const first = stream.content_serial(*buffers[0]);
+    EXPECT_THAT(first, Ne(0u));
+
+    stream.submit_buffer(buffers[1]);
+    EXPECT_THAT(stream.content_serial(*buffers[0]), Eq(first));
+
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(this);
+    stream.submit_buffer(buffers[0]);
+    EXPECT_THAT(stream.content_serial(*buffers[0]), Ne(first));
+}
+
 TEST_F(Stream, calls_frame_callback_after_scheduling_on_submissions)
 {
     int frame_count{0};
@@ -227,3 +246,36 @@ TEST_F(Stream, returns_buffers_to_client_when_told_to_bring_queue_up_to_date)
     EXPECT_THAT(buffers[1].use_count(), Eq(1));
     EXPECT_THAT(buffers[2].use_count(), Eq(2));
 }
+
+TEST_F(Stream, holds_timed_buffers_until_they_are_due)
+{
+    auto const clock = std::make_shared<mtd::AdvanceableClock>();
+    mc::Stream timed_stream{initial_size, construction_format, clock, nullptr};
+    int frames_posted{0};
+    timed_stream.set_frame_posted_callback([&](auto) { ++frames_posted; });
+
+    timed_stream.submit_buffer_at(buffers[0], clock->now() + 100ms);
+    timed_stream.submit_buffer_at(buffers[1], clock->now() + 200ms);
+
+    EXPECT_THAT(timed_stream.buffers_ready_for_compositor(this), Eq(0));
+    EXPECT_THAT(frames_posted, Eq(0));
+
+    clock->advance_by(200ms);
+    ASSERT_THAT(timed_stream.buffers_ready_for_compositor(this), Eq(1));
+    EXPECT_THAT(timed_stream.lock_compositor_buffer(this), Eq(buffers[1]));
+    EXPECT_TRUE(buffers[0].unique());
+}
+
+TEST_F(Stream, untimed_submission_releases_buffers_held_for_later)
+{
+    auto const clock = std::make_shared<mtd::AdvanceableClock>();
+    mc::Stream timed_stream{initial_size, construction_format, clock, nullptr};
+
+    timed_stream.submit_buffer_at(buffers[0], clock->now() + 100ms);
+    timed_stream.submit_buffer(buffers[1]);
+
+    std::vector<std::shared_ptr<mg::Buffer>> cbuffers;
+    while(timed_stream.buffers_ready_for_compositor(this))
+        cbuffers.push_back(timed_stream.lock_compositor_buffer(this));
+    EXPECT_THAT(cbuffers, ElementsAre(buffers[0], buffers[1]));
+}
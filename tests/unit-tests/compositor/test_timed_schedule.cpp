@@ -0,0 +1,148 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/timed_schedule.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+namespace mtd = mir::test::doubles;
+namespace mg = mir::graphics;
+namespace mc = mir::compositor;
+namespace
+{
+
+struct TimedSchedule : Test
+{
+    TimedSchedule()
+    {
+        for(auto i = 0u; i < num_buffers; i++)
+            buffers.emplace_back(std::make_shared<mtd::StubBuffer>());
+    }
+    unsigned int const num_buffers{5};
+    std::vector<std::shared_ptr<mg::Buffer>> buffers;
+
+    std::chrono::milliseconds const lead{16};
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    mc::TimedSchedule schedule{clock, lead};
+    std::vector<std::shared_ptr<mg::Buffer>> drain_queue()
+    {
+        std::vector<std::shared_ptr<mg::Buffer>> scheduled_buffers;
+        while(schedule.num_scheduled())
+            scheduled_buffers.emplace_back(schedule.next_buffer());
+        return scheduled_buffers;
+    }
+};
+}
+
+TEST_F(TimedSchedule, throws_if_no_buffers)
+{
+    EXPECT_FALSE(schedule.num_scheduled());
+    EXPECT_THROW({
+        schedule.next_buffer();
+    }, std::logic_error);
+}
+
+TEST_F(TimedSchedule, buffer_without_target_is_due_immediately)
+{
+    schedule.schedule(buffers[0]);
+
+    EXPECT_THAT(drain_queue(), ElementsAre(buffers[0]));
+}
+
+TEST_F(TimedSchedule, buffer_is_not_due_until_within_lead_of_its_target)
+{
+    schedule.schedule(buffers[0], clock->now() + 100ms);
+
+    EXPECT_FALSE(schedule.num_scheduled());
+    EXPECT_THROW({
+        schedule.next_buffer();
+    }, std::logic_error);
+
+    clock->advance_by(100ms - lead - 1ms);
+    EXPECT_FALSE(schedule.num_scheduled());
+
+    clock->advance_by(1ms);
+    EXPECT_THAT(drain_queue(), ElementsAre(buffers[0]));
+}
+
+TEST_F(TimedSchedule, gives_latest_due_buffer_and_drops_earlier_ones)
+{
+    auto const start = clock->now();
+    for(auto i = 0u; i < num_buffers; i++)
+        schedule.schedule(buffers[i], start + i * 50ms);
+
+    clock->advance_by(100ms);
+
+    EXPECT_THAT(drain_queue(), ElementsAre(buffers[2]));
+    EXPECT_TRUE(buffers[0].unique());
+    EXPECT_TRUE(buffers[1].unique());
+    EXPECT_FALSE(buffers[3].unique());
+}
+
+TEST_F(TimedSchedule, orders_buffers_by_target_not_submission)
+{
+    auto const start = clock->now();
+    schedule.schedule(buffers[0], start + 100ms);
+    schedule.schedule(buffers[1], start + 50ms);
+
+    clock->advance_by(50ms);
+    EXPECT_THAT(drain_queue(), ElementsAre(buffers[1]));
+
+    clock->advance_by(50ms);
+    EXPECT_THAT(drain_queue(), ElementsAre(buffers[0]));
+}
+
+TEST_F(TimedSchedule, rescheduling_a_buffer_replaces_its_target)
+{
+    auto const start = clock->now();
+    schedule.schedule(buffers[0], start);
+    schedule.schedule(buffers[0], start + 100ms);
+
+    EXPECT_FALSE(schedule.num_scheduled());
+    EXPECT_THAT(schedule.take_all(), ElementsAre(buffers[0]));
+}
+
+TEST_F(TimedSchedule, next_due_time_is_when_the_earliest_pending_buffer_becomes_due)
+{
+    auto const start = clock->now();
+    EXPECT_FALSE(schedule.next_due_time().is_set());
+
+    schedule.schedule(buffers[0], start);
+    schedule.schedule(buffers[1], start + 100ms);
+    schedule.schedule(buffers[2], start + 200ms);
+
+    ASSERT_TRUE(schedule.next_due_time().is_set());
+    EXPECT_THAT(schedule.next_due_time().value(), Eq(start + 100ms - lead));
+
+    clock->advance_by(100ms);
+    ASSERT_TRUE(schedule.next_due_time().is_set());
+    EXPECT_THAT(schedule.next_due_time().value(), Eq(start + 200ms - lead));
+}
+
+TEST_F(TimedSchedule, take_all_includes_buffers_not_yet_due)
+{
+    auto const start = clock->now();
+    schedule.schedule(buffers[1], start + 100ms);
+    schedule.schedule(buffers[0], start);
+
+    EXPECT_THAT(schedule.take_all(), ElementsAre(buffers[0], buffers[1]));
+    EXPECT_FALSE(schedule.num_scheduled());
+    EXPECT_FALSE(schedule.next_due_time().is_set());
+}
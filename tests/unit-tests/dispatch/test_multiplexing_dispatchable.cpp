@@ -490,3 +490,71 @@ TEST(MultiplexingDispatchableTest, automatic_removals_are_threadsafe)
     
     dispatchee->trigger();
 }
+
+TEST(MultiplexingDispatchableTest, batching_dispatches_all_ready_dispatchees_at_once)
+{
+    int dispatched{0};
+    auto dispatchee_a = std::make_shared<mt::TestDispatchable>([&dispatched]() { ++dispatched; });
+    auto dispatchee_b = std::make_shared<mt::TestDispatchable>([&dispatched]() { ++dispatched; });
+    auto dispatchee_c = std::make_shared<mt::TestDispatchable>([&dispatched]() { ++dispatched; });
+
+    md::MultiplexingDispatchable dispatcher{4};
+    dispatcher.add_watch(dispatchee_a);
+    dispatcher.add_watch(dispatchee_b);
+    dispatcher.add_watch(dispatchee_c);
+
+    dispatchee_a->trigger();
+    dispatchee_b->trigger();
+    dispatchee_c->trigger();
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(3));
+    EXPECT_FALSE(mt::fd_is_readable(dispatcher.watch_fd()));
+}
+
+TEST(MultiplexingDispatchableTest, dispatchee_removed_earlier_in_batch_is_not_dispatched)
+{
+    md::MultiplexingDispatchable dispatcher{4};
+
+    int dispatched{0};
+    std::shared_ptr<mt::TestDispatchable> dispatchee_a, dispatchee_b;
+    dispatchee_a = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatched; dispatcher.remove_watch(dispatchee_b); });
+    dispatchee_b = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatched; dispatcher.remove_watch(dispatchee_a); });
+
+    dispatcher.add_watch(dispatchee_a);
+    dispatcher.add_watch(dispatchee_b);
+
+    dispatchee_a->trigger();
+    dispatchee_b->trigger();
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(1));
+}
+
+TEST(MultiplexingDispatchableTest, dispatchees_after_a_throwing_one_in_batch_are_dispatched_later)
+{
+    int dispatched{0};
+    auto throwing = [&dispatched]() { ++dispatched; throw std::runtime_error{"Dispatch failed"}; };
+    auto dispatchee_a = std::make_shared<mt::TestDispatchable>(throwing);
+    auto dispatchee_b = std::make_shared<mt::TestDispatchable>(throwing);
+
+    md::MultiplexingDispatchable dispatcher{4};
+    dispatcher.add_watch(dispatchee_a);
+    dispatcher.add_watch(dispatchee_b);
+
+    dispatchee_a->trigger();
+    dispatchee_b->trigger();
+
+    EXPECT_THROW(dispatcher.dispatch(md::FdEvent::readable), std::runtime_error);
+    EXPECT_THAT(dispatched, testing::Eq(1));
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    EXPECT_THROW(dispatcher.dispatch(md::FdEvent::readable), std::runtime_error);
+    EXPECT_THAT(dispatched, testing::Eq(2));
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/socket_connection.h"
+#include "src/server/frontend/message_receiver.h"
+#include "mir/frontend/message_processor.h"
+#include "mir/frontend/session_credentials.h"
+#include "mir/protobuf/protocol_version.h"
+#include "mir/fd.h"
+
+#include "mir_protobuf_wire.pb.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace mf = mir::frontend;
+namespace mfd = mir::frontend::detail;
+namespace ba = boost::asio;
+namespace bs = boost::system;
+
+using namespace testing;
+
+namespace
+{
+/// What arrives in one read: bytes, and any fds that came with them
+struct Chunk
+{
+    std::vector<char> bytes;
+    std::vector<mir::Fd> fds;
+};
+
+/// Hands the connection one chunk per read, or as much of it as fits
+struct ScriptedReceiver : mfd::MessageReceiver
+{
+    void async_wait_readable(MirReadableHandler const& handler) override
+    {
+        readable = handler;
+    }
+
+    size_t receive_available(ba::mutable_buffers_1 const& buffer, std::vector<mir::Fd>& fds, bs::error_code&) override
+    {
+        if (chunks.empty())
+            return 0;
+
+        auto& chunk = chunks.front();
+        auto const size = std::min(ba::buffer_size(buffer), chunk.bytes.size());
+        std::copy(chunk.bytes.begin(), chunk.bytes.begin() + size, ba::buffer_cast<char*>(buffer));
+        chunk.bytes.erase(chunk.bytes.begin(), chunk.bytes.begin() + size);
+
+        fds.insert(fds.end(), chunk.fds.begin(), chunk.fds.end());
+        chunk.fds.clear();
+
+        if (chunk.bytes.empty())
+            chunks.pop_front();
+
+        return size;
+    }
+
+    mf::SessionCredentials client_creds() override
+    {
+        return {getpid(), getuid(), getgid()};
+    }
+
+    std::deque<Chunk> chunks;
+    MirReadableHandler readable;
+};
+
+struct Dispatched
+{
+    uint32_t id;
+    std::string method_name;
+    std::string parameters;
+    std::vector<int> fds;
+};
+
+struct RecordingProcessor : mfd::MessageProcessor
+{
+    bool dispatch(mfd::Invocation const& invocation, std::vector<mir::Fd> const& side_channel_fds) override
+    {
+        std::vector<int> fds{side_channel_fds.begin(), side_channel_fds.end()};
+        dispatched.push_back({invocation.id(), invocation.method_name(), invocation.parameters(), fds});
+        return true;
+    }
+
+    void client_pid(int) override {}
+
+    std::vector<Dispatched> dispatched;
+};
+
+/// A framed message as a client sends it: any fds go with a byte of their own after it
+struct Message
+{
+    std::vector<char> framed;
+    std::vector<mir::Fd> fds;
+};
+
+auto message(uint32_t id, std::string const& method_name, std::string const& parameters, unsigned fd_count = 0)
+    -> Message
+{
+    mir::protobuf::wire::Invocation invocation;
+    invocation.set_id(id);
+    invocation.set_method_name(method_name);
+    invocation.set_parameters(parameters);
+    invocation.set_protocol_version(mir::protobuf::current_protocol_version());
+    if (fd_count)
+        invocation.set_side_channel_fds(fd_count);
+
+    auto const body = invocation.SerializeAsString();
+    Message result;
+    result.framed = {static_cast<char>(body.size() >> 8), static_cast<char>(body.size() & 0xff)};
+    result.framed.insert(result.framed.end(), body.begin(), body.end());
+
+    for (auto i = 0u; i != fd_count; ++i)
+        result.fds.push_back(mir::Fd{open("/dev/null", O_RDONLY | O_CLOEXEC)});
+
+    return result;
+}
+
+auto fd_numbers(Message const& message) -> std::vector<int>
+{
+    return {message.fds.begin(), message.fds.end()};
+}
+
+struct SocketConnection : Test
+{
+    SocketConnection()
+    {
+        connections->add(connection);
+        connection->read_next_message();
+    }
+
+    ~SocketConnection()
+    {
+        connections->clear();
+    }
+
+    /// Lets the connection read until it has consumed every chunk
+    void read_all()
+    {
+        while (!receiver->chunks.empty())
+        {
+            auto const readable = receiver->readable;
+            ASSERT_TRUE(readable);
+            receiver->readable = nullptr;
+            readable(bs::error_code{});
+        }
+    }
+
+    static void expect_dispatched(Dispatched const& dispatched, uint32_t id, std::string const& method_name)
+    {
+        EXPECT_THAT(dispatched.id, Eq(id));
+        EXPECT_THAT(dispatched.method_name, Eq(method_name));
+    }
+
+    std::shared_ptr<ScriptedReceiver> const receiver{std::make_shared<ScriptedReceiver>()};
+    std::shared_ptr<RecordingProcessor> const processor{std::make_shared<RecordingProcessor>()};
+    std::shared_ptr<mfd::Connections<mfd::SocketConnection>> const connections{
+        std::make_shared<mfd::Connections<mfd::SocketConnection>>()};
+    std::shared_ptr<mfd::SocketConnection> const connection{
+        std::make_shared<mfd::SocketConnection>(receiver, 1, connections, processor)};
+};
+}
+
+TEST_F(SocketConnection, dispatches_every_message_that_arrives_in_one_read)
+{
+    Chunk chunk;
+    for (auto const& m : {message(1, "first", "a"), message(2, "second", "bb"), message(3, "third", "ccc")})
+        chunk.bytes.insert(chunk.bytes.end(), m.framed.begin(), m.framed.end());
+    receiver->chunks.push_back(std::move(chunk));
+
+    read_all();
+
+    ASSERT_THAT(processor->dispatched.size(), Eq(3u));
+    expect_dispatched(processor->dispatched[0], 1, "first");
+    expect_dispatched(processor->dispatched[1], 2, "second");
+    expect_dispatched(processor->dispatched[2], 3, "third");
+    EXPECT_THAT(processor->dispatched[2].parameters, Eq("ccc"));
+}
+
+TEST_F(SocketConnection, waits_for_the_rest_of_a_header_split_across_reads)
+{
+    auto const first = message(1, "first", "a");
+    auto const second = message(2, "second", "b");
+
+    Chunk before_split;
+    before_split.bytes = first.framed;
+    before_split.bytes.push_back(second.framed.front());
+    receiver->chunks.push_back(std::move(before_split));
+
+    read_all();
+
+    ASSERT_THAT(processor->dispatched.size(), Eq(1u));
+    expect_dispatched(processor->dispatched[0], 1, "first");
+
+    receiver->chunks.push_back({{second.framed.begin() + 1, second.framed.end()}, {}});
+
+    read_all();
+
+    ASSERT_THAT(processor->dispatched.size(), Eq(2u));
+    expect_dispatched(processor->dispatched[1], 2, "second");
+}
+
+TEST_F(SocketConnection, reassembles_a_message_read_a_byte_at_a_time)
+{
+    auto const m = message(7, "dribbled", "parameters");
+    for (auto const byte : m.framed)
+        receiver->chunks.push_back({{byte}, {}});
+
+    read_all();
+
+    ASSERT_THAT(processor->dispatched.size(), Eq(1u));
+    expect_dispatched(processor->dispatched[0], 7, "dribbled");
+    EXPECT_THAT(processor->dispatched[0].parameters, Eq("parameters"));
+}
+
+TEST_F(SocketConnection, reassembles_a_message_larger_than_the_receive_buffer)
+{
+    std::string const parameters(40000, 'p');
+    receiver->chunks.push_back({message(1, "large", parameters).framed, {}});
+
+    read_all();
+
+    ASSERT_THAT(processor->dispatched.size(), Eq(1u));
+    EXPECT_THAT(processor->dispatched[0].parameters, Eq(parameters));
+}
+
+TEST_F(SocketConnection, passes_fds_to_the_messages_they_came_with)
+{
+    auto const plain = message(1, "plain", "");
+    auto const with_fd = message(2, "with_fd", "", 1);
+    auto const plain_again = message(3, "plain_again", "");
+    auto const with_fds = message(4, "with_fds", "", 2);
+
+    Chunk chunk{plain.framed, {}};
+    chunk.bytes.insert(chunk.bytes.end(), with_fd.framed.begin(), with_fd.framed.end());
+    receiver->chunks.push_back(std::move(chunk));
+
+    // The fds of both messages arrive in one read, each with its message's trailing byte
+    chunk = Chunk{{'M'}, with_fd.fds};
+    chunk.bytes.insert(chunk.bytes.end(), plain_again.framed.begin(), plain_again.framed.end());
+    chunk.bytes.insert(chunk.bytes.end(), with_fds.framed.begin(), with_fds.framed.end());
+    chunk.bytes.push_back('M');
+    chunk.fds.insert(chunk.fds.end(), with_fds.fds.begin(), with_fds.fds.end());
+    receiver->chunks.push_back(std::move(chunk));
+
+    read_all();
+
+    ASSERT_THAT(processor->dispatched.size(), Eq(4u));
+    EXPECT_THAT(processor->dispatched[0].fds, IsEmpty());
+    EXPECT_THAT(processor->dispatched[1].fds, Eq(fd_numbers(with_fd)));
+    EXPECT_THAT(processor->dispatched[2].fds, IsEmpty());
+    EXPECT_THAT(processor->dispatched[3].fds, Eq(fd_numbers(with_fds)));
+    expect_dispatched(processor->dispatched[3], 4, "with_fds");
+}
+
+TEST_F(SocketConnection, does_not_carry_fields_over_from_the_previous_message)
+{
+    auto const with_fd = message(1, "with_fd", "parameters", 1);
+    auto const without = message(2, "without", "");
+    auto const after = message(3, "after", "");
+
+    Chunk chunk{with_fd.framed, {}};
+    chunk.bytes.push_back('M');
+    chunk.fds = with_fd.fds;
+    chunk.bytes.insert(chunk.bytes.end(), without.framed.begin(), without.framed.end());
+    chunk.bytes.insert(chunk.bytes.end(), after.framed.begin(), after.framed.end());
+    receiver->chunks.push_back(std::move(chunk));
+
+    read_all();
+
+    // Were side_channel_fds carried over, "without" would be rejected for want of fds
+    ASSERT_THAT(processor->dispatched.size(), Eq(3u));
+    expect_dispatched(processor->dispatched[1], 2, "without");
+    EXPECT_THAT(processor->dispatched[1].parameters, IsEmpty());
+    EXPECT_THAT(processor->dispatched[1].fds, IsEmpty());
+    expect_dispatched(processor->dispatched[2], 3, "after");
+}
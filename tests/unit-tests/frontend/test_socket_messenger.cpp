@@ -0,0 +1,269 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/socket_messenger.h"
+#include "mir/fd.h"
+
+#include <boost/asio.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace mfd = mir::frontend::detail;
+namespace ba = boost::asio;
+
+using namespace testing;
+
+namespace
+{
+/// What a client has read: the byte stream, and the fds by the offset of the byte they came with
+struct Received
+{
+    std::vector<char> bytes;
+    std::map<size_t, std::vector<mir::Fd>> fds_at;
+};
+
+struct Connection
+{
+    std::shared_ptr<mfd::SocketMessenger> messenger;
+    mir::Fd client_fd;
+};
+
+std::vector<char> payload_of(std::string const& text)
+{
+    return {text.begin(), text.end()};
+}
+
+struct SocketMessenger : Test
+{
+    Connection connect()
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+            throw std::system_error{errno, std::system_category(), "Failed to create socketpair"};
+
+        auto const socket = std::make_shared<ba::local::stream_protocol::socket>(
+            io_service, ba::local::stream_protocol(), fds[0]);
+        mir::Fd const client_fd{fds[1]};
+        fcntl(client_fd, F_SETFL, O_NONBLOCK);
+
+        return {std::make_shared<mfd::SocketMessenger>(socket), client_fd};
+    }
+
+    // Sends enough that the socket fills up and later messages are queued
+    void fill_socket(Connection const& connection)
+    {
+        for (auto i = 0; i != 8; ++i)
+        {
+            filler.push_back(std::vector<char>(60000, static_cast<char>('a' + i)));
+            connection.messenger->send(filler.back().data(), filler.back().size(), {});
+        }
+    }
+
+    // Reads as the client until expected_bytes have arrived, letting the
+    // messenger flush its backlog (on the "IPC thread") as the socket drains
+    void receive(Connection const& connection, Received& received, size_t expected_bytes)
+    {
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+
+        while (received.bytes.size() < expected_bytes && std::chrono::steady_clock::now() < deadline)
+        {
+            io_service.poll();
+            io_service.reset();
+
+            char buffer[16*1024];
+            iovec iov{buffer, sizeof buffer};
+
+            union {
+                cmsghdr cmh;
+                char control[CMSG_SPACE(16 * sizeof(int))];
+            } control_un;
+
+            msghdr header{};
+            header.msg_iov = &iov;
+            header.msg_iovlen = 1;
+            header.msg_control = control_un.control;
+            header.msg_controllen = sizeof(control_un.control);
+
+            auto const result = recvmsg(connection.client_fd, &header, MSG_CMSG_CLOEXEC);
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                pollfd readable{connection.client_fd, POLLIN, 0};
+                poll(&readable, 1, 10);
+                continue;
+            }
+            ASSERT_THAT(result, Gt(0));
+
+            received.bytes.insert(received.bytes.end(), buffer, buffer + result);
+
+            for (auto cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg))
+            {
+                if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+                {
+                    auto const data = reinterpret_cast<int const*>(CMSG_DATA(cmsg));
+                    auto const count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                    auto& fds = received.fds_at[received.bytes.size() - 1];
+                    for (size_t i = 0; i != count; ++i)
+                        fds.push_back(mir::Fd{data[i]});
+                }
+            }
+        }
+    }
+
+    static size_t framed_size(std::vector<char> const& payload)
+    {
+        return 2 + payload.size();
+    }
+
+    // Checks the framed message at offset is payload and returns the offset following it
+    static size_t expect_message_at(Received const& received, size_t offset, std::vector<char> const& payload)
+    {
+        EXPECT_THAT(received.bytes.size(), Ge(offset + framed_size(payload)));
+        if (received.bytes.size() < offset + framed_size(payload))
+            return received.bytes.size();
+
+        auto const length =
+            (size_t(static_cast<unsigned char>(received.bytes[offset])) << 8) |
+            size_t(static_cast<unsigned char>(received.bytes[offset + 1]));
+        EXPECT_THAT(length, Eq(payload.size()));
+
+        auto const begin = received.bytes.begin() + offset + 2;
+        EXPECT_TRUE(std::equal(payload.begin(), payload.end(), begin));
+
+        return offset + framed_size(payload);
+    }
+
+    // Checks that fd refers to the read end of the pipe with write_end
+    static void expect_reads_from_pipe(mir::Fd const& fd, mir::Fd const& write_end)
+    {
+        char const sent{'!'};
+        ASSERT_THAT(write(write_end, &sent, 1), Eq(1));
+
+        char read_back{0};
+        EXPECT_THAT(read(fd, &read_back, 1), Eq(1));
+        EXPECT_THAT(read_back, Eq(sent));
+    }
+
+    ba::io_service io_service;
+    std::vector<std::vector<char>> filler;
+};
+}
+
+TEST_F(SocketMessenger, keeps_order_and_fds_of_messages_queued_behind_a_partial_write)
+{
+    auto const connection = connect();
+
+    int pipe_fds[2];
+    ASSERT_THAT(pipe(pipe_fds), Eq(0));
+    mir::Fd const read_end{pipe_fds[0]};
+    mir::Fd const write_end{pipe_fds[1]};
+
+    auto const with_fd = payload_of("with fd");
+    auto const after = payload_of("after");
+
+    fill_socket(connection);
+    connection.messenger->send(with_fd.data(), with_fd.size(), {{read_end}});
+    connection.messenger->send(after.data(), after.size(), {});
+
+    size_t expected_bytes{0};
+    for (auto const& payload : filler)
+        expected_bytes += framed_size(payload);
+    expected_bytes += framed_size(with_fd) + 1 + framed_size(after);
+
+    Received received;
+    receive(connection, received, expected_bytes);
+    ASSERT_THAT(received.bytes.size(), Eq(expected_bytes));
+
+    size_t offset{0};
+    for (auto const& payload : filler)
+        offset = expect_message_at(received, offset, payload);
+    offset = expect_message_at(received, offset, with_fd);
+
+    // The fd follows its message, with the byte it travels with
+    EXPECT_THAT(received.bytes[offset], Eq('M'));
+    ASSERT_THAT(received.fds_at.size(), Eq(1u));
+    ASSERT_THAT(received.fds_at.begin()->first, Eq(offset));
+    ASSERT_THAT(received.fds_at.begin()->second.size(), Eq(1u));
+    expect_reads_from_pipe(received.fds_at.begin()->second.front(), write_end);
+
+    expect_message_at(received, offset + 1, after);
+}
+
+TEST_F(SocketMessenger, queued_fds_stay_valid_after_the_caller_closes_them)
+{
+    auto const connection = connect();
+
+    int pipe_fds[2];
+    ASSERT_THAT(pipe(pipe_fds), Eq(0));
+    mir::Fd const write_end{pipe_fds[1]};
+
+    auto const with_fd = payload_of("with fd");
+
+    fill_socket(connection);
+    connection.messenger->send(with_fd.data(), with_fd.size(), {{mir::Fd{mir::IntOwnedFd{pipe_fds[0]}}}});
+    close(pipe_fds[0]);
+
+    size_t expected_bytes{framed_size(with_fd) + 1};
+    for (auto const& payload : filler)
+        expected_bytes += framed_size(payload);
+
+    Received received;
+    receive(connection, received, expected_bytes);
+
+    ASSERT_THAT(received.fds_at.size(), Eq(1u));
+    ASSERT_THAT(received.fds_at.begin()->second.size(), Eq(1u));
+    expect_reads_from_pipe(received.fds_at.begin()->second.front(), write_end);
+}
+
+TEST_F(SocketMessenger, disconnects_a_client_that_never_reads_without_affecting_others)
+{
+    auto const slow = connect();
+    auto const other = connect();
+
+    // More than the 4MiB a client may leave unread
+    std::vector<char> const big(60000, 's');
+    for (auto i = 0; i != 80; ++i)
+        slow.messenger->send(big.data(), big.size(), {});
+
+    pollfd hangup{slow.client_fd, POLLIN, 0};
+    ASSERT_THAT(poll(&hangup, 1, 0), Eq(1));
+    EXPECT_TRUE(hangup.revents & POLLHUP);
+
+    char const byte{'x'};
+    EXPECT_THAT(send(slow.client_fd, &byte, 1, MSG_NOSIGNAL | MSG_DONTWAIT), Eq(-1));
+    EXPECT_THAT(errno, Eq(EPIPE));
+
+    // Further messages to the dropped client are discarded
+    EXPECT_NO_THROW(slow.messenger->send(big.data(), big.size(), {}));
+
+    auto const hello = payload_of("hello");
+    other.messenger->send(hello.data(), hello.size(), {});
+
+    Received received;
+    receive(other, received, framed_size(hello));
+    ASSERT_THAT(received.bytes.size(), Eq(framed_size(hello)));
+    expect_message_at(received, 0, hello);
+}
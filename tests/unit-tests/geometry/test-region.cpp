@@ -0,0 +1,166 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <iterator>
+
+using namespace mir::geometry;
+using namespace testing;
+
+namespace
+{
+auto contents_of(Region const& region) -> std::vector<Rectangle>
+{
+    return {std::begin(region), std::end(region)};
+}
+}
+
+TEST(Region, default_is_empty)
+{
+    Region region;
+
+    EXPECT_TRUE(region.empty());
+    EXPECT_THAT(region.size(), Eq(0u));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{}));
+}
+
+TEST(Region, empty_rectangle_gives_empty_region)
+{
+    Region region{Rectangle{{10, 10}, {0, 5}}};
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, single_rectangle)
+{
+    Rectangle const rect{{10, 20}, {30, 40}};
+    Region region{rect};
+
+    EXPECT_FALSE(region.empty());
+    EXPECT_THAT(contents_of(region), ElementsAre(rect));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(rect));
+}
+
+TEST(Region, union_of_overlapping_rectangles_is_banded)
+{
+    Region region{
+        Rectangle{{0, 0}, {10, 10}},
+        Rectangle{{5, 5}, {10, 10}}};
+
+    EXPECT_THAT(contents_of(region), ElementsAre(
+        Rectangle{{0, 0}, {10, 5}},
+        Rectangle{{0, 5}, {15, 5}},
+        Rectangle{{5, 10}, {10, 5}}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{{0, 0}, {15, 15}}));
+}
+
+TEST(Region, adjacent_rectangles_are_merged)
+{
+    Region horizontal{
+        Rectangle{{0, 0}, {10, 10}},
+        Rectangle{{10, 0}, {10, 10}}};
+    Region vertical{
+        Rectangle{{0, 0}, {10, 10}},
+        Rectangle{{0, 10}, {10, 10}}};
+
+    EXPECT_THAT(contents_of(horizontal), ElementsAre(Rectangle{{0, 0}, {20, 10}}));
+    EXPECT_THAT(contents_of(vertical), ElementsAre(Rectangle{{0, 0}, {10, 20}}));
+}
+
+TEST(Region, equal_areas_compare_equal_however_built)
+{
+    Region a{
+        Rectangle{{0, 0}, {20, 10}},
+        Rectangle{{0, 10}, {20, 10}}};
+    Region b{
+        Rectangle{{0, 0}, {10, 20}},
+        Rectangle{{10, 0}, {10, 20}}};
+
+    EXPECT_THAT(a, Eq(b));
+    EXPECT_THAT(a, Ne(Region{Rectangle{{0, 0}, {20, 19}}}));
+}
+
+TEST(Region, subtract_punches_a_hole)
+{
+    Region region{Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_THAT(contents_of(region), ElementsAre(
+        Rectangle{{0, 0}, {30, 10}},
+        Rectangle{{0, 10}, {10, 10}},
+        Rectangle{{20, 10}, {10, 10}},
+        Rectangle{{0, 20}, {30, 10}}));
+    EXPECT_FALSE(region.contains(Rectangle{{5, 5}, {10, 10}}));
+    EXPECT_TRUE(region.contains(Rectangle{{0, 0}, {30, 10}}));
+}
+
+TEST(Region, subtract_everything_leaves_nothing)
+{
+    Region region{Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(Region{
+        Rectangle{{0, 0}, {15, 30}},
+        Rectangle{{15, 0}, {15, 30}}});
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, intersect_keeps_common_area)
+{
+    Region region{
+        Rectangle{{0, 0}, {10, 10}},
+        Rectangle{{20, 0}, {10, 10}}};
+    region.intersect(Rectangle{{5, 5}, {20, 10}});
+
+    EXPECT_THAT(contents_of(region), ElementsAre(
+        Rectangle{{5, 5}, {5, 5}},
+        Rectangle{{20, 5}, {5, 5}}));
+}
+
+TEST(Region, jointly_covered_rectangle_is_contained)
+{
+    Region region{
+        Rectangle{{0, 0}, {50, 100}},
+        Rectangle{{50, 0}, {50, 100}}};
+
+    EXPECT_TRUE(region.contains(Rectangle{{25, 25}, {50, 50}}));
+    EXPECT_FALSE(region.contains(Rectangle{{75, 25}, {50, 50}}));
+}
+
+TEST(Region, overlaps)
+{
+    Region region{
+        Rectangle{{0, 0}, {10, 10}},
+        Rectangle{{20, 0}, {10, 10}}};
+
+    EXPECT_TRUE(region.overlaps(Rectangle{{5, 5}, {10, 10}}));
+    EXPECT_FALSE(region.overlaps(Rectangle{{10, 0}, {10, 10}}));
+}
+
+TEST(Region, translate_moves_all_rectangles)
+{
+    Region region{
+        Rectangle{{0, 0}, {10, 10}},
+        Rectangle{{20, 0}, {10, 10}}};
+    region.translate({5, -5});
+
+    EXPECT_THAT(contents_of(region), ElementsAre(
+        Rectangle{{5, -5}, {10, 10}},
+        Rectangle{{25, -5}, {10, 10}}));
+}
@@ -29,6 +29,7 @@ namespace mg=mir::graphics;
 
 namespace
 {
+size_t const texture_bytes{10 * 10 * 4};
 
 class RecentlyUsedCache : public testing::Test
 {
@@ -44,6 +45,20 @@ public:
             .WillByDefault(Return(mg::BufferID(123)));
     }
 
+    /// A renderable with a 10x10 buffer of its own, taking texture_bytes
+    static auto make_renderable(intptr_t n) -> std::shared_ptr<mtd::MockRenderable>
+    {
+        using namespace testing;
+        auto const buffer = std::make_shared<NiceMock<mtd::MockGLBuffer>>(
+            mir::geometry::Size{10, 10}, mir::geometry::Stride{40}, mir_pixel_format_abgr_8888);
+        auto const renderable = std::make_shared<NiceMock<mtd::MockRenderable>>();
+        ON_CALL(*renderable, buffer())
+            .WillByDefault(Return(buffer));
+        ON_CALL(*renderable, id())
+            .WillByDefault(Return(reinterpret_cast<mg::Renderable::ID>(n)));
+        return renderable;
+    }
+
     testing::NiceMock<mtd::MockGL> mock_gl;
     std::shared_ptr<mtd::MockGLBuffer> mock_buffer;
     std::shared_ptr<testing::NiceMock<mtd::MockRenderable>> renderable;
@@ -140,3 +155,123 @@ TEST_F(RecentlyUsedCache, invalidated_buffers_are_reloaded)
     cache.invalidate();
     cache.load(*renderable);
 }
+
+TEST_F(RecentlyUsedCache, keeps_textures_not_drawn_in_the_last_frame)
+{
+    EXPECT_CALL(mock_gl, glDeleteTextures(testing::_, testing::_))
+        .Times(0);
+
+    mgl::RecentlyUsedCache cache;
+    cache.load(*renderable);
+    cache.drop_unused();
+    cache.drop_unused();
+    cache.drop_unused();
+
+    EXPECT_EQ(1u, cache.usage().textures);
+    EXPECT_EQ(0u, cache.usage().evicted_textures);
+
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+}
+
+TEST_F(RecentlyUsedCache, rebinds_texture_not_drawn_in_the_last_frame)
+{
+    EXPECT_CALL(*mock_buffer, bind())
+        .Times(2);
+
+    mgl::RecentlyUsedCache cache;
+    cache.load(*renderable);
+    cache.drop_unused();
+    cache.drop_unused();
+    cache.load(*renderable);
+}
+
+TEST_F(RecentlyUsedCache, keeps_binding_of_unchanged_buffer_not_drawn_in_the_last_frame)
+{
+    ON_CALL(*renderable, content_serial())
+        .WillByDefault(testing::Return(7));
+    EXPECT_CALL(*mock_buffer, bind())
+        .Times(1);
+
+    mgl::RecentlyUsedCache cache;
+    cache.load(*renderable);
+    cache.drop_unused();
+    cache.drop_unused();
+    cache.load(*renderable);
+}
+
+TEST_F(RecentlyUsedCache, rebinds_buffer_resubmitted_while_not_drawn)
+{
+    using namespace testing;
+    EXPECT_CALL(*renderable, content_serial())
+        .WillOnce(Return(7))
+        .WillRepeatedly(Return(8));
+    EXPECT_CALL(*mock_buffer, bind())
+        .Times(2);
+
+    mgl::RecentlyUsedCache cache;
+    cache.load(*renderable);
+    cache.drop_unused();
+    cache.drop_unused();
+    cache.load(*renderable);
+}
+
+TEST_F(RecentlyUsedCache, evicts_least_recently_used_textures_beyond_budget)
+{
+    auto const first = make_renderable(1);
+    auto const second = make_renderable(2);
+    auto const third = make_renderable(3);
+
+    mgl::RecentlyUsedCache cache{std::make_shared<mgl::TextureBudget>(2 * texture_bytes)};
+    cache.load(*first);
+    cache.drop_unused();
+    cache.load(*second);
+    cache.drop_unused();
+    cache.load(*third);
+    cache.drop_unused();
+
+    EXPECT_EQ(2u, cache.usage().textures);
+    EXPECT_EQ(2 * texture_bytes, cache.usage().bytes);
+    EXPECT_EQ(1u, cache.usage().evicted_textures);
+    EXPECT_EQ(texture_bytes, cache.usage().evicted_bytes);
+}
+
+TEST_F(RecentlyUsedCache, caches_sharing_a_budget_keep_no_more_than_it_between_them)
+{
+    auto const first = make_renderable(1);
+    auto const second = make_renderable(2);
+    auto const third = make_renderable(3);
+
+    auto const budget = std::make_shared<mgl::TextureBudget>(2 * texture_bytes);
+    mgl::RecentlyUsedCache one_output{budget};
+    mgl::RecentlyUsedCache other_output{budget};
+
+    one_output.load(*first);
+    one_output.load(*second);
+    one_output.drop_unused();
+    other_output.load(*third);
+    other_output.drop_unused();
+
+    // Over budget, the first cache frees what it isn't drawing when it next can
+    one_output.drop_unused();
+
+    EXPECT_EQ(1u, one_output.usage().textures);
+    EXPECT_EQ(texture_bytes, one_output.usage().evicted_bytes);
+    EXPECT_EQ(1u, other_output.usage().textures);
+    EXPECT_FALSE(budget->exceeded());
+}
+
+TEST_F(RecentlyUsedCache, gives_back_its_share_of_the_budget_when_destroyed)
+{
+    auto const first = make_renderable(1);
+    auto const second = make_renderable(2);
+
+    auto const budget = std::make_shared<mgl::TextureBudget>(texture_bytes);
+    {
+        mgl::RecentlyUsedCache cache{budget};
+        cache.load(*first);
+        cache.load(*second);
+        EXPECT_TRUE(budget->exceeded());
+    }
+
+    EXPECT_FALSE(budget->exceeded());
+}
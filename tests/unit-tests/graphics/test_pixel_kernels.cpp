@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/pixel_kernels.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+namespace mgp = mir::graphics::pixel;
+using namespace testing;
+
+namespace
+{
+// Sizes either side of the vector widths, so the leftovers get exercised too
+std::vector<size_t> const sizes{0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33, 64};
+
+std::vector<uint32_t> numbered(size_t count)
+{
+    std::vector<uint32_t> pixels(count);
+    for (size_t i = 0; i != count; ++i)
+        pixels[i] = 0x01020304u * (i + 1) ^ (i << 20);
+    return pixels;
+}
+
+struct PixelKernels : TestWithParam<mgp::Kernels const*>
+{
+    mgp::Kernels const& kernels = *GetParam();
+};
+
+std::string kernels_name(TestParamInfo<mgp::Kernels const*> const& info)
+{
+    return info.param->name;
+}
+}
+
+TEST_P(PixelKernels, swap_red_blue_swaps_first_and_third_bytes)
+{
+    for (auto const count : sizes)
+    {
+        auto const src = numbered(count);
+        std::vector<uint32_t> dst(count);
+
+        kernels.swap_red_blue(src.data(), dst.data(), count);
+
+        for (size_t i = 0; i != count; ++i)
+        {
+            auto const expected = (src[i] & 0xff00ff00) | ((src[i] >> 16) & 0xff) | ((src[i] & 0xff) << 16);
+            ASSERT_THAT(dst[i], Eq(expected)) << "count=" << count << " i=" << i;
+        }
+    }
+}
+
+TEST_P(PixelKernels, swap_red_blue_works_in_place)
+{
+    for (auto const count : sizes)
+    {
+        auto pixels = numbered(count);
+        std::vector<uint32_t> expected(count);
+        kernels.swap_red_blue(pixels.data(), expected.data(), count);
+
+        kernels.swap_red_blue(pixels.data(), pixels.data(), count);
+
+        EXPECT_THAT(pixels, ContainerEq(expected)) << "count=" << count;
+    }
+}
+
+TEST_P(PixelKernels, reverse_reverses)
+{
+    for (auto const count : sizes)
+    {
+        auto const src = numbered(count);
+        std::vector<uint32_t> dst(count);
+
+        kernels.reverse(src.data(), dst.data(), count);
+
+        EXPECT_THAT(dst, ElementsAreArray(src.rbegin(), src.rend())) << "count=" << count;
+    }
+}
+
+TEST_P(PixelKernels, fill_writes_only_what_it_is_asked_to)
+{
+    for (auto const count : sizes)
+    {
+        std::vector<uint32_t> dst(count + 1, 0);
+
+        kernels.fill(dst.data(), count, 0xdeadbeef);
+
+        EXPECT_THAT(std::count(dst.begin(), dst.end(), 0xdeadbeef), Eq(long(count)));
+        EXPECT_THAT(dst.back(), Eq(0u));
+    }
+}
+
+TEST_P(PixelKernels, rotations_match_definition)
+{
+    for (auto const width : sizes)
+    {
+        for (auto const height : sizes)
+        {
+            // Pad the strides, to catch anything assuming they match the width
+            auto const src_stride = width + 3;
+            auto const dst_stride = height + 5;
+            auto const src = numbered(src_stride * height);
+
+            std::vector<uint32_t> clockwise(dst_stride * width, 0);
+            std::vector<uint32_t> anticlockwise(dst_stride * width, 0);
+            kernels.rotate_clockwise(src.data(), src_stride, width, height, clockwise.data(), dst_stride);
+            kernels.rotate_anticlockwise(src.data(), src_stride, width, height, anticlockwise.data(), dst_stride);
+
+            for (size_t row = 0; row != width; ++row)
+            {
+                for (size_t col = 0; col != dst_stride; ++col)
+                {
+                    auto const cw = col < height ? src[(height - 1 - col) * src_stride + row] : 0;
+                    auto const acw = col < height ? src[col * src_stride + width - 1 - row] : 0;
+                    ASSERT_THAT(clockwise[row * dst_stride + col], Eq(cw))
+                        << width << "x" << height << " row=" << row << " col=" << col;
+                    ASSERT_THAT(anticlockwise[row * dst_stride + col], Eq(acw))
+                        << width << "x" << height << " row=" << row << " col=" << col;
+                }
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(
+    PixelKernels, PixelKernels, ValuesIn(mgp::supported_kernels()), kernels_name);
+
+TEST(PixelKernelHelpers, best_kernels_are_the_last_supported)
+{
+    EXPECT_THAT(&mgp::best_kernels(), Eq(mgp::supported_kernels().back()));
+}
+
+TEST(PixelKernelHelpers, flip_vertically_reverses_row_order)
+{
+    size_t const width = 300, stride = 301, height = 5;
+    auto const original = numbered(stride * height);
+    auto pixels = original;
+
+    mgp::flip_vertically(pixels.data(), stride, width, height, false);
+
+    for (size_t row = 0; row != height; ++row)
+    {
+        for (size_t col = 0; col != width; ++col)
+            ASSERT_THAT(pixels[row * stride + col], Eq(original[(height - 1 - row) * stride + col]));
+    }
+}
+
+TEST(PixelKernelHelpers, flip_vertically_can_swap_red_and_blue_too)
+{
+    size_t const width = 7, height = 3;
+    auto const original = numbered(width * height);
+    auto pixels = original;
+
+    mgp::flip_vertically(pixels.data(), width, width, height, true);
+
+    for (size_t row = 0; row != height; ++row)
+    {
+        for (size_t col = 0; col != width; ++col)
+        {
+            uint32_t expected;
+            mgp::swap_red_blue(&original[(height - 1 - row) * width + col], &expected, 1);
+            ASSERT_THAT(pixels[row * width + col], Eq(expected));
+        }
+    }
+}
+
+TEST(PixelKernelHelpers, copy_rotated_inverted_turns_image_upside_down)
+{
+    std::vector<uint32_t> const src{
+        1, 2, 3,
+        4, 5, 6};
+    std::vector<uint32_t> dst(6);
+
+    mgp::copy_rotated(src.data(), 3, 3, 2, dst.data(), 3, mir_orientation_inverted);
+
+    EXPECT_THAT(dst, ElementsAre(
+        6, 5, 4,
+        3, 2, 1));
+}
+
+TEST(PixelKernelHelpers, copy_rotated_left_and_right_turn_a_quarter)
+{
+    std::vector<uint32_t> const src{
+        1, 2, 3,
+        4, 5, 6};
+    std::vector<uint32_t> left(6), right(6);
+
+    mgp::copy_rotated(src.data(), 3, 3, 2, left.data(), 2, mir_orientation_left);
+    mgp::copy_rotated(src.data(), 3, 3, 2, right.data(), 2, mir_orientation_right);
+
+    EXPECT_THAT(left, ElementsAre(
+        3, 6,
+        2, 5,
+        1, 4));
+    EXPECT_THAT(right, ElementsAre(
+        4, 1,
+        5, 2,
+        6, 3));
+}
+
+TEST(PixelKernelHelpers, fill_rectangle_leaves_the_rest_of_the_stride_alone)
+{
+    std::vector<uint32_t> pixels(4 * 3, 0);
+
+    mgp::fill(pixels.data(), 4, 3, 3, 7);
+
+    EXPECT_THAT(pixels, ElementsAre(
+        7, 7, 7, 0,
+        7, 7, 7, 0,
+        7, 7, 7, 0));
+}
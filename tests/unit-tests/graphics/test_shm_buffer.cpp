@@ -93,6 +93,11 @@ struct PlatformlessShmBuffer : mgc::MemoryBackedShmBuffer
     {
         return nullptr;
     }
+
+    void upload_damage(std::vector<geom::Rectangle> const& damage)
+    {
+        upload_damage_to_texture(pixel_buffer(), stride(), damage);
+    }
 };
 
 struct ShmBufferTest : public testing::Test
@@ -146,6 +151,28 @@ TEST_F(ShmBufferTest, cant_upload_bgr_888)
     buf.bind();
 }
 
+TEST_F(ShmBufferTest, uploads_only_damaged_region)
+{
+    PlatformlessShmBuffer buf(size, mir_pixel_format_argb_8888, egl_delegate);
+    auto const stride = buf.stride().as_int();
+
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, size.width.as_int()));
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        GL_TEXTURE_2D, 0,
+        10, 20, 30, 40,
+        _, GL_UNSIGNED_BYTE,
+        buf.pixel_buffer() + 20 * stride + 10 * 4));
+    // Clipped to the buffer
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        GL_TEXTURE_2D, 0,
+        140, 0, 10, 5,
+        _, GL_UNSIGNED_BYTE,
+        buf.pixel_buffer() + 140 * 4));
+
+    buf.upload_damage({{{10, 20}, {30, 40}}, {{140, -5}, {100, 10}}});
+}
+
 struct BufferUploadDesc
 {
     geom::Size size;
@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/events/event_builders.h"
+#include "mir/events/event_private.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace mev = mir::events;
+using namespace ::testing;
+
+// This replaces the global allocation functions, so it is built as a test
+// binary of its own rather than as part of mir_unit_tests
+namespace
+{
+// Heap allocations made by this thread while counting
+thread_local bool counting{false};
+thread_local int allocations{0};
+}
+
+void* operator new(std::size_t size)
+{
+    if (counting)
+        ++allocations;
+
+    if (auto const block = std::malloc(size ? size : 1))
+        return block;
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+namespace
+{
+struct EventAllocation : Test
+{
+    static int const events_in_flight = 32;
+
+    static auto make_pointer_event(float x) -> mir::EventUPtr
+    {
+        return mev::make_event(7, std::chrono::nanoseconds{39}, std::vector<uint8_t>{}, mir_input_event_modifier_none,
+            mir_pointer_action_motion, 0, x, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    // Events built here, as an input platform would, and released on another
+    // thread, as they are after dispatch
+    static auto build_events_released_elsewhere() -> int
+    {
+        std::vector<mir::EventUPtr> events;
+        events.reserve(events_in_flight);
+
+        counting = true;
+        allocations = 0;
+        for (auto i = 0; i != events_in_flight; ++i)
+            events.push_back(make_pointer_event(i));
+        counting = false;
+
+        std::thread{[&events] { events.clear(); }}.join();
+
+        return allocations;
+    }
+};
+}
+
+TEST_F(EventAllocation, building_events_released_on_another_thread_needs_no_heap_allocation_once_warm)
+{
+    // The first round may have to fill the pool
+    build_events_released_elsewhere();
+
+    EXPECT_THAT(build_events_released_elsewhere(), Eq(0));
+    EXPECT_THAT(build_events_released_elsewhere(), Eq(0));
+}
+
+TEST_F(EventAllocation, events_released_on_another_thread_are_valid_when_reused)
+{
+    build_events_released_elsewhere();
+
+    for (auto i = 0; i != events_in_flight; ++i)
+    {
+        auto const event = make_pointer_event(i);
+        auto const pev = mir_input_event_get_pointer_event(mir_event_get_input_event(event.get()));
+
+        EXPECT_THAT(mir_pointer_event_axis_value(pev, mir_pointer_axis_x), Eq(static_cast<float>(i)));
+        EXPECT_THAT(mir_pointer_event_axis_value(pev, mir_pointer_axis_y), Eq(0.0f));
+    }
+}
@@ -130,6 +130,27 @@ TEST_F(InputEventBuilder, makes_valid_pointer_event)
     EXPECT_EQ(vscroll_value, mir_pointer_event_axis_value(pev, mir_pointer_axis_vscroll));
 }
 
+TEST_F(InputEventBuilder, clone_is_unaffected_by_reuse_of_the_original)
+{
+    MirPointerButtons const buttons{mir_pointer_button_primary};
+    float const x_axis_value = 3.9, y_axis_value = 7.4;
+
+    auto original = mev::make_event(device_id, timestamp, cookie, modifiers,
+        mir_pointer_action_button_down, buttons, x_axis_value, y_axis_value, 0, 0, 0, 0);
+    auto const clone = mev::clone_event(*original);
+    original.reset();
+
+    // Likely to be built where the original was
+    auto const other = mev::make_event(device_id, timestamp, cookie, modifiers,
+        mir_pointer_action_motion, 0, 11.0f, 13.0f, 0, 0, 0, 0);
+
+    auto const pev = mir_input_event_get_pointer_event(mir_event_get_input_event(clone.get()));
+    EXPECT_EQ(mir_pointer_action_button_down, mir_pointer_event_action(pev));
+    EXPECT_EQ(buttons, mir_pointer_event_buttons(pev));
+    EXPECT_EQ(x_axis_value, mir_pointer_event_axis_value(pev, mir_pointer_axis_x));
+    EXPECT_EQ(y_axis_value, mir_pointer_event_axis_value(pev, mir_pointer_axis_y));
+}
+
 // The following three requirements can be removed as soon as we remove android::InputDispatcher, which is the
 // only remaining part that relies on the difference between mir_motion_action_pointer_{up,down} and
 // mir_motion_action_{up,down} and the difference between mir_motion_action_move and mir_motion_action_hover_move.
@@ -0,0 +1,220 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/input/motion_coalescing_dispatcher.h"
+
+#include "mir/events/event_private.h"
+#include "mir/events/event_builders.h"
+
+#include "mir/test/fake_shared.h"
+#include "mir/test/signal.h"
+#include "mir/test/event_matchers.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+#include "mir/test/doubles/mock_input_dispatcher.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+
+namespace mi = mir::input;
+namespace mev = mir::events;
+namespace mt = mir::test;
+namespace mtd = mt::doubles;
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct MotionCoalescingDispatcher : public testing::Test
+{
+    MotionCoalescingDispatcher(bool resample = false)
+        : dispatcher(mt::fake_shared(next_dispatcher), mt::fake_shared(alarm_factory),
+                     clock, frame_interval, resample)
+    {
+    }
+
+    mir::EventUPtr motion(float x, float y, float dx, float dy,
+                          MirPointerButtons buttons = 0)
+    {
+        return mev::make_event(
+            pointer_device, clock->now().time_since_epoch(), std::vector<uint8_t>{}, mir_input_event_modifier_none,
+            mir_pointer_action_motion, buttons, x, y, 0, 0, dx, dy);
+    }
+
+    mir::EventUPtr button_down(float x, float y)
+    {
+        return mev::make_event(
+            pointer_device, clock->now().time_since_epoch(), std::vector<uint8_t>{}, mir_input_event_modifier_none,
+            mir_pointer_action_button_down, mir_pointer_button_primary, x, y, 0, 0, 0, 0);
+    }
+
+    mir::EventUPtr touch(float x, float y, MirTouchAction action = mir_touch_action_change)
+    {
+        auto ev = mev::make_event(
+            touch_device, clock->now().time_since_epoch(), std::vector<uint8_t>{}, mir_input_event_modifier_none);
+        mev::add_touch(*ev, 0, action, mir_touch_tooltype_finger, x, y, 1, 1, 1, 1);
+        return ev;
+    }
+
+    void advance_by(mir::time::Duration step)
+    {
+        clock->advance_by(step);
+        alarm_factory.advance_by(step);
+    }
+
+    MirInputDeviceId const pointer_device{3};
+    MirInputDeviceId const touch_device{4};
+    std::chrono::milliseconds const frame_interval{16};
+
+    NiceMock<mtd::MockInputDispatcher> next_dispatcher;
+    mtd::FakeAlarmFactory alarm_factory;
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    mi::MotionCoalescingDispatcher dispatcher;
+};
+
+struct ResamplingMotionCoalescingDispatcher : MotionCoalescingDispatcher
+{
+    ResamplingMotionCoalescingDispatcher() : MotionCoalescingDispatcher(true) {}
+};
+}
+
+TEST_F(MotionCoalescingDispatcher, first_motion_is_passed_on_immediately)
+{
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(10, 10))).Times(1);
+
+    dispatcher.dispatch(motion(10, 10, 1, 1));
+}
+
+TEST_F(MotionCoalescingDispatcher, motion_within_a_frame_is_merged)
+{
+    InSequence seq;
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(10, 10)));
+    EXPECT_CALL(next_dispatcher, dispatch(AllOf(mt::PointerEventWithPosition(13, 14), mt::PointerEventWithDiff(3, 4))));
+
+    dispatcher.dispatch(motion(10, 10, 1, 1));
+    dispatcher.dispatch(motion(11, 12, 1, 2));
+    dispatcher.dispatch(motion(13, 14, 2, 2));
+
+    advance_by(frame_interval + 1ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, motion_after_a_quiet_frame_is_passed_on_immediately)
+{
+    EXPECT_CALL(next_dispatcher, dispatch(_)).Times(2);
+
+    dispatcher.dispatch(motion(10, 10, 1, 1));
+    advance_by(frame_interval + 1ms);
+    dispatcher.dispatch(motion(11, 11, 1, 1));
+}
+
+TEST_F(MotionCoalescingDispatcher, button_press_flushes_held_back_motion_first)
+{
+    InSequence seq;
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(10, 10)));
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(12, 12)));
+    EXPECT_CALL(next_dispatcher, dispatch(mt::ButtonDownEvent(12, 12)));
+
+    dispatcher.dispatch(motion(10, 10, 1, 1));
+    dispatcher.dispatch(motion(12, 12, 2, 2));
+    dispatcher.dispatch(button_down(12, 12));
+}
+
+TEST_F(MotionCoalescingDispatcher, passes_events_on_without_blocking_other_threads)
+{
+    mt::Signal other_thread_returned;
+    std::thread other;
+
+    InSequence seq;
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(10, 10)))
+        .WillOnce(InvokeWithoutArgs([&]
+            {
+                other = std::thread{[&]
+                    {
+                        dispatcher.dispatch(button_down(10, 10));
+                        other_thread_returned.raise();
+                    }};
+
+                EXPECT_TRUE(other_thread_returned.wait_for(5s));
+                return true;
+            }));
+    // ...and still in order
+    EXPECT_CALL(next_dispatcher, dispatch(mt::ButtonDownEvent(10, 10)));
+
+    dispatcher.dispatch(motion(10, 10, 1, 1));
+    other.join();
+}
+
+TEST_F(MotionCoalescingDispatcher, motion_with_different_buttons_is_not_merged)
+{
+    InSequence seq;
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(10, 10)));
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(11, 11)));
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(12, 12)));
+
+    dispatcher.dispatch(motion(10, 10, 1, 1));
+    dispatcher.dispatch(motion(11, 11, 1, 1));
+    dispatcher.dispatch(motion(12, 12, 1, 1, mir_pointer_button_primary));
+
+    advance_by(frame_interval + 1ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, touch_motion_within_a_frame_is_merged)
+{
+    InSequence seq;
+    EXPECT_CALL(next_dispatcher, dispatch(mt::TouchContact(0, mir_touch_action_down, 10, 10)));
+    EXPECT_CALL(next_dispatcher, dispatch(mt::TouchContact(0, mir_touch_action_change, 11, 11)));
+    EXPECT_CALL(next_dispatcher, dispatch(mt::TouchContact(0, mir_touch_action_change, 13, 13)));
+    EXPECT_CALL(next_dispatcher, dispatch(mt::TouchContact(0, mir_touch_action_up, 13, 13)));
+
+    dispatcher.dispatch(touch(10, 10, mir_touch_action_down));
+    dispatcher.dispatch(touch(11, 11));
+    dispatcher.dispatch(touch(12, 12));
+    dispatcher.dispatch(touch(13, 13));
+    dispatcher.dispatch(touch(13, 13, mir_touch_action_up));
+}
+
+TEST_F(ResamplingMotionCoalescingDispatcher, predicts_where_steady_motion_has_got_to)
+{
+    InSequence seq;
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(10, 10)));
+    // Moving 1px/ms, and passed on 3ms after the last motion
+    EXPECT_CALL(next_dispatcher, dispatch(AllOf(mt::PointerEventWithPosition(27, 10), mt::PointerEventWithDiff(14, 0))));
+
+    dispatcher.dispatch(motion(10, 10, 0, 0));
+    advance_by(10ms);
+    dispatcher.dispatch(motion(20, 10, 10, 0));
+    advance_by(4ms);
+    dispatcher.dispatch(motion(24, 10, 4, 0));
+    advance_by(3ms);
+}
+
+TEST_F(ResamplingMotionCoalescingDispatcher, prediction_is_limited)
+{
+    ASSERT_THAT(mi::MotionCoalescingDispatcher::max_prediction, Eq(8ms));
+
+    InSequence seq;
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(10, 10)));
+    // Moving 10px/8ms, and passed on 16ms after the last motion
+    EXPECT_CALL(next_dispatcher, dispatch(mt::PointerEventWithPosition(30, 10)));
+
+    dispatcher.dispatch(motion(10, 10, 0, 0));
+    advance_by(8ms);
+    dispatcher.dispatch(motion(20, 10, 10, 0));
+    advance_by(16ms);
+}
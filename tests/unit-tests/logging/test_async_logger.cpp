@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ml = mir::logging;
+using namespace testing;
+
+namespace
+{
+auto lines_of(std::ostringstream const& stream) -> std::vector<std::string>
+{
+    std::vector<std::string> lines;
+    std::istringstream in{stream.str()};
+    for (std::string line; std::getline(in, line);)
+        lines.push_back(line);
+    return lines;
+}
+
+struct AsyncLogger : Test
+{
+    std::ostringstream out;
+    std::ostringstream err;
+};
+}
+
+TEST_F(AsyncLogger, writes_lines_of_a_thread_in_order)
+{
+    {
+        ml::AsyncLogger logger{out, err, ml::AsyncLogger::default_lines_per_thread};
+        ml::Logger& as_logger = logger;
+
+        as_logger.log(ml::Severity::informational, "first", "test");
+        as_logger.log(ml::Severity::debug, "second", "test");
+    }
+
+    EXPECT_THAT(lines_of(out), ElementsAre(
+        AllOf(HasSubstr("<information> "), EndsWith("test: first")),
+        AllOf(HasSubstr("< - debug - > "), EndsWith("test: second"))));
+    EXPECT_THAT(lines_of(err), IsEmpty());
+}
+
+TEST_F(AsyncLogger, writes_warnings_and_errors_to_error_stream)
+{
+    {
+        ml::AsyncLogger logger{out, err, ml::AsyncLogger::default_lines_per_thread};
+        ml::Logger& as_logger = logger;
+
+        as_logger.log(ml::Severity::warning, "careful", "test");
+        as_logger.log(ml::Severity::error, "oops", "test");
+    }
+
+    EXPECT_THAT(lines_of(out), IsEmpty());
+    EXPECT_THAT(lines_of(err), ElementsAre(EndsWith("test: careful"), EndsWith("test: oops")));
+}
+
+TEST_F(AsyncLogger, writes_critical_lines_before_returning)
+{
+    ml::AsyncLogger logger{out, err, ml::AsyncLogger::default_lines_per_thread};
+    ml::Logger& as_logger = logger;
+
+    as_logger.log(ml::Severity::error, "before", "test");
+    as_logger.log(ml::Severity::critical, "fatal", "test");
+
+    EXPECT_THAT(lines_of(err), ElementsAre(EndsWith("test: before"), EndsWith("test: fatal")));
+}
+
+TEST_F(AsyncLogger, writes_lines_of_threads_that_have_exited)
+{
+    {
+        ml::AsyncLogger logger{out, err, ml::AsyncLogger::default_lines_per_thread};
+        ml::Logger& as_logger = logger;
+
+        std::thread{[&] { as_logger.log(ml::Severity::informational, "from a thread", "test"); }}.join();
+    }
+
+    EXPECT_THAT(lines_of(out), ElementsAre(EndsWith("test: from a thread")));
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/logging/xwayland_report.h"
+#include "mir/logging/logger.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace ml  = mir::logging;
+namespace mrl = mir::report::logging;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+class MockLogger : public ml::Logger
+{
+public:
+    MOCK_METHOD3(log, void(ml::Severity severity, const std::string& message, const std::string& component));
+    ~MockLogger() noexcept(true) {}
+};
+
+struct XWaylandReport : public testing::Test
+{
+    std::shared_ptr<MockLogger> logger{std::make_shared<MockLogger>()};
+    mrl::XWaylandReport report{logger};
+};
+
+char const* const component = "frontend::XWayland";
+}
+
+TEST_F(XWaylandReport, reports_startup_time_and_activation)
+{
+    EXPECT_CALL(*logger, log(
+        ml::Severity::informational,
+        "Xwayland ready 250.5ms after activation (client connected)",
+        component));
+
+    report.started(mrl::XWaylandReport::Activation::client_connected, 250500us);
+}
+
+TEST_F(XWaylandReport, reports_failed_start_as_warning)
+{
+    EXPECT_CALL(*logger, log(
+        ml::Severity::warning,
+        "Xwayland failed to start, gave up after 5000ms (prespawn)",
+        component));
+
+    report.start_failed(mrl::XWaylandReport::Activation::prespawn, 5s);
+}
+
+TEST_F(XWaylandReport, reports_crash_as_warning)
+{
+    EXPECT_CALL(*logger, log(ml::Severity::warning, _, component));
+
+    report.stopped(true);
+}
@@ -150,6 +150,23 @@ public:
             .WillRepeatedly(Return(screen_to_gl_coords_uniform_location));
     }
 
+    // Lets the renderer repaint only the damaged parts of a 1920x1080 output
+    void enable_buffer_age(int age)
+    {
+        ON_CALL(mock_egl, eglQueryString(_,EGL_EXTENSIONS))
+            .WillByDefault(Return("EGL_EXT_buffer_age"));
+        ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_WIDTH,_))
+            .WillByDefault(DoAll(SetArgPointee<3>(1920), Return(EGL_TRUE)));
+        ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_HEIGHT,_))
+            .WillByDefault(DoAll(SetArgPointee<3>(1080), Return(EGL_TRUE)));
+        ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_BUFFER_AGE_EXT,_))
+            .WillByDefault(DoAll(SetArgPointee<3>(age), Return(EGL_TRUE)));
+        ON_CALL(mock_gl, glGetIntegerv(GL_FRAMEBUFFER_BINDING,_))
+            .WillByDefault(SetArgPointee<1>(0));
+        ON_CALL(mock_display_buffer, view_area())
+            .WillByDefault(Return(mir::geometry::Rectangle{{0,0}, {1920,1080}}));
+    }
+
     testing::NiceMock<mtd::MockGL> mock_gl;
     testing::NiceMock<mtd::MockEGL> mock_egl;
     std::shared_ptr<mtd::MockGLBuffer> mock_buffer;
@@ -466,3 +483,117 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
 
     mrg::Renderer renderer(mock_display_buffer);
 }
+
+TEST_F(GLRenderer, repaints_only_damaged_area_of_recent_back_buffer)
+{
+    enable_buffer_age(1);
+    mrg::Renderer renderer(mock_display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(*mock_buffer, id())
+        .WillRepeatedly(Return(mir::graphics::BufferID(790)));
+    EXPECT_CALL(mock_gl, glScissor(1, 1074, 3, 4)).Times(AtLeast(1));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_nothing_when_buffer_and_content_are_unchanged)
+{
+    enable_buffer_age(1);
+    ON_CALL(*renderable, content_serial()).WillByDefault(Return(1));
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_)).Times(0);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_content_resubmitted_in_the_same_buffer)
+{
+    enable_buffer_age(1);
+    ON_CALL(*renderable, content_serial()).WillByDefault(Return(1));
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    ON_CALL(*renderable, content_serial()).WillByDefault(Return(2));
+    EXPECT_CALL(mock_gl, glScissor(1, 1074, 3, 4)).Times(AtLeast(1));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_renderable_whose_content_is_not_tracked)
+{
+    enable_buffer_age(1);
+    ON_CALL(*renderable, content_serial()).WillByDefault(Return(0));
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(mock_gl, glScissor(1, 1074, 3, 4)).Times(AtLeast(1));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_where_a_renderable_was_and_is_after_moving)
+{
+    enable_buffer_age(1);
+    ON_CALL(*renderable, content_serial()).WillByDefault(Return(1));
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(Return(mir::geometry::Rectangle{{100,200},{3,4}}));
+    EXPECT_CALL(mock_gl, glScissor(1, 1074, 3, 4)).Times(AtLeast(1));
+    EXPECT_CALL(mock_gl, glScissor(100, 876, 3, 4)).Times(AtLeast(1));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_renderable_whose_alpha_changed)
+{
+    enable_buffer_age(1);
+    ON_CALL(*renderable, content_serial()).WillByDefault(Return(1));
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(*renderable, alpha()).WillRepeatedly(Return(0.5f));
+    EXPECT_CALL(mock_gl, glScissor(1, 1074, 3, 4)).Times(AtLeast(1));
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_where_a_renderable_disappeared)
+{
+    enable_buffer_age(1);
+    ON_CALL(*renderable, content_serial()).WillByDefault(Return(1));
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(mock_gl, glScissor(1, 1074, 3, 4)).Times(AtLeast(1));
+    renderer.render({});
+}
+
+TEST_F(GLRenderer, repaints_everything_when_renderables_are_restacked)
+{
+    enable_buffer_age(1);
+    auto const other = std::make_shared<testing::NiceMock<mtd::MockRenderable>>();
+    ON_CALL(*other, id()).WillByDefault(Return(&other));
+    ON_CALL(*other, buffer()).WillByDefault(Return(mock_buffer));
+    ON_CALL(*other, alpha()).WillByDefault(Return(1.0f));
+    ON_CALL(*other, transformation()).WillByDefault(Return(trans));
+    ON_CALL(*other, screen_position()).WillByDefault(Return(mir::geometry::Rectangle{{10,20},{3,4}}));
+    ON_CALL(*other, content_serial()).WillByDefault(Return(1));
+    ON_CALL(*renderable, content_serial()).WillByDefault(Return(1));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.render({renderable, other});
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_)).Times(1);
+    renderer.render({other, renderable});
+}
@@ -1256,6 +1256,24 @@ TEST_F(BasicSurfaceTest, moving_surface_repositions_all_associated_streams)
     EXPECT_THAT(renderables[1], IsRenderableOfPosition(pt + d));
 }
 
+TEST_F(BasicSurfaceTest, opaque_region_of_stream_is_reported_in_screen_coordinates)
+{
+    using namespace testing;
+    geom::Displacement d{19,99};
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+
+    std::list<ms::StreamInfo> streams = {
+        { buffer_stream, d, geom::Size{50, 50}, {{{10, 10}, {20, 20}}, {{40, 40}, {20, 20}}} }
+    };
+    surface.set_streams(streams);
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0]->opaque_region(), ElementsAre(
+        geom::Rectangle{rect.top_left + d + geom::Displacement{10, 10}, {20, 20}},
+        geom::Rectangle{rect.top_left + d + geom::Displacement{40, 40}, {10, 10}}));
+}
+
 TEST_F(BasicSurfaceTest, can_remove_all_streams)
 {
     using namespace testing;
@@ -21,6 +21,7 @@
 
 #include "mir/test/doubles/mock_gl_buffer.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -69,11 +70,40 @@ public:
     }
 
     testing::NiceMock<mtd::MockGL> mock_gl;
+    testing::NiceMock<mtd::MockEGL> mock_egl;
     testing::NiceMock<mtd::MockGLBuffer> mock_buffer;
     MockGLContext mock_context;
     std::unique_ptr<WrappingGLContext> context;
 };
 
+/* Stands in for the contents of whichever pixel pack buffer glReadPixels() last wrote to */
+std::vector<uint32_t> pixel_pack_contents;
+
+void* fake_glMapBufferRange(GLenum, GLintptr, GLsizeiptr, GLbitfield)
+{
+    return pixel_pack_contents.data();
+}
+
+GLboolean fake_glUnmapBuffer(GLenum)
+{
+    return GL_TRUE;
+}
+
+void* fake_glFenceSync(GLenum, GLbitfield)
+{
+    static int fence;
+    return &fence;
+}
+
+GLenum fake_glClientWaitSync(void*, GLbitfield, uint64_t)
+{
+    return 0x911A; // GL_ALREADY_SIGNALED
+}
+
+void fake_glDeleteSync(void*)
+{
+}
+
 ACTION(FillPixels)
 {
     auto const pixels = static_cast<uint32_t*>(arg6);
@@ -225,3 +255,49 @@ TEST_F(GLPixelBufferTest, returns_data_from_rgba_buffer_texture)
     EXPECT_EQ(width - 1,
               static_cast<uint32_t const*>(data)[width * height - 1]);
 }
+
+TEST_F(GLPixelBufferTest, reads_back_through_pixel_pack_buffers_when_gl_has_them)
+{
+    using namespace testing;
+    uint32_t const width{mock_buffer.size().width.as_uint32_t()};
+    uint32_t const height{mock_buffer.size().height.as_uint32_t()};
+
+    using Function = mtd::MockEGL::generic_function_pointer_t;
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.0 Mesa")));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glMapBufferRange")))
+        .WillByDefault(Return(reinterpret_cast<Function>(&fake_glMapBufferRange)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glUnmapBuffer")))
+        .WillByDefault(Return(reinterpret_cast<Function>(&fake_glUnmapBuffer)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glFenceSync")))
+        .WillByDefault(Return(reinterpret_cast<Function>(&fake_glFenceSync)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glClientWaitSync")))
+        .WillByDefault(Return(reinterpret_cast<Function>(&fake_glClientWaitSync)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glDeleteSync")))
+        .WillByDefault(Return(reinterpret_cast<Function>(&fake_glDeleteSync)));
+
+    /* The pixels go to the bound pixel pack buffer rather than to client memory */
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, nullptr))
+        .Times(2);
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixel_pack_contents.resize(width * height);
+    for (uint32_t i = 0; i < width * height; ++i)
+        pixel_pack_contents[i] = i;
+
+    pixels.begin_fill_from(mock_buffer);
+    ASSERT_THAT(pixels.max_pending_fills(), Gt(1u));
+    pixels.begin_fill_from(mock_buffer);
+    pixels.complete_fill();
+    auto data = static_cast<uint32_t const*>(pixels.as_argb_8888());
+
+    EXPECT_EQ(mock_buffer.size(), pixels.size());
+
+    /* Check that data has been y-flipped on the way out of the pixel pack buffer */
+    EXPECT_EQ(1u, data[width * (height - 1) + 1]);
+    EXPECT_EQ(width * (height - 1), data[0]);
+    EXPECT_EQ(width - 1, data[width * height - 1]);
+
+    pixels.complete_fill();
+}
@@ -998,6 +998,80 @@ TEST_F(SurfaceStack, returns_top_visible_surface_under_cursor)
     EXPECT_THAT(stack.surface_at(cursor_over_none).get(), IsNull());
 }
 
+TEST_F(SurfaceStack, surface_under_cursor_follows_moves_and_raises)
+{
+    geom::Point const cursor{1100, 700};
+
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    stub_surface1->resize({300, 300});
+    stub_surface2->resize({300, 300});
+
+    EXPECT_THAT(stack.surface_at(cursor).get(), IsNull());
+
+    stub_surface1->move_to({1000, 600});
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface1));
+    EXPECT_THAT(stack.input_surface_at(cursor), Eq(stub_surface1));
+
+    stub_surface2->move_to({900, 500});
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface2));
+
+    stack.raise(stub_surface1);
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface1));
+
+    stub_surface1->move_to({-2000, -2000});
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({-1900, -1900}), Eq(stub_surface1));
+
+    stack.remove_surface(stub_surface2);
+    EXPECT_THAT(stack.surface_at(cursor).get(), IsNull());
+}
+
+TEST_F(SurfaceStack, surface_under_cursor_respects_input_region)
+{
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    stub_surface1->resize({900, 900});
+    stub_surface2->resize({100, 100});
+
+    // A custom input region may extend beyond the surface (e.g. to cover subsurfaces)
+    stub_surface2->set_input_region({{{500, 500}, {100, 100}}});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({550, 550}), Eq(stub_surface2));
+
+    stub_surface2->set_input_region({});
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({550, 550}), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_under_cursor_respects_depth_layers)
+{
+    geom::Point const cursor{100, 100};
+
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    // Large enough to span more of the plane than is worth indexing cell by cell
+    stub_surface1->resize({100000, 100000});
+    stub_surface2->resize({200, 200});
+
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface2));
+
+    stub_surface1->set_depth_layer(mir_depth_layer_above);
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface1));
+
+    stack.raise(stub_surface2);
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface1));
+
+    stub_surface2->set_depth_layer(mir_depth_layer_overlay);
+    EXPECT_THAT(stack.surface_at(cursor), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({5000, 5000}), Eq(stub_surface1));
+}
+
 TEST_F(SurfaceStack, raise_surfaces_to_top)
 {
     stack.add_surface(stub_surface1, default_params.input_mode);
@@ -54,18 +54,55 @@ public:
     MOCK_CONST_METHOD0(stride, geom::Stride());
 };
 
+class MockPipelinedPixelBuffer : public ms::PixelBuffer
+{
+public:
+    ~MockPipelinedPixelBuffer() noexcept {}
+
+    MOCK_METHOD1(fill_from, void(mg::Buffer& buffer));
+    MOCK_METHOD1(begin_fill_from, void(mg::Buffer& buffer));
+    MOCK_METHOD0(complete_fill, void());
+    MOCK_CONST_METHOD0(max_pending_fills, unsigned int());
+    MOCK_METHOD0(as_argb_8888, void const*());
+    MOCK_CONST_METHOD0(size, geom::Size());
+    MOCK_CONST_METHOD0(stride, geom::Stride());
+};
+
+/* Holds up the snapshot thread until released */
+struct BlockingBufferStream : mtd::StubBufferStream
+{
+    std::shared_ptr<mg::Buffer> snapshot_acquire() override
+    {
+        entered.raise();
+        release.wait_for(std::chrono::seconds{5});
+        return StubBufferStream::snapshot_acquire();
+    }
+    mt::Signal entered;
+    mt::Signal release;
+};
+
 struct NamedThreadBufferStream : mtd::StubBufferStream
 {
-    void with_most_recent_buffer_do(std::function<void(mg::Buffer & )> const& fn) override
+    std::shared_ptr<mg::Buffer> snapshot_acquire() override
     {
 #ifndef MIR_DONT_USE_PTHREAD_GETNAME_NP
         thread_name = mt::current_thread_name();
 #endif
-        StubBufferStream::with_most_recent_buffer_do(fn);
+        return StubBufferStream::snapshot_acquire();
     }
     std::string thread_name;
 };
 
+/* Hands out a buffer that is "returned to the client" when released */
+struct ReturningBufferStream : mtd::StubBufferStream
+{
+    std::shared_ptr<mg::Buffer> snapshot_acquire() override
+    {
+        return {stub_compositor_buffer.get(), [this](mg::Buffer*) { returned = true; }};
+    }
+    std::atomic<bool> returned{false};
+};
+
 struct ThreadedSnapshotStrategyTest : testing::Test
 {
     NamedThreadBufferStream buffer_access;
@@ -112,6 +149,74 @@ TEST_F(ThreadedSnapshotStrategyTest, takes_snapshot)
     EXPECT_EQ(pixels, snapshot.pixels);
 }
 
+TEST_F(ThreadedSnapshotStrategyTest, keeps_buffer_from_client_until_readback_completes)
+{
+    using namespace testing;
+
+    NiceMock<MockPipelinedPixelBuffer> pixel_buffer;
+    ReturningBufferStream returning_stream;
+
+    EXPECT_CALL(pixel_buffer, complete_fill())
+        .WillOnce(Invoke([&] { EXPECT_FALSE(returning_stream.returned); }));
+
+    mt::Signal snapshot_taken;
+
+    {
+        ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+        strategy.take_snapshot_of(
+            mt::fake_shared(returning_stream),
+            [&](ms::Snapshot const&) { snapshot_taken.raise(); });
+
+        EXPECT_TRUE(snapshot_taken.wait_for(std::chrono::seconds{5}));
+    }
+
+    EXPECT_TRUE(returning_stream.returned);
+}
+
+TEST_F(ThreadedSnapshotStrategyTest, overlaps_readback_of_queued_snapshots)
+{
+    using namespace testing;
+
+    NiceMock<MockPipelinedPixelBuffer> pixel_buffer;
+    ON_CALL(pixel_buffer, max_pending_fills())
+        .WillByDefault(Return(2));
+
+    {
+        InSequence s;
+        EXPECT_CALL(pixel_buffer, begin_fill_from(_));
+        EXPECT_CALL(pixel_buffer, complete_fill());
+        EXPECT_CALL(pixel_buffer, begin_fill_from(_)).Times(2);
+        EXPECT_CALL(pixel_buffer, complete_fill());
+        // The next is started as soon as there's room, not after the rest complete
+        EXPECT_CALL(pixel_buffer, begin_fill_from(_));
+        EXPECT_CALL(pixel_buffer, complete_fill()).Times(2);
+    }
+    EXPECT_CALL(pixel_buffer, fill_from(_)).Times(0);
+
+    BlockingBufferStream blocking_stream;
+    std::atomic<int> snapshots_taken{0};
+    mt::Signal all_taken;
+    auto const snapshot_taken =
+        [&](ms::Snapshot const&)
+        {
+            if (++snapshots_taken == 4)
+                all_taken.raise();
+        };
+
+    ms::ThreadedSnapshotStrategy strategy{mt::fake_shared(pixel_buffer)};
+
+    strategy.take_snapshot_of(mt::fake_shared(blocking_stream), snapshot_taken);
+    ASSERT_TRUE(blocking_stream.entered.wait_for(std::chrono::seconds{5}));
+
+    strategy.take_snapshot_of(mt::fake_shared(buffer_access), snapshot_taken);
+    strategy.take_snapshot_of(mt::fake_shared(buffer_access), snapshot_taken);
+    strategy.take_snapshot_of(mt::fake_shared(buffer_access), snapshot_taken);
+    blocking_stream.release.raise();
+
+    EXPECT_TRUE(all_taken.wait_for(std::chrono::seconds{5}));
+}
+
 #ifndef MIR_DONT_USE_PTHREAD_GETNAME_NP
 TEST_F(ThreadedSnapshotStrategyTest, names_snapshot_thread)
 {
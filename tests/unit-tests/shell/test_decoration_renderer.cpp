@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/shell/decoration/renderer.h"
+#include "src/server/shell/decoration/window.h"
+
+#include "mir/test/fake_shared.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_buffer_allocator.h"
+#include "mir/test/doubles/stub_surface.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+geom::Size const window_size{240, 120};
+geom::Width const button_width{24};
+geom::Height const titlebar_height{24};
+
+struct WindowSurface : mtd::StubSurface
+{
+    std::string name() const override { return "window"; }
+    geom::Size window_size() const override { return ::window_size; }
+    MirWindowState state() const override { return mir_window_state_restored; }
+    MirWindowFocusState focus_state() const override { return mir_window_focus_state_focused; }
+};
+
+struct MockText : msd::Renderer::Text
+{
+    MOCK_METHOD6(render, void(
+        msd::Renderer::Pixel* buf,
+        geom::Size buf_size,
+        std::string const& text,
+        geom::Point top_left,
+        geom::Height height_pixels,
+        msd::Renderer::Pixel color));
+};
+
+struct DecorationRenderer : Test
+{
+    auto button(msd::ButtonFunction function, int index, msd::ButtonState state) -> msd::ButtonInfo
+    {
+        geom::X const left = as_x(window_size.width) - as_delta(button_width) * (index + 1);
+        return {function, state, {{left, 0}, {button_width, titlebar_height}}};
+    }
+
+    auto buttons(msd::ButtonState maximize_state) -> std::vector<msd::ButtonInfo>
+    {
+        return {
+            button(msd::ButtonFunction::Close, 0, msd::ButtonState::Up),
+            button(msd::ButtonFunction::Maximize, 1, maximize_state),
+            button(msd::ButtonFunction::Minimize, 2, msd::ButtonState::Up)};
+    }
+
+    void update(std::vector<msd::ButtonInfo> const& buttons)
+    {
+        renderer.update_state(window_state, msd::InputState{buttons, {}});
+    }
+
+    auto render_titlebar() -> std::shared_ptr<mg::Buffer>
+    {
+        auto const buffer = renderer.render_titlebar();
+        EXPECT_TRUE(buffer);
+        return buffer ? buffer.value() : nullptr;
+    }
+
+    static auto pixels_of(std::shared_ptr<mg::Buffer> const& buffer) -> std::vector<msd::Renderer::Pixel>
+    {
+        auto const& bytes = dynamic_cast<mtd::StubBuffer&>(*buffer).written_pixels;
+        std::vector<msd::Renderer::Pixel> pixels(bytes.size() / sizeof(msd::Renderer::Pixel));
+        std::memcpy(pixels.data(), bytes.data(), pixels.size() * sizeof(msd::Renderer::Pixel));
+        return pixels;
+    }
+
+    std::shared_ptr<msd::StaticGeometry const> const static_geometry{
+        std::make_shared<msd::StaticGeometry>(msd::StaticGeometry{
+            titlebar_height,        // titlebar_height
+            geom::Width{6},         // side_border_width
+            geom::Height{6},        // bottom_border_height
+            geom::Size{16, 16},     // resize_corner_input_size
+            button_width,           // button_width
+            geom::Width{6},         // padding_between_buttons
+            geom::Height{12},       // title_font_height
+            geom::Point{8, 4},      // title_font_top_left
+            geom::Displacement{6, 6}, // icon_padding
+            geom::Width{2},         // icon_line_width
+        })};
+    msd::WindowState const window_state{static_geometry, std::make_shared<WindowSurface>()};
+    NiceMock<MockText> text;
+    mtd::StubBufferAllocator buffer_allocator;
+    msd::Renderer renderer{mt::fake_shared(buffer_allocator), static_geometry, mt::fake_shared(text)};
+};
+}
+
+TEST_F(DecorationRenderer, hover_change_redraws_only_that_button)
+{
+    EXPECT_CALL(text, render(_, _, "window", _, _, _)).Times(1);
+
+    update(buttons(msd::ButtonState::Up));
+    auto const before = pixels_of(render_titlebar());
+
+    update(buttons(msd::ButtonState::Hovered));
+    auto const after = pixels_of(render_titlebar());
+
+    ASSERT_THAT(after.size(), Eq(before.size()));
+
+    auto const hovered = button(msd::ButtonFunction::Maximize, 1, msd::ButtonState::Hovered).rect;
+    auto changed = 0;
+    for (size_t i = 0; i != after.size(); ++i)
+    {
+        if (after[i] != before[i])
+        {
+            geom::Point const pixel{i % window_size.width.as_int(), i / window_size.width.as_int()};
+            EXPECT_TRUE(hovered.contains(pixel)) << "pixel changed outside the hovered button at " << pixel;
+            ++changed;
+        }
+    }
+    EXPECT_THAT(changed, Gt(0));
+}
+
+TEST_F(DecorationRenderer, does_not_refill_a_buffer_still_held_elsewhere)
+{
+    update(buttons(msd::ButtonState::Up));
+    auto const held = render_titlebar();
+    auto const held_pixels = pixels_of(held);
+
+    update(buttons(msd::ButtonState::Hovered));
+    auto const next = render_titlebar();
+
+    EXPECT_THAT(next, Ne(held));
+    EXPECT_THAT(pixels_of(held), Eq(held_pixels));
+    EXPECT_THAT(pixels_of(next), Ne(held_pixels));
+}
+
+TEST_F(DecorationRenderer, refills_a_buffer_once_released)
+{
+    update(buttons(msd::ButtonState::Up));
+    auto released = render_titlebar();
+    auto const* const released_address = released.get();
+    released.reset();
+
+    update(buttons(msd::ButtonState::Hovered));
+    auto const next = render_titlebar();
+
+    EXPECT_THAT(next.get(), Eq(released_address));
+}
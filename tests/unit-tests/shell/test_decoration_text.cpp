@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/shell/decoration/glyph_cache.h"
+#include "src/server/shell/decoration/renderer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+
+using namespace testing;
+
+namespace
+{
+geom::Height const height{12};
+
+auto glyph_of_width(int width) -> msd::GlyphCache::Glyph
+{
+    return {{}, geom::Displacement{width, 0}, geom::Size{width, 1}, std::vector<unsigned char>(width, 0xFF)};
+}
+
+auto advance_of(msd::GlyphCache::Glyph const* glyph) -> int
+{
+    return glyph ? glyph->advance.dx.as_int() : -1;
+}
+}
+
+TEST(DecorationGlyphCache, finds_glyph_by_height_and_code_point)
+{
+    msd::GlyphCache cache;
+
+    cache.insert(height, U'a', glyph_of_width(1));
+    cache.insert(height, U'b', glyph_of_width(2));
+    cache.insert(geom::Height{24}, U'a', glyph_of_width(3));
+
+    EXPECT_THAT(advance_of(cache.find(height, U'a')), Eq(1));
+    EXPECT_THAT(advance_of(cache.find(height, U'b')), Eq(2));
+    EXPECT_THAT(advance_of(cache.find(geom::Height{24}, U'a')), Eq(3));
+
+    EXPECT_THAT(cache.find(geom::Height{24}, U'b'), IsNull());
+    EXPECT_THAT(cache.find(geom::Height{13}, U'a'), IsNull());
+}
+
+TEST(DecorationGlyphCache, distinguishes_code_points_beyond_16_bits)
+{
+    msd::GlyphCache cache;
+
+    cache.insert(height, U'\U0001F600', glyph_of_width(1));
+
+    EXPECT_THAT(cache.find(height, U'\uF600'), IsNull());
+    EXPECT_THAT(advance_of(cache.find(height, U'\U0001F600')), Eq(1));
+}
+
+TEST(DecorationGlyphCache, evicts_least_recently_used_glyph_when_full)
+{
+    msd::GlyphCache cache;
+
+    for (char32_t c = 0; c != msd::GlyphCache::max_cached_glyphs; ++c)
+        cache.insert(height, c, glyph_of_width(1));
+    ASSERT_THAT(cache.size(), Eq(msd::GlyphCache::max_cached_glyphs));
+
+    // Using the oldest glyph makes the next oldest the one to go
+    ASSERT_THAT(cache.find(height, 0), NotNull());
+    cache.insert(height, msd::GlyphCache::max_cached_glyphs, glyph_of_width(1));
+
+    EXPECT_THAT(cache.size(), Eq(msd::GlyphCache::max_cached_glyphs));
+    EXPECT_THAT(cache.find(height, 0), NotNull());
+    EXPECT_THAT(cache.find(height, 1), IsNull());
+    EXPECT_THAT(cache.find(height, msd::GlyphCache::max_cached_glyphs), NotNull());
+}
+
+TEST(DecorationGlyphCache, replaces_glyph_inserted_again)
+{
+    msd::GlyphCache cache{2};
+
+    cache.insert(height, U'a', glyph_of_width(1));
+    cache.insert(height, U'a', glyph_of_width(2));
+
+    EXPECT_THAT(cache.size(), Eq(1u));
+    EXPECT_THAT(advance_of(cache.find(height, U'a')), Eq(2));
+}
+
+TEST(DecorationGlyphCache, holds_at_least_one_glyph)
+{
+    msd::GlyphCache cache{0};
+
+    cache.insert(height, U'a', glyph_of_width(1));
+    cache.insert(height, U'b', glyph_of_width(2));
+
+    EXPECT_THAT(cache.size(), Eq(1u));
+    EXPECT_THAT(advance_of(cache.find(height, U'b')), Eq(2));
+}
+
+TEST(DecorationText, renders_the_same_with_glyphs_cached)
+{
+    using Pixel = msd::Renderer::Pixel;
+
+    geom::Size const size{160, 24};
+    Pixel const background{0xFF202020};
+    Pixel const color{0xFFFFFFFF};
+    // A height nothing else renders at, so nothing is cached yet
+    geom::Height const text_height{17};
+    std::string const title{"Cached glyphs: ÀÉÎõü"};
+
+    auto const text = msd::Renderer::Text::instance();
+
+    std::vector<Pixel> cold(size.width.as_int() * size.height.as_int(), background);
+    text->render(cold.data(), size, title, {2, 2}, text_height, color);
+
+    // Without a font nothing is drawn, either time, so there's nothing to compare
+    if (std::all_of(cold.begin(), cold.end(), [&](Pixel pixel) { return pixel == background; }))
+    {
+#ifdef GTEST_SKIP
+        GTEST_SKIP() << "No font found to render with";
+#else
+        std::cerr << "[ SKIPPED  ] No font found to render with" << std::endl;
+        return;
+#endif
+    }
+
+    std::vector<Pixel> warm(cold.size(), background);
+    text->render(warm.data(), size, title, {2, 2}, text_height, color);
+
+    EXPECT_THAT(warm, Eq(cold));
+}
@@ -157,3 +157,66 @@ TEST_F(ThreadSafeListTest, clears_all_elements)
 
     EXPECT_THAT(elements_seen, Eq(0));
 }
+
+TEST_F(ThreadSafeListTest, remove_waits_for_element_in_use_in_different_thread)
+{
+    using namespace testing;
+
+    list.add(element1);
+
+    mir::test::Signal element_in_use;
+    std::atomic<bool> element_finished{false};
+
+    std::thread t{
+        [&]
+        {
+            list.for_each(
+                [&] (Element const&)
+                {
+                    element_in_use.raise();
+                    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+                    element_finished = true;
+                });
+        }};
+
+    element_in_use.wait_for(std::chrono::seconds{3});
+    list.remove(element1);
+
+    EXPECT_TRUE(element_finished);
+
+    t.join();
+}
+
+TEST_F(ThreadSafeListTest, remove_waits_for_element_in_use_in_deeply_nested_iteration_in_different_thread)
+{
+    using namespace testing;
+
+    list.add(element1);
+
+    mir::test::Signal element_in_use;
+    std::atomic<bool> element_finished{false};
+    int depth = 0;
+
+    std::function<void(Element const&)> recurse;
+    recurse = [&] (Element const&)
+        {
+            if (++depth < 20)
+            {
+                list.for_each(recurse);
+                return;
+            }
+
+            element_in_use.raise();
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            element_finished = true;
+        };
+
+    std::thread t{[&] { list.for_each(recurse); }};
+
+    element_in_use.wait_for(std::chrono::seconds{3});
+    list.remove(element1);
+
+    EXPECT_TRUE(element_finished);
+
+    t.join();
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/keyboard_state_tracker.h"
+#include "src/server/frontend_wayland/keymap_cache.h"
+#include "mir/input/keymap.h"
+
+#include <linux/input-event-codes.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+
+using namespace testing;
+
+namespace
+{
+// The real modifier masks of the "Shift" and "Lock" modifiers
+uint32_t const shift_mask = 1 << 0;
+uint32_t const lock_mask = 1 << 1;
+
+struct KeyboardStateTracker : Test
+{
+    mi::Keymap const us{"pc105", "us", "", ""};
+    mi::Keymap const gb{"pc105", "gb", "", ""};
+    mf::KeyboardStateTracker tracker{std::make_shared<mf::KeymapCache>()};
+};
+}
+
+TEST_F(KeyboardStateTracker, keyboards_with_the_same_keymap_share_state)
+{
+    auto const first = tracker.state_for(us);
+    auto const second = tracker.state_for(us);
+    auto const third = tracker.state_for(gb);
+
+    EXPECT_THAT(second, Eq(first));
+    EXPECT_THAT(third, Ne(first));
+}
+
+TEST_F(KeyboardStateTracker, keys_update_modifiers_of_every_state)
+{
+    auto const us_state = tracker.state_for(us);
+    auto const gb_state = tracker.state_for(gb);
+
+    tracker.key(KEY_LEFTSHIFT, true);
+
+    EXPECT_THAT(us_state->modifiers().depressed, Eq(shift_mask));
+    EXPECT_THAT(gb_state->modifiers().depressed, Eq(shift_mask));
+
+    tracker.key(KEY_LEFTSHIFT, false);
+
+    EXPECT_THAT(us_state->modifiers().depressed, Eq(0u));
+    EXPECT_THAT(gb_state->modifiers().depressed, Eq(0u));
+}
+
+TEST_F(KeyboardStateTracker, repeated_presses_are_not_counted_twice)
+{
+    auto const state = tracker.state_for(us);
+
+    tracker.key(KEY_LEFTSHIFT, true);
+    tracker.key(KEY_LEFTSHIFT, true);
+    tracker.key(KEY_LEFTSHIFT, false);
+
+    EXPECT_THAT(state->modifiers().depressed, Eq(0u));
+}
+
+TEST_F(KeyboardStateTracker, new_states_see_keys_already_held)
+{
+    tracker.key(KEY_LEFTSHIFT, true);
+
+    auto const state = tracker.state_for(gb);
+
+    EXPECT_THAT(state->modifiers().depressed, Eq(shift_mask));
+}
+
+TEST_F(KeyboardStateTracker, sync_releases_keys_no_longer_held_and_presses_new_ones)
+{
+    auto const state = tracker.state_for(us);
+    tracker.key(KEY_LEFTSHIFT, true);
+
+    tracker.sync_pressed({KEY_A});
+    EXPECT_THAT(state->modifiers().depressed, Eq(0u));
+
+    tracker.sync_pressed({KEY_A, KEY_RIGHTSHIFT});
+    EXPECT_THAT(state->modifiers().depressed, Eq(shift_mask));
+}
+
+TEST_F(KeyboardStateTracker, locks_survive_sync)
+{
+    auto const state = tracker.state_for(us);
+    tracker.key(KEY_CAPSLOCK, true);
+    tracker.key(KEY_CAPSLOCK, false);
+
+    tracker.sync_pressed({});
+
+    EXPECT_THAT(state->modifiers().locked, Eq(lock_mask));
+}
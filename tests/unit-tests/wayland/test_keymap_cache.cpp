@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/keymap_cache.h"
+#include "mir/input/keymap.h"
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+
+using namespace testing;
+
+namespace
+{
+struct KeymapCache : Test
+{
+    std::string contents_of(mf::CompiledKeymap const& keymap)
+    {
+        auto const fd = keymap.client_fd();
+        auto const size = keymap.client_size();
+        auto const mapping = static_cast<char const*>(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+        EXPECT_THAT(mapping, Ne(MAP_FAILED));
+        std::string const contents{mapping, size};
+        munmap(const_cast<char*>(mapping), size);
+        return contents;
+    }
+
+    mi::Keymap const us{"pc105", "us", "", ""};
+    mi::Keymap const gb{"pc105", "gb", "", ""};
+    mf::KeymapCache cache;
+};
+}
+
+TEST_F(KeymapCache, same_names_share_a_keymap)
+{
+    auto const first = cache.keymap_for(us);
+    auto const second = cache.keymap_for(mi::Keymap{us});
+
+    EXPECT_THAT(second, Eq(first));
+}
+
+TEST_F(KeymapCache, different_names_get_different_keymaps)
+{
+    auto const first = cache.keymap_for(us);
+    auto const second = cache.keymap_for(gb);
+
+    EXPECT_THAT(second, Ne(first));
+    EXPECT_THAT(second->keymap(), Ne(first->keymap()));
+}
+
+TEST_F(KeymapCache, client_fd_holds_the_keymap_text)
+{
+    auto const keymap = cache.keymap_for(us);
+
+    std::unique_ptr<char, void(*)(void*)> const text{
+        xkb_keymap_get_as_string(keymap->keymap(), XKB_KEYMAP_FORMAT_TEXT_V1),
+        free};
+
+    EXPECT_THAT(contents_of(*keymap), Eq(std::string{text.get(), strlen(text.get()) + 1}));
+}
+
+TEST_F(KeymapCache, client_fd_cannot_be_changed)
+{
+    auto const keymap = cache.keymap_for(us);
+    auto const fd = keymap->client_fd();
+
+    EXPECT_THAT(fcntl(fd, F_GET_SEALS) & F_SEAL_WRITE, Ne(0));
+    EXPECT_THAT(keymap->client_fd(), Eq(static_cast<int>(fd)));
+}
+
+TEST_F(KeymapCache, throws_on_names_that_do_not_compile)
+{
+    EXPECT_THROW(
+        cache.keymap_for(mi::Keymap{"pc105", "no-such-layout", "", ""}),
+        std::runtime_error);
+}
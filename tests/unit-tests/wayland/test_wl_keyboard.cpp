@@ -0,0 +1,179 @@
+/*
+ * Copyright © 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/wl_keyboard.h"
+#include "src/server/frontend_wayland/keyboard_state_tracker.h"
+#include "src/server/frontend_wayland/keymap_cache.h"
+#include "mir/input/keymap.h"
+
+#include <wayland-server-core.h>
+#include <linux/input-event-codes.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mir
+{
+namespace wayland
+{
+extern struct wl_interface const wl_keyboard_interface_data;
+extern struct wl_interface const wl_surface_interface_data;
+}
+}
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+namespace mw = mir::wayland;
+
+using namespace testing;
+
+namespace
+{
+// The real modifier mask of the "Shift" modifier
+uint32_t const shift_mask = 1 << 0;
+
+/// An event as it went over the wire: its opcode and (undecoded) arguments
+struct Event
+{
+    uint32_t opcode;
+    std::vector<uint32_t> arguments;
+};
+
+MATCHER_P(IsEvent, opcode, "")
+{
+    return arg.opcode == opcode;
+}
+
+struct WlKeyboard : Test
+{
+    WlKeyboard()
+    {
+        int fds[2];
+        if (socketpair(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds))
+            throw std::system_error{errno, std::system_category(), "Failed to create socket pair"};
+
+        client = wl_client_create(display, fds[0]);
+        client_end = fds[1];
+        surface = wl_resource_create(client, &mw::wl_surface_interface_data, 4, 0);
+        keyboard = new mf::WlKeyboard{
+            wl_resource_create(client, &mw::wl_keyboard_interface_data, 6, 0),
+            us,
+            keyboard_states,
+            [](mf::WlKeyboard*) {},
+            [this] { return pressed_keys; }};
+
+        // Skip the keymap and repeat info every new keyboard is sent
+        events_sent();
+    }
+
+    ~WlKeyboard()
+    {
+        wl_client_destroy(client);
+        wl_display_destroy(display);
+        close(client_end);
+    }
+
+    /// The events the client has been sent since the last call
+    auto events_sent() -> std::vector<Event>
+    {
+        wl_client_flush(client);
+
+        std::vector<uint32_t> words;
+        uint32_t buffer[1024];
+        ssize_t bytes;
+        while ((bytes = read(client_end, buffer, sizeof buffer)) > 0)
+            words.insert(words.end(), buffer, buffer + bytes / sizeof buffer[0]);
+
+        std::vector<Event> events;
+        for (auto word = words.begin(); word != words.end();)
+        {
+            auto const size_in_words = (word[1] >> 16) / sizeof(uint32_t);
+            events.push_back({word[1] & 0xffff, {word + 2, word + size_in_words}});
+            word += size_in_words;
+        }
+        return events;
+    }
+
+    static auto depressed_modifiers_of(Event const& modifiers) -> uint32_t
+    {
+        // serial, depressed, latched, locked, group
+        return modifiers.arguments.at(1);
+    }
+
+    mi::Keymap const us{"pc105", "us", "", ""};
+    std::shared_ptr<mf::KeyboardStateTracker> const keyboard_states{
+        std::make_shared<mf::KeyboardStateTracker>(std::make_shared<mf::KeymapCache>())};
+    std::vector<uint32_t> pressed_keys;
+
+    wl_display* const display{wl_display_create()};
+    wl_client* client;
+    int client_end;
+    wl_resource* surface;
+    mf::WlKeyboard* keyboard; // Owned by its resource
+};
+}
+
+TEST_F(WlKeyboard, enter_is_followed_by_modifiers)
+{
+    keyboard->focussed(surface, true);
+
+    EXPECT_THAT(events_sent(), ElementsAre(
+        IsEvent(mw::Keyboard::Opcode::enter),
+        IsEvent(mw::Keyboard::Opcode::modifiers)));
+}
+
+TEST_F(WlKeyboard, every_enter_is_followed_by_modifiers_even_if_they_are_unchanged)
+{
+    keyboard->focussed(surface, true);
+    keyboard->focussed(surface, false);
+    events_sent();
+
+    keyboard->focussed(surface, true);
+
+    EXPECT_THAT(events_sent(), ElementsAre(
+        IsEvent(mw::Keyboard::Opcode::enter),
+        IsEvent(mw::Keyboard::Opcode::modifiers)));
+}
+
+TEST_F(WlKeyboard, modifiers_after_enter_include_keys_already_held)
+{
+    pressed_keys = {KEY_LEFTSHIFT};
+
+    keyboard->focussed(surface, true);
+
+    auto const events = events_sent();
+    ASSERT_THAT(events, ElementsAre(
+        IsEvent(mw::Keyboard::Opcode::enter),
+        IsEvent(mw::Keyboard::Opcode::modifiers)));
+    EXPECT_THAT(depressed_modifiers_of(events[1]), Eq(shift_mask));
+}
+
+TEST_F(WlKeyboard, leave_is_not_followed_by_modifiers)
+{
+    keyboard->focussed(surface, true);
+    events_sent();
+
+    keyboard->focussed(surface, false);
+
+    EXPECT_THAT(events_sent(), ElementsAre(IsEvent(mw::Keyboard::Opcode::leave)));
+}